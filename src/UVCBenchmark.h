@@ -0,0 +1,214 @@
+//
+//  UVCBenchmark.h
+//
+//  Microbenchmarks of the uvc-util classes with JSON results.
+//
+//  Copyright © 2016
+//  Dr. Jeffrey Frey, IT-NSS
+//  University of Delaware
+//
+// $Id$
+//
+
+#import "UVCValue.h"
+
+#include <stdio.h>
+
+/*!
+  @defined UVCBenchmarkDefaultSampleCount
+
+  Default number of timed samples taken of each benchmark; the median is
+  reported.
+*/
+#define UVCBenchmarkDefaultSampleCount        5
+
+/*!
+  @defined UVCBenchmarkDefaultMinimumSampleTime
+
+  Default minimum duration (in seconds) of a timed sample; the iteration
+  count is doubled until a sample takes at least this long.
+*/
+#define UVCBenchmarkDefaultMinimumSampleTime  0.02
+
+/*!
+  @defined UVCBenchmarkDefaultTolerance
+
+  Default fraction by which a result may be worse than its baseline before
+  it is reported as a regression.
+*/
+#define UVCBenchmarkDefaultTolerance          0.25
+
+/*!
+  @typedef UVCBenchmarkFunction
+
+  Function timed by measure:function:context: of UVCBenchmark.  It must
+  perform the operation being measured iterations times.
+*/
+typedef void (*UVCBenchmarkFunction)(void *context, NSUInteger iterations);
+
+/*!
+  @class UVCBenchmark
+  @abstract Runs suites of benchmarks and writes the results as JSON.
+
+  Each suite is a method of the class (or of a category on it) that calls
+  measure:function:context: for every operation it times, and
+  recordValue:unit:higherIsBetter:forName: for results that are not simple
+  per-operation times (rates, counts, latencies observed on a simulated
+  device).
+
+  A timed operation is first calibrated:  the iteration count is doubled
+  until a single sample takes at least minimumSampleTime.  Then sampleCount
+  samples are taken, each inside its own autorelease pool, and the median,
+  minimum, and maximum time per iteration are reported.  Using the median
+  of several long-enough samples keeps the results stable from run to run.
+
+  The portable suites ("type," "value," and "names") exercise only UVCType,
+  UVCValue, and the UVCControlNames look-up table, so they need nothing but
+  Foundation.  Before timing anything, the type suite checks
+  byteSwapBuffer:count: byte for byte against known layouts (it swaps on
+  any host, so a little-endian host exercises the path big-endian hosts
+  use), and it fuzzes the value parser against the one it replaced; a
+  mismatch in either is recorded with a limit of zero, so it fails the
+  run.  Suites that need devices
+  (simulated ones) are implemented in the UVCDeviceBenchmarks category;
+  only the suites whose methods are present are available.
+
+  The results are written as a single JSON object:
+
+    {"benchmark":"uvc-util","sample-count":5,"results":[
+      {"suite":"type","name":"type.uvcTypeWithCString","unit":"ns/op",
+       "value":412.5,"min":410.1,"max":430.8,"iterations":65536},
+      ...
+    ],"regression-count":0}
+
+  If a baseline (the JSON written by an earlier run) is loaded, each result
+  with the same name in the baseline also carries "baseline" and "change"
+  (the fractional difference) and, if it is worse by more than the
+  tolerance, "regression":true.  A result recorded with a limit (see
+  recordValue:unit:limit:forName:) also carries "limit" and, if its value
+  is above the limit, "exceeded":true whether or not a baseline is loaded.
+*/
+@interface UVCBenchmark : NSObject
+{
+  FILE                *_stream;
+  NSUInteger          _sampleCount;
+  NSTimeInterval      _minimumSampleTime;
+  NSDictionary        *_baseline;
+  double              _tolerance;
+  const char          *_suiteName;
+  NSUInteger          _resultCount;
+  NSUInteger          _regressionCount;
+}
+
+/*!
+  @method benchmarkWithStream:
+
+  Returns an autoreleased instance that writes its results to stream.
+*/
++ (UVCBenchmark*) benchmarkWithStream:(FILE*)stream;
+
+/*!
+  @method suiteNames
+
+  Returns the names of all available suites, in the order they are run by
+  default.
+*/
++ (NSArray*) suiteNames;
+
+/*!
+  @method sampleCount
+
+  Returns the number of timed samples taken of each operation.
+*/
+- (NSUInteger) sampleCount;
+
+/*!
+  @method setSampleCount:
+
+  Set the number of timed samples taken of each operation (at least 1).
+*/
+- (void) setSampleCount:(NSUInteger)sampleCount;
+
+/*!
+  @method minimumSampleTime
+
+  Returns the minimum duration of a timed sample, in seconds.
+*/
+- (NSTimeInterval) minimumSampleTime;
+
+/*!
+  @method setMinimumSampleTime:
+
+  Set the minimum duration of a timed sample, in seconds.
+*/
+- (void) setMinimumSampleTime:(NSTimeInterval)minimumSampleTime;
+
+/*!
+  @method tolerance
+
+  Returns the fraction by which a result may be worse than its baseline
+  before it is counted as a regression.
+*/
+- (double) tolerance;
+
+/*!
+  @method setTolerance:
+
+  Set the fraction by which a result may be worse than its baseline before
+  it is counted as a regression.
+*/
+- (void) setTolerance:(double)tolerance;
+
+/*!
+  @method loadBaselineFromFile:
+
+  Read the JSON results of an earlier run from path to compare against.
+  Returns NO if the file could not be read or parsed.
+*/
+- (BOOL) loadBaselineFromFile:(NSString*)path;
+
+/*!
+  @method runSuitesWithNames:
+
+  Run the named suites (all available suites if suiteNames is nil) and
+  write the results.  Returns zero, or ENOENT (without running anything) if
+  a suite name is unknown.
+*/
+- (int) runSuitesWithNames:(NSArray*)suiteNames;
+
+/*!
+  @method regressionCount
+
+  Returns the number of results of the last run that regressed against the
+  baseline or exceeded their limit.
+*/
+- (NSUInteger) regressionCount;
+
+/*!
+  @method measure:function:context:
+
+  Time function (called with context) and write the time per iteration,
+  in nanoseconds, as the result called name within the current suite.
+*/
+- (void) measure:(const char*)name function:(UVCBenchmarkFunction)function context:(void*)context;
+
+/*!
+  @method recordValue:unit:higherIsBetter:forName:
+
+  Write value (in the given unit) as the result called name within the
+  current suite.  The higherIsBetter flag determines the direction in which
+  a change counts as a regression.
+*/
+- (void) recordValue:(double)value unit:(const char*)unit higherIsBetter:(BOOL)higherIsBetter forName:(const char*)name;
+
+/*!
+  @method recordValue:unit:limit:forName:
+
+  Write value (in the given unit, lower being better) as the result called
+  name within the current suite.  A value above limit counts toward
+  regressionCount even without a baseline, so a suite can fail outright
+  (e.g. when memory grows during a soak).
+*/
+- (void) recordValue:(double)value unit:(const char*)unit limit:(double)limit forName:(const char*)name;
+
+@end
@@ -0,0 +1,1136 @@
+//
+//  UVCBenchmark.m
+//
+//  Microbenchmarks of the uvc-util classes with JSON results.
+//
+//  Copyright © 2016
+//  Dr. Jeffrey Frey, IT-NSS
+//  University of Delaware
+//
+// $Id$
+//
+
+#import "UVCBenchmark.h"
+#import "UVCControlNames.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <math.h>
+#include <strings.h>
+
+/*!
+  @typedef UVCBenchmarkSuite
+
+  Associates a suite name with the name of the UVCBenchmark method that runs
+  it.  Suites whose method is not implemented (e.g. the device suites in a
+  build without the UVCDeviceBenchmarks category) are unavailable.
+*/
+typedef struct {
+  const char      *name;
+  const char      *selectorName;
+} UVCBenchmarkSuite;
+
+static const UVCBenchmarkSuite UVCBenchmarkSuites[] = {
+                                  { "type",           "runTypeSuite" },
+                                  { "value",          "runValueSuite" },
+                                  { "names",          "runNamesSuite" },
+                                  { "controls",       "runControlsSuite" },
+                                  { "descriptors",    "runDescriptorsSuite" },
+                                  { "requests",       "runRequestsSuite" },
+                                  { "watch",          "runWatchSuite" },
+                                  { "daemon",         "runDaemonSuite" },
+                                  { "batch",          "runBatchSuite" },
+                                  { "enumeration",    "runEnumerationSuite" },
+                                  { "group",          "runGroupSuite" },
+                                  { "trajectory",     "runTrajectorySuite" },
+                                  { "coalescing",     "runCoalescingSuite" },
+                                  { "trace",          "runTraceSuite" },
+                                  { "arena",          "runArenaSuite" },
+                                  { "dump",           "runDumpSuite" },
+                                  { "listing",        "runListingSuite" },
+                                  { "cache",          "runCacheSuite" },
+                                  { "registry",       "runRegistrySuite" },
+                                  { "faults",         "runFaultsSuite" },
+                                  { "soak",           "runSoakSuite" },
+                                  { NULL,             NULL }
+                                };
+
+//
+
+/*!
+  @function UVCBenchmarkSuiteWithName
+
+  Returns the suite named name, or NULL.
+*/
+static const UVCBenchmarkSuite*
+UVCBenchmarkSuiteWithName(
+  const char    *name
+)
+{
+  const UVCBenchmarkSuite *suite = UVCBenchmarkSuites;
+
+  while ( suite->name ) {
+    if ( strcmp(suite->name, name) == 0 ) return suite;
+    suite++;
+  }
+  return NULL;
+}
+
+//
+
+static int
+UVCBenchmarkCompareDoubles(
+  const void    *a,
+  const void    *b
+)
+{
+  double        A = *((const double*)a), B = *((const double*)b);
+
+  return ( A < B ) ? -1 : ((A > B) ? 1 : 0);
+}
+
+//
+#if 0
+#pragma mark - Type and value operations
+#endif
+//
+
+/*!
+  @typedef UVCBenchmarkTypeContext
+
+  Data shared by the type and value benchmark functions:  a two-field
+  (pan-tilt-abs) type with its limits, in raw buffers and as UVCValues.
+*/
+typedef struct {
+  UVCType       *type;
+  SInt32        value[2], minimum[2], maximum[2], stepSize[2], defaultValue[2];
+  SInt32        values[64][2];
+  char          text[128];
+  UVCValue      *uvcValue, *uvcMinimum, *uvcMaximum, *uvcStepSize, *uvcDefaultValue;
+} UVCBenchmarkTypeContext;
+
+static void
+UVCBenchmarkTypeWithCString(
+  void          *context,
+  NSUInteger    iterations
+)
+{
+  while ( iterations-- ) [UVCType uvcTypeWithCString:"{S4 pan; S4 tilt;}"];
+}
+
+static void
+UVCBenchmarkTypeWithCStringSingle(
+  void          *context,
+  NSUInteger    iterations
+)
+{
+  while ( iterations-- ) [UVCType uvcTypeWithCString:"{S2}"];
+}
+
+static void
+UVCBenchmarkTypeIndexOfFieldWithCString(
+  void                    *context,
+  NSUInteger              iterations
+)
+{
+  UVCBenchmarkTypeContext *C = (UVCBenchmarkTypeContext*)context;
+
+  while ( iterations-- ) [C->type indexOfFieldWithCString:"tilt" length:4];
+}
+
+static void
+UVCBenchmarkTypeIndexOfFieldWithName(
+  void                    *context,
+  NSUInteger              iterations
+)
+{
+  UVCBenchmarkTypeContext *C = (UVCBenchmarkTypeContext*)context;
+
+  while ( iterations-- ) [C->type indexOfFieldWithName:@"tilt"];
+}
+
+static void
+UVCBenchmarkTypeByteSwap(
+  void                    *context,
+  NSUInteger              iterations
+)
+{
+  UVCBenchmarkTypeContext *C = (UVCBenchmarkTypeContext*)context;
+
+  while ( iterations-- ) [C->type byteSwapHostToUSBEndian:C->value];
+}
+
+static void
+UVCBenchmarkTypeByteSwapLoop64(
+  void                    *context,
+  NSUInteger              iterations
+)
+{
+  UVCBenchmarkTypeContext *C = (UVCBenchmarkTypeContext*)context;
+  NSUInteger              i;
+
+  while ( iterations-- ) {
+    for ( i = 0; i < 64; i++ ) [C->type byteSwapHostToUSBEndian:C->values[i]];
+  }
+}
+
+static void
+UVCBenchmarkTypeByteSwapBuffer64(
+  void                    *context,
+  NSUInteger              iterations
+)
+{
+  UVCBenchmarkTypeContext *C = (UVCBenchmarkTypeContext*)context;
+
+  while ( iterations-- ) [C->type byteSwapBuffer:C->values count:64];
+}
+
+//
+
+/*!
+  @defined UVCBenchmarkByteSwapCheckCount
+
+  Number of consecutive values in each buffer checked by
+  UVCBenchmarkTypeByteSwapMismatches().
+*/
+#define UVCBenchmarkByteSwapCheckCount  3
+
+/*!
+  @typedef UVCBenchmarkByteSwapCheck
+
+  A type and the byte-swapped layout of one of its values:  byte i of the
+  swapped value must be byte permutation[i] of the original.
+*/
+typedef struct {
+  const char    *typeDescription;
+  NSUInteger    byteSize;
+  UInt8         permutation[20];
+} UVCBenchmarkByteSwapCheck;
+
+static const UVCBenchmarkByteSwapCheck UVCBenchmarkByteSwapChecks[] = {
+                // pan-tilt-rel:  single-byte fields only, left untouched
+                { "{S1 pan-relative; U1 pan-speed; S1 tilt-relative; U1 tilt-speed;}", 4,
+                  { 0, 1, 2, 3 } },
+                // window:  one run of six 2-byte fields
+                { "{U2 window-top; U2 window-left; U2 window-bottom; U2 window-right; U2 num-steps; M2 num-steps-units;}", 12,
+                  { 1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10 } },
+                // every width, with single-byte fields between the runs
+                { "{S1 a; U2 b; S2 c; S4 d; U1 e; S8 f; M2 g;}", 20,
+                  { 0, 2, 1, 4, 3, 8, 7, 6, 5, 9, 17, 16, 15, 14, 13, 12, 11, 10, 19, 18 } }
+              };
+
+/*!
+  @function UVCBenchmarkTypeByteSwapMismatches
+
+  Check byteSwapBuffer:count: (which swaps regardless of the host byte order)
+  against UVCBenchmarkByteSwapChecks:  a buffer of consecutive values must
+  match the expected layout byte for byte, and swapping it again must restore
+  the original.  Returns the number of bytes that did not match.
+*/
+static NSUInteger
+UVCBenchmarkTypeByteSwapMismatches(void)
+{
+  NSUInteger                      mismatches = 0;
+  NSUInteger                      i, iMax = sizeof(UVCBenchmarkByteSwapChecks) / sizeof(UVCBenchmarkByteSwapCheck);
+
+  for ( i = 0; i < iMax; i++ ) {
+    const UVCBenchmarkByteSwapCheck *check = &UVCBenchmarkByteSwapChecks[i];
+    UVCType                       *type = [UVCType uvcTypeWithCString:check->typeDescription];
+    UInt8                         original[UVCBenchmarkByteSwapCheckCount * 20], buffer[UVCBenchmarkByteSwapCheckCount * 20];
+    NSUInteger                    j, jMax = UVCBenchmarkByteSwapCheckCount * check->byteSize;
+
+    if ( ! type || ([type byteSize] != check->byteSize) ) {
+      mismatches += jMax;
+      continue;
+    }
+    for ( j = 0; j < jMax; j++ ) original[j] = buffer[j] = (UInt8)(0x11 * (j + 1));
+    [type byteSwapBuffer:buffer count:UVCBenchmarkByteSwapCheckCount];
+    for ( j = 0; j < jMax; j++ ) {
+      NSUInteger                  value = j - (j % check->byteSize);
+
+      if ( buffer[j] != original[value + check->permutation[j - value]] ) mismatches++;
+    }
+    [type byteSwapBuffer:buffer count:UVCBenchmarkByteSwapCheckCount];
+    for ( j = 0; j < jMax; j++ ) if ( buffer[j] != original[j] ) mismatches++;
+  }
+  return mismatches;
+}
+
+//
+
+static void
+UVCBenchmarkTypeFormatDefault(
+  void                    *context,
+  NSUInteger              iterations
+)
+{
+  UVCBenchmarkTypeContext *C = (UVCBenchmarkTypeContext*)context;
+
+  while ( iterations-- ) [C->type formatBuffer:C->value format:kUVCTypeFormatDefault intoCString:C->text length:sizeof(C->text)];
+}
+
+static void
+UVCBenchmarkTypeFormatJSON(
+  void                    *context,
+  NSUInteger              iterations
+)
+{
+  UVCBenchmarkTypeContext *C = (UVCBenchmarkTypeContext*)context;
+
+  while ( iterations-- ) [C->type formatBuffer:C->value format:kUVCTypeFormatJSON intoCString:C->text length:sizeof(C->text)];
+}
+
+static void
+UVCBenchmarkTypeFormatCSV(
+  void                    *context,
+  NSUInteger              iterations
+)
+{
+  UVCBenchmarkTypeContext *C = (UVCBenchmarkTypeContext*)context;
+
+  while ( iterations-- ) [C->type formatBuffer:C->value format:kUVCTypeFormatCSV intoCString:C->text length:sizeof(C->text)];
+}
+
+static void
+UVCBenchmarkTypeStringFromBuffer(
+  void                    *context,
+  NSUInteger              iterations
+)
+{
+  UVCBenchmarkTypeContext *C = (UVCBenchmarkTypeContext*)context;
+
+  while ( iterations-- ) [C->type stringFromBuffer:C->value];
+}
+
+static void
+UVCBenchmarkTypeScanPositional(
+  void                    *context,
+  NSUInteger              iterations
+)
+{
+  UVCBenchmarkTypeContext *C = (UVCBenchmarkTypeContext*)context;
+
+  while ( iterations-- ) [C->type scanCString:"{-3600, 36000}" intoBuffer:C->value flags:0];
+}
+
+static void
+UVCBenchmarkTypeScanNamedFractional(
+  void                    *context,
+  NSUInteger              iterations
+)
+{
+  UVCBenchmarkTypeContext *C = (UVCBenchmarkTypeContext*)context;
+
+  while ( iterations-- ) [C->type scanCString:"{tilt=0.52778, pan=-3600}" intoBuffer:C->value flags:0 minimum:C->minimum maximum:C->maximum];
+}
+
+static void
+UVCBenchmarkTypeScanKeywords(
+  void                    *context,
+  NSUInteger              iterations
+)
+{
+  UVCBenchmarkTypeContext *C = (UVCBenchmarkTypeContext*)context;
+
+  while ( iterations-- ) [C->type scanCString:"{tilt=minimum, pan=default}" intoBuffer:C->value flags:0 minimum:C->minimum maximum:C->maximum stepSize:C->stepSize defaultValue:C->defaultValue];
+}
+
+static void
+UVCBenchmarkTypeScanError(
+  void                    *context,
+  NSUInteger              iterations
+)
+{
+  UVCBenchmarkTypeContext *C = (UVCBenchmarkTypeContext*)context;
+  NSUInteger              errorOffset;
+
+  while ( iterations-- ) [C->type scanCString:"{pan=-3600, roll=5}" intoBuffer:C->value flags:0 minimum:C->minimum maximum:C->maximum stepSize:C->stepSize defaultValue:C->defaultValue errorOffset:&errorOffset];
+}
+
+static void
+UVCBenchmarkValueWithType(
+  void                    *context,
+  NSUInteger              iterations
+)
+{
+  UVCBenchmarkTypeContext *C = (UVCBenchmarkTypeContext*)context;
+
+  while ( iterations-- ) [UVCValue uvcValueWithType:C->type];
+}
+
+static void
+UVCBenchmarkValueScan(
+  void                    *context,
+  NSUInteger              iterations
+)
+{
+  UVCBenchmarkTypeContext *C = (UVCBenchmarkTypeContext*)context;
+
+  while ( iterations-- ) [C->uvcValue scanCString:"{-3600, 36000}" flags:0];
+}
+
+static void
+UVCBenchmarkValueScanLimits(
+  void                    *context,
+  NSUInteger              iterations
+)
+{
+  UVCBenchmarkTypeContext *C = (UVCBenchmarkTypeContext*)context;
+
+  while ( iterations-- ) [C->uvcValue scanCString:"{tilt=0.5, pan=default}" flags:0 minimum:C->uvcMinimum maximum:C->uvcMaximum stepSize:C->uvcStepSize defaultValue:C->uvcDefaultValue];
+}
+
+static void
+UVCBenchmarkValueFormatJSON(
+  void                    *context,
+  NSUInteger              iterations
+)
+{
+  UVCBenchmarkTypeContext *C = (UVCBenchmarkTypeContext*)context;
+
+  while ( iterations-- ) [C->uvcValue formatAs:kUVCTypeFormatJSON intoCString:C->text length:sizeof(C->text)];
+}
+
+static void
+UVCBenchmarkValueStringValue(
+  void                    *context,
+  NSUInteger              iterations
+)
+{
+  UVCBenchmarkTypeContext *C = (UVCBenchmarkTypeContext*)context;
+
+  while ( iterations-- ) [C->uvcValue stringValue];
+}
+
+static void
+UVCBenchmarkValueByteSwapRoundTrip(
+  void                    *context,
+  NSUInteger              iterations
+)
+{
+  UVCBenchmarkTypeContext *C = (UVCBenchmarkTypeContext*)context;
+
+  while ( iterations-- ) {
+    [C->uvcValue byteSwapHostToUSBEndian];
+    [C->uvcValue byteSwapUSBToHostEndian];
+  }
+}
+
+static void
+UVCBenchmarkValueCopy(
+  void                    *context,
+  NSUInteger              iterations
+)
+{
+  UVCBenchmarkTypeContext *C = (UVCBenchmarkTypeContext*)context;
+
+  while ( iterations-- ) [C->uvcValue copyValue:C->uvcDefaultValue];
+}
+
+/*!
+  @typedef UVCBenchmarkNamesContext
+
+  Data for the control name look-up functions:  a few names (one of them
+  not a control's) and an NSDictionary mapping every name to its index.
+*/
+typedef struct {
+  NSDictionary  *dictionary;
+  NSString      *names[4];
+} UVCBenchmarkNamesContext;
+
+static void
+UVCBenchmarkNamesPerfectHash(
+  void                      *context,
+  NSUInteger                iterations
+)
+{
+  UVCBenchmarkNamesContext  *C = (UVCBenchmarkNamesContext*)context;
+
+  while ( iterations-- ) UVCControlNameIndexForString(C->names[iterations & 3]);
+}
+
+static void
+UVCBenchmarkNamesDictionary(
+  void                      *context,
+  NSUInteger                iterations
+)
+{
+  UVCBenchmarkNamesContext  *C = (UVCBenchmarkNamesContext*)context;
+
+  while ( iterations-- ) [[C->dictionary objectForKey:C->names[iterations & 3]] unsignedIntegerValue];
+}
+
+//
+#if 0
+#pragma mark - Reference value scanner
+#endif
+//
+
+//
+// Converts a single component value; implemented in UVCType.m.
+//
+extern BOOL __UVCTypeComponentTypeScanf(const char *cString, UVCTypeComponentType theType, void *theValue, UVCTypeScanFlags flags, void *theMinimum, void *theMaximum, void *theStepSize, void *theDefaultValue, NSUInteger *nChar);
+
+/*!
+  @function UVCBenchmarkReferenceScanCString
+
+  The value parser UVCType used before the single-pass __UVCTypeScanCString()
+  replaced it, kept as the reference for UVCBenchmarkScanMismatches().  It
+  chooses named-value assignment if an '=' appears anywhere in the string,
+  and looks fields up through the UVCType methods.  The only change is that
+  the fields assigned by name are tracked in an array rather than a
+  CFBitVector, so the portable suites need nothing but Foundation.
+
+  Returns YES if every component field was set.
+*/
+static BOOL
+UVCBenchmarkReferenceScanCString(
+  UVCType     *type,
+  const char  *cString,
+  void        *buffer,
+  void        *minimum,
+  void        *maximum,
+  void        *stepSize,
+  void        *defaultValue
+)
+{
+  NSUInteger  fieldCount = [type fieldCount];
+  BOOL        rc = NO;
+  NSUInteger  nChar;
+
+  //
+  // We at least need to drop leading whitespace:
+  //
+  while ( isspace(*cString) ) cString++;
+
+  //
+  // If the string doesn't lead with a brace...
+  //
+  if ( *cString != '{' ) {
+    //
+    // If it's "default," "minimum," or "maximum" then set the WHOLE THING to
+    // the corresponding limit:
+    //
+    if ( strncasecmp(cString, "default", 7) == 0 ) {
+      if ( defaultValue ) {
+        memcpy(buffer, defaultValue, [type byteSize]);
+        rc = YES;
+      }
+    }
+    if ( strncasecmp(cString, "minimum", 7) == 0 ) {
+      if ( minimum ) {
+        memcpy(buffer, minimum, [type byteSize]);
+        rc = YES;
+      }
+    }
+    if ( strncasecmp(cString, "maximum", 7) == 0 ) {
+      if ( maximum ) {
+        memcpy(buffer, maximum, [type byteSize]);
+        rc = YES;
+      }
+    }
+    if ( fieldCount == 1 ) {
+      //
+      // ...we have a single field, so try just scanning its value:
+      //
+      rc = __UVCTypeComponentTypeScanf(cString, [type fieldTypeAtIndex:0], buffer, 0, minimum, maximum, stepSize, defaultValue, &nChar);
+    }
+  } else {
+    BOOL        usesNamedValues = strchr(cString, '=') ? YES : NO;
+    NSUInteger  fieldIdx = 0;
+    BOOL        fieldsUsed[fieldCount];
+
+    memset(fieldsUsed, 0, sizeof(fieldsUsed));
+
+    // Skip-over the brace:
+    cString++;
+    while ( *cString && (fieldIdx < fieldCount) ) {
+      NSUInteger  fieldOffset;
+
+      //
+      // When doing named values, read the field name first:
+      //
+      if ( usesNamedValues ) {
+        // Drop leading whitespace:
+        while ( isspace(*cString) ) cString++;
+
+        // Isolate the name:
+        const char      *namePtr = cString;
+        while ( *cString && (*cString != '=') ) cString++;
+
+        NSUInteger      nameLen = cString - namePtr;
+
+        if ( *cString == '=' ) cString++;
+        fieldIdx = [type indexOfFieldWithCString:namePtr length:nameLen];
+        if ( fieldIdx == UVCTypeInvalidIndex ) return NO;
+      }
+
+      fieldOffset = [type offsetToFieldAtIndex:fieldIdx];
+
+      // Scan a value:
+      BOOL        scanned = __UVCTypeComponentTypeScanf(
+                                  cString,
+                                  [type fieldTypeAtIndex:fieldIdx],
+                                  buffer + fieldOffset,
+                                  0,
+                                  minimum ? minimum + fieldOffset : NULL,
+                                  maximum ? maximum + fieldOffset : NULL,
+                                  stepSize ? stepSize + fieldOffset : NULL,
+                                  defaultValue ? defaultValue + fieldOffset : NULL,
+                                  &nChar
+                                );
+      if ( ! scanned ) break;
+
+      // Skip trailing whitespace/commas:
+      cString += nChar;
+      while ( isspace(*cString) || (*cString == ',') ) cString++;
+
+      // If not doing named values, increase the field index; for named-values,
+      // make note of the fact that we set the value at this index:
+      if ( ! usesNamedValues ) {
+        fieldIdx++;
+      } else {
+        fieldsUsed[fieldIdx] = YES;
+      }
+
+      // If the closing brace, then exit:
+      if ( *cString == '}' ) break;
+    }
+    if ( usesNamedValues ) {
+      rc = YES;
+      for ( fieldIdx = 0; fieldIdx < fieldCount; fieldIdx++ ) if ( ! fieldsUsed[fieldIdx] ) rc = NO;
+    } else if ( fieldIdx >= fieldCount ) {
+      rc = YES;
+    }
+  }
+  return rc;
+}
+
+//
+
+/*!
+  @defined UVCBenchmarkScanFuzzCount
+
+  Number of generated strings each type is scanned with by
+  UVCBenchmarkScanMismatches().
+*/
+#define UVCBenchmarkScanFuzzCount   20000
+
+/*!
+  @defined UVCBenchmarkScanFuzzSeed
+
+  Fixed seed of the string generator, so every run scans the same strings
+  and a mismatch can be reproduced.
+*/
+#define UVCBenchmarkScanFuzzSeed    0x5556432d7574696cULL
+
+/*!
+  @var UVCBenchmarkScanFuzzTokens
+
+  The pieces generated strings are assembled from:  value syntax, names of
+  fields (in any case) of the types being scanned and of none, well- and
+  ill-formed numbers, and the limit keywords.
+*/
+static const char *UVCBenchmarkScanFuzzTokens[] = {
+                      "{", "}", ",", "=", " ", "\t",
+                      "pan", "TILT", "a", "b", "c", "zoom", "",
+                      "0", "1", "-1", "255", "256", "-129", "65536", "-3600", "36000", "648000", "-648001",
+                      "0x1f", "0X", "0.5", "-0.25", "1.", ".5", "1e3", "+7", "--1", "99999999999999999999",
+                      "default", "minimum", "maximum", "DEFAULT", "min", "y", "true"
+                    };
+
+/*!
+  @var UVCBenchmarkScanFuzzTypes
+
+  Descriptions of the types the generated strings are scanned as.
+*/
+static const char *UVCBenchmarkScanFuzzTypes[] = {
+                      "{S4 pan; S4 tilt;}",
+                      "{S2}",
+                      "{U1}",
+                      "{U2 a; M2 b; S1 c;}"
+                    };
+
+static inline UInt64
+UVCBenchmarkScanFuzzRandom(
+  UInt64    *state
+)
+{
+  // xorshift64*
+  *state ^= *state >> 12;
+  *state ^= *state << 25;
+  *state ^= *state >> 27;
+  return *state * 0x2545f4914f6cdd1dULL;
+}
+
+/*!
+  @function UVCBenchmarkScanMismatches
+
+  Differential fuzzing of the value parser:  strings assembled at random
+  from UVCBenchmarkScanFuzzTokens -- half of them shaped like a braced list
+  of values or name=value pairs -- are scanned as each of the
+  UVCBenchmarkScanFuzzTypes, with and without limits, by both
+  scanCString:...errorOffset: and UVCBenchmarkReferenceScanCString().
+
+  The two must accept and reject the same strings and, when they accept,
+  produce the same value; a rejection must report an error offset inside
+  the string.  Returns the number of strings for which that did not hold.
+  Set the UVC_BENCHMARK_FUZZ_VERBOSE environment variable to have each of
+  them written to stderr.
+*/
+static NSUInteger
+UVCBenchmarkScanMismatches(void)
+{
+  BOOL            isVerbose = ( getenv("UVC_BENCHMARK_FUZZ_VERBOSE") != NULL );
+  UInt64          state = UVCBenchmarkScanFuzzSeed;
+  NSUInteger      mismatches = 0;
+  NSUInteger      tokenCount = sizeof(UVCBenchmarkScanFuzzTokens) / sizeof(const char*);
+  NSUInteger      t, tMax = sizeof(UVCBenchmarkScanFuzzTypes) / sizeof(const char*);
+  UInt8           minimum[16], maximum[16], stepSize[16], defaultValue[16];
+  UInt8           buffer[16], referenceBuffer[16];
+  char            cString[512];
+
+  memset(minimum, 0x80, sizeof(minimum));
+  memset(maximum, 0x7f, sizeof(maximum));
+  memset(stepSize, 0x01, sizeof(stepSize));
+  memset(defaultValue, 0x00, sizeof(defaultValue));
+  for ( t = 0; t < tMax; t++ ) {
+    UVCType       *type = [UVCType uvcTypeWithCString:UVCBenchmarkScanFuzzTypes[t]];
+    NSUInteger    i;
+
+    if ( ! type ) {
+      mismatches++;
+      continue;
+    }
+    for ( i = 0; i < UVCBenchmarkScanFuzzCount; i++ ) {
+      UInt64      r = UVCBenchmarkScanFuzzRandom(&state);
+      BOOL        hasLimits = ( (r & 1) != 0 ), isShaped = ( (r & 2) != 0 );
+      NSUInteger  n = 0, tokenIdx, tokenMax = 1 + ((r >> 2) % 12);
+      BOOL        isOk, isReferenceOk;
+      NSUInteger  errorOffset = NSNotFound;
+
+      if ( isShaped ) n += snprintf(cString + n, sizeof(cString) - n, "{");
+      for ( tokenIdx = 0; (tokenIdx < tokenMax) && (n < sizeof(cString)); tokenIdx++ ) {
+        const char  *token = UVCBenchmarkScanFuzzTokens[UVCBenchmarkScanFuzzRandom(&state) % tokenCount];
+
+        if ( isShaped ) {
+          //
+          // A value or a name=value pair, separated from the previous one:
+          //
+          if ( tokenIdx ) n += snprintf(cString + n, sizeof(cString) - n, ",");
+          if ( (UVCBenchmarkScanFuzzRandom(&state) & 1) && (n < sizeof(cString)) ) {
+            n += snprintf(cString + n, sizeof(cString) - n, "%s=", [[type fieldNameAtIndex:UVCBenchmarkScanFuzzRandom(&state) % [type fieldCount]] UTF8String]);
+          }
+        }
+        if ( n < sizeof(cString) ) n += snprintf(cString + n, sizeof(cString) - n, "%s", token);
+      }
+      if ( isShaped && (n < sizeof(cString)) ) snprintf(cString + n, sizeof(cString) - n, "}");
+
+      memset(buffer, 0xa5, sizeof(buffer));
+      memset(referenceBuffer, 0xa5, sizeof(referenceBuffer));
+      isOk = ( [type scanCString:cString
+                      intoBuffer:buffer
+                      flags:0
+                      minimum:(hasLimits ? minimum : NULL)
+                      maximum:(hasLimits ? maximum : NULL)
+                      stepSize:(hasLimits ? stepSize : NULL)
+                      defaultValue:(hasLimits ? defaultValue : NULL)
+                      errorOffset:&errorOffset
+                    ] == kUVCTypeScanOk );
+      isReferenceOk = UVCBenchmarkReferenceScanCString(type, cString, referenceBuffer,
+                                (hasLimits ? minimum : NULL),
+                                (hasLimits ? maximum : NULL),
+                                (hasLimits ? stepSize : NULL),
+                                (hasLimits ? defaultValue : NULL)
+                              );
+      if ( (isOk != isReferenceOk) || (isOk && memcmp(buffer, referenceBuffer, [type byteSize])) || (! isOk && (errorOffset > strlen(cString))) ) {
+        if ( isVerbose ) fprintf(stderr, "%s \"%s\" (limits %s):  scanned %s, reference %s, error offset %ld\n", UVCBenchmarkScanFuzzTypes[t], cString, (hasLimits ? "yes" : "no"), (isOk ? "ok" : "failed"), (isReferenceOk ? "ok" : "failed"), (long)errorOffset);
+        mismatches++;
+      }
+    }
+  }
+  return mismatches;
+}
+
+//
+#if 0
+#pragma mark -
+#endif
+//
+
+@interface UVCBenchmark(UVCBenchmarkPrivate)
+
+- (id) initWithStream:(FILE*)stream;
+
+/*!
+  @method writeResultNamed:unit:value:minimum:maximum:iterations:higherIsBetter:limit:
+
+  Write one entry of the results array, comparing it with the baseline and,
+  if limit is finite, with limit.  The minimum, maximum, and iterations are
+  only written for timed results (iterations greater than zero).
+*/
+- (void) writeResultNamed:(const char*)name unit:(const char*)unit value:(double)value minimum:(double)minimum maximum:(double)maximum iterations:(NSUInteger)iterations higherIsBetter:(BOOL)higherIsBetter limit:(double)limit;
+
+/*!
+  @method prepareTypeContext:
+
+  Fill-in context with the pan-tilt-abs type, its limits, and sample values.
+*/
+- (void) prepareTypeContext:(UVCBenchmarkTypeContext*)context;
+
+- (void) runTypeSuite;
+- (void) runValueSuite;
+- (void) runNamesSuite;
+
+@end
+
+@implementation UVCBenchmark(UVCBenchmarkPrivate)
+
+  - (id) initWithStream:(FILE*)stream
+  {
+    if ( (self = [super init]) ) {
+      _stream = stream;
+      _sampleCount = UVCBenchmarkDefaultSampleCount;
+      _minimumSampleTime = UVCBenchmarkDefaultMinimumSampleTime;
+      _tolerance = UVCBenchmarkDefaultTolerance;
+    }
+    return self;
+  }
+
+//
+
+  - (void) writeResultNamed:(const char*)name
+    unit:(const char*)unit
+    value:(double)value
+    minimum:(double)minimum
+    maximum:(double)maximum
+    iterations:(NSUInteger)iterations
+    higherIsBetter:(BOOL)higherIsBetter
+    limit:(double)limit
+  {
+    char              fullName[128];
+    NSNumber          *baseline;
+
+    snprintf(fullName, sizeof(fullName), "%s.%s", _suiteName, name);
+    fprintf(_stream, "%s\n  {\"suite\":\"%s\",\"name\":\"%s\",\"unit\":\"%s\",\"value\":%.3f", (_resultCount++ ? "," : ""), _suiteName, fullName, unit, value);
+    if ( iterations ) fprintf(_stream, ",\"min\":%.3f,\"max\":%.3f,\"iterations\":%lu", minimum, maximum, (unsigned long)iterations);
+    if ( _baseline && (baseline = [_baseline objectForKey:[NSString stringWithUTF8String:fullName]]) && ([baseline doubleValue] != 0.0) ) {
+      double          change = (value - [baseline doubleValue]) / [baseline doubleValue];
+
+      fprintf(_stream, ",\"baseline\":%.3f,\"change\":%.4f", [baseline doubleValue], change);
+      if ( (higherIsBetter ? -change : change) > _tolerance ) {
+        fprintf(_stream, ",\"regression\":true");
+        _regressionCount++;
+      }
+    }
+    if ( isfinite(limit) ) {
+      fprintf(_stream, ",\"limit\":%.3f", limit);
+      if ( (higherIsBetter ? (value < limit) : (value > limit)) ) {
+        fprintf(_stream, ",\"exceeded\":true");
+        _regressionCount++;
+      }
+    }
+    fputc('}', _stream);
+    fflush(_stream);
+  }
+
+//
+
+  - (void) prepareTypeContext:(UVCBenchmarkTypeContext*)context
+  {
+    NSUInteger        i;
+
+    memset(context, 0, sizeof(*context));
+    context->type = [UVCType uvcTypeWithCString:"{S4 pan; S4 tilt;}"];
+    context->minimum[0] = context->minimum[1] = -648000;
+    context->maximum[0] = context->maximum[1] = 648000;
+    context->stepSize[0] = context->stepSize[1] = 3600;
+    context->value[0] = -3600; context->value[1] = 36000;
+    for ( i = 0; i < 64; i++ ) {
+      context->values[i][0] = (SInt32)(i * 3600);
+      context->values[i][1] = -(SInt32)(i * 3600);
+    }
+    context->uvcValue = [UVCValue uvcValueWithType:context->type];
+    context->uvcMinimum = [UVCValue uvcValueWithType:context->type];
+    context->uvcMaximum = [UVCValue uvcValueWithType:context->type];
+    context->uvcStepSize = [UVCValue uvcValueWithType:context->type];
+    context->uvcDefaultValue = [UVCValue uvcValueWithType:context->type];
+    memcpy([context->uvcMinimum valuePtr], context->minimum, sizeof(context->minimum));
+    memcpy([context->uvcMaximum valuePtr], context->maximum, sizeof(context->maximum));
+    memcpy([context->uvcStepSize valuePtr], context->stepSize, sizeof(context->stepSize));
+    memcpy([context->uvcDefaultValue valuePtr], context->defaultValue, sizeof(context->defaultValue));
+    memcpy([context->uvcValue valuePtr], context->value, sizeof(context->value));
+  }
+
+//
+
+  - (void) runTypeSuite
+  {
+    UVCBenchmarkTypeContext   context;
+
+    [self prepareTypeContext:&context];
+
+    // Correctness first:  any mismatch counts as a regression.
+    [self recordValue:(double)UVCBenchmarkTypeByteSwapMismatches() unit:"bytes" limit:0.0 forName:"byteSwapBuffer.mismatches"];
+    [self recordValue:(double)UVCBenchmarkScanMismatches() unit:"strings" limit:0.0 forName:"scanCString.referenceMismatches"];
+
+    [self measure:"uvcTypeWithCString" function:UVCBenchmarkTypeWithCString context:&context];
+    [self measure:"uvcTypeWithCString.single" function:UVCBenchmarkTypeWithCStringSingle context:&context];
+    [self measure:"indexOfFieldWithCString" function:UVCBenchmarkTypeIndexOfFieldWithCString context:&context];
+    [self measure:"indexOfFieldWithName" function:UVCBenchmarkTypeIndexOfFieldWithName context:&context];
+    [self measure:"byteSwapHostToUSBEndian" function:UVCBenchmarkTypeByteSwap context:&context];
+    [self measure:"byteSwapHostToUSBEndian.loop64" function:UVCBenchmarkTypeByteSwapLoop64 context:&context];
+    [self measure:"byteSwapBuffer.count64" function:UVCBenchmarkTypeByteSwapBuffer64 context:&context];
+    [self measure:"formatBuffer.default" function:UVCBenchmarkTypeFormatDefault context:&context];
+    [self measure:"formatBuffer.json" function:UVCBenchmarkTypeFormatJSON context:&context];
+    [self measure:"formatBuffer.csv" function:UVCBenchmarkTypeFormatCSV context:&context];
+    [self measure:"stringFromBuffer" function:UVCBenchmarkTypeStringFromBuffer context:&context];
+    [self measure:"scanCString.positional" function:UVCBenchmarkTypeScanPositional context:&context];
+    [self measure:"scanCString.namedFractional" function:UVCBenchmarkTypeScanNamedFractional context:&context];
+    [self measure:"scanCString.keywords" function:UVCBenchmarkTypeScanKeywords context:&context];
+    [self measure:"scanCString.unknownField" function:UVCBenchmarkTypeScanError context:&context];
+  }
+
+//
+
+  - (void) runValueSuite
+  {
+    UVCBenchmarkTypeContext   context;
+
+    [self prepareTypeContext:&context];
+    [self measure:"uvcValueWithType" function:UVCBenchmarkValueWithType context:&context];
+    [self measure:"scanCString" function:UVCBenchmarkValueScan context:&context];
+    [self measure:"scanCString.limits" function:UVCBenchmarkValueScanLimits context:&context];
+    [self measure:"formatAs.json" function:UVCBenchmarkValueFormatJSON context:&context];
+    [self measure:"stringValue" function:UVCBenchmarkValueStringValue context:&context];
+    [self measure:"byteSwap.roundTrip" function:UVCBenchmarkValueByteSwapRoundTrip context:&context];
+    [self measure:"copyValue" function:UVCBenchmarkValueCopy context:&context];
+  }
+
+//
+
+  - (void) runNamesSuite
+  {
+    UVCBenchmarkNamesContext  context;
+    NSMutableDictionary       *dictionary = [NSMutableDictionary dictionary];
+    NSUInteger                i;
+
+    for ( i = 0; i < UVCControlNameCount; i++ ) [dictionary setObject:[NSNumber numberWithUnsignedInteger:i] forKey:[NSString stringWithUTF8String:UVCControlNames[i]]];
+    context.dictionary = dictionary;
+    context.names[0] = @"brightness";
+    context.names[1] = @"pan-tilt-abs";
+    context.names[2] = @"white-balance-temp";
+    context.names[3] = @"no-such-control";
+
+    // What +[UVCController controlIndexForString:] does, vs. an NSDictionary:
+    [self measure:"controlIndexForString" function:UVCBenchmarkNamesPerfectHash context:&context];
+    [self measure:"controlIndexForString.nsdictionary" function:UVCBenchmarkNamesDictionary context:&context];
+  }
+
+@end
+
+//
+#if 0
+#pragma mark -
+#endif
+//
+
+@implementation UVCBenchmark
+
+  + (UVCBenchmark*) benchmarkWithStream:(FILE*)stream
+  {
+    return [[[UVCBenchmark alloc] initWithStream:stream] autorelease];
+  }
+
+//
+
+  + (NSArray*) suiteNames
+  {
+    NSMutableArray          *suiteNames = [NSMutableArray array];
+    const UVCBenchmarkSuite *suite = UVCBenchmarkSuites;
+
+    while ( suite->name ) {
+      if ( [self instancesRespondToSelector:NSSelectorFromString([NSString stringWithUTF8String:suite->selectorName])] ) {
+        [suiteNames addObject:[NSString stringWithUTF8String:suite->name]];
+      }
+      suite++;
+    }
+    return suiteNames;
+  }
+
+//
+
+  - (void) dealloc
+  {
+    if ( _baseline ) [_baseline release];
+    [super dealloc];
+  }
+
+//
+
+  - (NSString*) description
+  {
+    return [NSString stringWithFormat:@"UVCBenchmark@%p { sample-count: %lu; minimum-sample-time: %g; tolerance: %g; baseline: %s }",
+                        self,
+                        (unsigned long)_sampleCount,
+                        _minimumSampleTime,
+                        _tolerance,
+                        ( _baseline ? "yes" : "no" )
+                      ];
+  }
+
+//
+
+  - (NSUInteger) sampleCount
+  {
+    return _sampleCount;
+  }
+  - (void) setSampleCount:(NSUInteger)sampleCount
+  {
+    _sampleCount = ( sampleCount ? sampleCount : 1 );
+  }
+
+//
+
+  - (NSTimeInterval) minimumSampleTime
+  {
+    return _minimumSampleTime;
+  }
+  - (void) setMinimumSampleTime:(NSTimeInterval)minimumSampleTime
+  {
+    if ( minimumSampleTime > 0.0 ) _minimumSampleTime = minimumSampleTime;
+  }
+
+//
+
+  - (double) tolerance
+  {
+    return _tolerance;
+  }
+  - (void) setTolerance:(double)tolerance
+  {
+    if ( tolerance >= 0.0 ) _tolerance = tolerance;
+  }
+
+//
+
+  - (BOOL) loadBaselineFromFile:(NSString*)path
+  {
+    NSData                *data = [NSData dataWithContentsOfFile:path];
+    id                    results;
+
+    if ( data && (results = [NSJSONSerialization JSONObjectWithData:data options:0 error:NULL]) && [results isKindOfClass:[NSDictionary class]] ) {
+      NSMutableDictionary *baseline = [NSMutableDictionary dictionary];
+      NSEnumerator        *eResults;
+      NSDictionary        *result;
+
+      results = [results objectForKey:@"results"];
+      if ( ! [results isKindOfClass:[NSArray class]] ) return NO;
+      eResults = [results objectEnumerator];
+      while ( (result = [eResults nextObject]) ) {
+        if ( [result isKindOfClass:[NSDictionary class]] ) {
+          id              name = [result objectForKey:@"name"];
+          id              value = [result objectForKey:@"value"];
+
+          if ( [name isKindOfClass:[NSString class]] && [value isKindOfClass:[NSNumber class]] ) [baseline setObject:value forKey:name];
+        }
+      }
+      if ( _baseline ) [_baseline release];
+      _baseline = [baseline copy];
+      return YES;
+    }
+    return NO;
+  }
+
+//
+
+  - (int) runSuitesWithNames:(NSArray*)suiteNames
+  {
+    NSArray                 *available = [UVCBenchmark suiteNames];
+    NSEnumerator            *eNames;
+    NSString                *name;
+
+    if ( ! suiteNames ) suiteNames = available;
+    eNames = [suiteNames objectEnumerator];
+    while ( (name = [eNames nextObject]) ) {
+      if ( ! [available containsObject:name] ) return ENOENT;
+    }
+
+    _resultCount = _regressionCount = 0;
+    fprintf(_stream, "{\"benchmark\":\"uvc-util\",\"sample-count\":%lu,\"minimum-sample-time\":%g,\"results\":[", (unsigned long)_sampleCount, _minimumSampleTime);
+    eNames = [suiteNames objectEnumerator];
+    while ( (name = [eNames nextObject]) ) {
+      NSAutoreleasePool     *pool = [[NSAutoreleasePool alloc] init];
+      const UVCBenchmarkSuite *suite = UVCBenchmarkSuiteWithName([name UTF8String]);
+
+      _suiteName = suite->name;
+      [self performSelector:NSSelectorFromString([NSString stringWithUTF8String:suite->selectorName])];
+      [pool drain];
+    }
+    _suiteName = NULL;
+    fprintf(_stream, "\n],\"regression-count\":%lu}\n", (unsigned long)_regressionCount);
+    fflush(_stream);
+    return 0;
+  }
+
+//
+
+  - (NSUInteger) regressionCount
+  {
+    return _regressionCount;
+  }
+
+//
+
+  - (void) measure:(const char*)name
+    function:(UVCBenchmarkFunction)function
+    context:(void*)context
+  {
+    NSUInteger        iterations = 1, i;
+    double            samples[_sampleCount];
+    NSTimeInterval    elapsed;
+
+    // Calibrate:  the warm-up samples also bring caches and lazily-built state up to speed:
+    while ( 1 ) {
+      NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+      NSTimeInterval    startTime = [NSDate timeIntervalSinceReferenceDate];
+
+      function(context, iterations);
+      elapsed = [NSDate timeIntervalSinceReferenceDate] - startTime;
+      [pool drain];
+      if ( (elapsed >= _minimumSampleTime) || (iterations >= (NSUIntegerMax >> 2)) ) break;
+      iterations *= 2;
+    }
+    for ( i = 0; i < _sampleCount; i++ ) {
+      NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+      NSTimeInterval    startTime = [NSDate timeIntervalSinceReferenceDate];
+
+      function(context, iterations);
+      samples[i] = 1e9 * ([NSDate timeIntervalSinceReferenceDate] - startTime) / iterations;
+      [pool drain];
+    }
+    qsort(samples, _sampleCount, sizeof(double), UVCBenchmarkCompareDoubles);
+    [self writeResultNamed:name unit:"ns/op" value:samples[_sampleCount / 2] minimum:samples[0] maximum:samples[_sampleCount - 1] iterations:iterations higherIsBetter:NO limit:HUGE_VAL];
+  }
+
+//
+
+  - (void) recordValue:(double)value
+    unit:(const char*)unit
+    higherIsBetter:(BOOL)higherIsBetter
+    forName:(const char*)name
+  {
+    [self writeResultNamed:name unit:unit value:value minimum:0.0 maximum:0.0 iterations:0 higherIsBetter:higherIsBetter limit:HUGE_VAL];
+  }
+
+//
+
+  - (void) recordValue:(double)value
+    unit:(const char*)unit
+    limit:(double)limit
+    forName:(const char*)name
+  {
+    [self writeResultNamed:name unit:unit value:value minimum:0.0 maximum:0.0 iterations:0 higherIsBetter:NO limit:limit];
+  }
+
+@end
@@ -0,0 +1,159 @@
+//
+//  UVCCapabilityCache.h
+//
+//  Persistent on-disk cache of UVC control capabilities and limits.
+//
+//  Copyright © 2016
+//  Dr. Jeffrey Frey, IT-NSS
+//  University of Delaware
+//
+// $Id$
+//
+
+#import <Foundation/Foundation.h>
+
+/*!
+  @defined UVCCapabilityCacheMaxValueSize
+
+  Largest control value (in bytes) that a cache record can hold.  The largest
+  control implemented by UVCController (CT_WINDOW_CONTROL) occupies 12 bytes.
+*/
+#define UVCCapabilityCacheMaxValueSize  16
+
+/*!
+  @enum UVC capability cache value slots
+
+  Index of each of the limit values held in a cache record.
+*/
+enum {
+  kUVCCapabilityCacheValueMinimum       = 0,
+  kUVCCapabilityCacheValueMaximum       = 1,
+  kUVCCapabilityCacheValueStepSize      = 2,
+  kUVCCapabilityCacheValueDefault       = 3,
+  kUVCCapabilityCacheValueCount         = 4
+};
+
+/*!
+  @function UVCCapabilityCacheHashBytes
+
+  Computes the 64-bit FNV-1a hash of length bytes at bytes.  Used to derive
+  a key for a device's VideoControl descriptor block.
+*/
+UInt64 UVCCapabilityCacheHashBytes(const void *bytes, NSUInteger length);
+
+/*!
+  @class UVCCapabilityCache
+  @abstract Versioned binary cache of control capabilities and limits.
+
+  Instantiating a UVCControl normally costs five control transfers (GET_INFO,
+  GET_MIN, GET_MAX, GET_RES, and GET_DEF).  Since those values are fixed for
+  a given device model and firmware, an instance of this class records them
+  in a file so that subsequent runs of the program can skip the transfers.
+
+  Cache files are keyed by vendor- and product-id, UVC version, and a hash of
+  the device's VideoControl descriptor block.  The file consists of a fixed
+  header followed by one fixed-size record per control index, so lookups are
+  performed directly against a memory-mapped copy of the file.  Values are
+  stored in host byte order; the header records the byte order and a file
+  written on a host of the other endianness is ignored.
+
+  Modifications are held in memory until the synchronize method is called.
+*/
+@interface UVCCapabilityCache : NSObject
+{
+  NSString        *_path;
+  NSData          *_mappedData;
+  NSMutableData   *_updatedData;
+  NSUInteger      _controlCount;
+  BOOL            _isDirty;
+}
+
+/*!
+  @method isCachingEnabled
+
+  Returns YES if capability caching is enabled for this process (the
+  default).
+*/
++ (BOOL) isCachingEnabled;
+
+/*!
+  @method setIsCachingEnabled:
+
+  Enable or disable capability caching for this process.  When disabled,
+  the capabilityCacheFor... method returns nil.
+*/
++ (void) setIsCachingEnabled:(BOOL)isCachingEnabled;
+
+/*!
+  @method cacheDirectory
+
+  Returns the path of the directory in which cache files are kept
+  (~/Library/Caches/uvc-util).
+*/
++ (NSString*) cacheDirectory;
+
+/*!
+  @method invalidateAllCaches
+
+  Removes every cache file from the cacheDirectory.  Returns YES if
+  successful.
+*/
++ (BOOL) invalidateAllCaches;
+
+/*!
+  @method capabilityCacheForVendorId:productId:uvcVersion:descriptorHash:controlCount:
+
+  Returns an autoreleased instance of the class that is backed by the cache
+  file for the given device identity.  If the file does not exist (or is stale)
+  the returned instance is empty and will create the file when synchronized.
+
+  Returns nil if caching has been disabled.
+*/
++ (UVCCapabilityCache*) capabilityCacheForVendorId:(UInt16)vendorId productId:(UInt16)productId uvcVersion:(UInt16)uvcVersion descriptorHash:(UInt64)descriptorHash controlCount:(NSUInteger)controlCount;
+
+/*!
+  @method path
+
+  Returns the path of the receiver's cache file.
+*/
+- (NSString*) path;
+
+/*!
+  @method lookupControlAtIndex:isAvailable:capabilities:byteSize:values:
+
+  If the receiver holds a record for the given control index, returns YES and
+  sets isAvailable to indicate whether or not the device answered GET_INFO for
+  the control.  For available controls, capabilities is set and the non-NULL
+  entries of the values array (indexed by the kUVCCapabilityCacheValue*
+  constants) are filled-in with byteSize bytes each.
+
+  Returns NO if there is no record or if the record's value size does not
+  match byteSize.
+*/
+- (BOOL) lookupControlAtIndex:(NSUInteger)controlIndex isAvailable:(BOOL*)isAvailable capabilities:(NSUInteger*)capabilities byteSize:(NSUInteger)byteSize values:(void**)values;
+
+/*!
+  @method storeControlAtIndex:isAvailable:capabilities:byteSize:values:
+
+  Record the capabilities and limits for the given control index.  The values
+  array is indexed by the kUVCCapabilityCacheValue* constants; NULL entries are
+  stored as zeroes (the capabilities indicate which values are meaningful).
+*/
+- (void) storeControlAtIndex:(NSUInteger)controlIndex isAvailable:(BOOL)isAvailable capabilities:(NSUInteger)capabilities byteSize:(NSUInteger)byteSize values:(void**)values;
+
+/*!
+  @method synchronize
+
+  If the receiver has been modified, atomically write its contents to the
+  cache file.  Returns YES if successful (or nothing needed writing).
+*/
+- (BOOL) synchronize;
+
+/*!
+  @method invalidate
+
+  Discard all records held by the receiver and remove its cache file.
+*/
+- (void) invalidate;
+
+@end
@@ -0,0 +1,364 @@
+//
+//  UVCCapabilityCache.m
+//
+//  Persistent on-disk cache of UVC control capabilities and limits.
+//
+//  Copyright © 2016
+//  Dr. Jeffrey Frey, IT-NSS
+//  University of Delaware
+//
+// $Id$
+//
+
+#import "UVCCapabilityCache.h"
+
+//
+// Cache file format:
+//
+#define UVC_CAPABILITY_CACHE_MAGIC      0x55564343    /* 'UVCC' */
+#define UVC_CAPABILITY_CACHE_VERSION    1
+#define UVC_CAPABILITY_CACHE_BYTE_ORDER 0x1234
+
+typedef struct {
+  UInt32              magic;
+  UInt16              version;
+  UInt16              byteOrder;
+  UInt16              vendorId;
+  UInt16              productId;
+  UInt16              uvcVersion;
+  UInt16              controlCount;
+  UInt64              descriptorHash;
+  UInt32              recordSize;
+  UInt32              reserved;
+} __attribute__((packed)) UVCCapabilityCacheHeader;
+
+/*!
+  @enum UVC capability cache record flags
+*/
+enum {
+  kUVCCapabilityCacheRecordIsValid        = 1 << 0,
+  kUVCCapabilityCacheRecordIsAvailable    = 1 << 1
+};
+
+typedef struct {
+  UInt32              flags;
+  UInt32              capabilities;
+  UInt16              byteSize;
+  UInt16              reserved;
+  UInt8               values[kUVCCapabilityCacheValueCount][UVCCapabilityCacheMaxValueSize];
+} __attribute__((packed)) UVCCapabilityCacheRecord;
+
+//
+
+UInt64
+UVCCapabilityCacheHashBytes(
+  const void    *bytes,
+  NSUInteger    length
+)
+{
+  const UInt8   *p = (const UInt8*)bytes;
+  UInt64        hash = 0xcbf29ce484222325ULL;
+
+  while ( length-- ) {
+    hash ^= *p++;
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+//
+
+static BOOL UVCCapabilityCacheIsEnabled = YES;
+static NSString *UVCCapabilityCacheSharedDirectory = nil;
+
+//
+#if 0
+#pragma mark -
+#endif
+//
+
+@interface UVCCapabilityCache(UVCCapabilityCachePrivate)
+
+/*!
+  @method initWithPath:header:
+
+  Designated initializer.  If the file at path is present and its header
+  matches the given header, the file is mapped into memory and used as the
+  initial content of the receiver.
+*/
+- (id) initWithPath:(NSString*)path header:(UVCCapabilityCacheHeader*)header;
+
+/*!
+  @method recordAtIndex:
+
+  Returns a pointer to the record for the given control index in the
+  receiver's current data, or NULL if out of range.
+*/
+- (const UVCCapabilityCacheRecord*) recordAtIndex:(NSUInteger)controlIndex;
+
+@end
+
+@implementation UVCCapabilityCache(UVCCapabilityCachePrivate)
+
+  - (id) initWithPath:(NSString*)path
+    header:(UVCCapabilityCacheHeader*)header
+  {
+    if ( (self = [super init]) ) {
+      NSUInteger    expectedLength = sizeof(UVCCapabilityCacheHeader) + header->controlCount * sizeof(UVCCapabilityCacheRecord);
+
+      _path = [path copy];
+      _controlCount = header->controlCount;
+      _mappedData = [[NSData alloc] initWithContentsOfFile:path options:NSDataReadingMappedIfSafe error:NULL];
+      if ( _mappedData ) {
+        if ( ([_mappedData length] != expectedLength) || (memcmp([_mappedData bytes], header, sizeof(UVCCapabilityCacheHeader)) != 0) ) {
+          // Stale or corrupt, don't use it:
+          [_mappedData release];
+          _mappedData = nil;
+        }
+      }
+      if ( ! _mappedData ) {
+        // Start with an empty set of records:
+        _updatedData = [[NSMutableData alloc] initWithLength:expectedLength];
+        memcpy([_updatedData mutableBytes], header, sizeof(UVCCapabilityCacheHeader));
+      }
+    }
+    return self;
+  }
+
+//
+
+  - (const UVCCapabilityCacheRecord*) recordAtIndex:(NSUInteger)controlIndex
+  {
+    NSData          *data = ( _updatedData ? _updatedData : _mappedData );
+
+    if ( data && (controlIndex < _controlCount) ) {
+      return ((const UVCCapabilityCacheRecord*)([data bytes] + sizeof(UVCCapabilityCacheHeader))) + controlIndex;
+    }
+    return NULL;
+  }
+
+@end
+
+//
+#if 0
+#pragma mark -
+#endif
+//
+
+@implementation UVCCapabilityCache
+
+  + (void) initialize
+  {
+    //
+    // Resolved here rather than on first use since controllers may be created
+    // and probed from several threads at once:
+    //
+    if ( self == [UVCCapabilityCache class] ) {
+      NSArray         *cachePaths = NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES);
+
+      if ( cachePaths && [cachePaths count] ) {
+        UVCCapabilityCacheSharedDirectory = [[[cachePaths objectAtIndex:0] stringByAppendingPathComponent:@"uvc-util"] retain];
+      } else {
+        UVCCapabilityCacheSharedDirectory = [[NSTemporaryDirectory() stringByAppendingPathComponent:@"uvc-util"] retain];
+      }
+    }
+  }
+
+//
+
+  + (BOOL) isCachingEnabled
+  {
+    return UVCCapabilityCacheIsEnabled;
+  }
+  + (void) setIsCachingEnabled:(BOOL)isCachingEnabled
+  {
+    UVCCapabilityCacheIsEnabled = isCachingEnabled;
+  }
+
+//
+
+  + (NSString*) cacheDirectory
+  {
+    return UVCCapabilityCacheSharedDirectory;
+  }
+
+//
+
+  + (BOOL) invalidateAllCaches
+  {
+    NSFileManager     *fileManager = [NSFileManager defaultManager];
+    NSString          *cacheDirectory = [self cacheDirectory];
+    NSArray           *cacheFiles = [fileManager contentsOfDirectoryAtPath:cacheDirectory error:NULL];
+    BOOL              rc = YES;
+
+    if ( cacheFiles ) {
+      NSEnumerator    *eFiles = [cacheFiles objectEnumerator];
+      NSString        *cacheFile;
+
+      while ( (cacheFile = [eFiles nextObject]) ) {
+        if ( [[cacheFile pathExtension] isEqualToString:@"cache"] ) {
+          if ( ! [fileManager removeItemAtPath:[cacheDirectory stringByAppendingPathComponent:cacheFile] error:NULL] ) rc = NO;
+        }
+      }
+    }
+    return rc;
+  }
+
+//
+
+  + (UVCCapabilityCache*) capabilityCacheForVendorId:(UInt16)vendorId
+    productId:(UInt16)productId
+    uvcVersion:(UInt16)uvcVersion
+    descriptorHash:(UInt64)descriptorHash
+    controlCount:(NSUInteger)controlCount
+  {
+    if ( ! UVCCapabilityCacheIsEnabled ) return nil;
+
+    UVCCapabilityCacheHeader    header = {
+                                    .magic = UVC_CAPABILITY_CACHE_MAGIC,
+                                    .version = UVC_CAPABILITY_CACHE_VERSION,
+                                    .byteOrder = UVC_CAPABILITY_CACHE_BYTE_ORDER,
+                                    .vendorId = vendorId,
+                                    .productId = productId,
+                                    .uvcVersion = uvcVersion,
+                                    .controlCount = (UInt16)controlCount,
+                                    .descriptorHash = descriptorHash,
+                                    .recordSize = sizeof(UVCCapabilityCacheRecord),
+                                    .reserved = 0
+                                  };
+    NSString                    *path = [[self cacheDirectory] stringByAppendingPathComponent:
+                                            [NSString stringWithFormat:@"%04x-%04x-%04x-%016llx.cache",
+                                                vendorId, productId, uvcVersion, (unsigned long long)descriptorHash
+                                              ]
+                                          ];
+
+    return [[[self alloc] initWithPath:path header:&header] autorelease];
+  }
+
+//
+
+  - (void) dealloc
+  {
+    if ( _path ) [_path release];
+    if ( _mappedData ) [_mappedData release];
+    if ( _updatedData ) [_updatedData release];
+    [super dealloc];
+  }
+
+//
+
+  - (NSString*) description
+  {
+    return [NSString stringWithFormat:@"UVCCapabilityCache@%p { path: %@; control-count: %lu%s%s }",
+                        self,
+                        _path,
+                        (unsigned long)_controlCount,
+                        (_mappedData ? "; is-mapped" : ""),
+                        (_isDirty ? "; is-dirty" : "")
+                      ];
+  }
+
+//
+
+  - (NSString*) path
+  {
+    return _path;
+  }
+
+//
+
+  - (BOOL) lookupControlAtIndex:(NSUInteger)controlIndex
+    isAvailable:(BOOL*)isAvailable
+    capabilities:(NSUInteger*)capabilities
+    byteSize:(NSUInteger)byteSize
+    values:(void**)values
+  {
+    const UVCCapabilityCacheRecord    *record = [self recordAtIndex:controlIndex];
+
+    if ( record && (record->flags & kUVCCapabilityCacheRecordIsValid) ) {
+      if ( (record->flags & kUVCCapabilityCacheRecordIsAvailable) ) {
+        NSUInteger      valueIndex = 0;
+
+        if ( (byteSize > UVCCapabilityCacheMaxValueSize) || (record->byteSize != byteSize) ) return NO;
+        while ( valueIndex < kUVCCapabilityCacheValueCount ) {
+          if ( values[valueIndex] ) memcpy(values[valueIndex], record->values[valueIndex], byteSize);
+          valueIndex++;
+        }
+        *capabilities = record->capabilities;
+        *isAvailable = YES;
+      } else {
+        *isAvailable = NO;
+      }
+      return YES;
+    }
+    return NO;
+  }
+
+//
+
+  - (void) storeControlAtIndex:(NSUInteger)controlIndex
+    isAvailable:(BOOL)isAvailable
+    capabilities:(NSUInteger)capabilities
+    byteSize:(NSUInteger)byteSize
+    values:(void**)values
+  {
+    if ( (controlIndex >= _controlCount) || (byteSize > UVCCapabilityCacheMaxValueSize) ) return;
+
+    // Copy-on-write the mapped file:
+    if ( ! _updatedData ) {
+      _updatedData = [_mappedData mutableCopy];
+      [_mappedData release];
+      _mappedData = nil;
+    }
+
+    UVCCapabilityCacheRecord    *record = ((UVCCapabilityCacheRecord*)([_updatedData mutableBytes] + sizeof(UVCCapabilityCacheHeader))) + controlIndex;
+    NSUInteger                  valueIndex = 0;
+
+    memset(record, 0, sizeof(UVCCapabilityCacheRecord));
+    record->flags = kUVCCapabilityCacheRecordIsValid | (isAvailable ? kUVCCapabilityCacheRecordIsAvailable : 0);
+    if ( isAvailable ) {
+      record->capabilities = (UInt32)capabilities;
+      record->byteSize = (UInt16)byteSize;
+      while ( valueIndex < kUVCCapabilityCacheValueCount ) {
+        if ( values[valueIndex] ) memcpy(record->values[valueIndex], values[valueIndex], byteSize);
+        valueIndex++;
+      }
+    }
+    _isDirty = YES;
+  }
+
+//
+
+  - (BOOL) synchronize
+  {
+    if ( _isDirty && _updatedData ) {
+      NSString      *cacheDirectory = [_path stringByDeletingLastPathComponent];
+
+      if ( ! [[NSFileManager defaultManager] createDirectoryAtPath:cacheDirectory withIntermediateDirectories:YES attributes:nil error:NULL] ) return NO;
+      if ( ! [_updatedData writeToFile:_path atomically:YES] ) return NO;
+      _isDirty = NO;
+    }
+    return YES;
+  }
+
+//
+
+  - (void) invalidate
+  {
+    NSData          *data = ( _updatedData ? _updatedData : _mappedData );
+    NSMutableData   *emptyData = [[NSMutableData alloc] initWithLength:[data length]];
+
+    // Retain the header, drop all records:
+    memcpy([emptyData mutableBytes], [data bytes], sizeof(UVCCapabilityCacheHeader));
+    if ( _mappedData ) {
+      [_mappedData release];
+      _mappedData = nil;
+    }
+    if ( _updatedData ) [_updatedData release];
+    _updatedData = emptyData;
+    _isDirty = NO;
+
+    [[NSFileManager defaultManager] removeItemAtPath:_path error:NULL];
+  }
+
+@end
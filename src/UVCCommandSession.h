@@ -0,0 +1,257 @@
+//
+//  UVCCommandSession.h
+//
+//  Execution of uvc-util's device selection and control commands.
+//
+//  Copyright © 2016
+//  Dr. Jeffrey Frey, IT-NSS
+//  University of Delaware
+//
+// $Id$
+//
+
+#import "UVCControllerGroup.h"
+
+#include <stdio.h>
+
+/*!
+  @enum UVCCommand
+
+  Commands understood by UVCCommandSession.  Commands that correspond to a
+  single-character uvc-util option use that character as their value.
+*/
+typedef enum {
+  kUVCCommandNone                         = 0,
+  kUVCCommandListDevices                  = 'd',
+  kUVCCommandListControls                 = 'c',
+  kUVCCommandShowControl                  = 'S',
+  kUVCCommandSet                          = 's',
+  kUVCCommandGet                          = 'g',
+  kUVCCommandGetValue                     = 'o',
+  kUVCCommandResetAll                     = 'r',
+  kUVCCommandSelectNone                   = '0',
+  kUVCCommandSelectByVendorAndProductId   = 'V',
+  kUVCCommandSelectByLocationId           = 'L',
+  kUVCCommandSelectByName                 = 'N',
+  kUVCCommandSelectByIndex                = 'I',
+  kUVCCommandSaveProfile                  = 0x200,
+  kUVCCommandApplyProfile,
+  kUVCCommandSelectSimulated,
+  kUVCCommandSelect,
+  kUVCCommandSelectAll,
+  kUVCCommandSelectAllByVendorAndProductId,
+  kUVCCommandSelectAllByLocationId,
+  kUVCCommandSelectSimulatedGroup,
+  kUVCCommandStats,
+  kUVCCommandDump
+} UVCCommand;
+
+/*!
+  @function UVCCommandWithName
+
+  Returns the command whose uvc-util long option name (e.g. "get",
+  "select-by-location-id") or single-character option (e.g. "g", "L") matches
+  the nameLength characters at name, or kUVCCommandNone.  The shorter names
+  "show" and "reset" are also accepted, as is "select" (kUVCCommandSelect)
+  whose argument names the selection method followed by its value:
+
+    select index <device-index>
+    select location <location-id>
+    select vendor-product <vendor-id>:<product-id>
+    select name <device-name>
+    select none
+    select simulated
+    select all
+    select all-vendor-product <vendor-id>:<product-id>
+    select all-location <location-id>[,<location-id>...]
+    select simulated-group <count>
+*/
+UVCCommand UVCCommandWithName(const char *name, size_t nameLength);
+
+/*!
+  @function UVCCommandName
+
+  Returns the uvc-util long option name of command, or NULL.
+*/
+const char* UVCCommandName(UVCCommand command);
+
+/*!
+  @defined UVCCommandSessionMaxSharedReads
+
+  Most consecutive get commands that a batch combines into one pipelined
+  read of their controls.
+*/
+#define UVCCommandSessionMaxSharedReads   64
+
+/*!
+  @typedef UVCCommandBatchStatistics
+
+  Summary of the work done by performCommandsFromFileDescriptor:...:
+
+    - commandCount:  commands executed (blank lines and comments excluded)
+    - failedCount:  commands that returned a non-zero rc
+    - sharedReadCount:  get commands whose control was read as part of a
+      pipelined group
+    - sharedReadGroupCount:  number of such groups
+*/
+typedef struct {
+  NSUInteger        commandCount;
+  NSUInteger        failedCount;
+  NSUInteger        sharedReadCount;
+  NSUInteger        sharedReadGroupCount;
+} UVCCommandBatchStatistics;
+
+/*!
+  @class UVCCommandSession
+  @abstract State and execution of a sequence of uvc-util commands.
+
+  A session holds the list of UVC devices (enumerated on first use), the
+  currently-selected target device, and the flags used to parse values.
+  Selecting a device by location id, vendor and product id, or name before
+  the full list is needed consults only the I/O Registry (see UVCDeviceInfo)
+  and probes just the chosen device.
+
+  Instead of a single target device, a group of devices can be selected (all
+  devices, all with a vendor and product id, or a list of location ids).  The
+  set, reset-all, and apply-profile commands are then performed on every
+  member of the group concurrently (see UVCControllerGroup) and report each
+  device's outcome followed by a summary with the write skew.  Each
+  command writes its output to the session's output stream and its
+  diagnostics to the error stream, exactly as the uvc-util command-line
+  options do, and returns zero or an errno value describing the failure.
+
+  The devices are retained across commands, so controls (and their cached
+  capabilities and limits) and open interfaces persist for the lifetime of
+  the session.
+*/
+@interface UVCCommandSession : NSObject
+{
+  NSArray             *_devices;
+  NSMutableDictionary *_probedDevices;
+  UVCController       *_simulatedDevice;
+  NSMutableArray      *_simulatedGroupDevices;
+  UVCController       *_targetDevice;
+  UVCControllerGroup  *_targetGroup;
+  UVCTypeScanFlags    _scanFlags;
+  FILE                *_outStream;
+  FILE                *_errStream;
+}
+
+/*!
+  @method commandSession
+
+  Returns an autoreleased session with no devices enumerated yet, writing to
+  stdout and stderr.
+*/
++ (UVCCommandSession*) commandSession;
+
+/*!
+  @method commandSessionWithSession:
+
+  Returns an autoreleased session sharing the device list (and simulated and
+  individually-probed devices) of session and starting with the same target
+  device or group and scan flags.
+  Used to give each client of a long-running process its own selection state
+  while reusing the same controllers.
+*/
++ (UVCCommandSession*) commandSessionWithSession:(UVCCommandSession*)session;
+
+/*!
+  @method devices
+
+  Returns the list of UVC devices, enumerating them on the first call.
+*/
+- (NSArray*) devices;
+
+/*!
+  @method targetDevice
+
+  Returns the currently-selected device, or nil.
+*/
+- (UVCController*) targetDevice;
+
+/*!
+  @method setTargetDevice:
+
+  Select targetDevice as the target of subsequent commands.  Any selected
+  group is dropped.
+*/
+- (void) setTargetDevice:(UVCController*)targetDevice;
+
+/*!
+  @method targetGroup
+
+  Returns the currently-selected group of devices, or nil.
+*/
+- (UVCControllerGroup*) targetGroup;
+
+/*!
+  @method setTargetGroup:
+
+  Select targetGroup as the target of subsequent commands.  Any selected
+  device is dropped.
+*/
+- (void) setTargetGroup:(UVCControllerGroup*)targetGroup;
+
+/*!
+  @method scanFlags
+
+  Returns the flags passed to UVCType when parsing values.
+*/
+- (UVCTypeScanFlags) scanFlags;
+
+/*!
+  @method setScanFlags:
+
+  Set the flags passed to UVCType when parsing values.
+*/
+- (void) setScanFlags:(UVCTypeScanFlags)scanFlags;
+
+/*!
+  @method setOutStream:errStream:
+
+  Direct command output to outStream and diagnostics to errStream.  The
+  session does not close either stream.
+*/
+- (void) setOutStream:(FILE*)outStream errStream:(FILE*)errStream;
+
+/*!
+  @method performCommand:argument:
+
+  Execute command with the given argument (which may be NULL for commands
+  that take none).  Returns zero if successful, otherwise an errno value
+  (ENODEV, ENOENT, EINVAL, EACCES, ...).
+*/
+- (int) performCommand:(UVCCommand)command argument:(const char*)argument;
+
+/*!
+  @method performCommandLine:
+
+  Execute a command of the form "<name> [<argument>]", where name is accepted
+  by UVCCommandWithName().  Leading and trailing whitespace is ignored; the
+  argument is the rest of the line after the whitespace following name.
+  Returns zero if successful, otherwise an errno value.
+*/
+- (int) performCommandLine:(const char*)commandLine;
+
+/*!
+  @method performCommandsFromFileDescriptor:exitOnErrors:statistics:
+
+  Read newline-delimited commands (in the form accepted by performCommandLine:)
+  from fd until end-of-file and execute them, writing each command's output
+  as soon as it completes.  Blank lines and lines starting with '#' are
+  ignored.  Each command runs inside its own autorelease pool.
+
+  Consecutive get/get-value commands that are already available to be read
+  from fd are combined:  their controls are read with one pipelined set of
+  transfers (see readControls: in UVCController) before their output is
+  written in order.
+
+  If exitOnErrors is YES, processing stops at the first failed command.  If
+  stats is not NULL it is filled-in with a summary of the work done.  Returns
+  zero if every command succeeded, otherwise the rc of the last command that
+  failed.
+*/
+- (int) performCommandsFromFileDescriptor:(int)fd exitOnErrors:(BOOL)exitOnErrors statistics:(UVCCommandBatchStatistics*)stats;
+
+@end
@@ -0,0 +1,1472 @@
+//
+//  UVCCommandSession.m
+//
+//  Execution of uvc-util's device selection and control commands.
+//
+//  Copyright © 2016
+//  Dr. Jeffrey Frey, IT-NSS
+//  University of Delaware
+//
+// $Id$
+//
+
+#import "UVCCommandSession.h"
+#import "UVCValue.h"
+#import "UVCProfile.h"
+#import "UVCSimulatedTransport.h"
+#import "UVCDeviceInfo.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+
+typedef struct {
+  const char    *name;
+  UVCCommand    command;
+} UVCCommandNameMapping;
+
+static const UVCCommandNameMapping UVCCommandNames[] = {
+                                        { "list-devices",                     kUVCCommandListDevices },
+                                        { "list-controls",                    kUVCCommandListControls },
+                                        { "show-control",                     kUVCCommandShowControl },
+                                        { "set",                              kUVCCommandSet },
+                                        { "get",                              kUVCCommandGet },
+                                        { "get-value",                        kUVCCommandGetValue },
+                                        { "reset-all",                        kUVCCommandResetAll },
+                                        { "select-none",                      kUVCCommandSelectNone },
+                                        { "select-by-vendor-and-product-id",  kUVCCommandSelectByVendorAndProductId },
+                                        { "select-by-location-id",            kUVCCommandSelectByLocationId },
+                                        { "select-by-name",                   kUVCCommandSelectByName },
+                                        { "select-by-index",                  kUVCCommandSelectByIndex },
+                                        { "save-profile",                     kUVCCommandSaveProfile },
+                                        { "apply-profile",                    kUVCCommandApplyProfile },
+                                        { "select-simulated",                 kUVCCommandSelectSimulated },
+                                        { "select-all",                       kUVCCommandSelectAll },
+                                        { "select-all-by-vendor-and-product-id", kUVCCommandSelectAllByVendorAndProductId },
+                                        { "select-all-by-location-id",        kUVCCommandSelectAllByLocationId },
+                                        { "select-simulated-group",           kUVCCommandSelectSimulatedGroup },
+                                        { "stats",                            kUVCCommandStats },
+                                        { "dump",                             kUVCCommandDump },
+                                        // Shorter forms for command streams:
+                                        { "show",                             kUVCCommandShowControl },
+                                        { "reset",                            kUVCCommandResetAll },
+                                        { "select",                           kUVCCommandSelect },
+                                        { NULL,                               kUVCCommandNone }
+                                      };
+
+UVCCommand
+UVCCommandWithName(
+  const char    *name,
+  size_t        nameLength
+)
+{
+  const UVCCommandNameMapping *mapping = UVCCommandNames;
+
+  if ( nameLength == 1 ) {
+    while ( mapping->name ) {
+      if ( (mapping->command < 0x100) && (mapping->command == *name) ) return mapping->command;
+      mapping++;
+    }
+  } else {
+    while ( mapping->name ) {
+      if ( (strncmp(mapping->name, name, nameLength) == 0) && (mapping->name[nameLength] == '\0') ) return mapping->command;
+      mapping++;
+    }
+  }
+  return kUVCCommandNone;
+}
+
+//
+
+const char*
+UVCCommandName(
+  UVCCommand    command
+)
+{
+  const UVCCommandNameMapping *mapping = UVCCommandNames;
+
+  while ( mapping->name ) {
+    if ( mapping->command == command ) return mapping->name;
+    mapping++;
+  }
+  return NULL;
+}
+
+//
+#if 0
+#pragma mark -
+#endif
+//
+
+/*!
+  @function UVCCommandParseLine
+
+  Split commandLine into a command and its argument.  On return *argument
+  points to the argument within commandLine and *argumentLength excludes
+  trailing whitespace.  The name is returned in *name and *nameLength for
+  error reporting.
+*/
+static UVCCommand
+UVCCommandParseLine(
+  const char    *commandLine,
+  const char    **name,
+  size_t        *nameLength,
+  const char    **argument,
+  size_t        *argumentLength
+)
+{
+  const char    *nameEnd;
+  size_t        argumentLen;
+
+  while ( isspace(*commandLine) ) commandLine++;
+  nameEnd = commandLine;
+  while ( *nameEnd && ! isspace(*nameEnd) ) nameEnd++;
+  *name = commandLine;
+  *nameLength = nameEnd - commandLine;
+
+  // The argument is everything after the whitespace, less trailing whitespace:
+  while ( isspace(*nameEnd) ) nameEnd++;
+  argumentLen = strlen(nameEnd);
+  while ( argumentLen && isspace(nameEnd[argumentLen - 1]) ) argumentLen--;
+  *argument = nameEnd;
+  *argumentLength = argumentLen;
+
+  return UVCCommandWithName(*name, *nameLength);
+}
+
+//
+
+/*!
+  @typedef UVCCommandLineReader
+
+  Buffered reader of newline-delimited lines from a file descriptor.  Unlike
+  stdio it can report whether a complete line is available without blocking.
+*/
+typedef struct {
+  int         fd;
+  char        *buffer;
+  size_t      capacity;
+  size_t      start, end;
+  BOOL        isAtEOF;
+} UVCCommandLineReader;
+
+static void
+UVCCommandLineReaderInit(
+  UVCCommandLineReader  *reader,
+  int                   fd
+)
+{
+  memset(reader, 0, sizeof(*reader));
+  reader->fd = fd;
+}
+
+static void
+UVCCommandLineReaderDestroy(
+  UVCCommandLineReader  *reader
+)
+{
+  if ( reader->buffer ) free(reader->buffer);
+  reader->buffer = NULL;
+}
+
+/*!
+  @function UVCCommandLineReaderNextLine
+
+  Returns the next line (without its newline) or NULL at end-of-file.  If
+  shouldBlock is NO, NULL is also returned when no complete line can be read
+  without waiting.  The line remains valid until the next call.
+*/
+static char*
+UVCCommandLineReaderNextLine(
+  UVCCommandLineReader  *reader,
+  BOOL                  shouldBlock
+)
+{
+  while ( 1 ) {
+    char                *line = reader->buffer + reader->start;
+    char                *newline = ( reader->end > reader->start ) ? memchr(line, '\n', reader->end - reader->start) : NULL;
+    ssize_t             n;
+
+    if ( newline ) {
+      *newline = '\0';
+      reader->start = (newline - reader->buffer) + 1;
+      return line;
+    }
+    if ( reader->isAtEOF ) {
+      if ( reader->start == reader->end ) return NULL;
+      // Final line with no newline (there's always room for the NUL):
+      reader->buffer[reader->end] = '\0';
+      reader->start = reader->end;
+      return line;
+    }
+    if ( ! shouldBlock ) {
+      struct pollfd     pfd = { .fd = reader->fd, .events = POLLIN };
+
+      if ( poll(&pfd, 1, 0) <= 0 ) return NULL;
+    }
+    if ( reader->start ) {
+      memmove(reader->buffer, line, reader->end - reader->start);
+      reader->end -= reader->start;
+      reader->start = 0;
+    }
+    if ( reader->end + 1 >= reader->capacity ) {
+      size_t            newCapacity = ( reader->capacity ? 2 * reader->capacity : 4096 );
+      char              *newBuffer = realloc(reader->buffer, newCapacity);
+
+      if ( ! newBuffer ) return NULL;
+      reader->buffer = newBuffer;
+      reader->capacity = newCapacity;
+    }
+    n = read(reader->fd, reader->buffer + reader->end, reader->capacity - reader->end - 1);
+    if ( n > 0 ) {
+      reader->end += n;
+    } else if ( (n == 0) || (errno != EINTR) ) {
+      reader->isAtEOF = YES;
+    }
+  }
+}
+
+//
+#if 0
+#pragma mark -
+#endif
+//
+
+/*!
+  @defined UVCCommandSessionMaxSimulatedGroupCount
+
+  Most simulated cameras that select-simulated-group will create.
+*/
+#define UVCCommandSessionMaxSimulatedGroupCount   64
+
+/*!
+  @defined UVCCommandSessionSimulatedLocationId
+
+  Location id of the first camera created by select-simulated-group; the
+  rest follow consecutively.
+*/
+#define UVCCommandSessionSimulatedLocationId      0xfa000000
+
+//
+
+static void
+UVCCommandSessionPrintProfileStatistics(
+  FILE                            *outStream,
+  const UVCProfileApplyStatistics *stats
+)
+{
+  fprintf(outStream, "%lu controls: %lu written, %lu unchanged, %lu skipped (automatic mode), %lu failed; %lu SET_CUR transfers saved (%lu reads issued)\n",
+      (unsigned long)stats->controlCount,
+      (unsigned long)stats->writeCount,
+      (unsigned long)stats->unchangedCount,
+      (unsigned long)stats->automaticCount,
+      (unsigned long)stats->failedCount,
+      (unsigned long)UVCProfileApplyStatisticsTransfersSaved(stats),
+      (unsigned long)stats->readCount
+    );
+}
+
+//
+
+/*!
+  @function UVCCommandSessionPrintRequestFailure
+
+  Complete an error message with the reason device's most recent request
+  failed, e.g. " (device not ready; 3 attempts)", and a newline.
+*/
+static void
+UVCCommandSessionPrintRequestFailure(
+  FILE                            *errStream,
+  UVCController                   *device
+)
+{
+  UVCRequestFailure               failure = [device lastRequestFailure];
+  
+  if ( failure.result == kIOReturnSuccess ) {
+    fputc('\n', errStream);
+    return;
+  }
+  if ( UVCRequestFailureIsTimeout(failure) ) {
+    fprintf(errStream, " (timed out after %g seconds", [device requestTimeout]);
+  } else if ( failure.errorCode != kUVCRequestErrorCodeUnknown ) {
+    fprintf(errStream, " (%s", UVCRequestErrorCodeString(failure.errorCode));
+  } else {
+    fprintf(errStream, " (I/O Kit error 0x%08x", failure.result);
+  }
+  if ( failure.attemptCount > 1 ) fprintf(errStream, "; %lu attempts", (unsigned long)failure.attemptCount);
+  fprintf(errStream, ")\n");
+}
+
+//
+#if 0
+#pragma mark -
+#endif
+//
+
+@interface UVCCommandSession(UVCCommandSessionPrivate)
+
+- (int) listDevices;
+- (int) listControls;
+/*!
+  @method deviceMatchingFilter:
+
+  Returns the first UVC device matching filter.  If the full device list has
+  not been enumerated, only the I/O Registry is consulted and just the
+  matching device is probed (and remembered for later selections).
+*/
+- (UVCController*) deviceMatchingFilter:(const UVCDeviceFilter*)filter;
+/*!
+  @method devicesMatchingFilter:maximumCount:
+
+  Same as deviceMatchingFilter: but returns (up to maximumCount of) all the
+  matching devices, in order.
+*/
+- (NSArray*) devicesMatchingFilter:(const UVCDeviceFilter*)filter maximumCount:(NSUInteger)maximumCount;
+/*!
+  @method parseVendorAndProductId:filter:
+
+  Fill-in the vendor and product id of filter from an argument of the form
+  <vendor-id>:<product-id>.  Returns zero or EINVAL (after reporting the
+  problem).
+*/
+- (int) parseVendorAndProductId:(const char*)argument filter:(UVCDeviceFilter*)filter;
+- (int) selectByIndex:(const char*)argument;
+- (int) selectByName:(const char*)argument;
+- (int) selectByVendorAndProductId:(const char*)argument;
+- (int) selectByLocationId:(const char*)argument;
+- (int) selectSimulated;
+- (int) selectAll;
+- (int) selectAllByVendorAndProductId:(const char*)argument;
+- (int) selectAllByLocationId:(const char*)argument;
+- (int) selectSimulatedGroup:(const char*)argument;
+- (int) select:(const char*)argument;
+/*!
+  @method reportGroupOperation
+
+  Write the outcome of the target group's most recent operation:  an error
+  for each device that failed, profile statistics for each device (if any
+  were gathered), and a summary with the write skew.  Returns zero or the rc
+  of the last device that failed.
+*/
+- (int) reportGroupOperation;
+- (int) showControl:(const char*)argument;
+- (int) getControl:(const char*)argument valueOnly:(BOOL)valueOnly;
+- (int) setControl:(const char*)argument;
+- (int) resetAll;
+- (int) saveProfile:(const char*)argument;
+- (int) applyProfile:(const char*)argument;
+/*!
+  @method writeStatistics
+
+  Write the request statistics (see writeRequestStatisticsAsJSONToStream: in
+  UVCController) of the target device, the members of the target group, or --
+  with nothing selected -- every device the session has created, as a JSON
+  object with a "devices" array.  Always returns zero.
+*/
+- (int) writeStatistics;
+/*!
+  @method dump
+
+  Write the NDJSON state of every control (see writeControlsAsNDJSONToStream:failedCount:
+  in UVCController) of the target device, the members of the target group, or --
+  with nothing selected -- every UVC device.  Unless the full device list was
+  already needed, devices are probed one at a time from the I/O Registry, each
+  being dumped before the next is probed.  Returns zero, or ENODEV if there
+  were no devices.
+*/
+- (int) dump;
+
+/*!
+  @method getControlsNamed:count:valueOnly:statistics:
+
+  Execute count get (or get-value, per valueOnly) commands, reading all of
+  their controls with a single pipelined set of transfers before writing
+  their output in order.  Returns zero or the rc of the last that failed.
+*/
+- (int) getControlsNamed:(NSString**)controlNames count:(NSUInteger)count valueOnly:(const BOOL*)valueOnly statistics:(UVCCommandBatchStatistics*)stats;
+
+@end
+
+@implementation UVCCommandSession(UVCCommandSessionPrivate)
+
+  - (int) listDevices
+  {
+    NSArray           *uvcDevices = [self devices];
+
+    if ( uvcDevices && [uvcDevices count] ) {
+      NSEnumerator    *eDevices = [uvcDevices objectEnumerator];
+      UVCController   *device;
+      unsigned long   deviceIndex = 0;
+
+      fprintf(_outStream, "------------ -------------- ------------ ------------ ------------------------------------------------\n");
+      fprintf(_outStream, "%-12s %-14s %-12s %-12s %s\n", "Index", "Vend:Prod", "LocationID", "UVC Version", "Device name");
+      fprintf(_outStream, "------------ -------------- ------------ ------------ ------------------------------------------------\n");
+      while ( (device = [eDevices nextObject]) ) {
+        UInt16      uvcVersion = [device uvcVersion];
+        char        versionStr[8];
+
+        snprintf(versionStr, sizeof(versionStr), "%d.%02x", (short)(uvcVersion >> 8), (uvcVersion &0xFF));
+        fprintf(_outStream, "%-12lu 0x%04x:0x%04x  0x%08x   %-5s        %s\n", deviceIndex++, [device vendorId], [device productId], [device locationId], versionStr, [[device deviceName] cStringUsingEncoding:NSASCIIStringEncoding]);
+      }
+      fprintf(_outStream, "------------ -------------- ------------ ------------ ------------------------------------------------\n");
+      return 0;
+    }
+    fprintf(_errStream, "ERROR:  no UVC-capable devices available\n");
+    return ENODEV;
+  }
+
+//
+
+  - (int) listControls
+  {
+    NSArray     *controlNames = [UVCController controlStrings];
+
+    if ( _targetDevice ) {
+      //
+      // Answered from the device's availability mask alone; the controls are
+      // probed only when their attributes are asked for:
+      //
+      controlNames = [_targetDevice availableControlNames];
+      if ( controlNames && [controlNames count] ) {
+        NSEnumerator  *eNames = [controlNames objectEnumerator];
+        NSString      *name;
+
+        fprintf(_outStream, "UVC controls implemented by this device:\n");
+        while ( (name = [eNames nextObject]) ) fprintf(_outStream, "  %s\n", [name cStringUsingEncoding:NSASCIIStringEncoding]);
+      } else {
+        fprintf(_errStream, "WARNING:  no controls implemented by this device\n");
+      }
+    } else if ( controlNames ) {
+      NSEnumerator  *eNames = [controlNames objectEnumerator];
+      NSString      *name;
+
+      fprintf(_outStream, "UVC controls implemented by this program:\n");
+      while ( (name = [eNames nextObject]) ) fprintf(_outStream, "  %s\n", [name cStringUsingEncoding:NSASCIIStringEncoding]);
+    }
+    return 0;
+  }
+
+//
+
+  - (UVCController*) deviceMatchingFilter:(const UVCDeviceFilter*)filter
+  {
+    NSArray           *devices = [self devicesMatchingFilter:filter maximumCount:1];
+
+    return ( [devices count] ? [devices objectAtIndex:0] : nil );
+  }
+
+//
+
+  - (NSArray*) devicesMatchingFilter:(const UVCDeviceFilter*)filter
+    maximumCount:(NSUInteger)maximumCount
+  {
+    NSMutableArray    *devices = [NSMutableArray array];
+    NSEnumerator      *eDevices;
+    UVCController     *device;
+
+    if ( _devices ) {
+      eDevices = [_devices objectEnumerator];
+      while ( ([devices count] < maximumCount) && (device = [eDevices nextObject]) ) {
+        if ( (filter->flags & kUVCDeviceFilterVendorId) && (filter->vendorId != [device vendorId]) ) continue;
+        if ( (filter->flags & kUVCDeviceFilterProductId) && (filter->productId != [device productId]) ) continue;
+        if ( (filter->flags & kUVCDeviceFilterLocationId) && (filter->locationId != [device locationId]) ) continue;
+        if ( (filter->flags & kUVCDeviceFilterName) && ([filter->name compare:[device deviceName] options:NSCaseInsensitiveSearch] != NSOrderedSame) ) continue;
+        [devices addObject:device];
+      }
+      return devices;
+    }
+
+    NSEnumerator      *eDeviceInfos = [[UVCDeviceInfo deviceInfosMatchingFilter:filter] objectEnumerator];
+    UVCDeviceInfo     *deviceInfo;
+
+    while ( ([devices count] < maximumCount) && (deviceInfo = [eDeviceInfos nextObject]) ) {
+      NSNumber        *key = [NSNumber numberWithUnsignedInt:[deviceInfo locationId]];
+
+      if ( ! (device = [_probedDevices objectForKey:key]) ) {
+        if ( (device = [deviceInfo controller]) ) [_probedDevices setObject:device forKey:key];
+      }
+      if ( device ) [devices addObject:device];
+    }
+    return devices;
+  }
+
+//
+
+  - (int) parseVendorAndProductId:(const char*)argument
+    filter:(UVCDeviceFilter*)filter
+  {
+    unsigned short  vendorId, productId;
+    int             nChar;
+
+    if ( sscanf(argument, "%hi:%n", &vendorId, &nChar) == 1 ) {
+      if ( sscanf(argument + nChar, "%hi", &productId) == 1 ) {
+        filter->flags |= kUVCDeviceFilterVendorId | kUVCDeviceFilterProductId;
+        filter->vendorId = vendorId;
+        filter->productId = productId;
+        return 0;
+      }
+      fprintf(_errStream, "ERROR:  invalid product id: %s\n", argument + nChar);
+      return EINVAL;
+    }
+    fprintf(_errStream, "ERROR:  invalid vendor id: %s\n", argument);
+    return EINVAL;
+  }
+
+//
+
+  - (int) selectByIndex:(const char*)argument
+  {
+    if ( argument && *argument ) {
+      char              *endPtr = NULL;
+      unsigned long     deviceIndex = strtoul(argument, &endPtr, 10);
+
+      if ( endPtr > argument ) {
+        NSArray         *uvcDevices = [self devices];
+
+        if ( uvcDevices ) {
+          if ( deviceIndex < [uvcDevices count] ) {
+            [self setTargetDevice:[uvcDevices objectAtIndex:deviceIndex]];
+            return 0;
+          }
+          fprintf(_errStream, "ERROR:  invalid device index: %lu\n", deviceIndex);
+          return EINVAL;
+        }
+        fprintf(_errStream, "ERROR:  no UVC-capable devices available\n");
+        return ENODEV;
+      }
+      fprintf(_errStream, "ERROR:  invalid device index: %s\n", argument);
+      return EINVAL;
+    }
+    fprintf(_errStream, "ERROR:  missing argument to -I/--select-by-index\n");
+    return EINVAL;
+  }
+
+//
+
+  - (int) selectByName:(const char*)argument
+  {
+    if ( argument && *argument ) {
+      UVCDeviceFilter filter = { .flags = kUVCDeviceFilterName, .name = [NSString stringWithCString:argument encoding:NSASCIIStringEncoding] };
+      UVCController   *device = [self deviceMatchingFilter:&filter];
+
+      // A failed selection leaves no device selected:
+      [self setTargetDevice:device];
+      if ( device ) return 0;
+      fprintf(_errStream, "ERROR:  no UVC-capable device with the name \"%s\"\n", argument);
+      return ENODEV;
+    }
+    fprintf(_errStream, "ERROR:  missing argument to -N/--select-by-name\n");
+    return EINVAL;
+  }
+
+//
+
+  - (int) selectByVendorAndProductId:(const char*)argument
+  {
+    if ( argument && *argument ) {
+      UVCDeviceFilter filter = { .flags = 0 };
+      UVCController   *device;
+      int             rc;
+
+      if ( (rc = [self parseVendorAndProductId:argument filter:&filter]) ) return rc;
+      device = [self deviceMatchingFilter:&filter];
+
+      // A failed selection leaves no device selected:
+      [self setTargetDevice:device];
+      if ( device ) return 0;
+      fprintf(_errStream, "ERROR:  no UVC-capable device with vendor:product = 0x%04hx:0x%04hx\n", filter.vendorId, filter.productId);
+      return ENODEV;
+    }
+    fprintf(_errStream, "ERROR:  missing argument to -V/--select-by-vendor-and-product-id\n");
+    return EINVAL;
+  }
+
+//
+
+  - (int) selectByLocationId:(const char*)argument
+  {
+    if ( argument && *argument ) {
+      unsigned    locationId;
+
+      if ( sscanf(argument, "%i", &locationId) == 1 ) {
+        UVCDeviceFilter filter = { .flags = kUVCDeviceFilterLocationId, .locationId = locationId };
+        UVCController   *device = [self deviceMatchingFilter:&filter];
+
+        // A failed selection leaves no device selected:
+        [self setTargetDevice:device];
+        if ( device ) return 0;
+        fprintf(_errStream, "ERROR:  no UVC-capable device with location = 0x%08x\n", locationId);
+        return ENODEV;
+      }
+      fprintf(_errStream, "ERROR:  invalid location id: %s\n", argument);
+      return EINVAL;
+    }
+    fprintf(_errStream, "ERROR:  missing argument to -L/--select-by-location-id\n");
+    return EINVAL;
+  }
+
+//
+
+  - (int) selectSimulated
+  {
+    if ( ! _simulatedDevice ) {
+      UVCSimulatedTransport     *camera = [UVCSimulatedTransport simulatedCameraWithLatency:0.000125 serviceTime:0.0005];
+
+      // Give --watch something to see:
+      [camera setValueChangeInterval:1.0];
+      _simulatedDevice = [[UVCController uvcControllerWithTransport:camera deviceName:@"Simulated UVC Camera" vendorId:0 productId:0] retain];
+    }
+    [self setTargetDevice:_simulatedDevice];
+    return 0;
+  }
+
+//
+
+  - (int) selectAll
+  {
+    UVCControllerGroup  *group = [UVCControllerGroup controllerGroupWithControllers:[self devices]];
+
+    // A failed selection leaves no device selected:
+    [self setTargetGroup:group];
+    if ( group ) return 0;
+    fprintf(_errStream, "ERROR:  no UVC-capable devices available\n");
+    return ENODEV;
+  }
+
+//
+
+  - (int) selectAllByVendorAndProductId:(const char*)argument
+  {
+    if ( argument && *argument ) {
+      UVCDeviceFilter     filter = { .flags = 0 };
+      UVCControllerGroup  *group;
+      int                 rc;
+
+      if ( (rc = [self parseVendorAndProductId:argument filter:&filter]) ) return rc;
+      group = [UVCControllerGroup controllerGroupWithControllers:[self devicesMatchingFilter:&filter maximumCount:NSUIntegerMax]];
+
+      // A failed selection leaves no device selected:
+      [self setTargetGroup:group];
+      if ( group ) return 0;
+      fprintf(_errStream, "ERROR:  no UVC-capable device with vendor:product = 0x%04hx:0x%04hx\n", filter.vendorId, filter.productId);
+      return ENODEV;
+    }
+    fprintf(_errStream, "ERROR:  missing argument to --select-all-by-vendor-and-product-id\n");
+    return EINVAL;
+  }
+
+//
+
+  - (int) selectAllByLocationId:(const char*)argument
+  {
+    if ( argument && *argument ) {
+      NSMutableArray      *devices = [NSMutableArray array];
+      const char          *p = argument;
+
+      // A failed selection leaves no device selected:
+      [self setTargetDevice:nil];
+      while ( *p ) {
+        char              *endPtr = NULL;
+        unsigned long     locationId = strtoul(p, &endPtr, 0);
+
+        if ( (endPtr == p) || (locationId > UINT32_MAX) || (*endPtr && (*endPtr != ',')) ) {
+          fprintf(_errStream, "ERROR:  invalid location id: %.*s\n", (int)strcspn(p, ","), p);
+          return EINVAL;
+        }
+
+        UVCDeviceFilter   filter = { .flags = kUVCDeviceFilterLocationId, .locationId = (UInt32)locationId };
+        UVCController     *device = [self deviceMatchingFilter:&filter];
+
+        if ( ! device ) {
+          fprintf(_errStream, "ERROR:  no UVC-capable device with location = 0x%08x\n", filter.locationId);
+          return ENODEV;
+        }
+        if ( [devices indexOfObjectIdenticalTo:device] == NSNotFound ) [devices addObject:device];
+        p = ( *endPtr ? endPtr + 1 : endPtr );
+      }
+      [self setTargetGroup:[UVCControllerGroup controllerGroupWithControllers:devices]];
+      return 0;
+    }
+    fprintf(_errStream, "ERROR:  missing argument to --select-all-by-location-id\n");
+    return EINVAL;
+  }
+
+//
+
+  - (int) selectSimulatedGroup:(const char*)argument
+  {
+    char                *endPtr = NULL;
+    unsigned long       count = ( argument ? strtoul(argument, &endPtr, 10) : 0 );
+
+    if ( ! argument || (endPtr == argument) || *endPtr || (count < 1) || (count > UVCCommandSessionMaxSimulatedGroupCount) ) {
+      fprintf(_errStream, "ERROR:  invalid simulated device count: %s\n", (argument ? argument : ""));
+      return EINVAL;
+    }
+    if ( ! _simulatedGroupDevices ) _simulatedGroupDevices = [[NSMutableArray alloc] init];
+    while ( [_simulatedGroupDevices count] < count ) {
+      NSUInteger              i = [_simulatedGroupDevices count];
+      // Each camera in a run of four is slower than the last, so the write skew is visible:
+      UVCSimulatedTransport   *camera = [UVCSimulatedTransport simulatedCameraWithLatency:0.000125 serviceTime:0.0005 * (1 + (i % 4))];
+
+      [_simulatedGroupDevices addObject:[UVCController uvcControllerWithTransport:camera
+                                                deviceName:[NSString stringWithFormat:@"Simulated UVC Camera %lu", (unsigned long)i]
+                                                vendorId:0
+                                                productId:0
+                                                locationId:(UInt32)(UVCCommandSessionSimulatedLocationId + i)
+                                              ]];
+    }
+    [self setTargetGroup:[UVCControllerGroup controllerGroupWithControllers:[_simulatedGroupDevices subarrayWithRange:NSMakeRange(0, count)]]];
+    return 0;
+  }
+
+//
+
+  - (int) select:(const char*)argument
+  {
+    static const struct {
+      const char    *method;
+      UVCCommand    command;
+    } selectMethods[] = {
+          { "index",            kUVCCommandSelectByIndex },
+          { "location",         kUVCCommandSelectByLocationId },
+          { "vendor-product",   kUVCCommandSelectByVendorAndProductId },
+          { "name",             kUVCCommandSelectByName },
+          { "none",             kUVCCommandSelectNone },
+          { "simulated",        kUVCCommandSelectSimulated },
+          { "all",              kUVCCommandSelectAll },
+          { "all-vendor-product", kUVCCommandSelectAllByVendorAndProductId },
+          { "all-location",     kUVCCommandSelectAllByLocationId },
+          { "simulated-group",  kUVCCommandSelectSimulatedGroup },
+          { NULL,               kUVCCommandNone }
+        };
+    const char      *value = argument;
+    size_t          methodLen;
+    int             i = 0;
+
+    if ( ! argument || ! *argument ) {
+      fprintf(_errStream, "ERROR:  missing argument to select\n");
+      return EINVAL;
+    }
+    while ( *value && ! isspace(*value) ) value++;
+    methodLen = value - argument;
+    while ( isspace(*value) ) value++;
+    while ( selectMethods[i].method ) {
+      if ( (strncmp(selectMethods[i].method, argument, methodLen) == 0) && (selectMethods[i].method[methodLen] == '\0') ) {
+        return [self performCommand:selectMethods[i].command argument:(*value ? value : NULL)];
+      }
+      i++;
+    }
+    fprintf(_errStream, "ERROR:  invalid selection method: %.*s\n", (int)methodLen, argument);
+    return EINVAL;
+  }
+
+//
+
+  - (int) showControl:(const char*)argument
+  {
+    if ( ! _targetDevice ) {
+      fprintf(_errStream, "ERROR:  no target device selected\n");
+      return ENODEV;
+    }
+    if ( ! argument || ! *argument ) {
+      fprintf(_errStream, "ERROR:  missing argument to -S/--show option\n");
+      return EINVAL;
+    }
+    if ( (*argument == '*') && (*(argument + 1) == '\0') ) {
+      NSArray     *controlNames = [_targetDevice availableControlNames];
+
+      if ( controlNames && [controlNames count] ) {
+        NSEnumerator  *eNames = [controlNames objectEnumerator];
+        NSString      *name;
+
+        while ( (name = [eNames nextObject]) ) {
+          UVCControl  *control = [_targetDevice controlWithName:name];
+
+          if ( control ) fprintf(_outStream, "%s\n", [[control summaryString] cStringUsingEncoding:NSASCIIStringEncoding]);
+        }
+      } else {
+        fprintf(_errStream, "WARNING:  no controls implemented by this device\n");
+      }
+    } else {
+      long              controlNameLen = strlen(argument);
+      char              controlName[controlNameLen + 1];
+      long              i = 0;
+
+      while ( i < controlNameLen ) {
+        controlName[i] = tolower(argument[i]);
+        i++;
+      }
+      controlName[i] = '\0';
+
+      UVCControl        *control = [_targetDevice controlWithName:[NSString stringWithCString:controlName encoding:NSASCIIStringEncoding]];
+
+      if ( ! control ) {
+        fprintf(_errStream, "ERROR:  invalid control name: %s\n", controlName);
+        return ENOENT;
+      }
+      fprintf(_outStream, "%s\n", [[control summaryString] cStringUsingEncoding:NSASCIIStringEncoding]);
+    }
+    return 0;
+  }
+
+//
+
+  - (int) getControl:(const char*)argument
+    valueOnly:(BOOL)valueOnly
+  {
+    if ( ! _targetDevice ) {
+      fprintf(_errStream, "ERROR:  no target device selected\n");
+      return ENODEV;
+    }
+    if ( ! argument || ! *argument ) {
+      fprintf(_errStream, "ERROR:  missing argument to -g/--get/-o/--get-value option\n");
+      return EINVAL;
+    }
+
+    UVCControl      *control = [_targetDevice controlWithName:[NSString stringWithCString:argument encoding:NSASCIIStringEncoding]];
+
+    if ( ! control ) {
+      fprintf(_errStream, "ERROR:  invalid control name: %s\n", argument);
+      return ENOENT;
+    }
+
+    UVCValue        *currentValue = [control currentValue];
+
+    if ( ! currentValue ) {
+      fprintf(_errStream, "ERROR:  unable to read value of control: %s", argument);
+      UVCCommandSessionPrintRequestFailure(_errStream, _targetDevice);
+      return EACCES;
+    }
+
+    char            valueStr[[[currentValue valueType] maximumFormattedLength] + 1];
+
+    [currentValue formatAs:kUVCTypeFormatDefault intoCString:valueStr length:sizeof(valueStr)];
+    if ( valueOnly ) {
+      fprintf(_outStream, "%s\n", valueStr);
+    } else {
+      fprintf(_outStream, "%s = %s\n", argument, valueStr);
+    }
+    return 0;
+  }
+
+//
+
+  - (int) setControl:(const char*)argument
+  {
+    if ( ! _targetDevice && ! _targetGroup ) {
+      fprintf(_errStream, "ERROR:  no target device selected\n");
+      return ENODEV;
+    }
+    if ( ! argument || ! *argument ) {
+      fprintf(_errStream, "ERROR:  missing argument to -s/--set option\n");
+      return EINVAL;
+    }
+
+    const char      *valuePtr = strchr(argument, '=');
+
+    if ( ! valuePtr ) {
+      fprintf(_errStream, "ERROR:  no value provided with control name: %s\n", argument);
+      return EINVAL;
+    }
+
+    long            controlNameLen = valuePtr - argument;
+
+    valuePtr++;
+    if ( ! controlNameLen ) {
+      fprintf(_errStream, "ERROR:  missing control name: %s\n", argument);
+      return EINVAL;
+    }
+
+    char            controlName[controlNameLen + 1];
+    long            i = 0;
+
+    while ( i < controlNameLen ) {
+      controlName[i] = tolower(argument[i]);
+      i++;
+    }
+    controlName[i] = '\0';
+
+    if ( _targetGroup ) {
+      [_targetGroup setControlWithName:[NSString stringWithCString:controlName encoding:NSASCIIStringEncoding] fromCString:valuePtr flags:_scanFlags];
+      return [self reportGroupOperation];
+    }
+
+    UVCControl      *control = [_targetDevice controlWithName:[NSString stringWithCString:controlName encoding:NSASCIIStringEncoding]];
+
+    if ( ! control ) {
+      fprintf(_errStream, "ERROR:  invalid control name: %s\n", controlName);
+      return ENOENT;
+    }
+
+    NSUInteger          errorOffset = 0;
+    UVCTypeScanStatus   scanStatus = [control setCurrentValueFromCString:valuePtr flags:_scanFlags errorOffset:&errorOffset];
+
+    if ( scanStatus != kUVCTypeScanOk ) {
+      fprintf(_errStream, "ERROR:  invalid value for control %s: %s (at offset %lu: %s)\n", controlName, valuePtr, (unsigned long)errorOffset, UVCTypeScanStatusString(scanStatus));
+      fprintf(_errStream, "        %*s^\n", (int)(strlen(controlName) + 28 + errorOffset), "");
+      return EINVAL;
+    }
+    if ( ! [control writeFromCurrentValue] ) {
+      fprintf(_errStream, "ERROR:  unable to write new value to control %s", controlName);
+      UVCCommandSessionPrintRequestFailure(_errStream, _targetDevice);
+      return EACCES;
+    }
+    return 0;
+  }
+
+//
+
+  - (int) resetAll
+  {
+    if ( _targetGroup ) {
+      [_targetGroup resetAllWithFlags:_scanFlags];
+      return [self reportGroupOperation];
+    }
+    if ( ! _targetDevice ) {
+      fprintf(_errStream, "ERROR:  no target device selected\n");
+      return ENODEV;
+    }
+
+    UVCProfile                  *defaults = [UVCProfile defaultProfileWithController:_targetDevice];
+
+    if ( [[defaults controlNames] count] ) {
+      UVCProfileApplyStatistics stats;
+      BOOL                      didApply = [defaults applyToController:_targetDevice flags:_scanFlags statistics:&stats];
+
+      UVCCommandSessionPrintProfileStatistics(_outStream, &stats);
+      if ( ! didApply ) {
+        fprintf(_errStream, "ERROR:  unable to write default value to %lu control(s)\n", (unsigned long)stats.failedCount);
+        return EACCES;
+      }
+    } else {
+      fprintf(_errStream, "WARNING:  no controls implemented by this device\n");
+    }
+    return 0;
+  }
+
+//
+
+  - (int) saveProfile:(const char*)argument
+  {
+    if ( ! _targetDevice ) {
+      fprintf(_errStream, "ERROR:  no target device selected\n");
+      return ENODEV;
+    }
+
+    UVCProfile      *profile = [UVCProfile profileWithController:_targetDevice];
+
+    if ( ! argument || ! [profile writeToFile:[NSString stringWithUTF8String:argument]] ) {
+      fprintf(_errStream, "ERROR:  unable to write profile to %s\n", (argument ? argument : ""));
+      return EACCES;
+    }
+    return 0;
+  }
+
+//
+
+  - (int) applyProfile:(const char*)argument
+  {
+    if ( ! _targetDevice && ! _targetGroup ) {
+      fprintf(_errStream, "ERROR:  no target device selected\n");
+      return ENODEV;
+    }
+
+    UVCProfile                  *profile = ( argument ? [UVCProfile profileWithContentsOfFile:[NSString stringWithUTF8String:argument]] : nil );
+
+    if ( ! profile ) {
+      fprintf(_errStream, "ERROR:  unable to read profile from %s\n", (argument ? argument : ""));
+      return EINVAL;
+    }
+    if ( _targetGroup ) {
+      [_targetGroup applyProfile:profile flags:_scanFlags];
+      return [self reportGroupOperation];
+    }
+
+    UVCProfileApplyStatistics   stats;
+    BOOL                        didApply = [profile applyToController:_targetDevice flags:_scanFlags statistics:&stats];
+
+    UVCCommandSessionPrintProfileStatistics(_outStream, &stats);
+    if ( ! didApply ) {
+      fprintf(_errStream, "ERROR:  unable to apply %lu control(s) from profile %s\n", (unsigned long)stats.failedCount, argument);
+      return EACCES;
+    }
+    return 0;
+  }
+
+//
+
+  - (int) writeStatistics
+  {
+    NSMutableArray              *devices = [NSMutableArray array];
+    NSEnumerator                *eDevices;
+    UVCController               *device;
+    BOOL                        isFirst = YES;
+    
+    if ( _targetGroup ) {
+      [devices addObjectsFromArray:[_targetGroup controllers]];
+    } else if ( _targetDevice ) {
+      [devices addObject:_targetDevice];
+    } else {
+      // Every device this session has created (without enumerating any more):
+      if ( _devices ) [devices addObjectsFromArray:_devices];
+      eDevices = [_probedDevices objectEnumerator];
+      while ( (device = [eDevices nextObject]) ) {
+        if ( ! [devices containsObject:device] ) [devices addObject:device];
+      }
+      if ( _simulatedDevice ) [devices addObject:_simulatedDevice];
+      if ( _simulatedGroupDevices ) [devices addObjectsFromArray:_simulatedGroupDevices];
+    }
+    fprintf(_outStream, "{\"devices\":[");
+    eDevices = [devices objectEnumerator];
+    while ( (device = [eDevices nextObject]) ) {
+      if ( ! isFirst ) fputc(',', _outStream);
+      [device writeRequestStatisticsAsJSONToStream:_outStream];
+      isFirst = NO;
+    }
+    fprintf(_outStream, "]}\n");
+    return 0;
+  }
+
+//
+
+  - (int) dump
+  {
+    NSArray                     *devices = nil;
+    NSEnumerator                *eDevices;
+    UVCController               *device;
+    NSUInteger                  recordCount = 0, failedCount = 0, deviceCount = 0;
+    
+    if ( _targetGroup ) {
+      devices = [_targetGroup controllers];
+    } else if ( _targetDevice ) {
+      devices = [NSArray arrayWithObject:_targetDevice];
+    } else if ( _devices ) {
+      devices = _devices;
+    }
+    if ( devices ) {
+      eDevices = [devices objectEnumerator];
+      while ( (device = [eDevices nextObject]) ) {
+        @autoreleasepool {
+          NSUInteger            failed = 0;
+          
+          recordCount += [device writeControlsAsNDJSONToStream:_outStream failedCount:&failed];
+          failedCount += failed;
+          deviceCount++;
+        }
+      }
+    } else {
+      NSEnumerator              *eDeviceInfos = [[UVCDeviceInfo deviceInfosMatchingFilter:NULL] objectEnumerator];
+      UVCDeviceInfo             *deviceInfo;
+      
+      while ( (deviceInfo = [eDeviceInfos nextObject]) ) {
+        @autoreleasepool {
+          NSNumber              *key = [NSNumber numberWithUnsignedInt:[deviceInfo locationId]];
+          NSUInteger            failed = 0;
+          
+          if ( ! (device = [_probedDevices objectForKey:key]) ) {
+            if ( (device = [deviceInfo controller]) ) [_probedDevices setObject:device forKey:key];
+          }
+          if ( device ) {
+            recordCount += [device writeControlsAsNDJSONToStream:_outStream failedCount:&failed];
+            failedCount += failed;
+            deviceCount++;
+          }
+        }
+      }
+    }
+    if ( ! deviceCount ) {
+      fprintf(_errStream, "ERROR:  no UVC-capable devices available\n");
+      return ENODEV;
+    }
+    if ( _scanFlags & kUVCTypeScanFlagShowInfo ) fprintf(_errStream, "INFO:  dumped %lu control(s) of %lu device(s); %lu value(s) could not be read\n", (unsigned long)recordCount, (unsigned long)deviceCount, (unsigned long)failedCount);
+    return 0;
+  }
+
+//
+
+  - (int) getControlsNamed:(NSString**)controlNames
+    count:(NSUInteger)count
+    valueOnly:(const BOOL*)valueOnly
+    statistics:(UVCCommandBatchStatistics*)stats
+  {
+    UVCControl        *controls[count];
+    NSMutableArray    *readableControls = [NSMutableArray array];
+    BOOL              didRead = NO;
+    NSUInteger        i;
+    int               rc = 0;
+
+    for ( i = 0; i < count; i++ ) {
+      controls[i] = ( _targetDevice ? [_targetDevice controlWithName:controlNames[i]] : nil );
+      if ( controls[i] && [controls[i] supportsGetValue] && ([readableControls indexOfObjectIdenticalTo:controls[i]] == NSNotFound) ) [readableControls addObject:controls[i]];
+    }
+    if ( [readableControls count] > 1 ) {
+      didRead = [_targetDevice readControls:readableControls];
+      if ( didRead && stats ) {
+        stats->sharedReadCount += count;
+        stats->sharedReadGroupCount++;
+      }
+    }
+    for ( i = 0; i < count; i++ ) {
+      int             commandRc;
+
+      if ( didRead && controls[i] && [controls[i] supportsGetValue] ) {
+        UVCValue      *value = [controls[i] valueBuffer];
+        char          valueStr[[[value valueType] maximumFormattedLength] + 1];
+
+        [value formatAs:kUVCTypeFormatDefault intoCString:valueStr length:sizeof(valueStr)];
+        if ( valueOnly[i] ) {
+          fprintf(_outStream, "%s\n", valueStr);
+        } else {
+          fprintf(_outStream, "%s = %s\n", [controlNames[i] UTF8String], valueStr);
+        }
+        commandRc = 0;
+      } else {
+        // Fall back to the individual command, which reports any error:
+        commandRc = [self getControl:[controlNames[i] UTF8String] valueOnly:valueOnly[i]];
+      }
+      if ( stats ) {
+        stats->commandCount++;
+        if ( commandRc ) stats->failedCount++;
+      }
+      if ( commandRc ) rc = commandRc;
+    }
+    fflush(_outStream);
+    return rc;
+  }
+
+//
+
+  - (int) reportGroupOperation
+  {
+    NSArray           *devices = [_targetGroup controllers];
+    NSUInteger        i, count = [devices count], firstIndex, lastIndex;
+    NSTimeInterval    writeSkew = [_targetGroup writeSkewFirstIndex:&firstIndex lastIndex:&lastIndex];
+    int               rc = 0;
+
+    for ( i = 0; i < count; i++ ) {
+      UVCController                   *device = [devices objectAtIndex:i];
+      const UVCControllerGroupResult  *result = [_targetGroup resultAtIndex:i];
+
+      if ( result->profileStats.controlCount ) {
+        fprintf(_outStream, "0x%08x: ", [device locationId]);
+        UVCCommandSessionPrintProfileStatistics(_outStream, &result->profileStats);
+      }
+      if ( result->rc ) {
+        fprintf(_errStream, "ERROR:  0x%08x (%s): %s\n", [device locationId], [[device deviceName] UTF8String], result->reason);
+        rc = result->rc;
+      }
+    }
+    fprintf(_outStream, "%lu device(s): %lu succeeded, %lu failed; ", (unsigned long)count, (unsigned long)(count - [_targetGroup failedCount]), (unsigned long)[_targetGroup failedCount]);
+    if ( firstIndex != lastIndex ) {
+      fprintf(_outStream, "write skew %.3f ms (first 0x%08x, last 0x%08x); ", writeSkew * 1000.0, [[devices objectAtIndex:firstIndex] locationId], [[devices objectAtIndex:lastIndex] locationId]);
+    }
+    fprintf(_outStream, "%.3f ms elapsed\n", [_targetGroup elapsedTime] * 1000.0);
+    return rc;
+  }
+
+@end
+
+//
+#if 0
+#pragma mark -
+#endif
+//
+
+@implementation UVCCommandSession
+
+  + (UVCCommandSession*) commandSession
+  {
+    return [[[UVCCommandSession alloc] init] autorelease];
+  }
+
+//
+
+  + (UVCCommandSession*) commandSessionWithSession:(UVCCommandSession*)session
+  {
+    UVCCommandSession   *newSession = [[UVCCommandSession alloc] init];
+
+    if ( newSession ) {
+      newSession->_devices = [[session devices] retain];
+      [newSession->_probedDevices release];
+      newSession->_probedDevices = [session->_probedDevices retain];
+      newSession->_simulatedDevice = [session->_simulatedDevice retain];
+      newSession->_simulatedGroupDevices = [session->_simulatedGroupDevices retain];
+      newSession->_targetDevice = [[session targetDevice] retain];
+      newSession->_targetGroup = [[session targetGroup] retain];
+      newSession->_scanFlags = [session scanFlags];
+    }
+    return [newSession autorelease];
+  }
+
+//
+
+  - (id) init
+  {
+    if ( (self = [super init]) ) {
+      _scanFlags = kUVCTypeScanFlagShowWarnings;
+      _probedDevices = [[NSMutableDictionary alloc] init];
+      _outStream = stdout;
+      _errStream = stderr;
+    }
+    return self;
+  }
+
+//
+
+  - (void) dealloc
+  {
+    if ( _targetGroup ) [_targetGroup release];
+    if ( _targetDevice ) [_targetDevice release];
+    if ( _simulatedGroupDevices ) [_simulatedGroupDevices release];
+    if ( _simulatedDevice ) [_simulatedDevice release];
+    if ( _probedDevices ) [_probedDevices release];
+    if ( _devices ) [_devices release];
+    [super dealloc];
+  }
+
+//
+
+  - (NSArray*) devices
+  {
+    if ( ! _devices ) _devices = [[UVCController uvcControllers] retain];
+    return _devices;
+  }
+
+//
+
+  - (UVCController*) targetDevice
+  {
+    return _targetDevice;
+  }
+  - (void) setTargetDevice:(UVCController*)targetDevice
+  {
+    if ( targetDevice != _targetDevice ) {
+      if ( _targetDevice ) [_targetDevice release];
+      _targetDevice = ( targetDevice ? [targetDevice retain] : nil );
+    }
+    if ( _targetGroup ) {
+      [_targetGroup release];
+      _targetGroup = nil;
+    }
+  }
+
+//
+
+  - (UVCControllerGroup*) targetGroup
+  {
+    return _targetGroup;
+  }
+  - (void) setTargetGroup:(UVCControllerGroup*)targetGroup
+  {
+    if ( targetGroup ) [targetGroup retain];
+    [self setTargetDevice:nil];
+    _targetGroup = targetGroup;
+  }
+
+//
+
+  - (UVCTypeScanFlags) scanFlags
+  {
+    return _scanFlags;
+  }
+  - (void) setScanFlags:(UVCTypeScanFlags)scanFlags
+  {
+    _scanFlags = scanFlags;
+  }
+
+//
+
+  - (void) setOutStream:(FILE*)outStream
+    errStream:(FILE*)errStream
+  {
+    _outStream = outStream;
+    _errStream = errStream;
+  }
+
+//
+
+  - (int) performCommand:(UVCCommand)command
+    argument:(const char*)argument
+  {
+    switch ( command ) {
+
+      case kUVCCommandListDevices:
+        return [self listDevices];
+
+      case kUVCCommandListControls:
+        return [self listControls];
+
+      case kUVCCommandShowControl:
+        return [self showControl:argument];
+
+      case kUVCCommandSet:
+        return [self setControl:argument];
+
+      case kUVCCommandGet:
+      case kUVCCommandGetValue:
+        return [self getControl:argument valueOnly:(command == kUVCCommandGetValue)];
+
+      case kUVCCommandResetAll:
+        return [self resetAll];
+
+      case kUVCCommandSelectNone:
+        [self setTargetDevice:nil];
+        return 0;
+
+      case kUVCCommandSelectByVendorAndProductId:
+        return [self selectByVendorAndProductId:argument];
+
+      case kUVCCommandSelectByLocationId:
+        return [self selectByLocationId:argument];
+
+      case kUVCCommandSelectByName:
+        return [self selectByName:argument];
+
+      case kUVCCommandSelectByIndex:
+        return [self selectByIndex:argument];
+
+      case kUVCCommandSaveProfile:
+        return [self saveProfile:argument];
+
+      case kUVCCommandApplyProfile:
+        return [self applyProfile:argument];
+
+      case kUVCCommandSelectSimulated:
+        return [self selectSimulated];
+
+      case kUVCCommandSelect:
+        return [self select:argument];
+
+      case kUVCCommandSelectAll:
+        return [self selectAll];
+
+      case kUVCCommandSelectAllByVendorAndProductId:
+        return [self selectAllByVendorAndProductId:argument];
+
+      case kUVCCommandSelectAllByLocationId:
+        return [self selectAllByLocationId:argument];
+
+      case kUVCCommandSelectSimulatedGroup:
+        return [self selectSimulatedGroup:argument];
+
+      case kUVCCommandStats:
+        return [self writeStatistics];
+
+      case kUVCCommandDump:
+        return [self dump];
+
+      case kUVCCommandNone:
+        break;
+
+    }
+    fprintf(_errStream, "ERROR:  unknown command\n");
+    return EINVAL;
+  }
+
+//
+
+  - (int) performCommandLine:(const char*)commandLine
+  {
+    const char    *name, *argumentPtr;
+    size_t        nameLen, argumentLen;
+    UVCCommand    command = UVCCommandParseLine(commandLine, &name, &nameLen, &argumentPtr, &argumentLen);
+
+    if ( command == kUVCCommandNone ) {
+      fprintf(_errStream, "ERROR:  unknown command: %.*s\n", (int)nameLen, name);
+      return EINVAL;
+    }
+
+    char          argument[argumentLen + 1];
+
+    memcpy(argument, argumentPtr, argumentLen);
+    argument[argumentLen] = '\0';
+    return [self performCommand:command argument:(argumentLen ? argument : NULL)];
+  }
+
+//
+
+  - (int) performCommandsFromFileDescriptor:(int)fd
+    exitOnErrors:(BOOL)exitOnErrors
+    statistics:(UVCCommandBatchStatistics*)stats
+  {
+    UVCCommandLineReader  reader;
+    char                  *line;
+    int                   rc = 0;
+
+    if ( stats ) memset(stats, 0, sizeof(*stats));
+    UVCCommandLineReaderInit(&reader, fd);
+    line = UVCCommandLineReaderNextLine(&reader, YES);
+    while ( line ) {
+      @autoreleasepool {
+        const char        *name, *argument;
+        size_t            nameLen, argumentLen;
+        UVCCommand        command = UVCCommandParseLine(line, &name, &nameLen, &argument, &argumentLen);
+        int               commandRc = 0;
+
+        if ( ! nameLen || (*name == '#') ) {
+          line = UVCCommandLineReaderNextLine(&reader, YES);
+          continue;
+        }
+        if ( (command == kUVCCommandGet) || (command == kUVCCommandGetValue) ) {
+          NSString        *controlNames[UVCCommandSessionMaxSharedReads];
+          BOOL            valueOnly[UVCCommandSessionMaxSharedReads];
+          NSUInteger      count = 0;
+
+          //
+          // Gather the run of get commands that can be read right now; the
+          // first line that isn't one is carried over to the next iteration:
+          //
+          while ( 1 ) {
+            controlNames[count] = [[[NSString alloc] initWithBytes:argument length:argumentLen encoding:NSASCIIStringEncoding] autorelease];
+            valueOnly[count] = ( command == kUVCCommandGetValue );
+            count++;
+            if ( count == UVCCommandSessionMaxSharedReads ) {
+              line = UVCCommandLineReaderNextLine(&reader, YES);
+              break;
+            }
+            if ( ! (line = UVCCommandLineReaderNextLine(&reader, NO)) ) {
+              if ( reader.isAtEOF ) break;
+              // Nothing more yet, so don't keep the output waiting:
+              commandRc = [self getControlsNamed:controlNames count:count valueOnly:valueOnly statistics:stats];
+              count = 0;
+              if ( commandRc ) {
+                rc = commandRc;
+                if ( exitOnErrors ) break;
+              }
+              line = UVCCommandLineReaderNextLine(&reader, YES);
+              if ( ! line ) break;
+            }
+            command = UVCCommandParseLine(line, &name, &nameLen, &argument, &argumentLen);
+            if ( ((command != kUVCCommandGet) && (command != kUVCCommandGetValue)) || ! argumentLen ) break;
+          }
+          if ( count ) commandRc = [self getControlsNamed:controlNames count:count valueOnly:valueOnly statistics:stats];
+        } else {
+          char            argumentCopy[argumentLen + 1];
+
+          memcpy(argumentCopy, argument, argumentLen);
+          argumentCopy[argumentLen] = '\0';
+          if ( command == kUVCCommandNone ) {
+            fprintf(_errStream, "ERROR:  unknown command: %.*s\n", (int)nameLen, name);
+            commandRc = EINVAL;
+          } else {
+            commandRc = [self performCommand:command argument:(argumentLen ? argumentCopy : NULL)];
+          }
+          if ( stats ) {
+            stats->commandCount++;
+            if ( commandRc ) stats->failedCount++;
+          }
+          fflush(_outStream);
+          line = UVCCommandLineReaderNextLine(&reader, YES);
+        }
+        if ( commandRc ) {
+          rc = commandRc;
+          if ( exitOnErrors ) break;
+        }
+      }
+    }
+    UVCCommandLineReaderDestroy(&reader);
+    return rc;
+  }
+
+@end
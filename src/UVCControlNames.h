@@ -0,0 +1,61 @@
+//
+//  UVCControlNames.h
+//
+//  Names of the controls implemented by UVCController, with a perfect hash
+//  look-up from name to control index.
+//
+//  Copyright © 2016
+//  Dr. Jeffrey Frey, IT-NSS
+//  University of Delaware
+//
+// $Id$
+//
+
+#import <Foundation/Foundation.h>
+
+/*!
+  @defined UVCControlNameCount
+
+  Number of control names (and of controls in UVCController's table).
+*/
+#define UVCControlNameCount         39
+
+/*!
+  @defined UVCControlNameMaxLength
+
+  Length of the longest control name.
+*/
+#define UVCControlNameMaxLength     28
+
+/*!
+  @defined UVCControlNameInvalidIndex
+
+  Returned by the look-up functions for a name that is not a control's.
+*/
+#define UVCControlNameInvalidIndex  ((NSUInteger)-1)
+
+/*!
+  @var UVCControlNames
+
+  The control names, in the order of UVCController's control table:  the
+  index of a name is the index of its control.  The order is baked into the
+  perfect hash table and into capability cache files, so names may only be
+  appended.
+*/
+extern const char * const UVCControlNames[UVCControlNameCount];
+
+/*!
+  @function UVCControlNameIndexForCString
+
+  Returns the index of the control with the given name, or
+  UVCControlNameInvalidIndex.  One hash, one table probe, one string
+  comparison; nothing is allocated.
+*/
+NSUInteger UVCControlNameIndexForCString(const char *name);
+
+/*!
+  @function UVCControlNameIndexForString
+
+  Same as UVCControlNameIndexForCString() for an NSString.
+*/
+NSUInteger UVCControlNameIndexForString(NSString *name);
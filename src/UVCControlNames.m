@@ -0,0 +1,140 @@
+//
+//  UVCControlNames.m
+//
+//  Names of the controls implemented by UVCController, with a perfect hash
+//  look-up from name to control index.
+//
+//  Copyright © 2016
+//  Dr. Jeffrey Frey, IT-NSS
+//  University of Delaware
+//
+// $Id$
+//
+
+#import "UVCControlNames.h"
+
+#include <string.h>
+
+const char * const UVCControlNames[UVCControlNameCount] = {
+                      "scanning-mode",
+                      "auto-exposure-mode",
+                      "auto-exposure-priority",
+                      "exposure-time-abs",
+                      "exposure-time-rel",
+                      "focus-abs",
+                      "focus-rel",
+                      "auto-focus",
+                      "iris-abs",
+                      "iris-rel",
+                      "zoom-abs",
+                      "zoom-rel",
+                      "pan-tilt-abs",
+                      "pan-tilt-rel",
+                      "roll-abs",
+                      "roll-rel",
+                      "privacy",
+                      "focus-simple",
+                      "window",
+                      "region-of-interest",
+                      "backlight-compensation",
+                      "brightness",
+                      "contrast",
+                      "gain",
+                      "power-line-frequency",
+                      "hue",
+                      "saturation",
+                      "sharpness",
+                      "gamma",
+                      "white-balance-temp",
+                      "auto-white-balance-temp",
+                      "white-balance-component",
+                      "auto-white-balance-component",
+                      "digital-multiplier",
+                      "digital-multiplier-limit",
+                      "auto-hue",
+                      "analog-video-standard",
+                      "analog-lock-status",
+                      "auto-contrast"
+                    };
+
+/*!
+  @defined UVCControlNameHashSeed
+  
+  Seed for UVCControlNameHash() chosen (by trying successive values from 1)
+  such that every name in UVCControlNames lands in a distinct slot of the
+  UVCControlNameSlots table.  If controls are added or renamed, the seed and
+  table must be regenerated; +[UVCController initialize] verifies them.
+*/
+#define UVCControlNameHashSeed 138
+
+/*!
+  @defined UVCControlNameSlotCount
+  
+  Number of slots in the UVCControlNameSlots table (a power of two).
+*/
+#define UVCControlNameSlotCount 128
+
+/*!
+  @constant UVCControlNameSlots
+  
+  Perfect hash table over the control names:  the slot selected by a name's hash
+  holds 1 + the index of the control in UVCControlNames, or zero if no
+  control hashes to that slot.
+*/
+static const UInt8 UVCControlNameSlots[UVCControlNameSlotCount] = {
+                       4,  0, 38,  0,  0,  0,  0,  0,  0,  0,  9,  0,  0,  0,  0,  0,
+                      29,  0,  0, 14,  0, 27,  0, 19,  0,  0,  0,  0, 16,  0,  0, 34,
+                       0, 25,  0,  0,  0, 31,  0,  0,  0,  0, 28, 15,  0,  0,  0,  0,
+                      20,  0,  0,  0, 26,  0,  0,  0, 23,  0,  0,  0,  0,  0,  2,  0,
+                       0,  0, 39,  0,  0,  0,  0,  0,  0, 30, 12,  0,  0,  5,  0, 21,
+                       6, 13, 22,  1,  0,  0,  0,  0,  0,  8,  0,  0,  0, 11, 10, 17,
+                       0,  0,  0, 35,  3, 36,  0,  0,  0,  0,  0,  0,  0,  0,  0, 33,
+                       0,  0,  0,  0, 32,  0,  7,  0,  0, 24, 37,  0,  0,  0,  0, 18
+                    };
+
+/*!
+  @function UVCControlNameHash
+  
+  Seeded 32-bit FNV-1a hash of a NUL-terminated control name, with the high half
+  folded into the low bits.
+*/
+static inline UInt32
+UVCControlNameHash(
+  const char    *name
+)
+{
+  UInt32        hash = 0x811c9dc5 ^ UVCControlNameHashSeed;
+  
+  while ( *name ) {
+    hash ^= (UInt8)*name++;
+    hash *= 0x01000193;
+  }
+  return hash ^ (hash >> 16);
+}
+
+//
+
+NSUInteger
+UVCControlNameIndexForCString(
+  const char    *name
+)
+{
+  UInt8         slot = UVCControlNameSlots[UVCControlNameHash(name) & (UVCControlNameSlotCount - 1)];
+  
+  if ( slot && (strcmp(UVCControlNames[slot - 1], name) == 0) ) return slot - 1;
+  return UVCControlNameInvalidIndex;
+}
+
+//
+
+NSUInteger
+UVCControlNameIndexForString(
+  NSString      *name
+)
+{
+  char          cString[UVCControlNameMaxLength + 1];
+
+  // Anything that won't fit in the buffer can't be one of our names:
+  if ( ! [name getCString:cString maxLength:sizeof(cString) encoding:NSASCIIStringEncoding] ) return UVCControlNameInvalidIndex;
+  return UVCControlNameIndexForCString(cString);
+}
@@ -16,13 +16,145 @@
 #include <IOKit/IOMessage.h>
 #include <IOKit/IOCFPlugIn.h>
 #include <IOKit/usb/IOUSBLib.h>
+#include <pthread.h>
 
 #import "UVCValue.h"
+#import "UVCTransport.h"
+#import "UVCRequestStatistics.h"
+#include "UVCDescriptor.h"
+
+// On newer versions of Mac OS X, the kIOMasterPortDefault enum has been
+// replaced by kIOMainPortDefault.  Everything that talks to the I/O Registry
+// imports this header, so the shim lives here:
+#if (MAC_OS_X_VERSION_MAX_ALLOWED < 120000) // Before macOS 12 Monterey
+  #define kIOMainPortDefault kIOMasterPortDefault
+#endif
 
 //
 // Forward-declare the UVCControl class:
 //
 @class UVCControl;
+@class UVCCapabilityCache;
+@class UVCRequestQueue;
+@class UVCWriteQueue;
+@class UVCValueArena;
+
+/*!
+  @typedef UVCControlChangeAttribute
+
+  What changed about a control, as reported by a UVCControlChangeEvent.  The
+  values are the bAttribute codes of a UVC control-change status packet:
+
+    - kUVCControlChangeValue:  the control's value; the new value is in the
+      control's valueBuffer
+    - kUVCControlChangeInfo:  the control's GET_INFO capabilities (e.g. it was
+      disabled or enabled by an automatic mode)
+    - kUVCControlChangeFailure:  an asynchronous control failed; failureCode
+      holds the device's request error code
+    - kUVCControlChangeMinimum, kUVCControlChangeMaximum:  the control's
+      minimum or maximum, which have been updated
+*/
+typedef enum {
+  kUVCControlChangeValue      = 0,
+  kUVCControlChangeInfo       = 1,
+  kUVCControlChangeFailure    = 2,
+  kUVCControlChangeMinimum    = 3,
+  kUVCControlChangeMaximum    = 4
+} UVCControlChangeAttribute;
+
+/*!
+  @typedef UVCControlChangeEvent
+
+  Describes a single change observed by watchControls:pollInterval:duration:callback:context:
+  of UVCController.  The timestamp is the time (seconds since the reference date) at
+  which the change was observed; isFromStatusInterrupt is NO if the change was found
+  by polling.
+*/
+typedef struct {
+  UVCControl                  *control;
+  UVCControlChangeAttribute   attribute;
+  UInt8                       failureCode;
+  BOOL                        isFromStatusInterrupt;
+  NSTimeInterval              timestamp;
+} UVCControlChangeEvent;
+
+/*!
+  @typedef UVCControlChangeCallback
+
+  Function called for each UVCControlChangeEvent.  Return NO to stop watching.
+*/
+typedef BOOL (*UVCControlChangeCallback)(void *context, const UVCControlChangeEvent *event);
+
+/*!
+  @typedef UVCRequestErrorCode
+
+  The codes a device reports through its VideoControl interface's
+  VC_REQUEST_ERROR_CODE_CONTROL after stalling a request.  The value
+  kUVCRequestErrorCodeUnknown (not defined by the UVC specification) means
+  no code could be obtained, e.g. because the request timed out.
+*/
+typedef enum {
+  kUVCRequestErrorCodeNone                    = 0x00,
+  kUVCRequestErrorCodeNotReady                = 0x01,
+  kUVCRequestErrorCodeWrongState              = 0x02,
+  kUVCRequestErrorCodePower                   = 0x03,
+  kUVCRequestErrorCodeOutOfRange              = 0x04,
+  kUVCRequestErrorCodeInvalidUnit             = 0x05,
+  kUVCRequestErrorCodeInvalidControl          = 0x06,
+  kUVCRequestErrorCodeInvalidRequest          = 0x07,
+  kUVCRequestErrorCodeInvalidValueWithinRange = 0x08,
+  kUVCRequestErrorCodeUnknown                 = 0xFF
+} UVCRequestErrorCode;
+
+/*!
+  @function UVCRequestErrorCodeString
+
+  Returns a constant, human-readable description of errorCode.
+*/
+const char* UVCRequestErrorCodeString(UVCRequestErrorCode errorCode);
+
+/*!
+  @typedef UVCRequestFailure
+
+  The outcome of a control request delivered by a UVCController:  the result
+  of its final attempt, the device's request error code (if the request
+  stalled), and the number of attempts made.
+*/
+typedef struct {
+  IOReturn                    result;
+  UVCRequestErrorCode         errorCode;
+  NSUInteger                  attemptCount;
+} UVCRequestFailure;
+
+/*!
+  @function UVCRequestFailureIsTimeout
+
+  Returns YES if failure describes a request the device did not complete
+  before its deadline.
+*/
+BOOL UVCRequestFailureIsTimeout(UVCRequestFailure failure);
+
+/*!
+  @defined UVCControllerDefaultRequestTimeout
+
+  Default deadline (in seconds) for a single control request.
+*/
+#define UVCControllerDefaultRequestTimeout        1.0
+
+/*!
+  @defined UVCControllerDefaultMaximumRequestRetries
+
+  Default number of times a request that failed transiently is retried.
+*/
+#define UVCControllerDefaultMaximumRequestRetries 2
+
+/*!
+  @defined UVCControllerDefaultRequestRetryBackoff
+
+  Default delay (in seconds) before the first retry of a request; each
+  further retry waits twice as long as the one before.
+*/
+#define UVCControllerDefaultRequestRetryBackoff   0.005
 
 /*!
   @class UVCController
@@ -35,6 +167,10 @@
   instantiated.  The vendor- and product-id; USB location id; interface index;
   version of the UVC specification implemented; and the control enablement bit
   vectors are all explored and retained when available.
+
+  All control requests are delivered through a UVCTransport.  Instances
+  created from the I/O Registry use a UVCIOKitTransport; an instance can also
+  be created around any other transport (e.g. a UVCSimulatedTransport).
 */
 @interface UVCController : NSObject
 {
@@ -45,14 +181,29 @@
   // All necessary functionality comes from USB standard 2.2.0:
   IOUSBInterfaceInterface220    **_controllerInterface;
   
-  BOOL                          _isInterfaceOpen;
-  BOOL                          _shouldNotCloseInterface;
+  id<UVCTransport>              _transport;
+  NSUInteger                    _maximumRequestsInFlight;
   uint8_t                       _videoInterfaceIndex;
   NSMutableDictionary           *_controls;
   NSMutableDictionary           *_unitIds;
   UInt16                        _uvcVersion;
   NSData                        *_terminalControlsAvailable;
   NSData                        *_processingUnitControlsAvailable;
+  NSData                        *_videoControlDescriptors;
+  UVCDescriptorGraph            *_descriptorGraph;
+  UInt64                        _descriptorHash;
+  UVCCapabilityCache            *_capabilityCache;
+  UVCWriteQueue                 *_writeQueue;
+  BOOL                          _coalescesWrites;
+  UVCRequestStatistics          *_requestStatistics;
+  UVCValueArena                 *_valueArena;
+  UVCRequestQueue               *_idleRequestQueue;
+  pthread_mutex_t               _requestQueueLock;
+  UInt64                        _controlsAvailable;
+  NSTimeInterval                _requestTimeout, _requestRetryBackoff;
+  NSUInteger                    _maximumRequestRetries;
+  UVCRequestFailure             _lastRequestFailure;
+  pthread_mutex_t               _requestFailureLock;
 }
 
 /*!
@@ -61,6 +212,9 @@
   Scan the USB bus and locate all video devices that appear to be UVC-compliant.
   Returns an NSArray containing all such devices, or nil if no devices were
   present.
+
+  Every device is fully probed; to choose among devices first and probe only
+  the one chosen, see UVCDeviceInfo.
 */
 + (NSArray*) uvcControllers;
 
@@ -100,6 +254,37 @@
 */
 + (id) uvcControllerWithVendorId:(UInt16)vendorId productId:(UInt16)productId;
 
+/*!
+  @method uvcControllerWithTransport:deviceName:vendorId:productId:
+
+  Returns an autoreleased instance of the class which delivers all control
+  requests via transport.  No device descriptors are available, so every
+  control is assumed to be present until the device proves otherwise; the
+  default unit ids (input terminal 1, processing unit 2) are used.
+
+  Controllers created with this method do not use the capability cache.
+*/
++ (id) uvcControllerWithTransport:(id<UVCTransport>)transport deviceName:(NSString*)deviceName vendorId:(UInt16)vendorId productId:(UInt16)productId;
+
+/*!
+  @method uvcControllerWithTransport:deviceName:vendorId:productId:locationId:
+
+  Same as uvcControllerWithTransport:deviceName:vendorId:productId:, but the
+  instance reports locationId (e.g. to tell several simulated devices apart).
+  The location id of the former method is zero.
+*/
++ (id) uvcControllerWithTransport:(id<UVCTransport>)transport deviceName:(NSString*)deviceName vendorId:(UInt16)vendorId productId:(UInt16)productId locationId:(UInt32)locationId;
+
+/*!
+  @method uvcControllerWithTransport:deviceName:vendorId:productId:locationId:videoControlDescriptors:
+
+  Same as uvcControllerWithTransport:deviceName:vendorId:productId:locationId:,
+  but videoControlDescriptors (a VideoControl descriptor block, e.g. one saved
+  with a trace) supplies the UVC version, unit ids, and control enablement a
+  real device would.
+*/
++ (id) uvcControllerWithTransport:(id<UVCTransport>)transport deviceName:(NSString*)deviceName vendorId:(UInt16)vendorId productId:(UInt16)productId locationId:(UInt32)locationId videoControlDescriptors:(NSData*)videoControlDescriptors;
+
 /*!
   @method deviceName
 
@@ -136,6 +321,24 @@
 */
 - (UInt16) uvcVersion;
 
+/*!
+  @method videoControlDescriptors
+
+  Returns the device's class-specific VideoControl interface descriptor block
+  (starting with the VC interface header), or nil if the device provided none.
+  The data is in the same format as the files read by UVCDescriptorGraphParse()
+  and written by the --dump-descriptors option of uvc-util.
+*/
+- (NSData*) videoControlDescriptors;
+
+/*!
+  @method descriptorGraph
+
+  Returns the parsed form of the videoControlDescriptors, or NULL.  The graph
+  remains valid for the lifetime of the receiver.
+*/
+- (const UVCDescriptorGraph*) descriptorGraph;
+
 /*!
   @method isInterfaceOpen
 
@@ -151,6 +354,321 @@
 */
 - (void) setIsInterfaceOpen:(BOOL)isInterfaceOpen;
 
+/*!
+  @method transport
+
+  Returns the transport used to deliver the receiver's control requests.
+*/
+- (id<UVCTransport>) transport;
+
+/*!
+  @method setTransport:
+
+  Deliver the receiver's subsequent control requests via transport (e.g. a
+  UVCTraceRecorder wrapping the current transport).  Requests still in flight
+  on the current transport are completed first.
+*/
+- (void) setTransport:(id<UVCTransport>)transport;
+
+/*!
+  @method defaultRequestTimeout
+
+  Returns the request timeout given to controllers as they are created
+  (initially UVCControllerDefaultRequestTimeout).
+*/
++ (NSTimeInterval) defaultRequestTimeout;
+
+/*!
+  @method setDefaultRequestTimeout:
+
+  Set the request timeout given to controllers created from now on; zero
+  means no deadline.
+*/
++ (void) setDefaultRequestTimeout:(NSTimeInterval)requestTimeout;
+
+/*!
+  @method defaultMaximumRequestRetries
+
+  Returns the retry limit given to controllers as they are created
+  (initially UVCControllerDefaultMaximumRequestRetries).
+*/
++ (NSUInteger) defaultMaximumRequestRetries;
+
+/*!
+  @method setDefaultMaximumRequestRetries:
+
+  Set the retry limit given to controllers created from now on.
+*/
++ (void) setDefaultMaximumRequestRetries:(NSUInteger)maximumRequestRetries;
+
+/*!
+  @method requestTimeout
+
+  Returns the deadline (in seconds) the receiver's transport applies to each
+  control request; zero means none.
+*/
+- (NSTimeInterval) requestTimeout;
+
+/*!
+  @method setRequestTimeout:
+
+  Bound each control request to requestTimeout seconds (zero removes the
+  deadline), so a wedged device cannot block the calling thread
+  indefinitely.  Only transports that implement setRequestTimeout: (e.g.
+  UVCIOKitTransport, which then uses the timeout-capable IOKit requests)
+  honor it.  A request that times out is not retried.
+*/
+- (void) setRequestTimeout:(NSTimeInterval)requestTimeout;
+
+/*!
+  @method maximumRequestRetries
+
+  Returns the number of times the receiver retries a request that failed
+  transiently.
+*/
+- (NSUInteger) maximumRequestRetries;
+
+/*!
+  @method setMaximumRequestRetries:
+
+  Set the number of times a request is retried after a transient failure,
+  i.e. a stall for which the device reports "not ready".  A stall without
+  an error code is treated as permanent.  Zero disables retries.
+*/
+- (void) setMaximumRequestRetries:(NSUInteger)maximumRequestRetries;
+
+/*!
+  @method requestRetryBackoff
+
+  Returns the delay (in seconds) before the first retry of a request.
+*/
+- (NSTimeInterval) requestRetryBackoff;
+
+/*!
+  @method setRequestRetryBackoff:
+
+  Set the delay before the first retry of a request; each further retry of
+  the same request waits twice as long.
+*/
+- (void) setRequestRetryBackoff:(NSTimeInterval)requestRetryBackoff;
+
+/*!
+  @method lastRequestFailure
+
+  Returns the outcome of the most recent control request the receiver
+  delivered on its own (result is kIOReturnSuccess if it succeeded), or of
+  the most recent request in a batch that failed.  After a stall the
+  receiver reads the device's VC_REQUEST_ERROR_CODE_CONTROL, so errorCode
+  says why the device refused the request.
+*/
+- (UVCRequestFailure) lastRequestFailure;
+
+/*!
+  @method maximumRequestsInFlight
+
+  Returns the number of control requests the receiver will keep in flight
+  when delivering a batch of requests (defaults to
+  UVCRequestQueueDefaultWindowSize).
+*/
+- (NSUInteger) maximumRequestsInFlight;
+
+/*!
+  @method setMaximumRequestsInFlight:
+
+  Set the number of control requests the receiver will keep in flight when
+  delivering a batch of requests.  A value of 1 delivers batched requests
+  serially.
+*/
+- (void) setMaximumRequestsInFlight:(NSUInteger)maximumRequestsInFlight;
+
+/*!
+  @method requestQueue
+
+  Returns an autoreleased, empty UVCRequestQueue that delivers requests via
+  the receiver's transport with the receiver's maximumRequestsInFlight.
+*/
+- (UVCRequestQueue*) requestQueue;
+
+/*!
+  @method readControls:
+
+  Read the value of every UVCControl in controls into its current value,
+  with the requests pipelined on the transport.  Returns YES if every
+  control was read successfully.
+*/
+- (BOOL) readControls:(NSArray*)controls;
+
+/*!
+  @method writeControls:
+
+  Write the current value of every UVCControl in controls to the device,
+  with the requests pipelined on the transport.  The requests are issued in
+  array order.  Values for the same controls still waiting in the coalescing
+  write queue are cancelled, since the batch supersedes them.  Returns YES if
+  every control was written successfully.
+*/
+- (BOOL) writeControls:(NSArray*)controls;
+
+/*!
+  @method coalescesWrites
+
+  Returns YES if writes of single controls (e.g. UVCControl's
+  writeFromCurrentValue) pass through the receiver's writeQueue.
+*/
+- (BOOL) coalescesWrites;
+
+/*!
+  @method setCoalescesWrites:
+
+  Enable or disable write coalescing (disabled by default).  While enabled,
+  a single-control write that finds another thread already writing to the
+  device is queued (replacing any value still waiting for the same control)
+  and returns YES at once; the thread doing the writing delivers it.  A
+  write of the value last known to be on the device is skipped.  Disabling
+  coalescing flushes anything still pending.
+*/
+- (void) setCoalescesWrites:(BOOL)coalescesWrites;
+
+/*!
+  @method flushWrites
+
+  Write any values pending in the receiver's writeQueue, unless another
+  thread is already doing so.  Returns NO if any write failed.
+*/
+- (BOOL) flushWrites;
+
+/*!
+  @method writeQueue
+
+  Returns the receiver's UVCWriteQueue (nil if write coalescing has never
+  been enabled), e.g. to inspect its statistics.
+*/
+- (UVCWriteQueue*) writeQueue;
+
+/*!
+  @method requestStatistics
+
+  Returns the latency histograms and failure counts of every control request
+  the receiver has delivered, along with a count of the interface open and
+  close events requested with setIsInterfaceOpen:.
+*/
+- (UVCRequestStatistics*) requestStatistics;
+
+/*!
+  @method valueArena
+
+  Returns the UVCValueArena (indexed by control index) that holds the current
+  value, range, step size, and default value of every UVCControl the receiver
+  has created.  The values of a UVCControl are views onto this arena, and a
+  slot is marked present once the control has obtained that value.
+*/
+- (UVCValueArena*) valueArena;
+
+/*!
+  @method writeRequestStatisticsAsJSONToStream:
+
+  Write the receiver's requestStatistics to stream as a single JSON object
+  (no trailing newline) identifying the device and naming each control.
+  Latencies are in microseconds.
+*/
+- (void) writeRequestStatisticsAsJSONToStream:(FILE*)stream;
+
+/*!
+  @method writeControlsAsNDJSONToStream:failedCount:
+
+  Write one line of JSON to stream for every control the device provides, in
+  the order of the control table:
+
+    {"location-id":"0x14200000","vendor-id":"0x046d","product-id":"0x0825",
+     "control":"brightness","capabilities":["get","set"],
+     "type":{"byte-size":2,"fields":[{"name":"","type":"S2","offset":0}]},
+     "minimum":-64,"maximum":64,"step-size":1,"default":0,"value":0}
+
+  (shown here wrapped; each record is a single line).  Limits the control does
+  not provide, and the value of a control that cannot be read, are null; a
+  failed read adds an "error" member with the IOReturn code.  Values use the
+  JSON form of formatBuffer:format:intoCString:length: (UVCType).
+
+  The interface is kept open throughout.  Every control is created first (so
+  capabilities and limits come from the capability cache when possible), then
+  the current values are read with a single pipelined set of transfers, each
+  record being written and flushed as its read completes.  If failedCount is
+  not NULL it is set to the number of reads that failed.  Returns the number
+  of records written.
+*/
+- (NSUInteger) writeControlsAsNDJSONToStream:(FILE*)stream failedCount:(NSUInteger*)failedCount;
+
+/*!
+  @method refreshCapabilitiesOfControls:
+
+  Re-read the GET_INFO capabilities of every UVCControl in controls, with the
+  requests pipelined on the transport.  The device-provided bits (e.g. whether
+  the control is disabled due to an automatic mode) are updated.  Returns YES
+  if every control was refreshed successfully.
+*/
+- (BOOL) refreshCapabilitiesOfControls:(NSArray*)controls;
+
+/*!
+  @method hasStatusInterruptEndpoint
+
+  Returns YES if the receiver's transport can deliver status packets from the
+  device's VideoControl interrupt endpoint.
+*/
+- (BOOL) hasStatusInterruptEndpoint;
+
+/*!
+  @method watchControls:pollInterval:duration:callback:context:
+
+  Watch the UVCControls in controls for changes, calling callback once for every
+  change until it returns NO or duration seconds have passed (a duration of zero or
+  less means no limit).  Only changes are reported:  the values of all controls are
+  read once at the start, and a value is reported only when it differs from the last
+  one seen.
+
+  If the device has a status interrupt endpoint, controls that the device reports
+  through it (auto-update and asynchronous controls) are watched by waiting on status
+  packets, which cost nothing while the control is idle.  All other readable controls
+  -- every one of them, on a device without the endpoint -- are read (pipelined) no
+  more often than every pollInterval seconds; a pollInterval of zero or less disables
+  polling.
+
+  Returns NO if none of the controls could be watched or the device could not be
+  read.
+*/
+- (BOOL) watchControls:(NSArray*)controls pollInterval:(NSTimeInterval)pollInterval duration:(NSTimeInterval)duration callback:(UVCControlChangeCallback)callback context:(void*)context;
+
+/*!
+  @method capabilityCache
+
+  Returns the on-disk cache of control capabilities and limits associated
+  with the receiver's device, or nil if caching is disabled.
+*/
+- (UVCCapabilityCache*) capabilityCache;
+
+/*!
+  @method invalidateCapabilityCache
+
+  Discard all cached control capabilities and limits for the receiver's
+  device.  Controls instantiated after this call will be probed on the
+  device again.
+*/
+- (void) invalidateCapabilityCache;
+
+/*!
+  @method attachCapabilityCache
+
+  Controllers created by the uvcControllerWithTransport:... methods do not
+  use the on-disk capability cache.  This method attaches the cache for the
+  receiver's vendor- and product-id, UVC version, and descriptor block, just
+  as an I/O Registry-backed controller would have; controls instantiated
+  afterwards are looked-up in (and added to) the cache.  Used by the
+  benchmark harness to measure the cache against a simulated device.
+
+  Returns YES if the receiver has a capability cache after the call, NO if
+  caching is disabled.
+*/
+- (BOOL) attachCapabilityCache;
+
 /*!
   @method controlStrings
 
@@ -165,6 +683,28 @@
 */
 - (NSArray*) controlStrings;
 
+/*!
+  @method controlsAvailable
+
+  Returns the receiver's control availability mask:  bit i is set if the
+  control at index i in controlStrings may be implemented by the device.
+  The mask is decoded once from the terminal and processing unit enablement
+  bitmaps when the VideoControl descriptors are parsed (every control is
+  assumed available if the device provided none) and loses the bit of any
+  control controlWithName: then fails to create.  No control requests are
+  made.
+*/
+- (UInt64) controlsAvailable;
+
+/*!
+  @method availableControlNames
+
+  Returns the names (in controlStrings order) of the controls whose bits are
+  set in controlsAvailable.  Answering requires no control requests; the
+  controls are only probed when they are fetched with controlWithName:.
+*/
+- (NSArray*) availableControlNames;
+
 /*!
   @method controlWithName:
 
@@ -221,6 +761,30 @@ typedef NSUInteger uvc_capabilities_t;
 */
 - (BOOL) supportsSetValue;
 
+/*!
+  @method isDisabledDueToAutomaticMode
+
+  Returns YES if, as of the last time its capabilities were read from the
+  device, this control is under automatic control and cannot be altered.
+*/
+- (BOOL) isDisabledDueToAutomaticMode;
+
+/*!
+  @method isAutoUpdateControl
+
+  Returns YES if the device may change the value of this control on its own
+  (and will report the change through its status interrupt endpoint).
+*/
+- (BOOL) isAutoUpdateControl;
+
+/*!
+  @method isAsynchronousControl
+
+  Returns YES if a write to this control completes some time after the request,
+  with the completion reported through the device's status interrupt endpoint.
+*/
+- (BOOL) isAsynchronousControl;
+
 /*!
   @method hasRange
 
@@ -264,6 +828,14 @@ typedef NSUInteger uvc_capabilities_t;
 */
 - (UVCValue*) currentValue;
 
+/*!
+  @method valueBuffer
+  
+  Returns the receiver's UVCValue object without reading from the device.  It
+  contains whatever was last read from, parsed into, or written to the control.
+*/
+- (UVCValue*) valueBuffer;
+
 /*!
   @method minimum
   
@@ -318,6 +890,15 @@ typedef NSUInteger uvc_capabilities_t;
 */
 - (BOOL) setCurrentValueFromCString:(const char*)cString flags:(UVCTypeScanFlags)flags;
 
+/*!
+  @method setCurrentValueFromCString:flags:errorOffset:
+  
+  Same as setCurrentValueFromCString:flags: but returns the UVCTypeScanStatus
+  of the parse; on failure, errorOffset (if non-NULL) is set to the character
+  offset in cString at which the problem was found.
+*/
+- (UVCTypeScanStatus) setCurrentValueFromCString:(const char*)cString flags:(UVCTypeScanFlags)flags errorOffset:(NSUInteger*)errorOffset;
+
 /*!
   @method readIntoCurrentValue
   
@@ -13,6 +13,11 @@
 //#define DEBUG_WRITE_UVC_HEADER_TO_FILE
 
 #import "UVCController.h"
+#import "UVCCapabilityCache.h"
+#import "UVCRequestQueue.h"
+#import "UVCWriteQueue.h"
+#import "UVCValueArena.h"
+#import "UVCControlNames.h"
 
 //
 // UVC descriptor codes:
@@ -20,17 +25,6 @@
 #define CS_INTERFACE            0x24
 
 #define VC_HEADER               0x01
-#define VC_INPUT_TERMINAL       0x02
-#define VC_OUTPUT_TERMINAL      0x03
-#define VC_SELECTOR_UNIT        0x04
-#define VC_PROCESSING_UNIT      0x05
-#define VC_EXTENSION_UNIT       0x06
-
-// On newer versions of Mac OS X, the kIOMasterPortDefault enum has been
-// replaced by kIOMainPortDefault.
-#if (MAC_OS_X_VERSION_MAX_ALLOWED < 120000) // Before macOS 12 Monterey
-  #define kIOMainPortDefault kIOMasterPortDefault
-#endif
 
 //
 // UVC descriptor data type definitions:
@@ -52,25 +46,10 @@ typedef struct {
   UInt8               baInterfaceNr1;
 }  __attribute__((packed)) UVC_VC_Interface_Header_Descriptor;
 
-typedef struct {
-  UInt8               bLength;
-  UInt8               bDescriptorType;
-  UInt8               bDescriptorSubType;
-  UInt8               bTerminalId;
-  UInt16              wTerminalType;
-  UInt8               bAssocTerminal;
-  UInt8               iTerminal;
-  UInt16              wObjectiveFocalLengthMin;
-  UInt16              wObjectiveFocalLengthMax;
-  UInt16              wOcularFocalLength;
-  UInt8               bControlSize;
-  UInt8               bmControls[];
-} __attribute__((packed)) UVC_VC_Terminal_Header_Descriptor;
-
 /*!
   @enum UVC Terminal control enablement bit values
   
-  The UVC_VC_Terminal_Header_Descriptor contains a variable-length
+  The camera input terminal descriptor contains a variable-length
   bmControls field that expresses the controls which that unit
   implements.  The field is a bitmap, with bit zero (0) being
   the least-significant bit in the first byte -- which happens to
@@ -99,21 +78,10 @@ enum {
   kUVCTerminalControlEnableRegionOfInterest       = 21
 };
 
-typedef struct {
-  UInt8               bLength;
-  UInt8               bDescriptorType;
-  UInt8               bDescriptorSubType;
-  UInt8               bUnitId;
-  UInt8               bSourceId;
-  UInt16              wMaxMultiplier;
-  UInt8               bControlSize;
-  UInt8               bmControls[];
-} __attribute__((packed)) UVC_PU_Header_Descriptor;
-
 /*!
   @enum UVC Processing Unit control enablement bit values
   
-  The UVC_PU_Header_Descriptor contains a variable-length
+  The processing unit descriptor contains a variable-length
   bmControls field that expresses the controls which that unit
   implements.  The field is a bitmap, with bit zero (0) being
   the least-significant bit in the first byte -- which happens to
@@ -153,6 +121,11 @@ enum {
 #define UVC_GET_INFO  0x86
 #define UVC_GET_DEF   0x87
 
+//
+// VideoControl interface controls (unit 0):
+//
+#define VC_REQUEST_ERROR_CODE_CONTROL             0x02
+
 //
 // Terminal controls:
 //
@@ -261,88 +234,218 @@ typedef void (*UVCControllerPreProcessCallback)(void *data, int size);
   
   Each UVC control is defined via one of these data structures.  Since the standard
   declares each control's expected data size and structure, the data structure
-  associates the declared selector-id with the type description string and a cached
-  "compiled" type representation.
+  associates the declared selector-id with the control's name, its enablement bit
+  in the unit/terminal descriptor, a static table of its component fields, and the
+  UVCType built from that table.
 */
 typedef struct {
-  int           unitType;
-  NSString      *unitTypeStr;
-  int           selector;
-  const char    *uvcTypeDescription;
-  UVCType       *uvcType;
+  const char                    *controlName;
+  NSString                      *controlNameStr;
+  int                           unitType;
+  NSString                      *unitTypeStr;
+  int                           selector;
+  int                           enableBit;
+  NSUInteger                    fieldCount;
+  const UVCTypeFieldDescriptor  *fields;
+  UVCType                       *uvcType;
 } uvc_control_t;
 
 /*!
   @defined UVC_CONTROL_INIT
   
   Macro that expands a list of UVCControllerControls field values into a struct
-  initializer statement.
+  initializer statement.  The trailing arguments are the control's component
+  fields as UVCTypeFieldDescriptor initializers.
 */
-#define UVC_CONTROL_INIT(U,S,T) { .unitType = (U), .unitTypeStr = @#U, .selector = (S), .uvcTypeDescription = (T), .uvcType = nil }
+#define UVC_CONTROL_INIT(N,U,S,E,...) { .controlName = (N), .controlNameStr = @N, .unitType = (U), .unitTypeStr = @#U, .selector = (S), .enableBit = (E), \
+                                        .fieldCount = sizeof((const UVCTypeFieldDescriptor[]){ __VA_ARGS__ }) / sizeof(UVCTypeFieldDescriptor), \
+                                        .fields = (const UVCTypeFieldDescriptor[]){ __VA_ARGS__ }, \
+                                        .uvcType = nil }
 
 /*!
   @constant UVCControllerControls
   
   List of all the UVC controls this API supports.  Each control consists of:
   
+    - control name (e.g. "scanning-mode")
+    - unit type (UVC_INPUT_TERMINAL_ID or UVC_PROCESSING_UNIT_ID)
     - control selector (e.g. CT_SCANNING_MODE_CONTROL, PU_BACKLIGHT_COMPENSATION_CONTROL)
-    - UVCType type description string
-    - cached UVCType instance
+    - enablement bit index in the unit's bmControls
+    - component fields
+    - UVCType instance, built once by +[UVCController initialize]
   
-  The index of each control in this array is important!!!  It determines the value that
-  should be assigned to the control's textual name in the controlMapping dictionary
-  (see the controlMapping method).
+  The index of each control in this array is important!!!  It is baked into the
+  UVCControlNames table (and its perfect hash) and into capability cache files.
 */
 uvc_control_t     UVCControllerControls[] = {
-                      UVC_CONTROL_INIT(UVC_INPUT_TERMINAL_ID, CT_SCANNING_MODE_CONTROL, "{B}"),
-                      UVC_CONTROL_INIT(UVC_INPUT_TERMINAL_ID, CT_AE_MODE_CONTROL, "{M1}"),
-                      UVC_CONTROL_INIT(UVC_INPUT_TERMINAL_ID, CT_AE_PRIORITY_CONTROL, "{U1}"),
-                      UVC_CONTROL_INIT(UVC_INPUT_TERMINAL_ID, CT_EXPOSURE_TIME_ABSOLUTE_CONTROL, "{U4}"),
-                      UVC_CONTROL_INIT(UVC_INPUT_TERMINAL_ID, CT_EXPOSURE_TIME_RELATIVE_CONTROL, "{S1}"),
-                      UVC_CONTROL_INIT(UVC_INPUT_TERMINAL_ID, CT_FOCUS_ABSOLUTE_CONTROL, "{U2}"),
-                      UVC_CONTROL_INIT(UVC_INPUT_TERMINAL_ID, CT_FOCUS_RELATIVE_CONTROL, "{S1 focus-relative; U1 focus-speed}"),
-                      UVC_CONTROL_INIT(UVC_INPUT_TERMINAL_ID, CT_FOCUS_AUTO_CONTROL, "{B}"),
-                      UVC_CONTROL_INIT(UVC_INPUT_TERMINAL_ID, CT_IRIS_ABSOLUTE_CONTROL, "{U2}"),
-                      UVC_CONTROL_INIT(UVC_INPUT_TERMINAL_ID, CT_IRIS_RELATIVE_CONTROL, "{S1}"),
-                      UVC_CONTROL_INIT(UVC_INPUT_TERMINAL_ID, CT_ZOOM_ABSOLUTE_CONTROL, "{U2}"),
-                      UVC_CONTROL_INIT(UVC_INPUT_TERMINAL_ID, CT_ZOOM_RELATIVE_CONTROL, "{S1 zoom; B digital-zoom; U1 speed}"),
-                      UVC_CONTROL_INIT(UVC_INPUT_TERMINAL_ID, CT_PANTILT_ABSOLUTE_CONTROL, "{S4 pan; S4 tilt}"),
-                      UVC_CONTROL_INIT(UVC_INPUT_TERMINAL_ID, CT_PANTILT_RELATIVE_CONTROL, "{S1 pan-relative; U1 pan-speed; S1 tilt-relative; U1 tilt-speed}"),
-                      UVC_CONTROL_INIT(UVC_INPUT_TERMINAL_ID, CT_ROLL_ABSOLUTE_CONTROL, "{S2}"),
-                      UVC_CONTROL_INIT(UVC_INPUT_TERMINAL_ID, CT_ROLL_RELATIVE_CONTROL, "{S1 roll-relative; U1 roll-speed}"),
-                      UVC_CONTROL_INIT(UVC_INPUT_TERMINAL_ID, CT_PRIVACY_CONTROL, "{B}"),
-                      UVC_CONTROL_INIT(UVC_INPUT_TERMINAL_ID, CT_FOCUS_SIMPLE_CONTROL, "{U1}"),
-                      UVC_CONTROL_INIT(UVC_INPUT_TERMINAL_ID, CT_WINDOW_CONTROL, "{U2 window-top; U2 window-left; U2 window-bottom; U2 window-right; U2 num-steps; M2 num-steps-units}"),
-                      UVC_CONTROL_INIT(UVC_INPUT_TERMINAL_ID, CT_REGION_OF_INTEREST_CONTROL, "{U2 roi-top; U2 roi-left; U2 roi-bottom; U2 roi-right; M2 auto-controls}"),
+                      UVC_CONTROL_INIT("scanning-mode", UVC_INPUT_TERMINAL_ID, CT_SCANNING_MODE_CONTROL, kUVCTerminalControlEnableScanningMode,
+                          { "", kUVCTypeComponentTypeBoolean }),
+                      UVC_CONTROL_INIT("auto-exposure-mode", UVC_INPUT_TERMINAL_ID, CT_AE_MODE_CONTROL, kUVCTerminalControlEnableAutoExposureMode,
+                          { "", kUVCTypeComponentTypeBitmap8 }),
+                      UVC_CONTROL_INIT("auto-exposure-priority", UVC_INPUT_TERMINAL_ID, CT_AE_PRIORITY_CONTROL, kUVCTerminalControlEnableAutoExposurePriority,
+                          { "", kUVCTypeComponentTypeUInt8 }),
+                      UVC_CONTROL_INIT("exposure-time-abs", UVC_INPUT_TERMINAL_ID, CT_EXPOSURE_TIME_ABSOLUTE_CONTROL, kUVCTerminalControlEnableExposureTimeAbsolute,
+                          { "", kUVCTypeComponentTypeUInt32 }),
+                      UVC_CONTROL_INIT("exposure-time-rel", UVC_INPUT_TERMINAL_ID, CT_EXPOSURE_TIME_RELATIVE_CONTROL, kUVCTerminalControlEnableExposureTimeRelative,
+                          { "", kUVCTypeComponentTypeSInt8 }),
+                      UVC_CONTROL_INIT("focus-abs", UVC_INPUT_TERMINAL_ID, CT_FOCUS_ABSOLUTE_CONTROL, kUVCTerminalControlEnableFocusAbsolute,
+                          { "", kUVCTypeComponentTypeUInt16 }),
+                      UVC_CONTROL_INIT("focus-rel", UVC_INPUT_TERMINAL_ID, CT_FOCUS_RELATIVE_CONTROL, kUVCTerminalControlEnableFocusRelative,
+                          { "focus-relative", kUVCTypeComponentTypeSInt8 },
+                          { "focus-speed", kUVCTypeComponentTypeUInt8 }),
+                      UVC_CONTROL_INIT("auto-focus", UVC_INPUT_TERMINAL_ID, CT_FOCUS_AUTO_CONTROL, kUVCTerminalControlEnableFocusAuto,
+                          { "", kUVCTypeComponentTypeBoolean }),
+                      UVC_CONTROL_INIT("iris-abs", UVC_INPUT_TERMINAL_ID, CT_IRIS_ABSOLUTE_CONTROL, kUVCTerminalControlEnableIrisAbsolute,
+                          { "", kUVCTypeComponentTypeUInt16 }),
+                      UVC_CONTROL_INIT("iris-rel", UVC_INPUT_TERMINAL_ID, CT_IRIS_RELATIVE_CONTROL, kUVCTerminalControlEnableIrisRelative,
+                          { "", kUVCTypeComponentTypeSInt8 }),
+                      UVC_CONTROL_INIT("zoom-abs", UVC_INPUT_TERMINAL_ID, CT_ZOOM_ABSOLUTE_CONTROL, kUVCTerminalControlEnableZoomAbsolute,
+                          { "", kUVCTypeComponentTypeUInt16 }),
+                      UVC_CONTROL_INIT("zoom-rel", UVC_INPUT_TERMINAL_ID, CT_ZOOM_RELATIVE_CONTROL, kUVCTerminalControlEnableZoomRelative,
+                          { "zoom", kUVCTypeComponentTypeSInt8 },
+                          { "digital-zoom", kUVCTypeComponentTypeBoolean },
+                          { "speed", kUVCTypeComponentTypeUInt8 }),
+                      UVC_CONTROL_INIT("pan-tilt-abs", UVC_INPUT_TERMINAL_ID, CT_PANTILT_ABSOLUTE_CONTROL, kUVCTerminalControlEnablePanTiltAbsolute,
+                          { "pan", kUVCTypeComponentTypeSInt32 },
+                          { "tilt", kUVCTypeComponentTypeSInt32 }),
+                      UVC_CONTROL_INIT("pan-tilt-rel", UVC_INPUT_TERMINAL_ID, CT_PANTILT_RELATIVE_CONTROL, kUVCTerminalControlEnablePanTiltRelative,
+                          { "pan-relative", kUVCTypeComponentTypeSInt8 },
+                          { "pan-speed", kUVCTypeComponentTypeUInt8 },
+                          { "tilt-relative", kUVCTypeComponentTypeSInt8 },
+                          { "tilt-speed", kUVCTypeComponentTypeUInt8 }),
+                      UVC_CONTROL_INIT("roll-abs", UVC_INPUT_TERMINAL_ID, CT_ROLL_ABSOLUTE_CONTROL, kUVCTerminalControlEnableRollAbsolute,
+                          { "", kUVCTypeComponentTypeSInt16 }),
+                      UVC_CONTROL_INIT("roll-rel", UVC_INPUT_TERMINAL_ID, CT_ROLL_RELATIVE_CONTROL, kUVCTerminalControlEnableRollRelative,
+                          { "roll-relative", kUVCTypeComponentTypeSInt8 },
+                          { "roll-speed", kUVCTypeComponentTypeUInt8 }),
+                      UVC_CONTROL_INIT("privacy", UVC_INPUT_TERMINAL_ID, CT_PRIVACY_CONTROL, kUVCTerminalControlEnablePrivacy,
+                          { "", kUVCTypeComponentTypeBoolean }),
+                      UVC_CONTROL_INIT("focus-simple", UVC_INPUT_TERMINAL_ID, CT_FOCUS_SIMPLE_CONTROL, kUVCTerminalControlEnableFocusSimple,
+                          { "", kUVCTypeComponentTypeUInt8 }),
+                      UVC_CONTROL_INIT("window", UVC_INPUT_TERMINAL_ID, CT_WINDOW_CONTROL, kUVCTerminalControlEnableWindow,
+                          { "window-top", kUVCTypeComponentTypeUInt16 },
+                          { "window-left", kUVCTypeComponentTypeUInt16 },
+                          { "window-bottom", kUVCTypeComponentTypeUInt16 },
+                          { "window-right", kUVCTypeComponentTypeUInt16 },
+                          { "num-steps", kUVCTypeComponentTypeUInt16 },
+                          { "num-steps-units", kUVCTypeComponentTypeBitmap16 }),
+                      UVC_CONTROL_INIT("region-of-interest", UVC_INPUT_TERMINAL_ID, CT_REGION_OF_INTEREST_CONTROL, kUVCTerminalControlEnableRegionOfInterest,
+                          { "roi-top", kUVCTypeComponentTypeUInt16 },
+                          { "roi-left", kUVCTypeComponentTypeUInt16 },
+                          { "roi-bottom", kUVCTypeComponentTypeUInt16 },
+                          { "roi-right", kUVCTypeComponentTypeUInt16 },
+                          { "auto-controls", kUVCTypeComponentTypeBitmap16 }),
                       //
-                      UVC_CONTROL_INIT(UVC_PROCESSING_UNIT_ID, PU_BACKLIGHT_COMPENSATION_CONTROL, "{U2}"),
-                      UVC_CONTROL_INIT(UVC_PROCESSING_UNIT_ID, PU_BRIGHTNESS_CONTROL, "{S2}"),
-                      UVC_CONTROL_INIT(UVC_PROCESSING_UNIT_ID, PU_CONTRAST_CONTROL, "{U2}"),
-                      UVC_CONTROL_INIT(UVC_PROCESSING_UNIT_ID, PU_GAIN_CONTROL, "{U2}"),
-                      UVC_CONTROL_INIT(UVC_PROCESSING_UNIT_ID, PU_POWER_LINE_FREQUENCY_CONTROL, "{U1}"),
-                      UVC_CONTROL_INIT(UVC_PROCESSING_UNIT_ID, PU_HUE_CONTROL, "{S2}"),
-                      UVC_CONTROL_INIT(UVC_PROCESSING_UNIT_ID, PU_SATURATION_CONTROL, "{U2}"),
-                      UVC_CONTROL_INIT(UVC_PROCESSING_UNIT_ID, PU_SHARPNESS_CONTROL, "{U2}"),
-                      UVC_CONTROL_INIT(UVC_PROCESSING_UNIT_ID, PU_GAMMA_CONTROL, "{U2}"),
-                      UVC_CONTROL_INIT(UVC_PROCESSING_UNIT_ID, PU_WHITE_BALANCE_TEMPERATURE_CONTROL, "{U2}"),
-                      UVC_CONTROL_INIT(UVC_PROCESSING_UNIT_ID, PU_WHITE_BALANCE_TEMPERATURE_AUTO_CONTROL, "{B}"),
-                      UVC_CONTROL_INIT(UVC_PROCESSING_UNIT_ID, PU_WHITE_BALANCE_COMPONENT_CONTROL, "{U2 blue; U2 red}"),
-                      UVC_CONTROL_INIT(UVC_PROCESSING_UNIT_ID, PU_WHITE_BALANCE_COMPONENT_AUTO_CONTROL, "{B}"),
-                      UVC_CONTROL_INIT(UVC_PROCESSING_UNIT_ID, PU_DIGITAL_MULTIPLIER_CONTROL, "{U2}"),
-                      UVC_CONTROL_INIT(UVC_PROCESSING_UNIT_ID, PU_DIGITAL_MULTIPLIER_LIMIT_CONTROL, "{U2}"),
-                      UVC_CONTROL_INIT(UVC_PROCESSING_UNIT_ID, PU_HUE_AUTO_CONTROL,"{B}"),
-                      UVC_CONTROL_INIT(UVC_PROCESSING_UNIT_ID, PU_ANALOG_VIDEO_STANDARD_CONTROL, "{U1}"),
-                      UVC_CONTROL_INIT(UVC_PROCESSING_UNIT_ID, PU_ANALOG_LOCK_STATUS_CONTROL, "{U1}"),
-                      UVC_CONTROL_INIT(UVC_PROCESSING_UNIT_ID, PU_CONTRAST_AUTO_CONTROL, "{U1}")
+                      UVC_CONTROL_INIT("backlight-compensation", UVC_PROCESSING_UNIT_ID, PU_BACKLIGHT_COMPENSATION_CONTROL, kUVCProcessingUnitControlEnableBacklightCompensation,
+                          { "", kUVCTypeComponentTypeUInt16 }),
+                      UVC_CONTROL_INIT("brightness", UVC_PROCESSING_UNIT_ID, PU_BRIGHTNESS_CONTROL, kUVCProcessingUnitControlEnableBrightness,
+                          { "", kUVCTypeComponentTypeSInt16 }),
+                      UVC_CONTROL_INIT("contrast", UVC_PROCESSING_UNIT_ID, PU_CONTRAST_CONTROL, kUVCProcessingUnitControlEnableContrast,
+                          { "", kUVCTypeComponentTypeUInt16 }),
+                      UVC_CONTROL_INIT("gain", UVC_PROCESSING_UNIT_ID, PU_GAIN_CONTROL, kUVCProcessingUnitControlEnableGain,
+                          { "", kUVCTypeComponentTypeUInt16 }),
+                      UVC_CONTROL_INIT("power-line-frequency", UVC_PROCESSING_UNIT_ID, PU_POWER_LINE_FREQUENCY_CONTROL, kUVCProcessingUnitControlEnablePowerLineFrequency,
+                          { "", kUVCTypeComponentTypeUInt8 }),
+                      UVC_CONTROL_INIT("hue", UVC_PROCESSING_UNIT_ID, PU_HUE_CONTROL, kUVCProcessingUnitControlEnableHue,
+                          { "", kUVCTypeComponentTypeSInt16 }),
+                      UVC_CONTROL_INIT("saturation", UVC_PROCESSING_UNIT_ID, PU_SATURATION_CONTROL, kUVCProcessingUnitControlEnableSaturation,
+                          { "", kUVCTypeComponentTypeUInt16 }),
+                      UVC_CONTROL_INIT("sharpness", UVC_PROCESSING_UNIT_ID, PU_SHARPNESS_CONTROL, kUVCProcessingUnitControlEnableSharpness,
+                          { "", kUVCTypeComponentTypeUInt16 }),
+                      UVC_CONTROL_INIT("gamma", UVC_PROCESSING_UNIT_ID, PU_GAMMA_CONTROL, kUVCProcessingUnitControlEnableGamma,
+                          { "", kUVCTypeComponentTypeUInt16 }),
+                      UVC_CONTROL_INIT("white-balance-temp", UVC_PROCESSING_UNIT_ID, PU_WHITE_BALANCE_TEMPERATURE_CONTROL, kUVCProcessingUnitControlEnableWhiteBalanceTemperature,
+                          { "", kUVCTypeComponentTypeUInt16 }),
+                      UVC_CONTROL_INIT("auto-white-balance-temp", UVC_PROCESSING_UNIT_ID, PU_WHITE_BALANCE_TEMPERATURE_AUTO_CONTROL, kUVCProcessingUnitControlEnableAutoWhiteBalanceTemperature,
+                          { "", kUVCTypeComponentTypeBoolean }),
+                      UVC_CONTROL_INIT("white-balance-component", UVC_PROCESSING_UNIT_ID, PU_WHITE_BALANCE_COMPONENT_CONTROL, kUVCProcessingUnitControlEnableWhiteBalanceComponent,
+                          { "blue", kUVCTypeComponentTypeUInt16 },
+                          { "red", kUVCTypeComponentTypeUInt16 }),
+                      UVC_CONTROL_INIT("auto-white-balance-component", UVC_PROCESSING_UNIT_ID, PU_WHITE_BALANCE_COMPONENT_AUTO_CONTROL, kUVCProcessingUnitControlEnableAutoWhiteBalanceComponent,
+                          { "", kUVCTypeComponentTypeBoolean }),
+                      UVC_CONTROL_INIT("digital-multiplier", UVC_PROCESSING_UNIT_ID, PU_DIGITAL_MULTIPLIER_CONTROL, kUVCProcessingUnitControlEnableDigitalMultiplier,
+                          { "", kUVCTypeComponentTypeUInt16 }),
+                      UVC_CONTROL_INIT("digital-multiplier-limit", UVC_PROCESSING_UNIT_ID, PU_DIGITAL_MULTIPLIER_LIMIT_CONTROL, kUVCProcessingUnitControlEnableDigitalMultiplierLimit,
+                          { "", kUVCTypeComponentTypeUInt16 }),
+                      UVC_CONTROL_INIT("auto-hue", UVC_PROCESSING_UNIT_ID, PU_HUE_AUTO_CONTROL, kUVCProcessingUnitControlEnableAutoHue,
+                          { "", kUVCTypeComponentTypeBoolean }),
+                      UVC_CONTROL_INIT("analog-video-standard", UVC_PROCESSING_UNIT_ID, PU_ANALOG_VIDEO_STANDARD_CONTROL, kUVCProcessingUnitControlEnableAnalogVideoStandard,
+                          { "", kUVCTypeComponentTypeUInt8 }),
+                      UVC_CONTROL_INIT("analog-lock-status", UVC_PROCESSING_UNIT_ID, PU_ANALOG_LOCK_STATUS_CONTROL, kUVCProcessingUnitControlEnableAnalogVideoLockStatus,
+                          { "", kUVCTypeComponentTypeUInt8 }),
+                      UVC_CONTROL_INIT("auto-contrast", UVC_PROCESSING_UNIT_ID, PU_CONTRAST_AUTO_CONTROL, kUVCProcessingUnitControlEnableAutoContrast,
+                          { "", kUVCTypeComponentTypeUInt8 })
                     };
 
+/*!
+  @defined UVCControllerControlCount
+  
+  The number of controls present in the UVCControllerControls array.
+*/
+#define UVCControllerControlCount (sizeof(UVCControllerControls) / sizeof(uvc_control_t))
+
 /*!
   @defined UVCInvalidControlIndex
   
   Returned by control-lookup function(s) to indicate a control not implemented by
   this API. 
 */
-#define UVCInvalidControlIndex ((NSUInteger)-1)
+#define UVCInvalidControlIndex UVCControlNameInvalidIndex
+
+// Control indices are shared with the UVCControlNames table:
+_Static_assert(UVCControllerControlCount == UVCControlNameCount, "UVCControllerControls does not match UVCControlNames");
+
+// A controller's availability mask has one bit per control:
+_Static_assert(UVCControllerControlCount <= 64, "UVCControllerControls does not fit in the controlsAvailable mask");
+
+/*!
+  @var UVCControllerSharedControlStrings
+  
+  The names of all controls in UVCControllerControls, in order; built once by
+  +[UVCController initialize].
+*/
+static NSArray *UVCControllerSharedControlStrings = nil;
+
+/*!
+  @var UVCControllerControlTypes
+  
+  The UVCType of each control in UVCControllerControls, in order; the layout
+  of every controller's UVCValueArena.  Built once by +[UVCController initialize].
+*/
+static UVCType *UVCControllerControlTypes[UVCControllerControlCount];
+
+/*!
+  @var UVCControllerSharedRequestTimeout
+  
+  Request timeout given to each new controller (see +setDefaultRequestTimeout:).
+*/
+static NSTimeInterval UVCControllerSharedRequestTimeout = UVCControllerDefaultRequestTimeout;
+
+/*!
+  @var UVCControllerSharedMaximumRequestRetries
+  
+  Retry limit given to each new controller (see +setDefaultMaximumRequestRetries:).
+*/
+static NSUInteger UVCControllerSharedMaximumRequestRetries = UVCControllerDefaultMaximumRequestRetries;
+
+/*!
+  @defined UVCControllerMaximumRequestRetryBackoff
+  
+  Longest delay (in seconds) between two attempts at a request, however many
+  times its backoff has doubled.
+*/
+#define UVCControllerMaximumRequestRetryBackoff 0.25
+
+/*!
+  @var UVCControllerThreadRequestFailure
+  
+  Outcome of the most recent control request finished (see
+  finishControlRequest:result:isMostRecent:) on the calling thread, by any
+  controller.  Unlike lastRequestFailure it cannot be overwritten by
+  another thread between a request and the code that inspects it.
+*/
+static __thread UVCRequestFailure UVCControllerThreadRequestFailure;
+
 
 //
 #if 0
@@ -368,70 +471,59 @@ uvc_control_t     UVCControllerControls[] = {
 */
 - (id) initControlWithName:(NSString*)controlName parentController:(UVCController*)parentController controlIndex:(NSUInteger)controlIndex;
 
-@end
-
-//
-#if 0
-#pragma mark -
-#endif
-//
-
 /*!
-  @class UVCController(UVCControllerPrivate)
-  @abstract Non-public methods of the UVCController class.
+  @method enqueueReadIntoCurrentValueInQueue:
   
-  Class and instance methods of UVCController that should not be accessible
-  outside this source file.
+  Add to queue a request that reads the receiver control's value from the device
+  into the receiver's UVCValue object.
 */
-@interface UVCController(UVCControllerPrivate)
+- (void) enqueueReadIntoCurrentValueInQueue:(UVCRequestQueue*)queue;
 
 /*!
-  @method controlMapping
-  
-  Returns a constant NSDictionary which maps control name strings to an index in
-  the UVCControllerControls array.
-*/
-+ (NSDictionary*) controlMapping;
-/*!
-  @method controlMapping
+  @method enqueueWriteFromCurrentValueInQueue:
   
-  Convenience method which calls the controlMapping class method.
+  Add to queue a request that writes the value stored in the receiver's UVCValue
+  object to the device.
 */
-- (NSDictionary*) controlMapping;
+- (void) enqueueWriteFromCurrentValueInQueue:(UVCRequestQueue*)queue;
 
 /*!
-  @method terminalControlEnableMapping
-  
-  Returns a constant NSDictionary which maps Terminal unit control name strings to
-  the control's enablement bit in the UVC_VC_Terminal_Header_Descriptor.
-*/
-+ (NSDictionary*) terminalControlEnableMapping;
-/*!
-  @method terminalControlEnableMapping
+  @method setDeviceCapabilities:
   
-  Convenience method which calls the terminalControlEnableMapping class method.
+  Replace the device-provided (GET_INFO) bits of the receiver's capabilities.
 */
-- (NSDictionary*) terminalControlEnableMapping;
+- (void) setDeviceCapabilities:(UInt8)deviceCapabilities;
 
 /*!
-  @method processingUnitControlEnableMapping
+  @method controlIndex
   
-  Returns a constant NSDictionary which maps Processing Unit control name strings to
-  the control's enablement bit in the UVC_PU_Header_Descriptor.
+  Returns the receiver control's index in the UVCControllerControls array.
 */
-+ (NSDictionary*) processingUnitControlEnableMapping;
+- (NSUInteger) controlIndex;
+
+@end
+
+//
+#if 0
+#pragma mark -
+#endif
+//
+
 /*!
-  @method processingUnitControlEnableMapping
+  @class UVCController(UVCControllerPrivate)
+  @abstract Non-public methods of the UVCController class.
   
-  Convenience method which calls the processingUnitControlEnableMapping class method.
+  Class and instance methods of UVCController that should not be accessible
+  outside this source file.
 */
-- (NSDictionary*) processingUnitControlEnableMapping;
+@interface UVCController(UVCControllerPrivate)
 
 /*!
   @method controlIndexForString:
   
-  Looks-up the controlString in the controlMapping NSDictionary.  If found, returns
-  the control's index in the UVCControllerControls array.
+  Looks-up the controlString with UVCControlNameIndexForString() (a perfect hash
+  over UVCControlNames).  If found, returns the control's index in the
+  UVCControllerControls array.
   
   If the control is not found, returns UVCInvalidControlIndex.
 */
@@ -444,17 +536,17 @@ uvc_control_t     UVCControllerControls[] = {
 - (NSUInteger) controlIndexForString:(NSString*)controlString;
 
 /*!
-  @method controlIsNotAvailable:
+  @method controlIndexIsNotAvailable:
   
   If the findControllerInterfaceForServiceObject: method was able to pull control
   enablement data from the device descriptors, then this method will check the
   enablement bitmask to determine whether or not the device claims the control
-  is implemented.
+  at controlIndex is implemented.
   
   If no enablement data was found, this method always returns NO; the controlWithName:
   method will then always at least TRY to instantiate the control (and maybe fail).
 */
-- (BOOL) controlIsNotAvailable:(NSString*)controlString;
+- (BOOL) controlIndexIsNotAvailable:(NSUInteger)controlIndex;
 
 /*!
   @method initWithLocationId:vendorId:productId:ioServiceObject:
@@ -465,12 +557,22 @@ uvc_control_t     UVCControllerControls[] = {
   Caches a copy of the device's textual name.
   
   Calls the findControllerInterfaceForServiceObject: method to fill-in the USB
-  interface callback list, etc.
+  interface callback list, etc.  The caller's reference to ioServiceObject is
+  neither consumed nor retained.
   
   Returns nil if any aspect of initialization fails.
 */
 - (id) initWithLocationId:(UInt32)locationId vendorId:(UInt16)vendorId productId:(UInt16)productId ioServiceObject:(io_service_t)ioServiceObject;
 
+/*!
+  @method initWithTransport:deviceName:vendorId:productId:locationId:videoControlDescriptors:
+  
+  Initializer for instances that are not backed by an I/O Registry device; all
+  control requests are delivered via transport.  If videoControlDescriptors is
+  not nil, it is parsed as the device's descriptor block would be.
+*/
+- (id) initWithTransport:(id<UVCTransport>)transport deviceName:(NSString*)deviceName vendorId:(UInt16)vendorId productId:(UInt16)productId locationId:(UInt32)locationId videoControlDescriptors:(NSData*)videoControlDescriptors;
+
 /*!
   @method findControllerInterfaceForServiceObject:
   
@@ -480,30 +582,97 @@ uvc_control_t     UVCControllerControls[] = {
   Also determines the appropriate interface index for use in control request parameter
   blocks.
   
-  If successful, the interface's descriptor list is walked in an attempt to find
-  control enablement bitmasks; if found, they are retained as NSData instances which
-  are later consulted to determine which controls are enabled/disabled.
+  If successful, a copy of the interface's VideoControl descriptor block is parsed
+  into a UVCDescriptorGraph.  The camera input terminal and processing unit provide
+  their unit ids and control enablement bitmasks; the bitmasks are retained as NSData
+  instances which are later consulted to determine which controls are enabled/disabled.
 
   Returns YES if all operations are successful.
   
-  This method consumes one reference to ioServiceObject; the caller should retain
-  the object before calling this method if it needs to keep ioServiceObject valid
-  afterwards.
+  The caller's reference to ioServiceObject is neither consumed nor retained; the
+  caller remains responsible for releasing it.
 */
 - (BOOL) findControllerInterfaceForServiceObject:(io_service_t)ioServiceObject;
 
+/*!
+  @method parseVideoControlDescriptors:length:
+  
+  Keep a copy of the VideoControl descriptor block at bytes (starting with the
+  VC interface header, length bytes in all) and parse it into a UVCDescriptorGraph.
+  The UVC version, descriptor hash, unit ids, and control enablement bitmasks of
+  the receiver are taken from the block.
+*/
+- (void) parseVideoControlDescriptors:(const void*)bytes length:(NSUInteger)length;
+
+/*!
+  @method decodeControlsAvailable
+  
+  Rebuild the receiver's controlsAvailable mask from the terminal and processing
+  unit enablement bitmaps (see controlIndexIsNotAvailable:).
+*/
+- (void) decodeControlsAvailable;
+
 /*!
   @method sendControlRequest:
   
   Lowest-level mechanism for delivering USB requests to the receiver's device.
-  Returns YES if the request is successful.
+  Returns YES if the request is successful, after any retries (see
+  finishControlRequest:result:isMostRecent:).
   
-  In order to send the request, the interface must be open.  If the receiver has
-  not been explicitly opened (via setIsInterfaceOpen:) then this method will
-  open the interface, deliver the request, and then close the interface.
+  In order to send the request, the transport must be open.  If the receiver has
+  not been explicitly opened (via setIsInterfaceOpen:) then the transport opens
+  itself and remains open until the receiver is deallocated.
 */
 - (BOOL) sendControlRequest:(IOUSBDevRequest)controlRequest;
 
+/*!
+  @method transmitControlRequest:
+  
+  Deliver controlRequest once via the transport, recording its latency and
+  outcome in the receiver's requestStatistics.
+*/
+- (IOReturn) transmitControlRequest:(IOUSBDevRequest*)controlRequest;
+
+/*!
+  @method requestErrorCode
+  
+  Read the device's VC_REQUEST_ERROR_CODE_CONTROL, which describes the last
+  request the device handled.  Returns kUVCRequestErrorCodeUnknown if the
+  code could not be read.
+*/
+- (UVCRequestErrorCode) requestErrorCode;
+
+/*!
+  @method finishControlRequest:result:isMostRecent:
+  
+  Given the result of delivering controlRequest, retry it (with backoff)
+  while it fails transiently and the receiver's maximumRequestRetries allows,
+  then record the outcome as the receiver's lastRequestFailure.  After a
+  stall the device's request error code is read to decide whether the
+  failure is transient.  If other requests have reached the device since
+  controlRequest (isMostRecent is NO) the code may describe one of them:
+  a stall is then final unless the code says "not ready," in which case the
+  request is first delivered once more, at once and on its own.  Returns
+  the result of the final attempt.
+*/
+- (IOReturn) finishControlRequest:(IOUSBDevRequest*)controlRequest result:(IOReturn)result isMostRecent:(BOOL)isMostRecent;
+
+/*!
+  @method applyRequestTimeout
+  
+  Pass the receiver's requestTimeout on to its transport.
+*/
+- (void) applyRequestTimeout;
+
+/*!
+  @method controlRequestWithType:data:withLength:forSelector:atUnitId:
+  
+  Returns an IOUSBDevRequest parameter block for the given opcode (type) which
+  transfers length bytes at value to/from the given selector of the unit.  The
+  transfer direction is implied by the opcode.
+*/
+- (IOUSBDevRequest) controlRequestWithType:(int)type data:(void*)value withLength:(int)length forSelector:(int)selector atUnitId:(int)unitId;
+
 /*!
   @method setData:withLength:forSelector:atUnitId:
   
@@ -535,161 +704,332 @@ uvc_control_t     UVCControllerControls[] = {
   
   The capabilities bitmask is updated to indicate if the range, resolution (step size), or
   default values were available.
+  
+  Returns YES if every request that failed was refused definitively by the device (see
+  UVCControllerFailureIsDefinitive), i.e. the missing values may be cached as absent.
 */
-- (void) getLowValue:(UVCValue**)lowValue highValue:(UVCValue**)highValue stepSize:(UVCValue**)stepSize defaultValue:(UVCValue**)defaultValue updateCapabilitiesBitmask:(uvc_capabilities_t*)capabilities forControl:(NSUInteger)controlId;
+- (BOOL) getLowValue:(UVCValue**)lowValue highValue:(UVCValue**)highValue stepSize:(UVCValue**)stepSize defaultValue:(UVCValue**)defaultValue updateCapabilitiesBitmask:(uvc_capabilities_t*)capabilities forControl:(NSUInteger)controlId;
 
 
 - (BOOL) getValue:(UVCValue*)value forControl:(NSUInteger)controlId;
+
+/*!
+  @method setValue:forControl:
+  
+  Write value to the given control.  If the receiver coalesces writes the value
+  passes through its write queue (see setCoalescesWrites:); otherwise it is
+  written immediately with writeValue:forControl:.
+*/
 - (BOOL) setValue:(UVCValue*)value forControl:(NSUInteger)controlId;
 
+/*!
+  @method writeValue:forControl:
+  
+  Send a SET_CUR request for the given control with value (which is not altered,
+  regardless of its byte order).  Returns YES if successful.
+*/
+- (BOOL) writeValue:(UVCValue*)value forControl:(NSUInteger)controlId;
+
+/*!
+  @method drainWriteQueue
+  
+  For the thread that has become the flusher of the receiver's write queue:  write
+  values from the queue until it is empty.  Returns NO if any write failed.
+*/
+- (BOOL) drainWriteQueue;
+
+/*!
+  @method noteDeviceValuesOfControls:
+  
+  After the current values of the UVCControls in controls were read from (or written
+  to) the device, record them as the device's values in the receiver's write queue.
+*/
+- (void) noteDeviceValuesOfControls:(NSArray*)controls;
+
+/*!
+  @method checkOutRequestQueue
+  
+  Returns a retained, empty UVCRequestQueue configured like those returned by
+  requestQueue.  The receiver keeps one idle queue (and its entry storage) for
+  reuse, so steady-state batches of requests allocate nothing; a queue checked
+  out while another is in use is newly allocated.
+*/
+- (UVCRequestQueue*) checkOutRequestQueue;
+
+/*!
+  @method checkInRequestQueue:
+  
+  Return a queue obtained from checkOutRequestQueue (after its run method has
+  emptied it).  The receiver keeps it as the idle queue if it has none and the
+  queue delivers via the current transport; otherwise it is released.
+*/
+- (void) checkInRequestQueue:(UVCRequestQueue*)queue;
+
+/*!
+  @method writeNDJSONRecordForControl:result:toStream:
+  
+  Write the writeControlsAsNDJSONToStream:failedCount: record of control (whose
+  current value was read with the given result) and flush stream.
+*/
+- (void) writeNDJSONRecordForControl:(UVCControl*)control result:(IOReturn)result toStream:(FILE*)stream;
+
+/*!
+  @method enqueueGetValue:forControl:inQueue:
+  
+  Add a GET_CUR request for the given control to queue.  When the request completes
+  successfully, value holds the control's value in host byte order.
+*/
+- (void) enqueueGetValue:(UVCValue*)value forControl:(NSUInteger)controlId inQueue:(UVCRequestQueue*)queue;
+
+/*!
+  @method enqueueSetValue:forControl:inQueue:
+  
+  Add a SET_CUR request for the given control to queue.  The value is byte-swapped
+  to USB order until the request completes.
+*/
+- (void) enqueueSetValue:(UVCValue*)value forControl:(NSUInteger)controlId inQueue:(UVCRequestQueue*)queue;
+
 @end
 
-@implementation UVCController(UVCControllerPrivate)
+//
 
-  + (NSDictionary*) controlMapping
-  {
-    static NSDictionary *sharedControlMapping = nil;
-
-    if ( ! sharedControlMapping ) {
-      sharedControlMapping = [[NSDictionary alloc] initWithObjectsAndKeys:
-                                  [NSNumber numberWithInt:0], UVCTerminalControlScanningMode,
-                                  [NSNumber numberWithInt:1], UVCTerminalControlAutoExposureMode,
-                                  [NSNumber numberWithInt:2], UVCTerminalControlAutoExposurePriority,
-                                  [NSNumber numberWithInt:3], UVCTerminalControlExposureTimeAbsolute,
-                                  [NSNumber numberWithInt:4], UVCTerminalControlExposureTimeRelative,
-                                  [NSNumber numberWithInt:5], UVCTerminalControlFocusAbsolute,
-                                  [NSNumber numberWithInt:6], UVCTerminalControlFocusRelative,
-                                  [NSNumber numberWithInt:7], UVCTerminalControlAutoFocus,
-                                  [NSNumber numberWithInt:8], UVCTerminalControlIrisAbsolute,
-                                  [NSNumber numberWithInt:9], UVCTerminalControlIrisRelative,
-                                  [NSNumber numberWithInt:10], UVCTerminalControlZoomAbsolute,
-                                  [NSNumber numberWithInt:11], UVCTerminalControlZoomRelative,
-                                  [NSNumber numberWithInt:12], UVCTerminalControlPanTiltAbsolute,
-                                  [NSNumber numberWithInt:13], UVCTerminalControlPanTiltRelative,
-                                  [NSNumber numberWithInt:14], UVCTerminalControlRollAbsolute,
-                                  [NSNumber numberWithInt:15], UVCTerminalControlRollRelative,
-                                  [NSNumber numberWithInt:16], UVCTerminalControlPrivacy,
-                                  [NSNumber numberWithInt:17], UVCTerminalControlFocusSimple,
-                                  [NSNumber numberWithInt:18], UVCTerminalControlWindow,
-                                  [NSNumber numberWithInt:19], UVCTerminalControlRegionOfInterest,
-
-                                  [NSNumber numberWithInt:20], UVCProcessingUnitControlBacklightCompensation,
-                                  [NSNumber numberWithInt:21], UVCProcessingUnitControlBrightness,
-                                  [NSNumber numberWithInt:22], UVCProcessingUnitControlContrast,
-                                  [NSNumber numberWithInt:23], UVCProcessingUnitControlGain,
-                                  [NSNumber numberWithInt:24], UVCProcessingUnitControlPowerLineFrequency,
-                                  [NSNumber numberWithInt:25], UVCProcessingUnitControlHue,
-                                  [NSNumber numberWithInt:26], UVCProcessingUnitControlSaturation,
-                                  [NSNumber numberWithInt:27], UVCProcessingUnitControlSharpness,
-                                  [NSNumber numberWithInt:28], UVCProcessingUnitControlGamma,
-                                  [NSNumber numberWithInt:29], UVCProcessingUnitControlWhiteBalanceTemperature,
-                                  [NSNumber numberWithInt:30], UVCProcessingUnitControlAutoWhiteBalanceTemperature,
-                                  [NSNumber numberWithInt:31], UVCProcessingUnitControlWhiteBalanceComponent,
-                                  [NSNumber numberWithInt:32], UVCProcessingUnitControlAutoWhiteBalanceComponent,
-                                  [NSNumber numberWithInt:33], UVCProcessingUnitControlDigitalMultiplier,
-                                  [NSNumber numberWithInt:34], UVCProcessingUnitControlDigitalMultiplierLimit,
-                                  [NSNumber numberWithInt:35], UVCProcessingUnitControlAutoHue,
-                                  [NSNumber numberWithInt:36], UVCProcessingUnitControlAnalogVideoStandard,
-                                  [NSNumber numberWithInt:37], UVCProcessingUnitControlAnalogLockStatus,
-                                  [NSNumber numberWithInt:38], UVCProcessingUnitControlAutoContrast,
-                                  nil
-                                ];
-    }
-    return sharedControlMapping;
-  }
-  - (NSDictionary*) controlMapping
-  {
-    return [[self class] controlMapping];
-  }
-
-//
-
-  + (NSDictionary*) terminalControlEnableMapping
-  {
-    static NSDictionary *sharedTerminalControlEnableMapping = nil;
-
-    if ( ! sharedTerminalControlEnableMapping ) {
-      sharedTerminalControlEnableMapping = [[NSDictionary alloc] initWithObjectsAndKeys:
-                                              [NSNumber numberWithInt:kUVCTerminalControlEnableScanningMode], UVCTerminalControlScanningMode,
-                                              [NSNumber numberWithInt:kUVCTerminalControlEnableAutoExposureMode], UVCTerminalControlAutoExposureMode,
-                                              [NSNumber numberWithInt:kUVCTerminalControlEnableAutoExposurePriority], UVCTerminalControlAutoExposurePriority,
-                                              [NSNumber numberWithInt:kUVCTerminalControlEnableExposureTimeAbsolute], UVCTerminalControlExposureTimeAbsolute,
-                                              [NSNumber numberWithInt:kUVCTerminalControlEnableExposureTimeRelative], UVCTerminalControlExposureTimeRelative,
-                                              [NSNumber numberWithInt:kUVCTerminalControlEnableFocusAbsolute], UVCTerminalControlFocusAbsolute,
-                                              [NSNumber numberWithInt:kUVCTerminalControlEnableFocusRelative], UVCTerminalControlFocusRelative,
-                                              [NSNumber numberWithInt:kUVCTerminalControlEnableIrisAbsolute], UVCTerminalControlIrisAbsolute,
-                                              [NSNumber numberWithInt:kUVCTerminalControlEnableIrisRelative], UVCTerminalControlIrisRelative,
-                                              [NSNumber numberWithInt:kUVCTerminalControlEnableZoomAbsolute], UVCTerminalControlZoomAbsolute,
-                                              [NSNumber numberWithInt:kUVCTerminalControlEnableZoomRelative], UVCTerminalControlZoomRelative,
-                                              [NSNumber numberWithInt:kUVCTerminalControlEnablePanTiltAbsolute], UVCTerminalControlPanTiltAbsolute,
-                                              [NSNumber numberWithInt:kUVCTerminalControlEnablePanTiltRelative], UVCTerminalControlPanTiltRelative,
-                                              [NSNumber numberWithInt:kUVCTerminalControlEnableRollAbsolute], UVCTerminalControlRollAbsolute,
-                                              [NSNumber numberWithInt:kUVCTerminalControlEnableRollRelative], UVCTerminalControlRollRelative,
-                                              [NSNumber numberWithInt:kUVCTerminalControlEnableFocusAuto], UVCTerminalControlAutoFocus,
-                                              [NSNumber numberWithInt:kUVCTerminalControlEnablePrivacy], UVCTerminalControlPrivacy,
-                                              [NSNumber numberWithInt:kUVCTerminalControlEnableFocusSimple], UVCTerminalControlFocusSimple,
-                                              [NSNumber numberWithInt:kUVCTerminalControlEnableWindow], UVCTerminalControlWindow,
-                                              [NSNumber numberWithInt:kUVCTerminalControlEnableRegionOfInterest], UVCTerminalControlRegionOfInterest,
-                                              nil
-                                            ];
-    }
-    return sharedTerminalControlEnableMapping;
-  }
-  - (NSDictionary*) terminalControlEnableMapping
-  {
-    return [[self class] terminalControlEnableMapping];
-  }
-
-//
-
-  + (NSDictionary*) processingUnitControlEnableMapping
-  {
-    static NSDictionary *sharedProcessingUnitControlEnableMapping = nil;
-
-    if ( ! sharedProcessingUnitControlEnableMapping ) {
-      sharedProcessingUnitControlEnableMapping = [[NSDictionary alloc] initWithObjectsAndKeys:
-                                                    [NSNumber numberWithInt:kUVCProcessingUnitControlEnableBrightness], UVCProcessingUnitControlBrightness,
-                                                    [NSNumber numberWithInt:kUVCProcessingUnitControlEnableContrast], UVCProcessingUnitControlContrast,
-                                                    [NSNumber numberWithInt:kUVCProcessingUnitControlEnableHue], UVCProcessingUnitControlHue,
-                                                    [NSNumber numberWithInt:kUVCProcessingUnitControlEnableSaturation], UVCProcessingUnitControlSaturation,
-                                                    [NSNumber numberWithInt:kUVCProcessingUnitControlEnableSharpness], UVCProcessingUnitControlSharpness,
-                                                    [NSNumber numberWithInt:kUVCProcessingUnitControlEnableGamma], UVCProcessingUnitControlGamma,
-                                                    [NSNumber numberWithInt:kUVCProcessingUnitControlEnableWhiteBalanceTemperature], UVCProcessingUnitControlWhiteBalanceTemperature,
-                                                    [NSNumber numberWithInt:kUVCProcessingUnitControlEnableWhiteBalanceComponent], UVCProcessingUnitControlWhiteBalanceComponent,
-                                                    [NSNumber numberWithInt:kUVCProcessingUnitControlEnableBacklightCompensation], UVCProcessingUnitControlBacklightCompensation,
-                                                    [NSNumber numberWithInt:kUVCProcessingUnitControlEnableGain], UVCProcessingUnitControlGain,
-                                                    [NSNumber numberWithInt:kUVCProcessingUnitControlEnablePowerLineFrequency], UVCProcessingUnitControlPowerLineFrequency,
-                                                    [NSNumber numberWithInt:kUVCProcessingUnitControlEnableAutoHue], UVCProcessingUnitControlAutoHue,
-                                                    [NSNumber numberWithInt:kUVCProcessingUnitControlEnableAutoWhiteBalanceTemperature], UVCProcessingUnitControlAutoWhiteBalanceTemperature,
-                                                    [NSNumber numberWithInt:kUVCProcessingUnitControlEnableAutoWhiteBalanceComponent], UVCProcessingUnitControlAutoWhiteBalanceComponent,
-                                                    [NSNumber numberWithInt:kUVCProcessingUnitControlEnableDigitalMultiplier], UVCProcessingUnitControlDigitalMultiplier,
-                                                    [NSNumber numberWithInt:kUVCProcessingUnitControlEnableDigitalMultiplierLimit], UVCProcessingUnitControlDigitalMultiplierLimit,
-                                                    [NSNumber numberWithInt:kUVCProcessingUnitControlEnableAnalogVideoStandard], UVCProcessingUnitControlAnalogVideoStandard,
-                                                    [NSNumber numberWithInt:kUVCProcessingUnitControlEnableAnalogVideoLockStatus], UVCProcessingUnitControlAnalogLockStatus,
-                                                    [NSNumber numberWithInt:kUVCProcessingUnitControlEnableAutoContrast], UVCProcessingUnitControlAutoContrast,
-                                                    nil
-                                                  ];
+/*!
+  @function UVCControllerWriteJSONString
+
+  Write the UTF-8 cString to stream with the characters JSON requires escaped
+  (the surrounding quotes are not written).
+*/
+static void
+UVCControllerWriteJSONString(
+  FILE              *stream,
+  const char        *cString
+)
+{
+  unsigned char     c;
+  
+  while ( (c = *cString++) ) {
+    if ( c == '"' || c == '\\' ) {
+      fputc('\\', stream);
+      fputc(c, stream);
+    } else if ( c < 0x20 ) {
+      fprintf(stream, "\\u%04x", c);
+    } else {
+      fputc(c, stream);
     }
-    return sharedProcessingUnitControlEnableMapping;
   }
-  - (NSDictionary*) processingUnitControlEnableMapping
-  {
-    return [[self class] processingUnitControlEnableMapping];
+}
+
+//
+
+static void
+UVCControllerStoreResult(
+  void              *context,
+  IOUSBDevRequest   *controlRequest,
+  IOReturn          result
+)
+{
+  *((IOReturn*)context) = result;
+}
+
+//
+
+static void
+UVCControllerGetValueCompletion(
+  void              *context,
+  IOUSBDevRequest   *controlRequest,
+  IOReturn          result
+)
+{
+  if ( result == kIOReturnSuccess ) [(UVCValue*)context byteSwapFromUSBEndian];
+}
+
+//
+
+static void
+UVCControllerSetValueCompletion(
+  void              *context,
+  IOUSBDevRequest   *controlRequest,
+  IOReturn          result
+)
+{
+  [(UVCValue*)context byteSwapUSBToHostEndian];
+}
+
+//
+
+typedef struct {
+  UVCController   *controller;
+  UVCControl      *control;
+  FILE            *stream;
+  IOReturn        result;
+} UVCControllerNDJSONRecord;
+
+static void
+UVCControllerNDJSONCompletion(
+  void                      *context,
+  IOUSBDevRequest           *controlRequest,
+  IOReturn                  result
+)
+{
+  UVCControllerNDJSONRecord *R = (UVCControllerNDJSONRecord*)context;
+  
+  // The request filled the control's value buffer; swap it in place, with no further I/O:
+  if ( (R->result = result) == kIOReturnSuccess ) [[R->control valueBuffer] byteSwapFromUSBEndian];
+  [R->controller writeNDJSONRecordForControl:R->control result:result toStream:R->stream];
+}
+//
+
+typedef struct {
+  UVCControl      *control;
+  UInt8           info;
+  IOReturn        result;
+} UVCControllerCapabilitiesRefresh;
+
+//
+// Per-control state for watchControls:pollInterval:duration:callback:context:
+//
+typedef struct {
+  UVCControl      *control;
+  UInt8           unitId;
+  UInt8           selector;
+  BOOL            isInterruptDriven;
+  UVCValue        *lastValue;
+} UVCControllerWatchedControl;
+
+//
+
+static BOOL
+UVCControllerWatchedControlDidChange(
+  UVCControllerWatchedControl *watched
+)
+{
+  UVCValue                    *value = [watched->control valueBuffer];
+  
+  if ( memcmp([value valuePtr], [watched->lastValue valuePtr], [value byteSize]) == 0 ) return NO;
+  memcpy([watched->lastValue valuePtr], [value valuePtr], [value byteSize]);
+  return YES;
+}
+
+//
+
+const char*
+UVCRequestErrorCodeString(
+  UVCRequestErrorCode errorCode
+)
+{
+  switch ( errorCode ) {
+    case kUVCRequestErrorCodeNone:
+      return "no error";
+    case kUVCRequestErrorCodeNotReady:
+      return "device not ready";
+    case kUVCRequestErrorCodeWrongState:
+      return "device in the wrong state";
+    case kUVCRequestErrorCodePower:
+      return "insufficient power";
+    case kUVCRequestErrorCodeOutOfRange:
+      return "value out of range";
+    case kUVCRequestErrorCodeInvalidUnit:
+      return "invalid unit";
+    case kUVCRequestErrorCodeInvalidControl:
+      return "invalid control";
+    case kUVCRequestErrorCodeInvalidRequest:
+      return "invalid request";
+    case kUVCRequestErrorCodeInvalidValueWithinRange:
+      return "invalid value within range";
+    case kUVCRequestErrorCodeUnknown:
+      break;
   }
+  return "unknown error";
+}
 
 //
 
-  + (NSUInteger) controlIndexForString:(NSString*)controlString
-  {
-    NSDictionary    *controlMapping = [self controlMapping];
-    NSUInteger      index = UVCInvalidControlIndex;
+BOOL
+UVCRequestFailureIsTimeout(
+  UVCRequestFailure   failure
+)
+{
+  return ( (failure.result == kIOReturnTimeout) || (failure.result == kIOUSBTransactionTimeout) );
+}
 
-    if ( controlMapping ) {
-      NSNumber      *indexObj = [controlMapping objectForKey:controlString];
+//
 
-      if ( indexObj ) index = [indexObj unsignedIntegerValue];
-    }
-    return index;
+/*!
+  @function UVCControllerFailureIsTransient
+  
+  Returns YES if a request that failed with result (and, if it stalled, the
+  device's errorCode) may succeed if it is delivered again:  only a stall the
+  device explains as "not ready".  A stall without a code (the device may
+  not implement VC_REQUEST_ERROR_CODE_CONTROL) is most likely an unsupported
+  request, and a timeout is not transient either:  retrying a wedged device
+  only multiplies the wait.
+*/
+static BOOL
+UVCControllerFailureIsTransient(
+  IOReturn              result,
+  UVCRequestErrorCode   errorCode
+)
+{
+  return ( (result == kIOUSBPipeStalled) && (errorCode == kUVCRequestErrorCodeNotReady) );
+}
+
+//
+
+/*!
+  @function UVCControllerFailureIsDefinitive
+  
+  Returns YES if failure is the device's considered answer that the control
+  or request is not supported (as opposed to a stall, timeout, or busy or
+  missing device, which may not recur) and may therefore be cached.
+*/
+static BOOL
+UVCControllerFailureIsDefinitive(
+  UVCRequestFailure     failure
+)
+{
+  return ( (failure.result == kIOUSBPipeStalled) && ((failure.errorCode == kUVCRequestErrorCodeInvalidControl) || (failure.errorCode == kUVCRequestErrorCodeInvalidRequest)) );
+}
+
+//
+
+typedef struct {
+  IOReturn        result;
+  BOOL            isDefinitive;
+} UVCControllerLimitResult;
+
+static void
+UVCControllerStoreLimitResult(
+  void              *context,
+  IOUSBDevRequest   *controlRequest,
+  IOReturn          result
+)
+{
+  UVCControllerLimitResult  *R = (UVCControllerLimitResult*)context;
+  
+  // A failed request's callback follows its failure handler on this thread:
+  R->result = result;
+  R->isDefinitive = ( result != kIOReturnSuccess ) && UVCControllerFailureIsDefinitive(UVCControllerThreadRequestFailure);
+}
+
+//
+
+static IOReturn
+UVCControllerFinishQueuedRequest(
+  void              *context,
+  IOUSBDevRequest   *controlRequest,
+  IOReturn          result
+)
+{
+  return [(UVCController*)context finishControlRequest:controlRequest result:result isMostRecent:NO];
+}
+
+//
+
+@implementation UVCController(UVCControllerPrivate)
+
+  + (NSUInteger) controlIndexForString:(NSString*)controlString
+  {
+    return UVCControlNameIndexForString(controlString);
   }
   - (NSUInteger) controlIndexForString:(NSString*)controlString
   {
@@ -698,66 +1038,48 @@ uvc_control_t     UVCControllerControls[] = {
 
 //
 
-  - (BOOL) controlIsNotAvailable:(NSString*)controlString
+  - (BOOL) controlIndexIsNotAvailable:(NSUInteger)controlIndex
   {
-    NSUInteger      controlIndex = [self controlIndexForString:controlString];
+    if ( controlIndex >= UVCControllerControlCount ) return YES;
+    return ( (_controlsAvailable & (1ULL << controlIndex)) == 0 );
+  }
 
-    if ( controlIndex != UVCInvalidControlIndex ) {
-      switch ( UVCControllerControls[controlIndex].unitType ) {
+//
 
-        case UVC_INPUT_TERMINAL_ID: {
-          // If we weren't able to get control enablement from the interface
-          // descriptor, don't prevent the code from TRYING to access the
-          // control and failing:
-          if ( ! _terminalControlsAvailable ) return NO;
-          // Get the bit index for the given control:
-          NSNumber      *bitIndexObj = [[self terminalControlEnableMapping] objectForKey:controlString];
-
-          if ( bitIndexObj ) {
-            // Check the enablement bitvector:
-            NSUInteger  bitIndex = [bitIndexObj unsignedIntegerValue], byteIndex;
-            UInt8       byte;
-
-            byteIndex = bitIndex / 8;
-            bitIndex = bitIndex % 8;
-            if ( byteIndex < [_terminalControlsAvailable length] ) {
-              [_terminalControlsAvailable getBytes:&byte range:NSMakeRange(byteIndex, 1)];
-            } else {
-              return YES;
-            }
-            if ( (byte & (1 << bitIndex)) != 0 ) return NO;
-          }
+  - (void) decodeControlsAvailable
+  {
+    const UInt8     *terminalBits = [_terminalControlsAvailable bytes];
+    const UInt8     *processingUnitBits = [_processingUnitControlsAvailable bytes];
+    NSUInteger      terminalLength = [_terminalControlsAvailable length];
+    NSUInteger      processingUnitLength = [_processingUnitControlsAvailable length];
+    NSUInteger      controlIndex;
+    
+    _controlsAvailable = 0;
+    for ( controlIndex = 0; controlIndex < UVCControllerControlCount; controlIndex++ ) {
+      const UInt8   *controlsAvailable = NULL;
+      NSUInteger    length = 0;
+      
+      switch ( UVCControllerControls[controlIndex].unitType ) {
+        case UVC_INPUT_TERMINAL_ID:
+          controlsAvailable = terminalBits;
+          length = terminalLength;
           break;
-        }
-
-        case UVC_PROCESSING_UNIT_ID: {
-          // If we weren't able to get control enablement from the interface
-          // descriptor, don't prevent the code from TRYING to access the
-          // control and failing:
-          if ( ! _processingUnitControlsAvailable ) return NO;
-          // Get the bit index for the given control:
-          NSNumber      *bitIndexObj = [[self processingUnitControlEnableMapping] objectForKey:controlString];
-
-          if ( bitIndexObj ) {
-            // Check the enablement bitvector:
-            NSUInteger  bitIndex = [bitIndexObj unsignedIntegerValue], byteIndex;
-            UInt8       byte;
-
-            byteIndex = bitIndex / 8;
-            bitIndex = bitIndex % 8;
-            if ( byteIndex < [_processingUnitControlsAvailable length] ) {
-              [_processingUnitControlsAvailable getBytes:&byte range:NSMakeRange(byteIndex, 1)];
-            } else {
-              return YES;
-            }
-            if ( (byte & (1 << bitIndex)) != 0 ) return NO;
-          }
+        case UVC_PROCESSING_UNIT_ID:
+          controlsAvailable = processingUnitBits;
+          length = processingUnitLength;
           break;
-        }
-
       }
+      // If we weren't able to get control enablement from the interface
+      // descriptor, don't prevent the code from TRYING to access the
+      // control and failing:
+      if ( controlsAvailable ) {
+        NSUInteger  bitIndex = UVCControllerControls[controlIndex].enableBit;
+        NSUInteger  byteIndex = bitIndex / 8;
+        
+        if ( (byteIndex >= length) || ((controlsAvailable[byteIndex] & (1 << (bitIndex % 8))) == 0) ) continue;
+      }
+      _controlsAvailable |= (1ULL << controlIndex);
     }
-    return YES;
   }
 
 //
@@ -782,8 +1104,25 @@ uvc_control_t     UVCControllerControls[] = {
                         [NSNumber numberWithInt:UVC_PROCESSING_UNIT_ID], @"UVC_PROCESSING_UNIT_ID",
                         nil
                     ];
+      _maximumRequestsInFlight = UVCRequestQueueDefaultWindowSize;
+      _requestStatistics = [[UVCRequestStatistics alloc] init];
+      _valueArena = [[UVCValueArena valueArenaWithTypes:UVCControllerControlTypes count:UVCControllerControlCount] retain];
+      pthread_mutex_init(&_requestQueueLock, NULL);
+      pthread_mutex_init(&_requestFailureLock, NULL);
+      _requestTimeout = UVCControllerSharedRequestTimeout;
+      _maximumRequestRetries = UVCControllerSharedMaximumRequestRetries;
+      _requestRetryBackoff = UVCControllerDefaultRequestRetryBackoff;
+      [self decodeControlsAvailable];
       if ( [self findControllerInterfaceForServiceObject:ioServiceObject] ) {
+        _transport = [[UVCIOKitTransport alloc] initWithInterface:_controllerInterface];
+        [self applyRequestTimeout];
         _controls = [[NSMutableDictionary alloc] init];
+        _capabilityCache = [[UVCCapabilityCache capabilityCacheForVendorId:_vendorId
+                                                  productId:_productId
+                                                  uvcVersion:_uvcVersion
+                                                  descriptorHash:_descriptorHash
+                                                  controlCount:UVCControllerControlCount
+                                                ] retain];
       } else {
         [self release];
         self = nil;
@@ -792,6 +1131,43 @@ uvc_control_t     UVCControllerControls[] = {
     return self;
   }
 
+//
+
+  - (id) initWithTransport:(id<UVCTransport>)transport
+    deviceName:(NSString*)deviceName
+    vendorId:(UInt16)vendorId
+    productId:(UInt16)productId
+    locationId:(UInt32)locationId
+    videoControlDescriptors:(NSData*)videoControlDescriptors
+  {
+    if ( (self = [self init]) ) {
+      _locationId = locationId;
+      _deviceName = [deviceName copy];
+      _vendorId = vendorId;
+      _productId = productId;
+      _uvcVersion = 0x0100;
+      _unitIds = [[NSMutableDictionary alloc] initWithObjectsAndKeys:
+                        [NSNumber numberWithInt:UVC_INPUT_TERMINAL_ID], @"UVC_INPUT_TERMINAL_ID",
+                        [NSNumber numberWithInt:UVC_PROCESSING_UNIT_ID], @"UVC_PROCESSING_UNIT_ID",
+                        nil
+                    ];
+      _maximumRequestsInFlight = UVCRequestQueueDefaultWindowSize;
+      _requestStatistics = [[UVCRequestStatistics alloc] init];
+      _valueArena = [[UVCValueArena valueArenaWithTypes:UVCControllerControlTypes count:UVCControllerControlCount] retain];
+      pthread_mutex_init(&_requestQueueLock, NULL);
+      pthread_mutex_init(&_requestFailureLock, NULL);
+      _requestTimeout = UVCControllerSharedRequestTimeout;
+      _maximumRequestRetries = UVCControllerSharedMaximumRequestRetries;
+      _requestRetryBackoff = UVCControllerDefaultRequestRetryBackoff;
+      [self decodeControlsAvailable];
+      _transport = [transport retain];
+      [self applyRequestTimeout];
+      _controls = [[NSMutableDictionary alloc] init];
+      if ( [videoControlDescriptors length] >= sizeof(UVC_VC_Interface_Header_Descriptor) ) [self parseVideoControlDescriptors:[videoControlDescriptors bytes] length:[videoControlDescriptors length]];
+    }
+    return self;
+  }
+
 //
 
   - (BOOL) findControllerInterfaceForServiceObject:(io_service_t)ioServiceObject
@@ -860,7 +1236,6 @@ uvc_control_t     UVCControllerControls[] = {
         case VC_HEADER: {
           UVC_VC_Interface_Header_Descriptor    *vcHeader = (UVC_VC_Interface_Header_Descriptor*)interfaceDescriptor;
           void                                  *basePtr = (void*)vcHeader;
-          void                                  *endPtr = basePtr + vcHeader->wTotalLength;
           
 #ifdef DEBUG_WRITE_UVC_HEADER_TO_FILE
           // Dump the header to a file for debugging:
@@ -876,49 +1251,55 @@ uvc_control_t     UVCControllerControls[] = {
           }
 #endif
           
-          // Grab the version of the UVC standard this device implements:
-          _uvcVersion = NSSwapLittleShortToHost(vcHeader->bcdUVC);
-
-          //
-          // basePtr and endPtr are setup to allow us to easily walk the embedded
-          // Unit/Terminal descriptors
-          //
-          basePtr += vcHeader->bLength;
-          while ( basePtr < endPtr ) {
-            descriptorPrefix = (UVC_Descriptor_Prefix*)basePtr;
-            if ( descriptorPrefix->bDescriptorType == CS_INTERFACE ) {
-              switch ( descriptorPrefix->bDescriptorSubType ) {
-
-                case VC_INPUT_TERMINAL: {
-                  UVC_VC_Terminal_Header_Descriptor   *terminalHeader = (UVC_VC_Terminal_Header_Descriptor*)basePtr;
-
-                  if ( terminalHeader->bControlSize > 0 ) {
-                    _terminalControlsAvailable = [[NSData alloc] initWithBytes:&terminalHeader->bmControls[0] length:terminalHeader->bControlSize];
-                  }
-                  break;
-                }
+          [self parseVideoControlDescriptors:basePtr length:vcHeader->wTotalLength];
+          break;
+        }
+      }
+    }
 
-                case VC_PROCESSING_UNIT: {
-                  UVC_PU_Header_Descriptor            *puHeader = (UVC_PU_Header_Descriptor*)basePtr;
+    return YES;
+  }
 
-                  if ( puHeader->bControlSize > 0 ) {
-                    [_unitIds setObject:[NSNumber numberWithInt:puHeader->bUnitId] forKey:@"UVC_PROCESSING_UNIT_ID"];
-                    _processingUnitControlsAvailable = [[NSData alloc] initWithBytes:&puHeader->bmControls[0] length:puHeader->bControlSize];
-                  }
-                  break;
-                }
+//
 
-              }
-            }
-            basePtr += descriptorPrefix->bLength;
+  - (void) parseVideoControlDescriptors:(const void*)bytes
+    length:(NSUInteger)length
+  {
+    // Grab the version of the UVC standard this device implements:
+    _uvcVersion = NSSwapLittleShortToHost(((const UVC_VC_Interface_Header_Descriptor*)bytes)->bcdUVC);
+    
+    // The capability cache is keyed in part by the content of the descriptor block:
+    _descriptorHash = UVCCapabilityCacheHashBytes(bytes, length);
 
-          }
-          break;
+    //
+    // Keep a copy of the block and parse the embedded Unit/Terminal descriptors
+    // out of it:
+    //
+    _videoControlDescriptors = [[NSData alloc] initWithBytes:bytes length:length];
+    if ( (_descriptorGraph = malloc(sizeof(UVCDescriptorGraph))) ) {
+      const UVCDescriptorUnit             *unit;
+      
+      // A malformed block still yields the units that preceded the error:
+      UVCDescriptorGraphParse(_descriptorGraph, [_videoControlDescriptors bytes], [_videoControlDescriptors length]);
+      
+      //
+      // Only a camera-type input terminal has the bmControls that our terminal
+      // controls refer to:
+      //
+      if ( (unit = UVCDescriptorGraphFirstUnitOfSubtype(_descriptorGraph, kUVCDescriptorSubtypeInputTerminal, kUVCTerminalTypeCamera)) ) {
+        [_unitIds setObject:[NSNumber numberWithInt:unit->unitId] forKey:@"UVC_INPUT_TERMINAL_ID"];
+        if ( unit->controlSize > 0 ) {
+          _terminalControlsAvailable = [[NSData alloc] initWithBytes:UVCDescriptorUnitControls(_descriptorGraph, unit) length:unit->controlSize];
+        }
+      }
+      if ( (unit = UVCDescriptorGraphFirstUnitOfSubtype(_descriptorGraph, kUVCDescriptorSubtypeProcessingUnit, 0)) ) {
+        if ( unit->controlSize > 0 ) {
+          [_unitIds setObject:[NSNumber numberWithInt:unit->unitId] forKey:@"UVC_PROCESSING_UNIT_ID"];
+          _processingUnitControlsAvailable = [[NSData alloc] initWithBytes:UVCDescriptorUnitControls(_descriptorGraph, unit) length:unit->controlSize];
         }
       }
     }
-
-    return YES;
+    [self decodeControlsAvailable];
   }
 
 //
@@ -926,36 +1307,119 @@ uvc_control_t     UVCControllerControls[] = {
   - (BOOL) sendControlRequest:(IOUSBDevRequest)controlRequest
   {
     //
-    // Open the interface. This will cause the pipes associated with the endpoints in
-    // the interface descriptor to be instantiated.  Then send a control request.
+    // The transport opens the interface (causing the pipes associated with the
+    // endpoints in the interface descriptor to be instantiated) if necessary:
     //
-    IOReturn          rc = 0;
+    IOReturn        rc = [self transmitControlRequest:&controlRequest];
+    
+    return ( [self finishControlRequest:&controlRequest result:rc isMostRecent:YES] == kIOReturnSuccess );
+  }
+
+//
+
+  - (IOReturn) transmitControlRequest:(IOUSBDevRequest*)controlRequest
+  {
+    UInt64          startTime = UVCRequestStatisticsTimestamp();
+    IOReturn        rc = [_transport sendControlRequest:controlRequest];
+    
+    [_requestStatistics recordRequest:controlRequest startTime:startTime result:rc];
+    return rc;
+  }
+
+//
+
+  - (UVCRequestErrorCode) requestErrorCode
+  {
+    UInt8           errorCode = kUVCRequestErrorCodeUnknown;
+    IOUSBDevRequest controlRequest = [self controlRequestWithType:UVC_GET_CUR data:&errorCode withLength:1 forSelector:VC_REQUEST_ERROR_CODE_CONTROL atUnitId:0];
+    
+    if ( ([self transmitControlRequest:&controlRequest] != kIOReturnSuccess) || (controlRequest.wLenDone != 1) ) return kUVCRequestErrorCodeUnknown;
+    return (UVCRequestErrorCode)errorCode;
+  }
+
+//
+
+  - (IOReturn) finishControlRequest:(IOUSBDevRequest*)controlRequest
+    result:(IOReturn)result
+    isMostRecent:(BOOL)isMostRecent
+  {
+    UVCRequestFailure   failure = { .result = result, .errorCode = kUVCRequestErrorCodeNone, .attemptCount = 1 };
+    NSTimeInterval      backoff = _requestRetryBackoff;
+    NSUInteger          retryCount = 0;
     
-    if ( ! [self isInterfaceOpen] ) {
-      [self setIsInterfaceOpen:YES];
-      if ( ! [self isInterfaceOpen] ) return NO;
+    while ( failure.result != kIOReturnSuccess ) {
+      failure.errorCode = kUVCRequestErrorCodeUnknown;
+      if ( failure.result == kIOUSBPipeStalled ) failure.errorCode = [self requestErrorCode];
+      if ( ! isMostRecent ) {
+        //
+        // In a batch the error code may describe a later request.  An unsupported
+        // control or request (e.g. a limit probe) is taken at its word, so the
+        // expected stall costs one extra transfer; only "not ready" is worth
+        // delivering ours again, at once and on its own, to hear about it alone.
+        // That delivery is not a retry:
+        //
+        isMostRecent = YES;
+        if ( UVCControllerFailureIsTransient(failure.result, failure.errorCode) ) {
+          failure.result = [self transmitControlRequest:controlRequest];
+          failure.attemptCount++;
+          continue;
+        }
+        break;
+      }
+      if ( (retryCount >= _maximumRequestRetries) || ! UVCControllerFailureIsTransient(failure.result, failure.errorCode) ) break;
+      
+      // The device says it is not ready; give it a little longer each time:
+      if ( backoff > 0 ) {
+        [NSThread sleepForTimeInterval:backoff];
+        if ( (backoff *= 2) > UVCControllerMaximumRequestRetryBackoff ) backoff = UVCControllerMaximumRequestRetryBackoff;
+      }
+      failure.result = [self transmitControlRequest:controlRequest];
+      failure.attemptCount++;
+      retryCount++;
     }
-    rc = (*_controllerInterface)->ControlRequest(_controllerInterface, 0, &controlRequest);
-    return ( rc == kIOReturnSuccess );
+    if ( failure.result == kIOReturnSuccess ) failure.errorCode = kUVCRequestErrorCodeNone;
+    UVCControllerThreadRequestFailure = failure;
+    pthread_mutex_lock(&_requestFailureLock);
+    _lastRequestFailure = failure;
+    pthread_mutex_unlock(&_requestFailureLock);
+    return failure.result;
   }
 
 //
 
-  - (BOOL) setData:(void*)value
+  - (void) applyRequestTimeout
+  {
+    if ( [_transport respondsToSelector:@selector(setRequestTimeout:)] ) [_transport setRequestTimeout:_requestTimeout];
+  }
+
+//
+
+  - (IOUSBDevRequest) controlRequestWithType:(int)type
+    data:(void*)value
     withLength:(int)length
     forSelector:(int)selector
     atUnitId:(int)unitId
   {
     IOUSBDevRequest controlRequest = {
-                        .bmRequestType = USBmakebmRequestType(kUSBOut, kUSBClass, kUSBInterface),
-                        .bRequest = UVC_SET_CUR,
+                        .bmRequestType = USBmakebmRequestType(((type == UVC_SET_CUR) ? kUSBOut : kUSBIn), kUSBClass, kUSBInterface),
+                        .bRequest = type,
                         .wValue = (selector << 8),
                         .wIndex = (unitId << 8) | _videoInterfaceIndex,
                         .wLength = length,
                         .wLenDone = 0,
                         .pData = value
                       };
-    return [self sendControlRequest:controlRequest];
+    return controlRequest;
+  }
+
+//
+
+  - (BOOL) setData:(void*)value
+    withLength:(int)length
+    forSelector:(int)selector
+    atUnitId:(int)unitId
+  {
+    return [self sendControlRequest:[self controlRequestWithType:UVC_SET_CUR data:value withLength:length forSelector:selector atUnitId:unitId]];
   }
 
 //
@@ -966,16 +1430,7 @@ uvc_control_t     UVCControllerControls[] = {
     fromSelector:(int)selector
     atUnitId:(int)unitId
   {
-    IOUSBDevRequest controlRequest = {
-                        .bmRequestType = USBmakebmRequestType(kUSBIn, kUSBClass, kUSBInterface),
-                        .bRequest = type,
-                        .wValue = (selector << 8),
-                        .wIndex = (unitId << 8) | _videoInterfaceIndex,
-                        .wLength = length,
-                        .wLenDone = 0,
-                        .pData = value
-                      };
-    return [self sendControlRequest:controlRequest];
+    return [self sendControlRequest:[self controlRequestWithType:type data:value withLength:length forSelector:selector atUnitId:unitId]];
   }
 
 //
@@ -995,7 +1450,7 @@ uvc_control_t     UVCControllerControls[] = {
 
 //
 
-  - (void) getLowValue:(UVCValue**)lowValue
+  - (BOOL) getLowValue:(UVCValue**)lowValue
     highValue:(UVCValue**)highValue
     stepSize:(UVCValue**)stepSize
     defaultValue:(UVCValue**)defaultValue
@@ -1004,35 +1459,58 @@ uvc_control_t     UVCControllerControls[] = {
   {
     uvc_control_t   *control = &UVCControllerControls[controlId];
     int             unitId = [[_unitIds objectForKey:control->unitTypeStr] intValue];
+    UVCRequestQueue *queue = [self checkOutRequestQueue];
+    UVCValue        **values[4] = { lowValue, highValue, stepSize, defaultValue };
+    int             types[4] = { UVC_GET_MIN, UVC_GET_MAX, UVC_GET_RES, UVC_GET_DEF };
+    UVCControllerLimitResult  results[4];
+    BOOL            isDefinitive = YES;
+    int             i;
+    
+    //
+    // The four limit requests are independent of one another, so they are all
+    // put in flight together:
+    //
+    for ( i = 0; i < 4; i++ ) {
+      results[i].result = kIOReturnError;
+      results[i].isDefinitive = YES;
+      if ( ! *values[i] ) continue;
+      if ( (i < 2) && ! (*lowValue && *highValue) ) continue;
+      [queue enqueueControlRequest:[self controlRequestWithType:types[i] data:[*values[i] valuePtr] withLength:(int)[*values[i] byteSize] forSelector:control->selector atUnitId:unitId]
+                  callback:UVCControllerStoreLimitResult
+                  context:&results[i]
+                ];
+    }
+    [queue run];
+    [self checkInRequestQueue:queue];
+    for ( i = 0; i < 4; i++ ) if ( ! results[i].isDefinitive ) isDefinitive = NO;
     
     if ( *lowValue && *highValue ) {
-      if ( [self getData:[*lowValue valuePtr] ofType:UVC_GET_MIN withLength:(int)[*lowValue byteSize] fromSelector:control->selector atUnitId:unitId] &&
-           [self getData:[*highValue valuePtr] ofType:UVC_GET_MAX withLength:(int)[*highValue byteSize] fromSelector:control->selector atUnitId:unitId]
-      ) {
+      if ( (results[0].result == kIOReturnSuccess) && (results[1].result == kIOReturnSuccess) ) {
         *capabilities |= kUVCControlHasRange;
-        [(*lowValue = [*lowValue retain]) byteSwapUSBToHostEndian];
-        [(*highValue = [*highValue retain]) byteSwapUSBToHostEndian];
+        [(*lowValue = [*lowValue retain]) byteSwapFromUSBEndian];
+        [(*highValue = [*highValue retain]) byteSwapFromUSBEndian];
       } else {
         *lowValue = nil;
         *highValue = nil;
       }
     }
     if ( *stepSize ) {
-      if ( [self getData:[*stepSize valuePtr] ofType:UVC_GET_RES withLength:(int)[*stepSize byteSize] fromSelector:control->selector atUnitId:unitId]) {
+      if ( results[2].result == kIOReturnSuccess ) {
         *capabilities |= kUVCControlHasStepSize;
-        [(*stepSize = [*stepSize retain]) byteSwapUSBToHostEndian];
+        [(*stepSize = [*stepSize retain]) byteSwapFromUSBEndian];
       } else {
         *stepSize = nil;
       }
     }
     if ( *defaultValue ) {
-      if ( [self getData:[*defaultValue valuePtr] ofType:UVC_GET_DEF withLength:(int)[*defaultValue byteSize] fromSelector:control->selector atUnitId:unitId]) {
+      if ( results[3].result == kIOReturnSuccess ) {
         *capabilities |= kUVCControlHasDefaultValue;
-        [(*defaultValue = [*defaultValue retain]) byteSwapUSBToHostEndian];
+        [(*defaultValue = [*defaultValue retain]) byteSwapFromUSBEndian];
       } else {
         *defaultValue = nil;
       }
     }
+    return isDefinitive;
   }
 
 //
@@ -1043,7 +1521,8 @@ uvc_control_t     UVCControllerControls[] = {
     uvc_control_t   *control = &UVCControllerControls[controlId];
      
     if ( [self getData:[value valuePtr] ofType:UVC_GET_CUR withLength:(int)[value byteSize] fromSelector:control->selector atUnitId:[[_unitIds objectForKey:control->unitTypeStr] intValue]] ) {
-      [value byteSwapUSBToHostEndian];
+      [value byteSwapFromUSBEndian];
+      if ( _writeQueue ) [_writeQueue noteDeviceValue:value atIndex:controlId];
       return YES;
     }
     return NO;
@@ -1053,16 +1532,137 @@ uvc_control_t     UVCControllerControls[] = {
 
   - (BOOL) setValue:(UVCValue*)value
     forControl:(NSUInteger)controlId
+  {
+    if ( _writeQueue && [self coalescesWrites] ) {
+      // Another thread already flushing will deliver our value:
+      if ( [_writeQueue enqueueValue:value atIndex:controlId] ) return [self drainWriteQueue];
+      return YES;
+    }
+    return [self writeValue:value forControl:controlId];
+  }
+
+//
+
+  - (BOOL) writeValue:(UVCValue*)value
+    forControl:(NSUInteger)controlId
   {
     uvc_control_t   *control = &UVCControllerControls[controlId];
-    BOOL            rc = NO;
+    int             unitId = [[_unitIds objectForKey:control->unitTypeStr] intValue];
     
-    [value byteSwapHostToUSBEndian];
-    rc = [self setData:[value valuePtr] withLength:(int)[value byteSize] forSelector:control->selector atUnitId:[[_unitIds objectForKey:control->unitTypeStr] intValue]];
-    [value byteSwapUSBToHostEndian];
+    if ( ! [[value valueType] needsByteSwap] || [value isSwappedToUSBEndian] ) {
+      return [self setData:[value valuePtr] withLength:(int)[value byteSize] forSelector:control->selector atUnitId:unitId];
+    }
+    
+    // Send a swapped copy rather than swapping the value out and back again:
+    UInt8           usbValue[[value byteSize]];
+    
+    memcpy(usbValue, [value valuePtr], [value byteSize]);
+    [[value valueType] byteSwapHostToUSBEndian:usbValue];
+    return [self setData:usbValue withLength:(int)[value byteSize] forSelector:control->selector atUnitId:unitId];
+  }
+
+//
+
+  - (BOOL) drainWriteQueue
+  {
+    UVCValue        *value;
+    NSUInteger      controlId;
+    BOOL            rc = YES;
+    
+    while ( (value = [_writeQueue dequeueValueAtIndex:&controlId]) ) {
+      BOOL          ok = [self writeValue:value forControl:controlId];
+      
+      [_writeQueue didWriteValueAtIndex:controlId successfully:ok];
+      if ( ! ok ) rc = NO;
+    }
     return rc;
   }
 
+//
+
+  - (void) noteDeviceValuesOfControls:(NSArray*)controls
+  {
+    if ( _writeQueue ) {
+      NSEnumerator  *eControls = [controls objectEnumerator];
+      UVCControl    *control;
+      
+      // The batch just read or wrote each value buffer:
+      while ( (control = [eControls nextObject]) ) [_writeQueue noteDeviceValue:[control valueBuffer] atIndex:[control controlIndex]];
+    }
+  }
+
+//
+
+  - (void) writeNDJSONRecordForControl:(UVCControl*)control
+    result:(IOReturn)result
+    toStream:(FILE*)stream
+  {
+    static const char   *capabilityNames[] = { "get", "set", "disabled-due-to-automatic-mode", "auto-update", "asynchronous" };
+    static const char   *limitNames[] = { "minimum", "maximum", "step-size", "default" };
+    BOOL                capabilities[] = { [control supportsGetValue], [control supportsSetValue], [control isDisabledDueToAutomaticMode], [control isAutoUpdateControl], [control isAsynchronousControl] };
+    UVCValue            *limits[] = { [control minimum], [control maximum], [control stepSize], [control defaultValue] };
+    UVCValue            *value = [control valueBuffer];
+    UVCType             *valueType = UVCControllerControls[[control controlIndex]].uvcType;
+    char                valueStr[[valueType maximumFormattedLength] + 1];
+    NSUInteger          i, count;
+    
+    fprintf(stream, "{\"location-id\":\"0x%08x\",\"vendor-id\":\"0x%04x\",\"product-id\":\"0x%04x\",\"control\":\"%s\",\"capabilities\":[",
+        _locationId, _vendorId, _productId,
+        UVCControllerControls[[control controlIndex]].controlName
+      );
+    for ( i = 0, count = 0; i < sizeof(capabilities) / sizeof(BOOL); i++ ) {
+      if ( capabilities[i] ) fprintf(stream, "%s\"%s\"", ( count++ ? "," : "" ), capabilityNames[i]);
+    }
+    fprintf(stream, "],\"type\":");
+    [valueType writeLayoutAsJSONToStream:stream];
+    for ( i = 0; i < sizeof(limits) / sizeof(UVCValue*); i++ ) {
+      if ( limits[i] ) {
+        [limits[i] formatAs:kUVCTypeFormatJSON intoCString:valueStr length:sizeof(valueStr)];
+        fprintf(stream, ",\"%s\":%s", limitNames[i], valueStr);
+      } else {
+        fprintf(stream, ",\"%s\":null", limitNames[i]);
+      }
+    }
+    if ( ! [control supportsGetValue] || ! value ) {
+      fprintf(stream, ",\"value\":null}\n");
+    } else if ( result == kIOReturnSuccess ) {
+      [value formatAs:kUVCTypeFormatJSON intoCString:valueStr length:sizeof(valueStr)];
+      fprintf(stream, ",\"value\":%s}\n", valueStr);
+    } else {
+      fprintf(stream, ",\"value\":null,\"error\":\"0x%08x\"}\n", result);
+    }
+    fflush(stream);
+  }
+
+//
+
+  - (void) enqueueGetValue:(UVCValue*)value
+    forControl:(NSUInteger)controlId
+    inQueue:(UVCRequestQueue*)queue
+  {
+    uvc_control_t   *control = &UVCControllerControls[controlId];
+    
+    [queue enqueueControlRequest:[self controlRequestWithType:UVC_GET_CUR data:[value valuePtr] withLength:(int)[value byteSize] forSelector:control->selector atUnitId:[[_unitIds objectForKey:control->unitTypeStr] intValue]]
+                callback:UVCControllerGetValueCompletion
+                context:value
+              ];
+  }
+
+//
+
+  - (void) enqueueSetValue:(UVCValue*)value
+    forControl:(NSUInteger)controlId
+    inQueue:(UVCRequestQueue*)queue
+  {
+    uvc_control_t   *control = &UVCControllerControls[controlId];
+    
+    [value byteSwapHostToUSBEndian];
+    [queue enqueueControlRequest:[self controlRequestWithType:UVC_SET_CUR data:[value valuePtr] withLength:(int)[value byteSize] forSelector:control->selector atUnitId:[[_unitIds objectForKey:control->unitTypeStr] intValue]]
+                callback:UVCControllerSetValueCompletion
+                context:value
+              ];
+  }
+
 @end
 
 //
@@ -1073,22 +1673,66 @@ uvc_control_t     UVCControllerControls[] = {
 
 @implementation UVCController
 
-  + (NSArray*) controlStrings
+  + (void) initialize
   {
-    static NSArray    *sharedControlStrings = nil;
+    //
+    // The runtime serializes +initialize, so the shared UVCType instances are
+    // built exactly once, before any control can be created:
+    //
+    if ( self == [UVCController class] ) {
+      NSString      *controlNames[UVCControllerControlCount];
+      NSUInteger    i;
 
-    if ( ! sharedControlStrings ) {
-      NSDictionary    *controlMapping = [self controlMapping];
+      for ( i = 0; i < UVCControllerControlCount; i++ ) {
+        uvc_control_t   *controlInfo = &UVCControllerControls[i];
 
-      if ( controlMapping ) sharedControlStrings = [controlMapping allKeys];
+        if ( (strcmp(UVCControlNames[i], controlInfo->controlName) != 0) || (UVCControlNameIndexForCString(controlInfo->controlName) != i) ) {
+          fprintf(stderr, "FATAL ERROR:  control name hash table does not match control %s !!!\n", controlInfo->controlName);
+          exit(EFAULT);
+        }
+        if ( (controlInfo->uvcType = [UVCType uvcTypeWithFieldCount:controlInfo->fieldCount descriptors:controlInfo->fields]) == nil ) {
+          fprintf(stderr, "FATAL ERROR:  unable to instantiate UVCType for control %s !!!\n", controlInfo->controlName);
+          exit(EFAULT);
+        }
+        controlInfo->uvcType = [controlInfo->uvcType retain];
+        UVCControllerControlTypes[i] = controlInfo->uvcType;
+        controlNames[i] = controlInfo->controlNameStr;
+      }
+      UVCControllerSharedControlStrings = [[NSArray alloc] initWithObjects:controlNames count:UVCControllerControlCount];
     }
-    return sharedControlStrings;
+  }
+
+//
+
+  + (NSArray*) controlStrings
+  {
+    return UVCControllerSharedControlStrings;
   }
   - (NSArray*) controlStrings
   {
     return [[self class] controlStrings];
   }
 
+//
+
+  - (UInt64) controlsAvailable
+  {
+    return _controlsAvailable;
+  }
+
+//
+
+  - (NSArray*) availableControlNames
+  {
+    NSString        *controlNames[UVCControllerControlCount];
+    NSUInteger      controlIndex, count = 0;
+    
+    for ( controlIndex = 0; controlIndex < UVCControllerControlCount; controlIndex++ ) {
+      if ( _controlsAvailable & (1ULL << controlIndex) ) controlNames[count++] = [UVCControllerSharedControlStrings objectAtIndex:controlIndex];
+    }
+    return [NSArray arrayWithObjects:controlNames count:count];
+  }
+
 //
 
   + (NSArray*) uvcControllers
@@ -1105,7 +1749,6 @@ uvc_control_t     UVCControllerControls[] = {
       while ( (device = IOIteratorNext(deviceIter)) ) {
         UVCController       *newController = [UVCController uvcControllerWithService:device];
 
-        IOObjectRelease(device);
         if ( newController ) {
           if ( ! newControllers ) newControllers = [[NSMutableArray alloc] init];
           [newControllers addObject:newController];
@@ -1145,9 +1788,7 @@ uvc_control_t     UVCControllerControls[] = {
       CFNumberGetValue(locationIdObj, kCFNumberSInt32Type, &locationId);
       CFRelease(locationIdObj);
     }
-    // We assume that the caller doesn't want to lose ioService in the course of finding the
-    // controller interface, so increase the refcount on it:
-    IOObjectRetain(ioService);
+    // Finding the controller interface does not consume the caller's reference to ioService:
     return [[[UVCController alloc] initWithLocationId:locationId vendorId:vendorId productId:productId ioServiceObject:ioService] autorelease];
   }
 
@@ -1185,8 +1826,8 @@ uvc_control_t     UVCControllerControls[] = {
         CFRelease(productIdObj);
       }
 
-      // Our reference to the "device" object will be dropped in the course of finding the controller interface:
       newController = [[[UVCController alloc] initWithLocationId:locationId vendorId:vendorId productId:productId ioServiceObject:device] autorelease];
+      IOObjectRelease(device);
     }
     return newController;
   }
@@ -1224,24 +1865,70 @@ uvc_control_t     UVCControllerControls[] = {
         CFRelease(locationIdObj);
       }
 
-      // Our reference to the "device" object will be dropped in the course of finding the controller interface:
       newController = [[[UVCController alloc] initWithLocationId:locationId vendorId:vendorId productId:productId ioServiceObject:device] autorelease];
+      IOObjectRelease(device);
     }
     return newController;
   }
 
+//
+
+  + (id) uvcControllerWithTransport:(id<UVCTransport>)transport
+    deviceName:(NSString*)deviceName
+    vendorId:(UInt16)vendorId
+    productId:(UInt16)productId
+  {
+    return [[[UVCController alloc] initWithTransport:transport deviceName:deviceName vendorId:vendorId productId:productId locationId:0 videoControlDescriptors:nil] autorelease];
+  }
+
+//
+
+  + (id) uvcControllerWithTransport:(id<UVCTransport>)transport
+    deviceName:(NSString*)deviceName
+    vendorId:(UInt16)vendorId
+    productId:(UInt16)productId
+    locationId:(UInt32)locationId
+  {
+    return [[[UVCController alloc] initWithTransport:transport deviceName:deviceName vendorId:vendorId productId:productId locationId:locationId videoControlDescriptors:nil] autorelease];
+  }
+
+//
+
+  + (id) uvcControllerWithTransport:(id<UVCTransport>)transport
+    deviceName:(NSString*)deviceName
+    vendorId:(UInt16)vendorId
+    productId:(UInt16)productId
+    locationId:(UInt32)locationId
+    videoControlDescriptors:(NSData*)videoControlDescriptors
+  {
+    return [[[UVCController alloc] initWithTransport:transport deviceName:deviceName vendorId:vendorId productId:productId locationId:locationId videoControlDescriptors:videoControlDescriptors] autorelease];
+  }
+
 //
 
   - (void) dealloc
   {
+    if ( _capabilityCache ) {
+      [_capabilityCache synchronize];
+      [_capabilityCache release];
+    }
+    if ( _writeQueue ) [_writeQueue release];
+    if ( _requestStatistics ) [_requestStatistics release];
+    if ( _valueArena ) [_valueArena release];
+    if ( _idleRequestQueue ) [_idleRequestQueue release];
+    pthread_mutex_destroy(&_requestQueueLock);
+    pthread_mutex_destroy(&_requestFailureLock);
     if ( _terminalControlsAvailable ) [_terminalControlsAvailable release];
     if ( _processingUnitControlsAvailable ) [_processingUnitControlsAvailable release];
     if ( _controls ) [_controls release];
     if ( _unitIds ) [_unitIds release];
-    if ( _controllerInterface ) {
-      [self setIsInterfaceOpen:NO];
-      (*_controllerInterface)->Release(_controllerInterface);
+    if ( _descriptorGraph ) free(_descriptorGraph);
+    if ( _videoControlDescriptors ) [_videoControlDescriptors release];
+    if ( _transport ) {
+      [_transport close];
+      [_transport release];
     }
+    if ( _controllerInterface ) (*_controllerInterface)->Release(_controllerInterface);
     if ( _deviceName ) [_deviceName release];
     [super dealloc];
   }
@@ -1257,7 +1944,7 @@ uvc_control_t     UVCControllerControls[] = {
                         _locationId,
                         _uvcVersion,
                         _videoInterfaceIndex,
-                        (_isInterfaceOpen ? " ; is-open" : "")
+                        ([_transport isOpen] ? " ; is-open" : "")
                       ];
   }
 
@@ -1296,33 +1983,629 @@ uvc_control_t     UVCControllerControls[] = {
     return _uvcVersion;
   }
 
+//
+
+  - (NSData*) videoControlDescriptors
+  {
+    return _videoControlDescriptors;
+  }
+  - (const UVCDescriptorGraph*) descriptorGraph
+  {
+    return _descriptorGraph;
+  }
+
+//
+
+  - (UVCCapabilityCache*) capabilityCache
+  {
+    return _capabilityCache;
+  }
+  - (void) invalidateCapabilityCache
+  {
+    if ( _capabilityCache ) [_capabilityCache invalidate];
+  }
+  - (BOOL) attachCapabilityCache
+  {
+    if ( ! _capabilityCache ) {
+      _capabilityCache = [[UVCCapabilityCache capabilityCacheForVendorId:_vendorId
+                                                productId:_productId
+                                                uvcVersion:_uvcVersion
+                                                descriptorHash:_descriptorHash
+                                                controlCount:UVCControllerControlCount
+                                              ] retain];
+    }
+    return ( _capabilityCache != nil );
+  }
+
 //
 
   - (BOOL) isInterfaceOpen
   {
-    return _isInterfaceOpen;
+    return [_transport isOpen];
   }
   - (void) setIsInterfaceOpen:(BOOL)isInterfaceOpen
   {
-    if ( isInterfaceOpen != _isInterfaceOpen ) {
-      IOReturn          rc;
+    if ( isInterfaceOpen != [_transport isOpen] ) [_requestStatistics recordInterfaceOpen:isInterfaceOpen];
+    if ( isInterfaceOpen ) {
+      [_transport open];
+    } else {
+      [_transport close];
+    }
+  }
+
+//
+
+  - (id<UVCTransport>) transport
+  {
+    return _transport;
+  }
+  - (void) setTransport:(id<UVCTransport>)transport
+  {
+    if ( transport != _transport ) {
+      while ( [_transport requestsInFlight] ) [_transport waitForCompletions];
+      [transport retain];
+      [_transport release];
+      _transport = transport;
+      [self applyRequestTimeout];
+
+      // The idle request queue delivers via the old transport:
+      pthread_mutex_lock(&_requestQueueLock);
+      if ( _idleRequestQueue ) {
+        [_idleRequestQueue release];
+        _idleRequestQueue = nil;
+      }
+      pthread_mutex_unlock(&_requestQueueLock);
+    }
+  }
+
+//
+
+  + (NSTimeInterval) defaultRequestTimeout
+  {
+    return UVCControllerSharedRequestTimeout;
+  }
+  + (void) setDefaultRequestTimeout:(NSTimeInterval)requestTimeout
+  {
+    UVCControllerSharedRequestTimeout = ( requestTimeout > 0 ) ? requestTimeout : 0;
+  }
+
+//
+
+  + (NSUInteger) defaultMaximumRequestRetries
+  {
+    return UVCControllerSharedMaximumRequestRetries;
+  }
+  + (void) setDefaultMaximumRequestRetries:(NSUInteger)maximumRequestRetries
+  {
+    UVCControllerSharedMaximumRequestRetries = maximumRequestRetries;
+  }
+
+//
+
+  - (NSTimeInterval) requestTimeout
+  {
+    return _requestTimeout;
+  }
+  - (void) setRequestTimeout:(NSTimeInterval)requestTimeout
+  {
+    _requestTimeout = ( requestTimeout > 0 ) ? requestTimeout : 0;
+    [self applyRequestTimeout];
+  }
+
+//
+
+  - (NSUInteger) maximumRequestRetries
+  {
+    return _maximumRequestRetries;
+  }
+  - (void) setMaximumRequestRetries:(NSUInteger)maximumRequestRetries
+  {
+    _maximumRequestRetries = maximumRequestRetries;
+  }
 
-      if ( isInterfaceOpen ) {
-        rc = (*_controllerInterface)->USBInterfaceOpen(_controllerInterface);
-        if ( rc == kIOReturnSuccess ) {
-          _shouldNotCloseInterface = _isInterfaceOpen = YES;
+//
+
+  - (NSTimeInterval) requestRetryBackoff
+  {
+    return _requestRetryBackoff;
+  }
+  - (void) setRequestRetryBackoff:(NSTimeInterval)requestRetryBackoff
+  {
+    _requestRetryBackoff = ( requestRetryBackoff > 0 ) ? requestRetryBackoff : 0;
+  }
+
+//
+
+  - (UVCRequestFailure) lastRequestFailure
+  {
+    UVCRequestFailure   failure;
+    
+    pthread_mutex_lock(&_requestFailureLock);
+    failure = _lastRequestFailure;
+    pthread_mutex_unlock(&_requestFailureLock);
+    return failure;
+  }
+
+//
+
+  - (NSUInteger) maximumRequestsInFlight
+  {
+    return _maximumRequestsInFlight;
+  }
+  - (void) setMaximumRequestsInFlight:(NSUInteger)maximumRequestsInFlight
+  {
+    _maximumRequestsInFlight = ( maximumRequestsInFlight ? maximumRequestsInFlight : 1 );
+  }
+
+//
+
+  - (UVCRequestQueue*) requestQueue
+  {
+    UVCRequestQueue   *queue = [UVCRequestQueue requestQueueWithTransport:_transport];
+    
+    [queue setWindowSize:_maximumRequestsInFlight];
+    [queue setStatistics:_requestStatistics];
+    [queue setFailureHandler:UVCControllerFinishQueuedRequest context:self];
+    return queue;
+  }
+
+//
+
+  - (UVCRequestQueue*) checkOutRequestQueue
+  {
+    UVCRequestQueue   *queue;
+    
+    pthread_mutex_lock(&_requestQueueLock);
+    queue = _idleRequestQueue;
+    _idleRequestQueue = nil;
+    pthread_mutex_unlock(&_requestQueueLock);
+    if ( ! queue ) {
+      queue = [[UVCRequestQueue alloc] initWithTransport:_transport];
+      [queue setStatistics:_requestStatistics];
+      [queue setFailureHandler:UVCControllerFinishQueuedRequest context:self];
+    }
+    [queue setWindowSize:_maximumRequestsInFlight];
+    return queue;
+  }
+  
+//
+
+  - (void) checkInRequestQueue:(UVCRequestQueue*)queue
+  {
+    pthread_mutex_lock(&_requestQueueLock);
+    if ( ! _idleRequestQueue && ([queue transport] == _transport) ) {
+      _idleRequestQueue = queue;
+      queue = nil;
+    }
+    pthread_mutex_unlock(&_requestQueueLock);
+    if ( queue ) [queue release];
+  }
+
+//
+
+  - (UVCRequestStatistics*) requestStatistics
+  {
+    return _requestStatistics;
+  }
+
+//
+
+  - (UVCValueArena*) valueArena
+  {
+    return _valueArena;
+  }
+
+//
+
+  - (void) writeRequestStatisticsAsJSONToStream:(FILE*)stream
+  {
+    static const double       percentiles[] = { 50.0, 90.0, 99.0 };
+    static const char         *percentileNames[] = { "p50", "p90", "p99" };
+    NSUInteger                i, j, iMax = [_requestStatistics entryCount];
+    UVCRequestStatisticsEntry entry;
+    UInt64                    count;
+    
+    fprintf(stream, "{\"name\":\"");
+    UVCControllerWriteJSONString(stream, ( _deviceName ? [_deviceName UTF8String] : "" ));
+    fprintf(stream, "\",\"location-id\":\"0x%08x\",\"vendor-id\":\"0x%04x\",\"product-id\":\"0x%04x\"", _locationId, _vendorId, _productId);
+    fprintf(stream, ",\"interface-opens\":%llu,\"interface-closes\":%llu,\"requests\":%llu,\"failures\":%llu,\"failures-by-ioreturn\":{",
+        (unsigned long long)[_requestStatistics interfaceOpenCount],
+        (unsigned long long)[_requestStatistics interfaceCloseCount],
+        (unsigned long long)[_requestStatistics requestCount],
+        (unsigned long long)[_requestStatistics failedCount]
+      );
+    for ( i = 0; i < [_requestStatistics failureCodeCount]; i++ ) {
+      IOReturn                code = [_requestStatistics failureCodeAtIndex:i count:&count];
+      
+      fprintf(stream, "%s\"0x%08x\":%llu", ( i ? "," : "" ), code, (unsigned long long)count);
+    }
+    if ( (count = [_requestStatistics otherFailureCount]) ) fprintf(stream, "%s\"other\":%llu", ( i ? "," : "" ), (unsigned long long)count);
+    fprintf(stream, "},\"controls\":[");
+    for ( i = 0; i < iMax; i++ ) {
+      const char              *controlName = NULL;
+      
+      if ( ! [_requestStatistics getEntry:&entry atIndex:i] ) break;
+      for ( j = 0; j < UVCControllerControlCount; j++ ) {
+        uvc_control_t         *control = &UVCControllerControls[j];
+        
+        if ( (control->selector == entry.selector) && ([[_unitIds objectForKey:control->unitTypeStr] intValue] == entry.unitId) ) {
+          controlName = control->controlName;
+          break;
         }
-        else if ( rc == kIOReturnExclusiveAccess) {
-          _isInterfaceOpen = YES;
-          _shouldNotCloseInterface = NO;
+      }
+      fprintf(stream, "%s{", ( i ? "," : "" ));
+      if ( controlName ) {
+        fprintf(stream, "\"control\":\"%s\"", controlName);
+      } else {
+        fprintf(stream, "\"control\":null,\"unit-id\":%hhu,\"selector\":%hhu", entry.unitId, entry.selector);
+      }
+      fprintf(stream, ",\"request\":\"%s\",\"count\":%llu,\"failed\":%llu,\"min-us\":%.3f,\"mean-us\":%.3f,\"max-us\":%.3f",
+          UVCRequestStatisticsRequestName(entry.request),
+          (unsigned long long)entry.count,
+          (unsigned long long)entry.failedCount,
+          ( entry.count ? entry.minimumTime / 1000.0 : 0.0 ),
+          ( entry.count ? entry.totalTime / 1000.0 / entry.count : 0.0 ),
+          entry.maximumTime / 1000.0
+        );
+      for ( j = 0; j < sizeof(percentiles) / sizeof(double); j++ ) {
+        fprintf(stream, ",\"%s-us\":%.3f", percentileNames[j], UVCRequestStatisticsEntryPercentile(&entry, percentiles[j]));
+      }
+      // Only the non-empty buckets, keyed by their upper bound:
+      fprintf(stream, ",\"histogram-us\":{");
+      count = 0;
+      for ( j = 0; j < UVCRequestStatisticsBucketCount; j++ ) {
+        if ( entry.buckets[j] ) {
+          if ( j + 1 < UVCRequestStatisticsBucketCount ) {
+            fprintf(stream, "%s\"<%llu\":%llu", ( count++ ? "," : "" ), (unsigned long long)UVCRequestStatisticsBucketLimit(j), (unsigned long long)entry.buckets[j]);
+          } else {
+            fprintf(stream, "%s\">=%llu\":%llu", ( count++ ? "," : "" ), (unsigned long long)UVCRequestStatisticsBucketLimit(j - 1), (unsigned long long)entry.buckets[j]);
+          }
         }
-      } else if ( ! _shouldNotCloseInterface ) {
-        rc = (*_controllerInterface)->USBInterfaceClose(_controllerInterface);
-        if ( rc == kIOReturnSuccess ) _shouldNotCloseInterface = _isInterfaceOpen = NO;
       }
+      fprintf(stream, "}}");
+    }
+    fprintf(stream, "]}");
+  }
+
+//
+
+  - (NSUInteger) writeControlsAsNDJSONToStream:(FILE*)stream
+    failedCount:(NSUInteger*)failedCount
+  {
+    UVCControllerNDJSONRecord records[UVCControllerControlCount];
+    NSMutableArray            *readControls = [NSMutableArray array];
+    BOOL                      wasOpen = [self isInterfaceOpen];
+    UVCRequestQueue           *queue;
+    NSUInteger                i, recordCount = 0, failed = 0;
+    
+    if ( ! wasOpen ) [self setIsInterfaceOpen:YES];
+    
+    //
+    // Capabilities and limits first, one control at a time (most come from the
+    // capability cache):
+    //
+    for ( i = 0; i < UVCControllerControlCount; i++ ) {
+      UVCControl              *control = [self controlWithName:UVCControllerControls[i].controlNameStr];
+      
+      if ( control ) {
+        records[recordCount].controller = self;
+        records[recordCount].control = control;
+        records[recordCount].stream = stream;
+        records[recordCount].result = kIOReturnSuccess;
+        recordCount++;
+      }
+    }
+    
+    //
+    // ...then every current value in one pipelined set of transfers, each record
+    // written as its transfer completes:
+    //
+    queue = [self checkOutRequestQueue];
+    for ( i = 0; i < recordCount; i++ ) {
+      UVCControl              *control = records[i].control;
+      
+      if ( [control supportsGetValue] ) {
+        uvc_control_t         *controlInfo = &UVCControllerControls[[control controlIndex]];
+        UVCValue              *value = [control valueBuffer];
+        
+        [queue enqueueControlRequest:[self controlRequestWithType:UVC_GET_CUR data:[value valuePtr] withLength:(int)[value byteSize] forSelector:controlInfo->selector atUnitId:[[_unitIds objectForKey:controlInfo->unitTypeStr] intValue]]
+                    callback:UVCControllerNDJSONCompletion
+                    context:&records[i]
+                  ];
+      } else {
+        [self writeNDJSONRecordForControl:control result:kIOReturnSuccess toStream:stream];
+      }
+    }
+    [queue run];
+    [self checkInRequestQueue:queue];
+    for ( i = 0; i < recordCount; i++ ) {
+      if ( ! [records[i].control supportsGetValue] ) continue;
+      if ( records[i].result == kIOReturnSuccess ) {
+        [readControls addObject:records[i].control];
+      } else {
+        failed++;
+      }
+    }
+    [self noteDeviceValuesOfControls:readControls];
+    
+    if ( ! wasOpen ) [self setIsInterfaceOpen:NO];
+    if ( failedCount ) *failedCount = failed;
+    return recordCount;
+  }
+
+//
+
+  - (BOOL) readControls:(NSArray*)controls
+  {
+    UVCRequestQueue   *queue = [self checkOutRequestQueue];
+    NSEnumerator      *eControls = [controls objectEnumerator];
+    UVCControl        *control;
+    NSUInteger        failedCount;
+    
+    while ( (control = [eControls nextObject]) ) [control enqueueReadIntoCurrentValueInQueue:queue];
+    failedCount = [queue run];
+    [self checkInRequestQueue:queue];
+    if ( failedCount == 0 ) {
+      [self noteDeviceValuesOfControls:controls];
+      return YES;
+    }
+    return NO;
+  }
+
+//
+
+  - (BOOL) writeControls:(NSArray*)controls
+  {
+    UVCRequestQueue   *queue = [self checkOutRequestQueue];
+    NSEnumerator      *eControls = [controls objectEnumerator];
+    UVCControl        *control;
+    NSUInteger        failedCount;
+    
+    while ( (control = [eControls nextObject]) ) {
+      // The batch is the newest writer, so a coalesced value still waiting must not overwrite it:
+      if ( _writeQueue ) [_writeQueue cancelValueAtIndex:[control controlIndex]];
+      [control enqueueWriteFromCurrentValueInQueue:queue];
+    }
+    failedCount = [queue run];
+    [self checkInRequestQueue:queue];
+    if ( failedCount == 0 ) {
+      [self noteDeviceValuesOfControls:controls];
+      return YES;
+    }
+    return NO;
+  }
+
+//
+
+  - (BOOL) coalescesWrites
+  {
+    return _coalescesWrites;
+  }
+  - (void) setCoalescesWrites:(BOOL)coalescesWrites
+  {
+    if ( coalescesWrites ) {
+      if ( ! _writeQueue ) _writeQueue = [[UVCWriteQueue writeQueueWithControlCount:UVCControllerControlCount] retain];
+      _coalescesWrites = YES;
+    } else if ( _coalescesWrites ) {
+      _coalescesWrites = NO;
+      [self flushWrites];
     }
   }
 
+//
+
+  - (BOOL) flushWrites
+  {
+    if ( _writeQueue && [_writeQueue beginFlush] ) return [self drainWriteQueue];
+    return YES;
+  }
+
+//
+
+  - (UVCWriteQueue*) writeQueue
+  {
+    return _writeQueue;
+  }
+
+//
+
+  - (BOOL) refreshCapabilitiesOfControls:(NSArray*)controls
+  {
+    NSUInteger                        i, iMax = [controls count];
+    UVCControllerCapabilitiesRefresh  refresh[iMax ? iMax : 1];
+    UVCRequestQueue                   *queue = [self checkOutRequestQueue];
+    BOOL                              rc = YES;
+    
+    for ( i = 0; i < iMax; i++ ) {
+      uvc_control_t                   *control;
+      
+      refresh[i].control = [controls objectAtIndex:i];
+      refresh[i].result = kIOReturnError;
+      control = &UVCControllerControls[[refresh[i].control controlIndex]];
+      [queue enqueueControlRequest:[self controlRequestWithType:UVC_GET_INFO data:&refresh[i].info withLength:1 forSelector:control->selector atUnitId:[[_unitIds objectForKey:control->unitTypeStr] intValue]]
+                  callback:UVCControllerStoreResult
+                  context:&refresh[i].result
+                ];
+    }
+    [queue run];
+    [self checkInRequestQueue:queue];
+    for ( i = 0; i < iMax; i++ ) {
+      if ( refresh[i].result == kIOReturnSuccess ) {
+        [refresh[i].control setDeviceCapabilities:refresh[i].info];
+      } else {
+        rc = NO;
+      }
+    }
+    return rc;
+  }
+
+//
+
+  - (BOOL) hasStatusInterruptEndpoint
+  {
+    if ( [_transport respondsToSelector:@selector(hasStatusInterruptEndpoint)] ) return [_transport hasStatusInterruptEndpoint];
+    return NO;
+  }
+
+//
+
+  - (BOOL) watchControls:(NSArray*)controls
+    pollInterval:(NSTimeInterval)pollInterval
+    duration:(NSTimeInterval)duration
+    callback:(UVCControlChangeCallback)callback
+    context:(void*)context
+  {
+    BOOL                          hasStatusEndpoint = [self hasStatusInterruptEndpoint];
+    NSUInteger                    i, iMax = [controls count], watchCount = 0, interruptCount = 0;
+    UVCControllerWatchedControl   watched[iMax ? iMax : 1];
+    NSMutableArray                *polledControls = [NSMutableArray array];
+    NSTimeInterval                now = [NSDate timeIntervalSinceReferenceDate];
+    NSTimeInterval                endAt = ( duration > 0 ) ? now + duration : 0;
+    NSTimeInterval                nextPollAt;
+    UVCControlChangeEvent         event;
+    BOOL                          rc = YES;
+    
+    for ( i = 0; i < iMax; i++ ) {
+      UVCControl                  *control = [controls objectAtIndex:i];
+      uvc_control_t               *controlInfo = &UVCControllerControls[[control controlIndex]];
+      
+      if ( ! [control supportsGetValue] ) continue;
+      watched[watchCount].control = control;
+      watched[watchCount].unitId = [[_unitIds objectForKey:controlInfo->unitTypeStr] intValue];
+      watched[watchCount].selector = controlInfo->selector;
+      watched[watchCount].isInterruptDriven = hasStatusEndpoint && ([control isAutoUpdateControl] || [control isAsynchronousControl]);
+      watched[watchCount].lastValue = [UVCValue uvcValueWithType:[[control valueBuffer] valueType]];
+      if ( watched[watchCount].isInterruptDriven ) {
+        interruptCount++;
+      } else if ( pollInterval > 0 ) {
+        [polledControls addObject:control];
+      }
+      watchCount++;
+    }
+    if ( ! interruptCount && ! [polledControls count] ) return NO;
+    
+    //
+    // Establish the starting values that changes are measured against:
+    //
+    NSMutableArray                *allControls = [NSMutableArray arrayWithCapacity:watchCount];
+    
+    for ( i = 0; i < watchCount; i++ ) [allControls addObject:watched[i].control];
+    if ( ! [self readControls:allControls] ) return NO;
+    for ( i = 0; i < watchCount; i++ ) UVCControllerWatchedControlDidChange(&watched[i]);
+    
+    nextPollAt = now + pollInterval;
+    while ( 1 ) {
+      // Polling allocates (request queues), so drain as we go:
+      @autoreleasepool {
+        NSTimeInterval              waitUntil;
+      
+        now = [NSDate timeIntervalSinceReferenceDate];
+        if ( endAt && (now >= endAt) ) break;
+      
+        waitUntil = endAt ? endAt : now + 1.0;
+        if ( [polledControls count] && (nextPollAt < waitUntil) ) waitUntil = nextPollAt;
+      
+        if ( interruptCount ) {
+          UInt8                     packet[UVCTransportStatusPacketMaxSize];
+          NSUInteger                packetLength = sizeof(packet);
+          IOReturn                  ioRC = [_transport readStatusPacket:packet length:&packetLength timeout:(waitUntil > now ? waitUntil - now : 0)];
+        
+          if ( ioRC == kIOReturnSuccess ) {
+            //
+            // A VideoControl control-change packet:  bStatusType (1), bOriginator, bEvent (0),
+            // bSelector, bAttribute, bValue[n]:
+            //
+            if ( (packetLength >= 5) && ((packet[0] & 0x0F) == 0x01) && (packet[2] == 0x00) ) {
+              UVCControllerWatchedControl *target = NULL;
+              NSUInteger                  valueLength = packetLength - 5;
+              BOOL                        didChange = NO;
+            
+              for ( i = 0; i < watchCount; i++ ) {
+                if ( watched[i].isInterruptDriven && (watched[i].unitId == packet[1]) && (watched[i].selector == packet[3]) ) {
+                  target = &watched[i];
+                  break;
+                }
+              }
+              if ( target ) {
+                UVCValue                  *value = nil;
+              
+                event.control = target->control;
+                event.attribute = packet[4];
+                event.failureCode = valueLength ? packet[5] : 0;
+                event.isFromStatusInterrupt = YES;
+                event.timestamp = [NSDate timeIntervalSinceReferenceDate];
+                switch ( packet[4] ) {
+              
+                  case kUVCControlChangeValue:
+                    value = [target->control valueBuffer];
+                    break;
+                  
+                  case kUVCControlChangeInfo:
+                    if ( valueLength ) {
+                      [target->control setDeviceCapabilities:packet[5]];
+                      didChange = YES;
+                    }
+                    break;
+                  
+                  case kUVCControlChangeFailure:
+                    didChange = YES;
+                    break;
+                  
+                  case kUVCControlChangeMinimum:
+                    value = [target->control minimum];
+                    break;
+                  
+                  case kUVCControlChangeMaximum:
+                    value = [target->control maximum];
+                    break;
+                  
+                }
+                if ( value && (valueLength == [value byteSize]) ) {
+                  memcpy([value valuePtr], &packet[5], valueLength);
+                  [value byteSwapFromUSBEndian];
+                  didChange = ( packet[4] == kUVCControlChangeValue ) ? UVCControllerWatchedControlDidChange(target) : YES;
+                }
+                if ( didChange && ! callback(context, &event) ) break;
+              }
+            }
+          }
+          else if ( ioRC != kIOReturnTimeout ) {
+            rc = NO;
+            break;
+          }
+        } else if ( waitUntil > now ) {
+          [NSThread sleepForTimeInterval:(waitUntil - now)];
+        }
+      
+        if ( [polledControls count] && ([NSDate timeIntervalSinceReferenceDate] >= nextPollAt) ) {
+          BOOL                      keepWatching = YES;
+        
+          if ( ! [self readControls:polledControls] ) {
+            rc = NO;
+            break;
+          }
+          now = [NSDate timeIntervalSinceReferenceDate];
+          for ( i = 0; keepWatching && (i < watchCount); i++ ) {
+            if ( ! watched[i].isInterruptDriven && UVCControllerWatchedControlDidChange(&watched[i]) ) {
+              event.control = watched[i].control;
+              event.attribute = kUVCControlChangeValue;
+              event.failureCode = 0;
+              event.isFromStatusInterrupt = NO;
+              event.timestamp = now;
+              keepWatching = callback(context, &event);
+            }
+          }
+          if ( ! keepWatching ) break;
+        
+          // Rate-limit:  a slow read pushes the next poll out rather than bunching them up:
+          nextPollAt += pollInterval;
+          if ( nextPollAt < now ) nextPollAt = now + pollInterval;
+        }
+      }
+    }
+    return rc;
+  }
+
 //
 
   - (UVCControl*) controlWithName:(NSString*)controlName
@@ -1330,19 +2613,19 @@ uvc_control_t     UVCControllerControls[] = {
     UVCControl      *theControl = [_controls objectForKey:controlName];
 
     if ( ! theControl ) {
-      if ( ! [self controlIsNotAvailable:controlName] ) {
-        NSUInteger    controlIndex = [self controlIndexForString:controlName];
+      NSUInteger      controlIndex = [self controlIndexForString:controlName];
 
-        if ( controlIndex != UVCInvalidControlIndex ) {
-          theControl = [[UVCControl alloc] initControlWithName:controlName parentController:self controlIndex:controlIndex];
+      if ( controlIndex == UVCInvalidControlIndex ) return nil;
+      if ( ! [self controlIndexIsNotAvailable:controlIndex] ) {
+        theControl = [[UVCControl alloc] initControlWithName:UVCControllerControls[controlIndex].controlNameStr parentController:self controlIndex:controlIndex];
 
-          if ( theControl ) {
-            [_controls setObject:theControl forKey:controlName];
-          } else {
-            [_controls setObject:[NSNull null] forKey:controlName];
-          }
-          [theControl release];
+        if ( theControl ) {
+          [_controls setObject:theControl forKey:controlName];
+        } else {
+          [_controls setObject:[NSNull null] forKey:controlName];
+          _controlsAvailable &= ~(1ULL << controlIndex);
         }
+        [theControl release];
       } else {
         [_controls setObject:[NSNull null] forKey:controlName];
       }
@@ -1366,37 +2649,117 @@ uvc_control_t     UVCControllerControls[] = {
     controlIndex:(NSUInteger)controlIndex
   {
     if ( (self = [super init]) ) {
-      if ( ! [parentController capabilities:&_capabilities forControl:controlIndex] ) {
+      uvc_control_t       *controlInfo = &UVCControllerControls[controlIndex];
+      UVCCapabilityCache  *capabilityCache = [parentController capabilityCache];
+      UVCValueArena       *valueArena = [parentController valueArena];
+      BOOL                isAvailable = NO;
+      
+      //
+      // The values live in the controller's arena; these are (autoreleased) views
+      // onto this control's slots:
+      //
+      _minimum = [valueArena valueForSlot:kUVCValueArenaSlotMinimum atIndex:controlIndex];
+      _maximum = [valueArena valueForSlot:kUVCValueArenaSlotMaximum atIndex:controlIndex];
+      _stepSize = [valueArena valueForSlot:kUVCValueArenaSlotStepSize atIndex:controlIndex];
+      _defaultValue = [valueArena valueForSlot:kUVCValueArenaSlotDefault atIndex:controlIndex];
+      
+      void                *limits[kUVCCapabilityCacheValueCount] = {
+                                [_minimum valuePtr],
+                                [_maximum valuePtr],
+                                [_stepSize valuePtr],
+                                [_defaultValue valuePtr]
+                              };
+      
+      if ( capabilityCache && [capabilityCache lookupControlAtIndex:controlIndex isAvailable:&isAvailable capabilities:&_capabilities byteSize:[controlInfo->uvcType byteSize] values:limits] ) {
+        //
+        // Cache hit, no need to talk to the device.  Retain only those limits which the
+        // device provided when the cache record was created:
+        //
+        if ( isAvailable ) {
+          if ( [self hasRange] ) {
+            [_minimum retain];
+            [_maximum retain];
+          } else {
+            _minimum = _maximum = nil;
+          }
+          _stepSize = [self hasStepSize] ? [_stepSize retain] : nil;
+          _defaultValue = [self hasDefaultValue] ? [_defaultValue retain] : nil;
+        }
+      } else {
+        BOOL              isCacheable;
+        
+        //
+        // Only the device's definitive refusal of a request may be remembered as
+        // the control (or a limit) being absent; a stall, timeout, or busy device
+        // is not cached, so the next run asks again:
+        //
+        if ( (isAvailable = [parentController capabilities:&_capabilities forControl:controlIndex]) ) {
+          isCacheable = [parentController getLowValue:&_minimum highValue:&_maximum stepSize:&_stepSize defaultValue:&_defaultValue updateCapabilitiesBitmask:&_capabilities forControl:controlIndex];
+        } else {
+          isCacheable = UVCControllerFailureIsDefinitive(UVCControllerThreadRequestFailure);
+        }
+        if ( capabilityCache && isCacheable ) {
+          limits[kUVCCapabilityCacheValueMinimum] = _minimum ? [_minimum valuePtr] : NULL;
+          limits[kUVCCapabilityCacheValueMaximum] = _maximum ? [_maximum valuePtr] : NULL;
+          limits[kUVCCapabilityCacheValueStepSize] = _stepSize ? [_stepSize valuePtr] : NULL;
+          limits[kUVCCapabilityCacheValueDefault] = _defaultValue ? [_defaultValue valuePtr] : NULL;
+          
+          // The automatic-mode bit reflects the device's current state, so it is never cached:
+          [capabilityCache storeControlAtIndex:controlIndex
+                                   isAvailable:isAvailable
+                                  capabilities:(_capabilities & ~kUVCControlDisabledDueToAutomaticMode)
+                                      byteSize:[controlInfo->uvcType byteSize]
+                                        values:limits];
+        }
+      }
+      if ( ! isAvailable ) {
+        // The limit values are autoreleased at this point, don't let dealloc release them:
+        _minimum = _maximum = _stepSize = _defaultValue = nil;
         [self release];
         self = nil;
       } else {
         _parentController = [parentController retain];
         _controlName = [controlName copy];
         _controlIndex = controlIndex;
-        
-        uvc_control_t   *controlInfo = &UVCControllerControls[controlIndex];
-        
-        if ( controlInfo->uvcType == nil ) {
-          if ( (controlInfo->uvcType = [UVCType uvcTypeWithCString:controlInfo->uvcTypeDescription]) == nil ) {
-            fprintf(stderr, "FATAL ERROR:  unable to instantiate UVCType for description %s !!!\n", controlInfo->uvcTypeDescription);
-            exit(EFAULT);
-          }
-          controlInfo->uvcType = [controlInfo->uvcType retain];
-        }
-        
-        _currentValue = [[UVCValue uvcValueWithType:controlInfo->uvcType] retain];
-
-        _minimum = [UVCValue uvcValueWithType:controlInfo->uvcType];
-        _maximum = [UVCValue uvcValueWithType:controlInfo->uvcType];
-        _stepSize = [UVCValue uvcValueWithType:controlInfo->uvcType];
-        _defaultValue = [UVCValue uvcValueWithType:controlInfo->uvcType];
-
-        [_parentController getLowValue:&_minimum highValue:&_maximum stepSize:&_stepSize defaultValue:&_defaultValue updateCapabilitiesBitmask:&_capabilities forControl:controlIndex];
+        _currentValue = [[valueArena valueForSlot:kUVCValueArenaSlotCurrent atIndex:controlIndex] retain];
+        [valueArena setSlot:kUVCValueArenaSlotCurrent atIndex:controlIndex isPresent:YES];
+        [valueArena setSlot:kUVCValueArenaSlotMinimum atIndex:controlIndex isPresent:(_minimum != nil)];
+        [valueArena setSlot:kUVCValueArenaSlotMaximum atIndex:controlIndex isPresent:(_maximum != nil)];
+        [valueArena setSlot:kUVCValueArenaSlotStepSize atIndex:controlIndex isPresent:(_stepSize != nil)];
+        [valueArena setSlot:kUVCValueArenaSlotDefault atIndex:controlIndex isPresent:(_defaultValue != nil)];
       }
     }
     return self;
   }
 
+//
+
+  - (void) enqueueReadIntoCurrentValueInQueue:(UVCRequestQueue*)queue
+  {
+    [_parentController enqueueGetValue:_currentValue forControl:_controlIndex inQueue:queue];
+  }
+
+//
+
+  - (void) enqueueWriteFromCurrentValueInQueue:(UVCRequestQueue*)queue
+  {
+    [_parentController enqueueSetValue:_currentValue forControl:_controlIndex inQueue:queue];
+  }
+
+//
+
+  - (void) setDeviceCapabilities:(UInt8)deviceCapabilities
+  {
+    _capabilities = (_capabilities & ~((uvc_capabilities_t)0xFF)) | deviceCapabilities;
+  }
+
+//
+
+  - (NSUInteger) controlIndex
+  {
+    return _controlIndex;
+  }
+
 @end
 
 //
@@ -1452,6 +2815,18 @@ uvc_control_t     UVCControllerControls[] = {
   {
     return ((_capabilities & kUVCControlSupportsSet) != 0);
   }
+  - (BOOL) isDisabledDueToAutomaticMode
+  {
+    return ((_capabilities & kUVCControlDisabledDueToAutomaticMode) != 0);
+  }
+  - (BOOL) isAutoUpdateControl
+  {
+    return ((_capabilities & kUVCControlAutoUpdateControl) != 0);
+  }
+  - (BOOL) isAsynchronousControl
+  {
+    return ((_capabilities & kUVCControlAsynchronousControl) != 0);
+  }
   - (BOOL) hasRange
   {
     return ((_capabilities & kUVCControlHasRange) != 0 );
@@ -1479,6 +2854,7 @@ uvc_control_t     UVCControllerControls[] = {
     if ( [self readIntoCurrentValue] ) return _currentValue;
     return nil;
   }
+  - (UVCValue*) valueBuffer { return _currentValue; }
   - (UVCValue*) minimum { return _minimum; }
   - (UVCValue*) maximum { return _maximum; }
   - (UVCValue*) stepSize { return _stepSize; }
@@ -1500,6 +2876,15 @@ uvc_control_t     UVCControllerControls[] = {
     return [_currentValue scanCString:cString flags:flags minimum:_minimum maximum:_maximum stepSize:_stepSize defaultValue:_defaultValue];
   }
 
+//
+
+  - (UVCTypeScanStatus) setCurrentValueFromCString:(const char*)cString
+    flags:(UVCTypeScanFlags)flags
+    errorOffset:(NSUInteger*)errorOffset
+  {
+    return [_currentValue scanCString:cString flags:flags minimum:_minimum maximum:_maximum stepSize:_stepSize defaultValue:_defaultValue errorOffset:errorOffset];
+  }
+
 //
 
   - (BOOL) readIntoCurrentValue
@@ -0,0 +1,148 @@
+//
+//  UVCControllerGroup.h
+//
+//  Concurrent application of a control change to several UVC devices.
+//
+//  Copyright © 2016
+//  Dr. Jeffrey Frey, IT-NSS
+//  University of Delaware
+//
+// $Id$
+//
+
+#import "UVCProfile.h"
+
+/*!
+  @typedef UVCControllerGroupResult
+
+  Outcome of an operation on one member of a UVCControllerGroup:
+
+    - rc:  zero if successful, otherwise an errno value (ENOENT for an
+      unknown control, EINVAL for an unparseable value, EACCES if the
+      device could not be written)
+    - reason:  static description of the failure, or NULL
+    - profileStats:  for profile and reset operations, the statistics
+      returned by UVCProfile's applyToController:... method
+    - startTime:  when the member's worker began the operation
+    - writeTime:  when the member's write completed (for profile and reset
+      operations, when the last of its writes completed); zero if nothing
+      was written
+
+  Times are NSDate reference-date intervals.
+*/
+typedef struct {
+  int                         rc;
+  const char                  *reason;
+  UVCProfileApplyStatistics   profileStats;
+  NSTimeInterval              startTime;
+  NSTimeInterval              writeTime;
+} UVCControllerGroupResult;
+
+/*!
+  @class UVCControllerGroup
+  @abstract A set of UVCControllers that are changed together.
+
+  Each operation (setting a control, resetting all controls, applying a
+  profile) is performed on every member concurrently, by one worker thread
+  per device.  The workers are all created before any is released to begin
+  its work, so the writes to the devices start as close together as
+  possible; how close together they completed is returned by
+  writeSkewFirstIndex:lastIndex:.
+
+  The result of the most recent operation on each member is available from
+  resultAtIndex:.  A failure on one device does not affect the others.
+
+  While an operation is in progress the members must not be used by any
+  other thread.  Each member is driven by a single worker, so no member is
+  ever used by two threads at once.
+*/
+@interface UVCControllerGroup : NSObject
+{
+  NSArray                     *_controllers;
+  UVCControllerGroupResult    *_results;
+  NSTimeInterval              _startTime, _endTime;
+}
+
+/*!
+  @method controllerGroupWithControllers:
+
+  Returns an autoreleased group of the UVCController instances in the array
+  controllers, or nil if the array is empty.
+*/
++ (UVCControllerGroup*) controllerGroupWithControllers:(NSArray*)controllers;
+
+/*!
+  @method controllers
+
+  Returns the members of the group.
+*/
+- (NSArray*) controllers;
+
+/*!
+  @method count
+
+  Returns the number of members in the group.
+*/
+- (NSUInteger) count;
+
+/*!
+  @method setControlWithName:fromCString:flags:
+
+  On every member, parse cString as the new value of the control named
+  controlName (see setCurrentValueFromCString:flags:errorOffset: in
+  UVCControl) and write it to the device.  Returns YES if every member
+  succeeded.
+*/
+- (BOOL) setControlWithName:(NSString*)controlName fromCString:(const char*)cString flags:(UVCTypeScanFlags)flags;
+
+/*!
+  @method resetAllWithFlags:
+
+  Write the default value of every control to each member (the equivalent
+  of applying UVCProfile's defaultProfileWithController: to each).  Returns
+  YES if every member succeeded.
+*/
+- (BOOL) resetAllWithFlags:(UVCTypeScanFlags)flags;
+
+/*!
+  @method applyProfile:flags:
+
+  Apply profile to every member.  Returns YES if every member succeeded.
+*/
+- (BOOL) applyProfile:(UVCProfile*)profile flags:(UVCTypeScanFlags)flags;
+
+/*!
+  @method resultAtIndex:
+
+  Returns the outcome of the most recent operation on the member at index,
+  or NULL if index is out of range.
+*/
+- (const UVCControllerGroupResult*) resultAtIndex:(NSUInteger)index;
+
+/*!
+  @method failedCount
+
+  Returns the number of members on which the most recent operation failed.
+*/
+- (NSUInteger) failedCount;
+
+/*!
+  @method elapsedTime
+
+  Returns the wall-clock duration of the most recent operation, from the
+  release of the workers until the last of them finished.
+*/
+- (NSTimeInterval) elapsedTime;
+
+/*!
+  @method writeSkewFirstIndex:lastIndex:
+
+  Returns the time between the first and last member's write completing in
+  the most recent operation (zero if fewer than two members were written).
+  If firstIndex or lastIndex are not NULL, they are set to the index of the
+  member whose write completed first and last, respectively (NSNotFound if
+  none were written).
+*/
+- (NSTimeInterval) writeSkewFirstIndex:(NSUInteger*)firstIndex lastIndex:(NSUInteger*)lastIndex;
+
+@end
@@ -0,0 +1,355 @@
+//
+//  UVCControllerGroup.m
+//
+//  Concurrent application of a control change to several UVC devices.
+//
+//  Copyright © 2016
+//  Dr. Jeffrey Frey, IT-NSS
+//  University of Delaware
+//
+// $Id$
+//
+
+#import "UVCControllerGroup.h"
+
+#include <errno.h>
+#include <pthread.h>
+
+/*!
+  @enum UVCControllerGroupOperation
+
+  Operations a UVCControllerGroup performs on each member.
+*/
+typedef enum {
+  kUVCControllerGroupOperationSet,
+  kUVCControllerGroupOperationReset,
+  kUVCControllerGroupOperationApplyProfile
+} UVCControllerGroupOperation;
+
+/*!
+  @typedef UVCControllerGroupOperationState
+
+  What the workers are to do, plus the gate that holds them until all have
+  been created.  Shared (read-only, once the gate opens) by every worker.
+*/
+typedef struct {
+  pthread_mutex_t               lock;
+  pthread_cond_t                gate;
+  BOOL                          isGateOpen;
+  UVCControllerGroupOperation   operation;
+  NSString                      *controlName;
+  const char                    *cString;
+  UVCProfile                    *profile;
+  UVCTypeScanFlags              flags;
+} UVCControllerGroupOperationState;
+
+/*!
+  @typedef UVCControllerGroupWorker
+
+  Per-thread context:  the member to operate on and where its result goes.
+*/
+typedef struct {
+  UVCControllerGroupOperationState  *state;
+  UVCController                     *controller;
+  UVCControllerGroupResult          *result;
+} UVCControllerGroupWorker;
+
+//
+
+static void
+UVCControllerGroupPerformOperation(
+  UVCControllerGroupOperationState  *state,
+  UVCController                     *controller,
+  UVCControllerGroupResult          *result
+)
+{
+  UVCProfile            *profile = state->profile;
+
+  result->startTime = [NSDate timeIntervalSinceReferenceDate];
+  switch ( state->operation ) {
+
+    case kUVCControllerGroupOperationSet: {
+      UVCControl        *control = [controller controlWithName:state->controlName];
+      UVCTypeScanStatus scanStatus;
+
+      if ( ! control ) {
+        result->rc = ENOENT;
+        result->reason = "invalid control name";
+        return;
+      }
+      if ( (scanStatus = [control setCurrentValueFromCString:state->cString flags:state->flags errorOffset:NULL]) != kUVCTypeScanOk ) {
+        result->rc = EINVAL;
+        result->reason = UVCTypeScanStatusString(scanStatus);
+        return;
+      }
+      if ( ! [control writeFromCurrentValue] ) {
+        result->rc = EACCES;
+        result->reason = "unable to write new value";
+        return;
+      }
+      result->writeTime = [NSDate timeIntervalSinceReferenceDate];
+      return;
+    }
+
+    case kUVCControllerGroupOperationReset:
+      profile = [UVCProfile defaultProfileWithController:controller];
+      if ( ! [[profile controlNames] count] ) return;
+      break;
+
+    case kUVCControllerGroupOperationApplyProfile:
+      break;
+
+  }
+  if ( ! [profile applyToController:controller flags:state->flags statistics:&result->profileStats] ) {
+    result->rc = EACCES;
+    result->reason = ( (state->operation == kUVCControllerGroupOperationReset) ? "unable to write default value(s)" : "unable to apply profile" );
+  }
+  if ( result->profileStats.writeCount ) result->writeTime = [NSDate timeIntervalSinceReferenceDate];
+}
+
+//
+
+static void*
+UVCControllerGroupWorkerMain(
+  void      *context
+)
+{
+  UVCControllerGroupWorker          *worker = (UVCControllerGroupWorker*)context;
+  UVCControllerGroupOperationState  *state = worker->state;
+
+  pthread_mutex_lock(&state->lock);
+  while ( ! state->isGateOpen ) pthread_cond_wait(&state->gate, &state->lock);
+  pthread_mutex_unlock(&state->lock);
+
+  @autoreleasepool {
+    UVCControllerGroupPerformOperation(state, worker->controller, worker->result);
+  }
+  return NULL;
+}
+
+//
+#if 0
+#pragma mark -
+#endif
+//
+
+@interface UVCControllerGroup(UVCControllerGroupPrivate)
+
+- (id) initWithControllers:(NSArray*)controllers;
+
+/*!
+  @method performOperation:
+
+  Start one worker per member, release them together, and wait for all of
+  them to finish.  Returns YES if the operation succeeded on every member.
+*/
+- (BOOL) performOperation:(UVCControllerGroupOperationState*)state;
+
+/*!
+  @method becomeMultiThreaded:
+
+  No-op target of the NSThread that puts Cocoa into multithreaded mode
+  before the first POSIX worker thread is created.
+*/
++ (void) becomeMultiThreaded:(id)unused;
+
+@end
+
+@implementation UVCControllerGroup(UVCControllerGroupPrivate)
+
+  - (id) initWithControllers:(NSArray*)controllers
+  {
+    if ( (self = [super init]) ) {
+      _controllers = [controllers copy];
+      _results = calloc([_controllers count], sizeof(UVCControllerGroupResult));
+      if ( ! _results ) {
+        [self release];
+        self = nil;
+      }
+    }
+    return self;
+  }
+
+//
+
+  - (BOOL) performOperation:(UVCControllerGroupOperationState*)state
+  {
+    NSUInteger                  count = [_controllers count], i;
+    pthread_t                   threads[count];
+    BOOL                        isStarted[count];
+    UVCControllerGroupWorker    workers[count];
+
+    if ( ! [NSThread isMultiThreaded] ) [NSThread detachNewThreadSelector:@selector(becomeMultiThreaded:) toTarget:[UVCControllerGroup class] withObject:nil];
+
+    memset(_results, 0, count * sizeof(UVCControllerGroupResult));
+    pthread_mutex_init(&state->lock, NULL);
+    pthread_cond_init(&state->gate, NULL);
+    state->isGateOpen = NO;
+
+    for ( i = 0; i < count; i++ ) {
+      workers[i].state = state;
+      workers[i].controller = [_controllers objectAtIndex:i];
+      workers[i].result = &_results[i];
+      isStarted[i] = ( pthread_create(&threads[i], NULL, UVCControllerGroupWorkerMain, &workers[i]) == 0 );
+      if ( ! isStarted[i] ) {
+        _results[i].rc = EAGAIN;
+        _results[i].reason = "unable to start worker thread";
+      }
+    }
+
+    // Release every worker at once:
+    pthread_mutex_lock(&state->lock);
+    _startTime = [NSDate timeIntervalSinceReferenceDate];
+    state->isGateOpen = YES;
+    pthread_cond_broadcast(&state->gate);
+    pthread_mutex_unlock(&state->lock);
+
+    for ( i = 0; i < count; i++ ) {
+      if ( isStarted[i] ) pthread_join(threads[i], NULL);
+    }
+    _endTime = [NSDate timeIntervalSinceReferenceDate];
+
+    pthread_cond_destroy(&state->gate);
+    pthread_mutex_destroy(&state->lock);
+    return ( [self failedCount] == 0 );
+  }
+
+//
+
+  + (void) becomeMultiThreaded:(id)unused
+  {
+  }
+
+@end
+
+//
+#if 0
+#pragma mark -
+#endif
+//
+
+@implementation UVCControllerGroup
+
+  + (UVCControllerGroup*) controllerGroupWithControllers:(NSArray*)controllers
+  {
+    if ( ! controllers || ! [controllers count] ) return nil;
+    return [[[UVCControllerGroup alloc] initWithControllers:controllers] autorelease];
+  }
+
+//
+
+  - (void) dealloc
+  {
+    if ( _results ) free(_results);
+    if ( _controllers ) [_controllers release];
+    [super dealloc];
+  }
+
+//
+
+  - (NSString*) description
+  {
+    return [NSString stringWithFormat:@"UVCControllerGroup@%p { count: %lu }", self, (unsigned long)[_controllers count]];
+  }
+
+//
+
+  - (NSArray*) controllers
+  {
+    return _controllers;
+  }
+
+//
+
+  - (NSUInteger) count
+  {
+    return [_controllers count];
+  }
+
+//
+
+  - (BOOL) setControlWithName:(NSString*)controlName
+    fromCString:(const char*)cString
+    flags:(UVCTypeScanFlags)flags
+  {
+    UVCControllerGroupOperationState  state = {
+                                          .operation = kUVCControllerGroupOperationSet,
+                                          .controlName = controlName,
+                                          .cString = cString,
+                                          .flags = flags
+                                        };
+
+    return [self performOperation:&state];
+  }
+
+//
+
+  - (BOOL) resetAllWithFlags:(UVCTypeScanFlags)flags
+  {
+    UVCControllerGroupOperationState  state = {
+                                          .operation = kUVCControllerGroupOperationReset,
+                                          .flags = flags
+                                        };
+
+    return [self performOperation:&state];
+  }
+
+//
+
+  - (BOOL) applyProfile:(UVCProfile*)profile
+    flags:(UVCTypeScanFlags)flags
+  {
+    UVCControllerGroupOperationState  state = {
+                                          .operation = kUVCControllerGroupOperationApplyProfile,
+                                          .profile = profile,
+                                          .flags = flags
+                                        };
+
+    return [self performOperation:&state];
+  }
+
+//
+
+  - (const UVCControllerGroupResult*) resultAtIndex:(NSUInteger)index
+  {
+    if ( index >= [_controllers count] ) return NULL;
+    return &_results[index];
+  }
+
+//
+
+  - (NSUInteger) failedCount
+  {
+    NSUInteger      count = [_controllers count], i, failedCount = 0;
+
+    for ( i = 0; i < count; i++ ) if ( _results[i].rc ) failedCount++;
+    return failedCount;
+  }
+
+//
+
+  - (NSTimeInterval) elapsedTime
+  {
+    return _endTime - _startTime;
+  }
+
+//
+
+  - (NSTimeInterval) writeSkewFirstIndex:(NSUInteger*)firstIndex
+    lastIndex:(NSUInteger*)lastIndex
+  {
+    NSUInteger      count = [_controllers count], i;
+    NSUInteger      first = NSNotFound, last = NSNotFound;
+
+    for ( i = 0; i < count; i++ ) {
+      if ( _results[i].writeTime <= 0.0 ) continue;
+      if ( (first == NSNotFound) || (_results[i].writeTime < _results[first].writeTime) ) first = i;
+      if ( (last == NSNotFound) || (_results[i].writeTime > _results[last].writeTime) ) last = i;
+    }
+    if ( firstIndex ) *firstIndex = first;
+    if ( lastIndex ) *lastIndex = last;
+    if ( first == NSNotFound ) return 0.0;
+    return _results[last].writeTime - _results[first].writeTime;
+  }
+
+@end
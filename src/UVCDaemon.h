@@ -0,0 +1,140 @@
+//
+//  UVCDaemon.h
+//
+//  Long-running server for uvc-util commands over a local UNIX socket, and
+//  the client side of the same.
+//
+//  Copyright © 2016
+//  Dr. Jeffrey Frey, IT-NSS
+//  University of Delaware
+//
+// $Id$
+//
+
+#import "UVCCommandSession.h"
+
+/*!
+  @defined UVCDaemonMaxRequestLength
+
+  Longest request line (including the newline) a UVCDaemon will accept.
+*/
+#define UVCDaemonMaxRequestLength   4096
+
+/*!
+  @class UVCDaemon
+  @abstract Serves uvc-util commands over a UNIX-domain stream socket.
+
+  The daemon enumerates the UVC devices and opens their interfaces once, then
+  executes commands on behalf of any number of clients (one at a time).  The
+  controllers, their controls, and the controls' capabilities and limits
+  persist across requests, so a request costs little more than its control
+  transfers.
+
+  The protocol is line-oriented.  A request is a single line:
+
+    <command> [<argument>]\n
+
+  where command is a uvc-util long option name or its single-character
+  equivalent (see UVCCommandWithName()), e.g. "L 0x14200000" or
+  "get brightness".  Each request produces a response of the form:
+
+    <rc> <output-length> <error-length>\n
+    <output-length bytes written to stdout>
+    <error-length bytes written to stderr>
+
+  where rc is zero or an errno value.  A connection may carry any number of
+  requests; each connection starts with the target device that was selected
+  when the daemon was started, and selections made over the connection last
+  until it is closed.
+*/
+@interface UVCDaemon : NSObject
+{
+  UVCCommandSession   *_session;
+  NSString            *_socketPath;
+  int                 _listenSocket;
+  NSUInteger          _connectionCount;
+  NSUInteger          _requestCount;
+}
+
+/*!
+  @method daemonWithSocketPath:session:
+
+  Returns an autoreleased daemon that will listen at socketPath and serve
+  requests using the devices (and initial target device) of session.
+*/
++ (UVCDaemon*) daemonWithSocketPath:(NSString*)socketPath session:(UVCCommandSession*)session;
+
+/*!
+  @method socketPath
+
+  Returns the path of the daemon's socket.
+*/
+- (NSString*) socketPath;
+
+/*!
+  @method listen
+
+  Create the socket (replacing a stale socket left by a daemon that has
+  exited) and enumerate and open the devices.  Returns zero if successful,
+  otherwise an errno value (EADDRINUSE if another daemon is already serving
+  the path).
+*/
+- (int) listen;
+
+/*!
+  @method serve
+
+  Accept connections and execute their requests until the process receives
+  SIGINT, SIGTERM, or SIGHUP, then remove the socket.  The receiver must have
+  been sent listen.  Returns zero if the daemon stopped due to a signal,
+  otherwise an errno value.
+*/
+- (int) serve;
+
+/*!
+  @method connectionCount
+
+  Returns the number of connections accepted so far.
+*/
+- (NSUInteger) connectionCount;
+
+/*!
+  @method requestCount
+
+  Returns the number of requests executed so far.
+*/
+- (NSUInteger) requestCount;
+
+@end
+
+/*!
+  @class UVCDaemonClient
+  @abstract Forwards uvc-util commands to a UVCDaemon.
+
+  The response to each command is relayed to the client's own stdout and
+  stderr, so a client behaves like the command-line program it stands in for.
+*/
+@interface UVCDaemonClient : NSObject
+{
+  int                 _socket;
+  FILE                *_responseStream;
+}
+
+/*!
+  @method daemonClientWithSocketPath:error:
+
+  Returns an autoreleased client connected to the daemon listening at
+  socketPath, or nil (with an errno value in *error if error is not NULL).
+*/
++ (UVCDaemonClient*) daemonClientWithSocketPath:(NSString*)socketPath error:(int*)error;
+
+/*!
+  @method performCommand:argument:
+
+  Send command and argument to the daemon and relay its response.  Returns
+  the rc the daemon reported, or an errno value if the request could not be
+  delivered or the response could not be read.
+*/
+- (int) performCommand:(UVCCommand)command argument:(const char*)argument;
+
+@end
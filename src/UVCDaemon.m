@@ -0,0 +1,468 @@
+//
+//  UVCDaemon.m
+//
+//  Long-running server for uvc-util commands over a local UNIX socket, and
+//  the client side of the same.
+//
+//  Copyright © 2016
+//  Dr. Jeffrey Frey, IT-NSS
+//  University of Delaware
+//
+// $Id$
+//
+
+#import "UVCDaemon.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+static volatile sig_atomic_t UVCDaemonShouldStop = 0;
+
+static void
+UVCDaemonSignalHandler(
+  int     signum
+)
+{
+  UVCDaemonShouldStop = 1;
+}
+
+//
+
+static BOOL
+UVCDaemonSocketAddress(
+  NSString            *socketPath,
+  struct sockaddr_un  *address
+)
+{
+  const char          *path = [socketPath fileSystemRepresentation];
+
+  if ( ! path || (strlen(path) >= sizeof(address->sun_path)) ) return NO;
+  memset(address, 0, sizeof(*address));
+  address->sun_family = AF_UNIX;
+  strncpy(address->sun_path, path, sizeof(address->sun_path) - 1);
+  return YES;
+}
+
+//
+
+static int
+UVCDaemonWriteAll(
+  int           fd,
+  const void    *bytes,
+  size_t        length
+)
+{
+  const char    *p = (const char*)bytes;
+
+  while ( length ) {
+    ssize_t     n = write(fd, p, length);
+
+    if ( n < 0 ) {
+      if ( errno == EINTR && ! UVCDaemonShouldStop ) continue;
+      return errno;
+    }
+    p += n;
+    length -= n;
+  }
+  return 0;
+}
+
+//
+
+static int
+UVCDaemonDataStreamWrite(
+  void          *cookie,
+  const char    *bytes,
+  int           length
+)
+{
+  [(NSMutableData*)cookie appendBytes:bytes length:length];
+  return length;
+}
+
+//
+#if 0
+#pragma mark -
+#endif
+//
+
+@interface UVCDaemon(UVCDaemonPrivate)
+
+- (id) initWithSocketPath:(NSString*)socketPath session:(UVCCommandSession*)session;
+
+/*!
+  @method serveConnection:
+
+  Execute requests read from the connected socket until the client closes
+  it or the daemon is signaled to stop.
+*/
+- (void) serveConnection:(int)connection;
+
+@end
+
+@implementation UVCDaemon(UVCDaemonPrivate)
+
+  - (id) initWithSocketPath:(NSString*)socketPath
+    session:(UVCCommandSession*)session
+  {
+    if ( (self = [super init]) ) {
+      _socketPath = [socketPath copy];
+      _session = [session retain];
+      _listenSocket = -1;
+    }
+    return self;
+  }
+
+//
+
+  - (void) serveConnection:(int)connection
+  {
+    UVCCommandSession *session = [[UVCCommandSession commandSessionWithSession:_session] retain];
+    NSMutableData     *outData = [[NSMutableData alloc] init];
+    NSMutableData     *errData = [[NSMutableData alloc] init];
+    FILE              *outStream = funopen(outData, NULL, UVCDaemonDataStreamWrite, NULL, NULL);
+    FILE              *errStream = funopen(errData, NULL, UVCDaemonDataStreamWrite, NULL, NULL);
+    FILE              *requestStream = fdopen(dup(connection), "r");
+    char              *request = NULL;
+    size_t            requestCapacity = 0;
+    ssize_t           requestLen;
+
+    if ( outStream && errStream && requestStream ) {
+      [session setOutStream:outStream errStream:errStream];
+      while ( ! UVCDaemonShouldStop && ((requestLen = getline(&request, &requestCapacity, requestStream)) > 0) ) {
+        @autoreleasepool {
+          char        header[64];
+          int         rc;
+
+          if ( requestLen < UVCDaemonMaxRequestLength ) {
+            rc = [session performCommandLine:request];
+          } else {
+            fprintf(errStream, "ERROR:  request exceeds %d bytes\n", UVCDaemonMaxRequestLength);
+            rc = EINVAL;
+          }
+          _requestCount++;
+          fflush(outStream);
+          fflush(errStream);
+          snprintf(header, sizeof(header), "%d %lu %lu\n", rc, (unsigned long)[outData length], (unsigned long)[errData length]);
+          if ( UVCDaemonWriteAll(connection, header, strlen(header)) ||
+               UVCDaemonWriteAll(connection, [outData bytes], [outData length]) ||
+               UVCDaemonWriteAll(connection, [errData bytes], [errData length])
+          ) break;
+          [outData setLength:0];
+          [errData setLength:0];
+        }
+      }
+    }
+    if ( request ) free(request);
+    if ( requestStream ) fclose(requestStream);
+    if ( errStream ) fclose(errStream);
+    if ( outStream ) fclose(outStream);
+    [errData release];
+    [outData release];
+    [session release];
+  }
+
+@end
+
+//
+#if 0
+#pragma mark -
+#endif
+//
+
+@implementation UVCDaemon
+
+  + (UVCDaemon*) daemonWithSocketPath:(NSString*)socketPath
+    session:(UVCCommandSession*)session
+  {
+    return [[[UVCDaemon alloc] initWithSocketPath:socketPath session:session] autorelease];
+  }
+
+//
+
+  - (void) dealloc
+  {
+    if ( _listenSocket >= 0 ) {
+      close(_listenSocket);
+      unlink([_socketPath fileSystemRepresentation]);
+    }
+    [_socketPath release];
+    [_session release];
+    [super dealloc];
+  }
+
+//
+
+  - (NSString*) socketPath
+  {
+    return _socketPath;
+  }
+
+//
+
+  - (int) listen
+  {
+    struct sockaddr_un    address;
+    int                   s;
+
+    if ( _listenSocket >= 0 ) return 0;
+    if ( ! UVCDaemonSocketAddress(_socketPath, &address) ) return ENAMETOOLONG;
+
+    if ( (s = socket(AF_UNIX, SOCK_STREAM, 0)) < 0 ) return errno;
+    if ( bind(s, (struct sockaddr*)&address, sizeof(address)) != 0 ) {
+      int                 rc = errno;
+
+      if ( rc == EADDRINUSE ) {
+        //
+        // If something answers at the path it's a running daemon; otherwise
+        // the socket was left behind and can be replaced:
+        //
+        int               probe = socket(AF_UNIX, SOCK_STREAM, 0);
+
+        if ( probe >= 0 ) {
+          BOOL            isLive = ( connect(probe, (struct sockaddr*)&address, sizeof(address)) == 0 );
+
+          close(probe);
+          if ( ! isLive ) {
+            struct stat   info;
+
+            if ( (lstat(address.sun_path, &info) == 0) && S_ISSOCK(info.st_mode) && (unlink(address.sun_path) == 0) ) {
+              rc = ( bind(s, (struct sockaddr*)&address, sizeof(address)) == 0 ) ? 0 : errno;
+            }
+          }
+        }
+      }
+      if ( rc ) {
+        close(s);
+        return rc;
+      }
+    }
+    // Only the owner may issue commands:
+    chmod(address.sun_path, S_IRUSR | S_IWUSR);
+    if ( listen(s, 16) != 0 ) {
+      int                 rc = errno;
+
+      close(s);
+      unlink(address.sun_path);
+      return rc;
+    }
+    _listenSocket = s;
+
+    //
+    // Enumerate now and hold the interfaces open so that no request pays for
+    // either:
+    //
+    NSEnumerator          *eDevices = [[_session devices] objectEnumerator];
+    UVCController         *device;
+
+    while ( (device = [eDevices nextObject]) ) [device setIsInterfaceOpen:YES];
+    if ( [_session targetDevice] ) [[_session targetDevice] setIsInterfaceOpen:YES];
+    return 0;
+  }
+
+//
+
+  - (int) serve
+  {
+    struct sigaction      action, oldInt, oldTerm, oldHup, oldPipe;
+    int                   rc = 0;
+
+    if ( _listenSocket < 0 ) return ENOTCONN;
+
+    // No SA_RESTART, so that a signal interrupts accept() and reads:
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = UVCDaemonSignalHandler;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, &oldInt);
+    sigaction(SIGTERM, &action, &oldTerm);
+    sigaction(SIGHUP, &action, &oldHup);
+    // A client that goes away mid-response is not fatal:
+    action.sa_handler = SIG_IGN;
+    sigaction(SIGPIPE, &action, &oldPipe);
+
+    UVCDaemonShouldStop = 0;
+    while ( ! UVCDaemonShouldStop ) {
+      int                 connection = accept(_listenSocket, NULL, NULL);
+
+      if ( connection < 0 ) {
+        if ( (errno == EINTR) || (errno == ECONNABORTED) ) continue;
+        rc = errno;
+        break;
+      }
+      _connectionCount++;
+      [self serveConnection:connection];
+      close(connection);
+    }
+
+    sigaction(SIGPIPE, &oldPipe, NULL);
+    sigaction(SIGHUP, &oldHup, NULL);
+    sigaction(SIGTERM, &oldTerm, NULL);
+    sigaction(SIGINT, &oldInt, NULL);
+
+    close(_listenSocket);
+    _listenSocket = -1;
+    unlink([_socketPath fileSystemRepresentation]);
+    return rc;
+  }
+
+//
+
+  - (NSUInteger) connectionCount
+  {
+    return _connectionCount;
+  }
+
+//
+
+  - (NSUInteger) requestCount
+  {
+    return _requestCount;
+  }
+
+@end
+
+//
+#if 0
+#pragma mark -
+#endif
+//
+
+@interface UVCDaemonClient(UVCDaemonClientPrivate)
+
+- (id) initWithSocket:(int)s;
+
+/*!
+  @method relayBytes:toStream:
+
+  Copy length bytes of the response to stream.  Returns zero if successful,
+  otherwise an errno value.
+*/
+- (int) relayBytes:(unsigned long)length toStream:(FILE*)stream;
+
+@end
+
+@implementation UVCDaemonClient(UVCDaemonClientPrivate)
+
+  - (id) initWithSocket:(int)s
+  {
+    if ( (self = [super init]) ) {
+      _socket = s;
+      if ( ! (_responseStream = fdopen(dup(s), "r")) ) {
+        // The caller still owns s:
+        _socket = -1;
+        [self release];
+        self = nil;
+      }
+    }
+    return self;
+  }
+
+//
+
+  - (int) relayBytes:(unsigned long)length
+    toStream:(FILE*)stream
+  {
+    char              buffer[4096];
+
+    while ( length ) {
+      size_t          n = fread(buffer, 1, ((length < sizeof(buffer)) ? length : sizeof(buffer)), _responseStream);
+
+      if ( n == 0 ) return EPIPE;
+      fwrite(buffer, 1, n, stream);
+      length -= n;
+    }
+    return 0;
+  }
+
+@end
+
+//
+#if 0
+#pragma mark -
+#endif
+//
+
+@implementation UVCDaemonClient
+
+  + (UVCDaemonClient*) daemonClientWithSocketPath:(NSString*)socketPath
+    error:(int*)error
+  {
+    struct sockaddr_un    address;
+    int                   s;
+
+    if ( ! UVCDaemonSocketAddress(socketPath, &address) ) {
+      if ( error ) *error = ENAMETOOLONG;
+      return nil;
+    }
+    if ( (s = socket(AF_UNIX, SOCK_STREAM, 0)) >= 0 ) {
+      if ( connect(s, (struct sockaddr*)&address, sizeof(address)) == 0 ) {
+        int               noSigPipe = 1;
+        UVCDaemonClient   *newClient;
+
+        // A daemon that goes away should produce an error, not kill us:
+        setsockopt(s, SOL_SOCKET, SO_NOSIGPIPE, &noSigPipe, sizeof(noSigPipe));
+        newClient = [[UVCDaemonClient alloc] initWithSocket:s];
+
+        if ( newClient ) return [newClient autorelease];
+      }
+      if ( error ) *error = errno;
+      close(s);
+    } else if ( error ) {
+      *error = errno;
+    }
+    return nil;
+  }
+
+//
+
+  - (void) dealloc
+  {
+    if ( _responseStream ) fclose(_responseStream);
+    if ( _socket >= 0 ) close(_socket);
+    [super dealloc];
+  }
+
+//
+
+  - (int) performCommand:(UVCCommand)command
+    argument:(const char*)argument
+  {
+    const char        *name = UVCCommandName(command);
+    size_t            nameLen, argumentLen = ( argument ? strlen(argument) : 0 );
+    char              *response = NULL;
+    size_t            responseCapacity = 0;
+    unsigned long     outLen, errLen;
+    int               rc;
+
+    if ( ! name ) return EINVAL;
+    nameLen = strlen(name);
+    if ( (argument && strchr(argument, '\n')) || (nameLen + argumentLen + 2 >= UVCDaemonMaxRequestLength) ) {
+      fprintf(stderr, "ERROR:  argument to %s cannot be sent to the daemon\n", name);
+      return EINVAL;
+    }
+
+    char              request[nameLen + argumentLen + 3];
+
+    snprintf(request, sizeof(request), "%s%s%s\n", name, (argumentLen ? " " : ""), (argumentLen ? argument : ""));
+    if ( (rc = UVCDaemonWriteAll(_socket, request, strlen(request))) ) return rc;
+
+    if ( getline(&response, &responseCapacity, _responseStream) <= 0 ) {
+      if ( response ) free(response);
+      return EPIPE;
+    }
+    if ( sscanf(response, "%d %lu %lu", &rc, &outLen, &errLen) != 3 ) rc = EPROTO;
+    free(response);
+    if ( rc != EPROTO ) {
+      int             relayRc;
+
+      fflush(stdout);
+      if ( (relayRc = [self relayBytes:outLen toStream:stdout]) || (relayRc = [self relayBytes:errLen toStream:stderr]) ) rc = relayRc;
+    }
+    return rc;
+  }
+
+@end
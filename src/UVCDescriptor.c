@@ -0,0 +1,308 @@
+//
+//  UVCDescriptor.c
+//
+//  Parser for the class-specific VideoControl interface descriptor block.
+//
+//  Copyright © 2016
+//  Dr. Jeffrey Frey, IT-NSS
+//  University of Delaware
+//
+// $Id$
+//
+
+#include "UVCDescriptor.h"
+
+#include <string.h>
+
+#define CS_INTERFACE      0x24
+
+//
+// All multi-byte descriptor fields are little-endian and unaligned:
+//
+static inline uint16_t
+UVCDescriptorReadU16(
+  const uint8_t   *p
+)
+{
+  return (uint16_t)p[0] | ((uint16_t)p[1] << 8);
+}
+
+static inline uint32_t
+UVCDescriptorReadU32(
+  const uint8_t   *p
+)
+{
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+//
+
+static UVCDescriptorParseStatus
+UVCDescriptorParseUnit(
+  UVCDescriptorUnit   *unit,
+  const uint8_t       *d,
+  size_t              offset
+)
+{
+  uint8_t             bLength = d[0];
+  size_t              p;
+
+  memset(unit, 0, sizeof(UVCDescriptorUnit));
+  unit->subtype = d[2];
+  unit->descriptorOffset = (uint16_t)offset;
+  unit->descriptorLength = bLength;
+
+  switch ( unit->subtype ) {
+
+    case kUVCDescriptorSubtypeInputTerminal: {
+      // bTerminalID, wTerminalType, bAssocTerminal, iTerminal
+      if ( bLength < 8 ) return kUVCDescriptorParseBadLength;
+      unit->unitId = d[3];
+      unit->terminalType = UVCDescriptorReadU16(d + 4);
+      //
+      // Only the camera and media transport terminals carry a bmControls
+      // field, and they place it at different offsets:
+      //
+      switch ( unit->terminalType ) {
+        case kUVCTerminalTypeCamera:
+          p = 14;
+          break;
+        case kUVCTerminalTypeMediaTransportInput:
+          p = 8;
+          break;
+        default:
+          p = 0;
+          break;
+      }
+      if ( p ) {
+        if ( bLength < p + 1 ) return kUVCDescriptorParseBadLength;
+        unit->controlSize = d[p];
+        unit->controlsOffset = (uint16_t)(offset + p + 1);
+        if ( bLength < p + 1 + unit->controlSize ) return kUVCDescriptorParseBadLength;
+      }
+      break;
+    }
+
+    case kUVCDescriptorSubtypeOutputTerminal: {
+      // bTerminalID, wTerminalType, bAssocTerminal, bSourceID, iTerminal
+      if ( bLength < 9 ) return kUVCDescriptorParseBadLength;
+      unit->unitId = d[3];
+      unit->terminalType = UVCDescriptorReadU16(d + 4);
+      unit->sourceCount = 1;
+      unit->sourceOffset = (uint16_t)(offset + 7);
+      break;
+    }
+
+    case kUVCDescriptorSubtypeSelectorUnit: {
+      // bUnitID, bNrInPins, baSourceID[p], iSelector
+      if ( bLength < 6 ) return kUVCDescriptorParseBadLength;
+      unit->unitId = d[3];
+      unit->sourceCount = d[4];
+      unit->sourceOffset = (uint16_t)(offset + 5);
+      if ( bLength < 6 + unit->sourceCount ) return kUVCDescriptorParseBadLength;
+      break;
+    }
+
+    case kUVCDescriptorSubtypeProcessingUnit: {
+      // bUnitID, bSourceID, wMaxMultiplier, bControlSize, bmControls[n], iProcessing
+      if ( bLength < 8 ) return kUVCDescriptorParseBadLength;
+      unit->unitId = d[3];
+      unit->sourceCount = 1;
+      unit->sourceOffset = (uint16_t)(offset + 4);
+      unit->controlSize = d[7];
+      unit->controlsOffset = (uint16_t)(offset + 8);
+      if ( bLength < 8 + unit->controlSize ) return kUVCDescriptorParseBadLength;
+      break;
+    }
+
+    case kUVCDescriptorSubtypeExtensionUnit: {
+      // bUnitID, guidExtensionCode[16], bNumControls, bNrInPins, baSourceID[p],
+      // bControlSize, bmControls[n], iExtension
+      if ( bLength < 24 ) return kUVCDescriptorParseBadLength;
+      unit->unitId = d[3];
+      unit->sourceCount = d[21];
+      unit->sourceOffset = (uint16_t)(offset + 22);
+      p = 22 + unit->sourceCount;
+      if ( bLength < p + 1 ) return kUVCDescriptorParseBadLength;
+      unit->controlSize = d[p];
+      unit->controlsOffset = (uint16_t)(offset + p + 1);
+      if ( bLength < p + 1 + unit->controlSize ) return kUVCDescriptorParseBadLength;
+      break;
+    }
+
+    case kUVCDescriptorSubtypeEncodingUnit: {
+      // bUnitID, bSourceID, iEncoding, bControlSize, bmControls[n], bmControlsRuntime[n]
+      if ( bLength < 7 ) return kUVCDescriptorParseBadLength;
+      unit->unitId = d[3];
+      unit->sourceCount = 1;
+      unit->sourceOffset = (uint16_t)(offset + 4);
+      unit->controlSize = d[6];
+      unit->controlsOffset = (uint16_t)(offset + 7);
+      if ( bLength < 7 + unit->controlSize ) return kUVCDescriptorParseBadLength;
+      break;
+    }
+
+  }
+  return kUVCDescriptorParseOk;
+}
+
+//
+
+UVCDescriptorParseStatus
+UVCDescriptorGraphParse(
+  UVCDescriptorGraph  *graph,
+  const void          *bytes,
+  size_t              length
+)
+{
+  const uint8_t       *base = (const uint8_t*)bytes;
+  size_t              offset, end;
+
+  memset(graph, 0, sizeof(UVCDescriptorGraph));
+  graph->bytes = base;
+  graph->length = length;
+
+  //
+  // The VC interface header:  bLength, bDescriptorType, bDescriptorSubtype,
+  // bcdUVC, wTotalLength, dwClockFrequency, bInCollection, baInterfaceNr[n]
+  //
+  if ( length < 12 ) return kUVCDescriptorParseTruncated;
+  if ( (base[1] != CS_INTERFACE) || (base[2] != kUVCDescriptorSubtypeHeader) ) return kUVCDescriptorParseNotVideoControl;
+  if ( base[0] < 12 ) return kUVCDescriptorParseBadLength;
+  graph->uvcVersion = UVCDescriptorReadU16(base + 3);
+  graph->totalLength = UVCDescriptorReadU16(base + 5);
+  graph->clockFrequency = UVCDescriptorReadU32(base + 7);
+  graph->interfaceCount = base[11];
+  graph->interfaceOffset = 12;
+  if ( base[0] < 12 + graph->interfaceCount ) return kUVCDescriptorParseBadLength;
+  if ( (graph->totalLength > length) || (base[0] > graph->totalLength) ) return kUVCDescriptorParseTruncated;
+
+  end = graph->totalLength;
+  offset = base[0];
+  while ( offset < end ) {
+    const uint8_t     *d = base + offset;
+    uint8_t           bLength;
+
+    // Need at least the three-byte prefix:
+    if ( end - offset < 3 ) return kUVCDescriptorParseTruncated;
+    bLength = d[0];
+    if ( bLength < 3 ) return kUVCDescriptorParseBadLength;
+    if ( bLength > end - offset ) return kUVCDescriptorParseTruncated;
+
+    if ( (d[1] == CS_INTERFACE) && (d[2] >= kUVCDescriptorSubtypeInputTerminal) && (d[2] <= kUVCDescriptorSubtypeEncodingUnit) ) {
+      UVCDescriptorUnit         unit;
+      UVCDescriptorParseStatus  status = UVCDescriptorParseUnit(&unit, d, offset);
+
+      if ( status != kUVCDescriptorParseOk ) return status;
+      if ( unit.unitId == 0 ) return kUVCDescriptorParseBadUnitId;
+      if ( graph->unitIndex[unit.unitId] ) return kUVCDescriptorParseDuplicateUnit;
+      graph->units[graph->unitCount] = unit;
+      graph->unitIndex[unit.unitId] = (uint8_t)(++graph->unitCount);
+    }
+    offset += bLength;
+  }
+  return kUVCDescriptorParseOk;
+}
+
+//
+
+const UVCDescriptorUnit*
+UVCDescriptorGraphUnitWithId(
+  const UVCDescriptorGraph  *graph,
+  uint8_t                   unitId
+)
+{
+  uint8_t                   index = graph->unitIndex[unitId];
+
+  return ( index ? &graph->units[index - 1] : NULL );
+}
+
+//
+
+const UVCDescriptorUnit*
+UVCDescriptorGraphFirstUnitOfSubtype(
+  const UVCDescriptorGraph  *graph,
+  uint8_t                   subtype,
+  uint16_t                  terminalType
+)
+{
+  unsigned int              i;
+
+  for ( i = 0; i < graph->unitCount; i++ ) {
+    if ( (graph->units[i].subtype == subtype) && (! terminalType || (graph->units[i].terminalType == terminalType)) ) return &graph->units[i];
+  }
+  return NULL;
+}
+
+//
+
+uint8_t
+UVCDescriptorUnitSourceId(
+  const UVCDescriptorGraph  *graph,
+  const UVCDescriptorUnit   *unit,
+  unsigned int              index
+)
+{
+  return graph->bytes[unit->sourceOffset + index];
+}
+
+//
+
+const uint8_t*
+UVCDescriptorUnitControls(
+  const UVCDescriptorGraph  *graph,
+  const UVCDescriptorUnit   *unit
+)
+{
+  return ( unit->controlSize ? graph->bytes + unit->controlsOffset : NULL );
+}
+
+//
+
+const char*
+UVCDescriptorSubtypeName(
+  uint8_t     subtype
+)
+{
+  switch ( subtype ) {
+    case kUVCDescriptorSubtypeHeader:
+      return "header";
+    case kUVCDescriptorSubtypeInputTerminal:
+      return "input-terminal";
+    case kUVCDescriptorSubtypeOutputTerminal:
+      return "output-terminal";
+    case kUVCDescriptorSubtypeSelectorUnit:
+      return "selector-unit";
+    case kUVCDescriptorSubtypeProcessingUnit:
+      return "processing-unit";
+    case kUVCDescriptorSubtypeExtensionUnit:
+      return "extension-unit";
+    case kUVCDescriptorSubtypeEncodingUnit:
+      return "encoding-unit";
+  }
+  return "unknown";
+}
+
+//
+
+const char*
+UVCDescriptorParseStatusString(
+  UVCDescriptorParseStatus  status
+)
+{
+  switch ( status ) {
+    case kUVCDescriptorParseOk:
+      return "ok";
+    case kUVCDescriptorParseTruncated:
+      return "descriptor block is truncated";
+    case kUVCDescriptorParseNotVideoControl:
+      return "not a VideoControl interface header";
+    case kUVCDescriptorParseBadLength:
+      return "descriptor length too short for its subtype";
+    case kUVCDescriptorParseDuplicateUnit:
+      return "duplicate unit/terminal id";
+    case kUVCDescriptorParseBadUnitId:
+      return "invalid unit/terminal id (zero)";
+  }
+  return "unknown error";
+}
@@ -0,0 +1,186 @@
+//
+//  UVCDescriptor.h
+//
+//  Parser for the class-specific VideoControl interface descriptor block.
+//
+//  Copyright © 2016
+//  Dr. Jeffrey Frey, IT-NSS
+//  University of Delaware
+//
+// $Id$
+//
+
+#ifndef __UVCDESCRIPTOR_H__
+#define __UVCDESCRIPTOR_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/*!
+  @enum UVC VideoControl descriptor subtypes
+*/
+enum {
+  kUVCDescriptorSubtypeHeader           = 0x01,
+  kUVCDescriptorSubtypeInputTerminal    = 0x02,
+  kUVCDescriptorSubtypeOutputTerminal   = 0x03,
+  kUVCDescriptorSubtypeSelectorUnit     = 0x04,
+  kUVCDescriptorSubtypeProcessingUnit   = 0x05,
+  kUVCDescriptorSubtypeExtensionUnit    = 0x06,
+  kUVCDescriptorSubtypeEncodingUnit     = 0x07
+};
+
+/*!
+  @enum UVC terminal types
+
+  The terminal types which affect the layout of an input terminal
+  descriptor.
+*/
+enum {
+  kUVCTerminalTypeStreaming             = 0x0101,
+  kUVCTerminalTypeCamera                = 0x0201,
+  kUVCTerminalTypeMediaTransportInput   = 0x0202
+};
+
+/*!
+  @enum UVC descriptor parse status
+
+  Values returned by UVCDescriptorGraphParse():
+
+    - kUVCDescriptorParseOk:  the block was parsed completely
+    - kUVCDescriptorParseTruncated:  the block (or a descriptor within it) is
+      shorter than its declared length
+    - kUVCDescriptorParseNotVideoControl:  the block does not start with a
+      class-specific VC interface header
+    - kUVCDescriptorParseBadLength:  a descriptor's bLength is too short
+      for its subtype
+    - kUVCDescriptorParseDuplicateUnit:  two units/terminals share an id
+    - kUVCDescriptorParseBadUnitId:  a unit/terminal uses the reserved id 0
+*/
+typedef enum {
+  kUVCDescriptorParseOk                 = 0,
+  kUVCDescriptorParseTruncated,
+  kUVCDescriptorParseNotVideoControl,
+  kUVCDescriptorParseBadLength,
+  kUVCDescriptorParseDuplicateUnit,
+  kUVCDescriptorParseBadUnitId
+} UVCDescriptorParseStatus;
+
+/*!
+  @defined UVCDescriptorMaxUnits
+
+  Unit and terminal ids are 8-bit values and zero is reserved, so a
+  VideoControl interface can contain at most 255 of them.
+*/
+#define UVCDescriptorMaxUnits   255
+
+/*!
+  @typedef UVCDescriptorUnit
+
+  Compact description of a single unit or terminal.  All offsets are byte
+  offsets from the start of the descriptor block that was parsed, so the
+  structure holds no pointers and needs no allocation:
+
+    - descriptorOffset/descriptorLength:  the unit's own descriptor
+    - sourceOffset/sourceCount:  the array of bSourceID values
+    - controlsOffset/controlSize:  the bmControls bitmap (controlSize of
+      zero if the unit has none)
+    - terminalType:  wTerminalType for input and output terminals
+*/
+typedef struct {
+  uint8_t             unitId;
+  uint8_t             subtype;
+  uint16_t            terminalType;
+  uint16_t            descriptorOffset;
+  uint8_t             descriptorLength;
+  uint8_t             sourceCount;
+  uint16_t            sourceOffset;
+  uint16_t            controlsOffset;
+  uint8_t             controlSize;
+} UVCDescriptorUnit;
+
+/*!
+  @typedef UVCDescriptorGraph
+
+  The parsed form of a VideoControl descriptor block.  The bytes pointer
+  references the caller's buffer, which must remain valid for as long as the
+  graph is used.  The units array holds unitCount entries in the order they
+  appear in the block; unitIndex maps a unit id to 1 + its index in units
+  (zero meaning no such unit).
+*/
+typedef struct {
+  const uint8_t       *bytes;
+  size_t              length;
+  uint16_t            uvcVersion;
+  uint16_t            totalLength;
+  uint32_t            clockFrequency;
+  uint8_t             interfaceCount;
+  uint16_t            interfaceOffset;
+  unsigned int        unitCount;
+  UVCDescriptorUnit   units[UVCDescriptorMaxUnits];
+  uint8_t             unitIndex[256];
+} UVCDescriptorGraph;
+
+/*!
+  @function UVCDescriptorGraphParse
+
+  Parse the length bytes at bytes (which should begin with the VC interface
+  header) into graph.  Every field read is bounds-checked against both the
+  buffer and the enclosing descriptor, so arbitrary input is safe.  On error
+  graph holds the units parsed prior to the offending descriptor.
+*/
+UVCDescriptorParseStatus UVCDescriptorGraphParse(UVCDescriptorGraph *graph, const void *bytes, size_t length);
+
+/*!
+  @function UVCDescriptorGraphUnitWithId
+
+  Returns the unit or terminal with the given id, or NULL.
+*/
+const UVCDescriptorUnit* UVCDescriptorGraphUnitWithId(const UVCDescriptorGraph *graph, uint8_t unitId);
+
+/*!
+  @function UVCDescriptorGraphFirstUnitOfSubtype
+
+  Returns the first unit with the given subtype (and, if terminalType is
+  non-zero, that terminal type), or NULL.
+*/
+const UVCDescriptorUnit* UVCDescriptorGraphFirstUnitOfSubtype(const UVCDescriptorGraph *graph, uint8_t subtype, uint16_t terminalType);
+
+/*!
+  @function UVCDescriptorUnitSourceId
+
+  Returns the index'th source id of unit (no bounds checking beyond
+  sourceCount, which the parser has already validated).
+*/
+uint8_t UVCDescriptorUnitSourceId(const UVCDescriptorGraph *graph, const UVCDescriptorUnit *unit, unsigned int index);
+
+/*!
+  @function UVCDescriptorUnitControls
+
+  Returns a pointer to the unit's bmControls bitmap within the graph's
+  buffer, or NULL if it has none.
+*/
+const uint8_t* UVCDescriptorUnitControls(const UVCDescriptorGraph *graph, const UVCDescriptorUnit *unit);
+
+/*!
+  @function UVCDescriptorSubtypeName
+
+  Returns a constant, human-readable name for the given descriptor subtype.
+*/
+const char* UVCDescriptorSubtypeName(uint8_t subtype);
+
+/*!
+  @function UVCDescriptorParseStatusString
+
+  Returns a constant, human-readable description of status.
+*/
+const char* UVCDescriptorParseStatusString(UVCDescriptorParseStatus status);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* __UVCDESCRIPTOR_H__ */
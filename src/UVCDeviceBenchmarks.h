@@ -0,0 +1,81 @@
+//
+//  UVCDeviceBenchmarks.h
+//
+//  UVCBenchmark suites that exercise controllers on simulated devices.
+//
+//  Copyright © 2016
+//  Dr. Jeffrey Frey, IT-NSS
+//  University of Delaware
+//
+// $Id$
+//
+
+#import "UVCBenchmark.h"
+
+/*!
+  @category UVCBenchmark(UVCDeviceBenchmarks)
+  @abstract Benchmark suites that need UVCController.
+
+  Every suite runs against UVCSimulatedTransport cameras, so the results do
+  not depend on the hardware attached and are comparable between runs.  The
+  suites that model transfer costs use the simulated device's latency and
+  service time; those reporting observed behavior (rates, counts, skew)
+  rather than per-operation times use recordValue:unit:higherIsBetter:forName:.
+
+    - controls:  UVCController and UVCControl creation
+    - descriptors:  parsing a VideoControl descriptor block
+    - requests:  request instrumentation overhead, synchronous vs. pipelined
+      reads
+    - watch:  change-detection latency and CPU use, status interrupt vs.
+      polling
+    - daemon:  per-request latency through a resident daemon vs. a fresh
+      uvc-util process per request
+    - batch:  --batch command throughput
+    - enumeration:  eager vs. lazy (UVCDeviceInfo) start-up across hundreds
+      of devices
+    - group:  concurrent writes to a group of cameras and their skew
+    - trajectory:  achieved update rate and deadline misses of a move
+    - coalescing:  write-queue counters with several producer threads
+    - trace:  recording overhead, and replay of a recorded session as fast
+      as possible and with its original latencies
+    - arena:  memory used by control values kept in a UVCValueArena vs.
+      standalone UVCValue objects, and full-scan diffs and range checks by
+      plane sweep vs. object traversal
+    - dump:  an NDJSON dump of every control vs. showing and getting each
+      control in turn
+    - listing:  listing a device's controls by creating every control vs.
+      from the descriptor-derived availability mask
+    - cache:  start-up (a new controller creating every control) with the
+      capability cache flushed vs. warm
+    - registry:  hotplug reaction latency of a UVCDeviceRegistry, and the
+      cost of one incremental arrival/removal vs. a full rescan
+    - faults:  tail latency (p50/p99/max) and failures of single and
+      batched reads from a camera that stalls and hangs at random, with no
+      deadline or retries vs. a request timeout and bounded retries; fails
+      if a single read outlasts the bound the timeout and retries imply
+    - soak:  thousands of get/set/show/dump cycles in one session; fails
+      (see recordValue:unit:limit:forName:) if live heap blocks, heap bytes,
+      or the resident set keep growing once warmed up
+*/
+@interface UVCBenchmark(UVCDeviceBenchmarks)
+
+- (void) runControlsSuite;
+- (void) runDescriptorsSuite;
+- (void) runRequestsSuite;
+- (void) runWatchSuite;
+- (void) runDaemonSuite;
+- (void) runBatchSuite;
+- (void) runEnumerationSuite;
+- (void) runGroupSuite;
+- (void) runTrajectorySuite;
+- (void) runCoalescingSuite;
+- (void) runTraceSuite;
+- (void) runArenaSuite;
+- (void) runDumpSuite;
+- (void) runListingSuite;
+- (void) runCacheSuite;
+- (void) runRegistrySuite;
+- (void) runFaultsSuite;
+- (void) runSoakSuite;
+
+@end
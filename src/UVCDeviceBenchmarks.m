@@ -0,0 +1,1672 @@
+//
+//  UVCDeviceBenchmarks.m
+//
+//  UVCBenchmark suites that exercise controllers on simulated devices.
+//
+//  Copyright © 2016
+//  Dr. Jeffrey Frey, IT-NSS
+//  University of Delaware
+//
+// $Id$
+//
+
+#import "UVCDeviceBenchmarks.h"
+#import "UVCSimulatedTransport.h"
+#import "UVCDeviceInfo.h"
+#import "UVCControllerGroup.h"
+#import "UVCTrajectory.h"
+#import "UVCWriteQueue.h"
+#import "UVCDaemon.h"
+#import "UVCTrace.h"
+#import "UVCValueArena.h"
+#import "UVCDeviceRegistry.h"
+#import "UVCCapabilityCache.h"
+#include "UVCDescriptor.h"
+
+#include <errno.h>
+#include <math.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <malloc/malloc.h>
+#include <mach-o/dyld.h>
+#include <mach/mach.h>
+
+extern char **environ;
+
+//
+// Methods of UVCController that are not part of its public interface but are
+// measured here:
+//
+@interface UVCController(UVCDeviceBenchmarksAccess)
+
++ (NSUInteger) controlIndexForString:(NSString*)controlString;
+- (BOOL) setValue:(UVCValue*)value forControl:(NSUInteger)controlId;
+
+@end
+
+//
+
+/*!
+  @defined UVCDeviceBenchmarksEnumerationCount
+
+  Number of simulated devices on the "bus" in the enumeration suite.
+*/
+#define UVCDeviceBenchmarksEnumerationCount   256
+
+/*!
+  @defined UVCDeviceBenchmarksGroupCount
+
+  Number of simulated cameras in the group suite.
+*/
+#define UVCDeviceBenchmarksGroupCount         8
+
+/*!
+  @defined UVCDeviceBenchmarksProducerCount
+
+  Number of threads writing a control in the coalescing suite.
+*/
+#define UVCDeviceBenchmarksProducerCount      4
+
+/*!
+  @defined UVCDeviceBenchmarksBatchCount
+
+  Number of commands in each of the batch suite's command files.
+*/
+#define UVCDeviceBenchmarksBatchCount         500
+
+/*!
+  @defined UVCDeviceBenchmarksRegistryCount
+
+  Number of simulated cameras present in the registry suite.
+*/
+#define UVCDeviceBenchmarksRegistryCount      64
+
+/*!
+  @defined UVCDeviceBenchmarksRegistryEventCount
+
+  Number of arrival/removal pairs whose latency the registry suite samples.
+*/
+#define UVCDeviceBenchmarksRegistryEventCount 256
+
+/*!
+  @defined UVCDeviceBenchmarksFaultSampleCount
+
+  Number of GET_CUR requests the faults suite times under each policy.
+*/
+#define UVCDeviceBenchmarksFaultSampleCount   500
+
+/*!
+  @defined UVCDeviceBenchmarksFaultBatchCount
+
+  Number of readControls: batches the faults suite times under each policy.
+*/
+#define UVCDeviceBenchmarksFaultBatchCount    50
+
+/*!
+  @defined UVCDeviceBenchmarksFaultStallProbability
+
+  Fraction of transfers the faults suite's camera stalls as "not ready".
+*/
+#define UVCDeviceBenchmarksFaultStallProbability  0.05
+
+/*!
+  @defined UVCDeviceBenchmarksFaultHangProbability
+
+  Fraction of transfers the faults suite's camera leaves hanging for
+  UVCDeviceBenchmarksFaultHangDuration.
+*/
+#define UVCDeviceBenchmarksFaultHangProbability   0.01
+#define UVCDeviceBenchmarksFaultHangDuration      0.25
+
+/*!
+  @defined UVCDeviceBenchmarksFaultRequestTimeout
+
+  Request timeout of the faults suite's bounded policy.
+*/
+#define UVCDeviceBenchmarksFaultRequestTimeout    0.05
+
+/*!
+  @defined UVCDeviceBenchmarksSoakCycleCount
+
+  Number of command cycles the soak suite runs between its two memory
+  samples (after as many again to warm up).
+*/
+#define UVCDeviceBenchmarksSoakCycleCount     2000
+
+/*!
+  @defined UVCDeviceBenchmarksSoakBlockLimit
+
+  Allowed growth in the soak suite of the number of live heap blocks (one per
+  object or buffer), to absorb allocator and Foundation noise.
+*/
+#define UVCDeviceBenchmarksSoakBlockLimit     64
+
+/*!
+  @defined UVCDeviceBenchmarksSoakByteLimit
+
+  Allowed growth in the soak suite of the bytes held in live heap blocks.
+*/
+#define UVCDeviceBenchmarksSoakByteLimit      (64 * 1024)
+
+/*!
+  @defined UVCDeviceBenchmarksSoakResidentLimit
+
+  Allowed growth in the soak suite of the resident set size.
+*/
+#define UVCDeviceBenchmarksSoakResidentLimit  (1024 * 1024)
+
+//
+
+/*!
+  @var UVCDeviceBenchmarksDescriptorBlock
+
+  VideoControl descriptor block of a typical UVC 1.00 webcam:  header, camera
+  input terminal, processing unit, output terminal, and an extension unit.
+*/
+static const UInt8 UVCDeviceBenchmarksDescriptorBlock[] = {
+                              // Header (one streaming interface):
+                              0x0d, 0x24, 0x01, 0x00, 0x01, 0x4e, 0x00, 0x80, 0xc3, 0xc9, 0x01, 0x01, 0x01,
+                              // Camera input terminal 1:
+                              0x12, 0x24, 0x02, 0x01, 0x01, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x2a, 0x08, 0x00,
+                              // Processing unit 2 (source 1):
+                              0x0b, 0x24, 0x05, 0x02, 0x01, 0x00, 0x40, 0x02, 0x7f, 0x17, 0x00,
+                              // Output terminal 3 (source 2):
+                              0x09, 0x24, 0x03, 0x03, 0x01, 0x01, 0x00, 0x02, 0x00,
+                              // Extension unit 4 (source 2):
+                              0x1b, 0x24, 0x06, 0x04, 0x70, 0x33, 0xf0, 0x28, 0x11, 0x63, 0x2e, 0x4a, 0xba, 0x2c, 0x68, 0x90, 0xeb, 0x33, 0x40, 0x16,
+                              0x08, 0x01, 0x02, 0x02, 0x1f, 0x00, 0x00
+                            };
+
+//
+
+/*!
+  @function UVCDeviceBenchmarksCamera
+
+  Returns an autoreleased controller for a new simulated camera with the
+  given timing; the camera itself is returned in *camera if not NULL.
+*/
+static UVCController*
+UVCDeviceBenchmarksCamera(
+  NSTimeInterval          latency,
+  NSTimeInterval          serviceTime,
+  UVCSimulatedTransport   **camera
+)
+{
+  UVCSimulatedTransport   *transport = [UVCSimulatedTransport simulatedCameraWithLatency:latency serviceTime:serviceTime];
+
+  if ( camera ) *camera = transport;
+  return [UVCController uvcControllerWithTransport:transport deviceName:@"Simulated UVC Camera" vendorId:0 productId:0];
+}
+
+//
+
+/*!
+  @function UVCDeviceBenchmarksCPUTime
+
+  Returns the user plus system CPU time consumed by the process so far.
+*/
+static NSTimeInterval
+UVCDeviceBenchmarksCPUTime(void)
+{
+  struct rusage           usage;
+
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + 1e-6 * (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+}
+
+//
+
+/*!
+  @function UVCDeviceBenchmarksMemoryUsage
+
+  Sample the process' memory use:  the number of live blocks and bytes in
+  use across all malloc zones, and the resident set size.
+*/
+static void
+UVCDeviceBenchmarksMemoryUsage(
+  size_t                        *blocksInUse,
+  size_t                        *bytesInUse,
+  size_t                        *residentSize
+)
+{
+  malloc_statistics_t           stats;
+  mach_task_basic_info_data_t   info;
+  mach_msg_type_number_t        infoCount = MACH_TASK_BASIC_INFO_COUNT;
+
+  malloc_zone_statistics(NULL, &stats);
+  *blocksInUse = stats.blocks_in_use;
+  *bytesInUse = stats.size_in_use;
+  if ( task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &infoCount) == KERN_SUCCESS ) {
+    *residentSize = info.resident_size;
+  } else {
+    *residentSize = 0;
+  }
+}
+
+//
+
+/*!
+  @function UVCDeviceBenchmarksSpawn
+
+  Start the program at path with the NULL-terminated argv, its stdout and
+  stderr discarded.  Returns zero (and the child's pid in *pid) or an errno
+  value.
+*/
+static int
+UVCDeviceBenchmarksSpawn(
+  const char                  *path,
+  char *const                 argv[],
+  pid_t                       *pid
+)
+{
+  posix_spawn_file_actions_t  actions;
+  int                         rc;
+
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+  posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+  rc = posix_spawn(pid, path, &actions, NULL, argv, environ);
+  posix_spawn_file_actions_destroy(&actions);
+  return rc;
+}
+
+//
+#if 0
+#pragma mark - Timed operations
+#endif
+//
+
+typedef struct {
+  UVCSimulatedTransport   *camera;
+  UVCController           *controller;
+} UVCDeviceBenchmarksControlsContext;
+
+static void
+UVCDeviceBenchmarksControllerCreate(
+  void                                *context,
+  NSUInteger                          iterations
+)
+{
+  UVCDeviceBenchmarksControlsContext  *C = (UVCDeviceBenchmarksControlsContext*)context;
+
+  while ( iterations-- ) [UVCController uvcControllerWithTransport:C->camera deviceName:@"Simulated UVC Camera" vendorId:0 productId:0];
+}
+
+static void
+UVCDeviceBenchmarksControlCreate(
+  void                                *context,
+  NSUInteger                          iterations
+)
+{
+  UVCDeviceBenchmarksControlsContext  *C = (UVCDeviceBenchmarksControlsContext*)context;
+
+  while ( iterations-- ) {
+    [[UVCController uvcControllerWithTransport:C->camera deviceName:@"Simulated UVC Camera" vendorId:0 productId:0] controlWithName:@"pan-tilt-abs"];
+  }
+}
+
+static void
+UVCDeviceBenchmarksControlCached(
+  void                                *context,
+  NSUInteger                          iterations
+)
+{
+  UVCDeviceBenchmarksControlsContext  *C = (UVCDeviceBenchmarksControlsContext*)context;
+
+  while ( iterations-- ) [C->controller controlWithName:@"pan-tilt-abs"];
+}
+
+//
+
+typedef struct {
+  UVCDescriptorGraph      *graph;
+} UVCDeviceBenchmarksDescriptorContext;
+
+static void
+UVCDeviceBenchmarksDescriptorParse(
+  void                                  *context,
+  NSUInteger                            iterations
+)
+{
+  UVCDeviceBenchmarksDescriptorContext  *C = (UVCDeviceBenchmarksDescriptorContext*)context;
+
+  while ( iterations-- ) UVCDescriptorGraphParse(C->graph, UVCDeviceBenchmarksDescriptorBlock, sizeof(UVCDeviceBenchmarksDescriptorBlock));
+}
+
+static void
+UVCDeviceBenchmarksDescriptorUnitWithId(
+  void                                  *context,
+  NSUInteger                            iterations
+)
+{
+  UVCDeviceBenchmarksDescriptorContext  *C = (UVCDeviceBenchmarksDescriptorContext*)context;
+
+  while ( iterations-- ) UVCDescriptorGraphUnitWithId(C->graph, (iterations & 3) + 1);
+}
+
+//
+
+typedef struct {
+  UVCRequestStatistics    *statistics;
+  IOUSBDevRequest         request;
+  UVCController           *controller;
+  UVCControl              *control;
+  NSArray                 *controls;
+} UVCDeviceBenchmarksRequestsContext;
+
+static void
+UVCDeviceBenchmarksRecordRequest(
+  void                                *context,
+  NSUInteger                          iterations
+)
+{
+  UVCDeviceBenchmarksRequestsContext  *C = (UVCDeviceBenchmarksRequestsContext*)context;
+
+  while ( iterations-- ) [C->statistics recordRequest:&C->request startTime:UVCRequestStatisticsTimestamp() result:kIOReturnSuccess];
+}
+
+static void
+UVCDeviceBenchmarksReadOne(
+  void                                *context,
+  NSUInteger                          iterations
+)
+{
+  UVCDeviceBenchmarksRequestsContext  *C = (UVCDeviceBenchmarksRequestsContext*)context;
+
+  while ( iterations-- ) [C->control readIntoCurrentValue];
+}
+
+static void
+UVCDeviceBenchmarksReadAllSequential(
+  void                                *context,
+  NSUInteger                          iterations
+)
+{
+  UVCDeviceBenchmarksRequestsContext  *C = (UVCDeviceBenchmarksRequestsContext*)context;
+
+  while ( iterations-- ) {
+    NSEnumerator                      *eControls = [C->controls objectEnumerator];
+    UVCControl                        *control;
+
+    while ( (control = [eControls nextObject]) ) [control readIntoCurrentValue];
+  }
+}
+
+static void
+UVCDeviceBenchmarksReadAllPipelined(
+  void                                *context,
+  NSUInteger                          iterations
+)
+{
+  UVCDeviceBenchmarksRequestsContext  *C = (UVCDeviceBenchmarksRequestsContext*)context;
+
+  while ( iterations-- ) [C->controller readControls:C->controls];
+}
+
+//
+
+typedef struct {
+  UVCDaemonClient         *client;
+  const char              *executablePath;
+} UVCDeviceBenchmarksDaemonContext;
+
+static void
+UVCDeviceBenchmarksDaemonRequest(
+  void                                *context,
+  NSUInteger                          iterations
+)
+{
+  UVCDeviceBenchmarksDaemonContext    *C = (UVCDeviceBenchmarksDaemonContext*)context;
+
+  while ( iterations-- ) [C->client performCommand:kUVCCommandSet argument:( (iterations & 1) ? "brightness=10" : "brightness=20" )];
+}
+
+static void
+UVCDeviceBenchmarksExecRequest(
+  void                                *context,
+  NSUInteger                          iterations
+)
+{
+  UVCDeviceBenchmarksDaemonContext    *C = (UVCDeviceBenchmarksDaemonContext*)context;
+
+  while ( iterations-- ) {
+    char *const                       argv[] = { (char*)C->executablePath, "--select-simulated", "-s", ( (iterations & 1) ? "brightness=10" : "brightness=20" ), NULL };
+    pid_t                             pid;
+    int                               status;
+
+    if ( UVCDeviceBenchmarksSpawn(C->executablePath, argv, &pid) == 0 ) waitpid(pid, &status, 0);
+  }
+}
+
+//
+
+typedef struct {
+  NSArray                 *cameras;
+  UVCDeviceFilter         filter;
+} UVCDeviceBenchmarksEnumerationContext;
+
+/*!
+  @function UVCDeviceBenchmarksEnumerationInfos
+
+  Returns a UVCDeviceInfo for each of the simulated cameras, as a registry
+  scan would.
+*/
+static NSArray*
+UVCDeviceBenchmarksEnumerationInfos(
+  UVCDeviceBenchmarksEnumerationContext *C
+)
+{
+  NSMutableArray                        *infos = [NSMutableArray arrayWithCapacity:[C->cameras count]];
+  NSUInteger                            i, iMax = [C->cameras count];
+
+  for ( i = 0; i < iMax; i++ ) {
+    [infos addObject:[UVCDeviceInfo deviceInfoWithTransport:[C->cameras objectAtIndex:i]
+                                      deviceName:@"Simulated UVC Camera"
+                                      vendorId:0
+                                      productId:0
+                                      locationId:0xfa000000 + (UInt32)i
+                                    ]];
+  }
+  return infos;
+}
+
+static void
+UVCDeviceBenchmarksEnumerationEager(
+  void                                  *context,
+  NSUInteger                            iterations
+)
+{
+  UVCDeviceBenchmarksEnumerationContext *C = (UVCDeviceBenchmarksEnumerationContext*)context;
+
+  while ( iterations-- ) {
+    NSEnumerator                        *eInfos = [UVCDeviceBenchmarksEnumerationInfos(C) objectEnumerator];
+    UVCDeviceInfo                       *info;
+    UVCController                       *match = nil;
+
+    // Probe every device, then pick the one wanted:
+    while ( (info = [eInfos nextObject]) ) {
+      UVCController                     *controller = [info controller];
+
+      [controller controlWithName:@"brightness"];
+      if ( [controller locationId] == C->filter.locationId ) match = controller;
+    }
+    [match controlWithName:@"brightness"];
+  }
+}
+
+static void
+UVCDeviceBenchmarksEnumerationLazy(
+  void                                  *context,
+  NSUInteger                            iterations
+)
+{
+  UVCDeviceBenchmarksEnumerationContext *C = (UVCDeviceBenchmarksEnumerationContext*)context;
+
+  while ( iterations-- ) {
+    NSArray                             *matches = [UVCDeviceInfo deviceInfos:UVCDeviceBenchmarksEnumerationInfos(C) matchingFilter:&C->filter];
+
+    if ( [matches count] ) [[[matches objectAtIndex:0] controller] controlWithName:@"brightness"];
+  }
+}
+
+//
+
+typedef struct {
+  UVCController           *controller;
+  UVCControl              *control;
+  NSArray                 *controls;
+  UVCTraceReplayTransport *replay;
+} UVCDeviceBenchmarksTraceContext;
+
+static void
+UVCDeviceBenchmarksTraceRead(
+  void                              *context,
+  NSUInteger                        iterations
+)
+{
+  UVCDeviceBenchmarksTraceContext   *C = (UVCDeviceBenchmarksTraceContext*)context;
+
+  while ( iterations-- ) [C->control readIntoCurrentValue];
+}
+
+static void
+UVCDeviceBenchmarksTraceReplay(
+  void                              *context,
+  NSUInteger                        iterations
+)
+{
+  UVCDeviceBenchmarksTraceContext   *C = (UVCDeviceBenchmarksTraceContext*)context;
+
+  while ( iterations-- ) {
+    [C->replay rewind];
+    [C->controller readControls:C->controls];
+  }
+}
+
+/*!
+  @function UVCDeviceBenchmarksTraceControls
+
+  Returns the readable controls of controller (creating them, so their
+  capability probes are delivered through its transport).
+*/
+static NSArray*
+UVCDeviceBenchmarksTraceControls(
+  UVCController           *controller
+)
+{
+  NSMutableArray          *controls = [NSMutableArray array];
+  NSEnumerator            *eNames = [[controller controlStrings] objectEnumerator];
+  NSString                *name;
+  UVCControl              *control;
+
+  while ( (name = [eNames nextObject]) ) {
+    if ( (control = [controller controlWithName:name]) && [control supportsGetValue] ) [controls addObject:control];
+  }
+  return controls;
+}
+
+typedef struct {
+  UVCValueArena           *arena;
+  NSArray                 *controls;
+  NSArray                 *snapshotValues;
+  NSData                  *snapshot;
+  NSUInteger              differingCount;
+} UVCDeviceBenchmarksArenaContext;
+
+static void
+UVCDeviceBenchmarksArenaDiffObjects(
+  void                              *context,
+  NSUInteger                        iterations
+)
+{
+  UVCDeviceBenchmarksArenaContext   *C = (UVCDeviceBenchmarksArenaContext*)context;
+  NSUInteger                        i, iMax = [C->controls count];
+
+  while ( iterations-- ) {
+    C->differingCount = 0;
+    for ( i = 0; i < iMax; i++ ) {
+      if ( ! [[[C->controls objectAtIndex:i] currentValue] isEqual:[C->snapshotValues objectAtIndex:i]] ) C->differingCount++;
+    }
+  }
+}
+
+static void
+UVCDeviceBenchmarksArenaDiffSweep(
+  void                              *context,
+  NSUInteger                        iterations
+)
+{
+  UVCDeviceBenchmarksArenaContext   *C = (UVCDeviceBenchmarksArenaContext*)context;
+
+  while ( iterations-- ) C->differingCount = [[C->arena indexesOfSlot:kUVCValueArenaSlotCurrent differingFromSnapshot:C->snapshot] count];
+}
+
+static void
+UVCDeviceBenchmarksArenaRangeObjects(
+  void                              *context,
+  NSUInteger                        iterations
+)
+{
+  UVCDeviceBenchmarksArenaContext   *C = (UVCDeviceBenchmarksArenaContext*)context;
+  NSUInteger                        i, iMax = [C->controls count];
+
+  while ( iterations-- ) {
+    C->differingCount = 0;
+    for ( i = 0; i < iMax; i++ ) {
+      UVCControl                    *control = [C->controls objectAtIndex:i];
+
+      if ( [control hasRange] ) {
+        UVCValue                    *value = [control currentValue];
+
+        if ( ! [[value valueType] isBuffer:[value valuePtr] withinMinimum:[[control minimum] valuePtr] maximum:[[control maximum] valuePtr]] ) C->differingCount++;
+      }
+    }
+  }
+}
+
+static void
+UVCDeviceBenchmarksArenaRangeSweep(
+  void                              *context,
+  NSUInteger                        iterations
+)
+{
+  UVCDeviceBenchmarksArenaContext   *C = (UVCDeviceBenchmarksArenaContext*)context;
+
+  while ( iterations-- ) C->differingCount = [[C->arena indexesOutOfRange] count];
+}
+
+/*!
+  @function UVCDeviceBenchmarksArenaValueBytes
+
+  Returns the heap footprint of the values of control:  the current value
+  plus each limit it provides, using the given value objects.
+*/
+static size_t
+UVCDeviceBenchmarksArenaValueBytes(
+  UVCControl              *control,
+  UVCValue                *current,
+  UVCValue                *limit
+)
+{
+  size_t                  bytes = malloc_size(current);
+  
+  if ( [control hasRange] ) bytes += 2 * malloc_size(limit);
+  if ( [control hasStepSize] ) bytes += malloc_size(limit);
+  if ( [control hasDefaultValue] ) bytes += malloc_size(limit);
+  return bytes;
+}
+
+typedef struct {
+  UVCController           *controller;
+  NSArray                 *controls;
+  FILE                    *devNull;
+} UVCDeviceBenchmarksDumpContext;
+
+static void
+UVCDeviceBenchmarksDumpNDJSON(
+  void                              *context,
+  NSUInteger                        iterations
+)
+{
+  UVCDeviceBenchmarksDumpContext    *C = (UVCDeviceBenchmarksDumpContext*)context;
+
+  while ( iterations-- ) [C->controller writeControlsAsNDJSONToStream:C->devNull failedCount:NULL];
+}
+
+static void
+UVCDeviceBenchmarksDumpShowAndGet(
+  void                              *context,
+  NSUInteger                        iterations
+)
+{
+  UVCDeviceBenchmarksDumpContext    *C = (UVCDeviceBenchmarksDumpContext*)context;
+  NSUInteger                        i, iMax = [C->controls count];
+
+  while ( iterations-- ) {
+    for ( i = 0; i < iMax; i++ ) {
+      UVCControl                    *control = [C->controls objectAtIndex:i];
+
+      fprintf(C->devNull, "%s\n", [[control summaryString] UTF8String]);
+      if ( [control readIntoCurrentValue] ) fprintf(C->devNull, "%s = %s\n", [[control controlName] UTF8String], [[[control currentValue] stringValue] UTF8String]);
+    }
+  }
+}
+
+typedef struct {
+  UVCSimulatedTransport   *camera;
+  NSData                  *descriptors;
+  UVCController           *controller;
+} UVCDeviceBenchmarksListingContext;
+
+static void
+UVCDeviceBenchmarksListingProbe(
+  void                                *context,
+  NSUInteger                          iterations
+)
+{
+  UVCDeviceBenchmarksListingContext   *C = (UVCDeviceBenchmarksListingContext*)context;
+
+  while ( iterations-- ) {
+    UVCController                     *controller = [UVCController uvcControllerWithTransport:C->camera deviceName:@"Simulated UVC Camera" vendorId:0 productId:0 locationId:0 videoControlDescriptors:C->descriptors];
+    NSEnumerator                      *eNames = [[UVCController controlStrings] objectEnumerator];
+    NSString                          *name;
+
+    while ( (name = [eNames nextObject]) ) [controller controlWithName:name];
+  }
+}
+
+static void
+UVCDeviceBenchmarksListingMask(
+  void                                *context,
+  NSUInteger                          iterations
+)
+{
+  UVCDeviceBenchmarksListingContext   *C = (UVCDeviceBenchmarksListingContext*)context;
+
+  while ( iterations-- ) {
+    UVCController                     *controller = [UVCController uvcControllerWithTransport:C->camera deviceName:@"Simulated UVC Camera" vendorId:0 productId:0 locationId:0 videoControlDescriptors:C->descriptors];
+
+    [controller availableControlNames];
+  }
+}
+
+static void
+UVCDeviceBenchmarksListingMaskResident(
+  void                                *context,
+  NSUInteger                          iterations
+)
+{
+  UVCDeviceBenchmarksListingContext   *C = (UVCDeviceBenchmarksListingContext*)context;
+
+  while ( iterations-- ) [C->controller availableControlNames];
+}
+
+typedef struct {
+  UVCSimulatedTransport   *camera;
+  NSData                  *descriptors;
+} UVCDeviceBenchmarksCacheContext;
+
+static void
+UVCDeviceBenchmarksCachePass(
+  UVCDeviceBenchmarksCacheContext     *C,
+  BOOL                                shouldFlush
+)
+{
+  NSAutoreleasePool                   *localPool = [[NSAutoreleasePool alloc] init];
+  UVCController                       *controller = [UVCController uvcControllerWithTransport:C->camera deviceName:@"Simulated UVC Camera" vendorId:0 productId:0 locationId:0 videoControlDescriptors:C->descriptors];
+  NSEnumerator                        *eNames = [[UVCController controlStrings] objectEnumerator];
+  NSString                            *name;
+
+  [controller attachCapabilityCache];
+  if ( shouldFlush ) [controller invalidateCapabilityCache];
+  while ( (name = [eNames nextObject]) ) [controller controlWithName:name];
+
+  // Releasing the controller writes any new records to the cache file:
+  [localPool drain];
+}
+
+static void
+UVCDeviceBenchmarksCacheCold(
+  void                                *context,
+  NSUInteger                          iterations
+)
+{
+  while ( iterations-- ) UVCDeviceBenchmarksCachePass((UVCDeviceBenchmarksCacheContext*)context, YES);
+}
+
+static void
+UVCDeviceBenchmarksCacheWarm(
+  void                                *context,
+  NSUInteger                          iterations
+)
+{
+  while ( iterations-- ) UVCDeviceBenchmarksCachePass((UVCDeviceBenchmarksCacheContext*)context, NO);
+}
+
+//
+
+typedef struct {
+  UVCSimulatedDeviceEventSource *source;
+  UVCDeviceRegistry             *registry;
+  UVCSimulatedTransport         *cameras[UVCDeviceBenchmarksRegistryCount];
+  UInt64                        nextDeviceId;
+  NSTimeInterval                notifiedAt;
+} UVCDeviceBenchmarksRegistryContext;
+
+/*!
+  @function UVCDeviceBenchmarksRegistryDevice
+
+  Returns an autoreleased, unprobed UVCDeviceInfo for a simulated camera.
+*/
+static UVCDeviceInfo*
+UVCDeviceBenchmarksRegistryDevice(
+  UVCSimulatedTransport           *camera,
+  UInt64                          deviceId
+)
+{
+  return [UVCDeviceInfo deviceInfoWithTransport:camera deviceName:@"Simulated UVC Camera" vendorId:0 productId:0 locationId:(UInt32)deviceId];
+}
+
+static void
+UVCDeviceBenchmarksRegistryListener(
+  void                                *context,
+  UVCDeviceRegistry                   *registry,
+  UVCDeviceRegistryEvent              event,
+  UVCDeviceInfo                       *device
+)
+{
+  ((UVCDeviceBenchmarksRegistryContext*)context)->notifiedAt = [NSDate timeIntervalSinceReferenceDate];
+}
+
+static void
+UVCDeviceBenchmarksRegistryHotplug(
+  void                                *context,
+  NSUInteger                          iterations
+)
+{
+  UVCDeviceBenchmarksRegistryContext  *C = (UVCDeviceBenchmarksRegistryContext*)context;
+
+  while ( iterations-- ) {
+    UInt64                            deviceId = C->nextDeviceId++;
+
+    [C->source postArrivalOfDevice:UVCDeviceBenchmarksRegistryDevice(C->cameras[0], deviceId) deviceId:deviceId];
+    [C->source postRemovalOfDeviceId:deviceId];
+  }
+}
+
+static void
+UVCDeviceBenchmarksRegistryRescan(
+  void                                *context,
+  NSUInteger                          iterations
+)
+{
+  UVCDeviceBenchmarksRegistryContext  *C = (UVCDeviceBenchmarksRegistryContext*)context;
+  NSUInteger                          i;
+
+  while ( iterations-- ) {
+    NSMutableArray                    *controllers = [NSMutableArray arrayWithCapacity:UVCDeviceBenchmarksRegistryCount];
+
+    for ( i = 0; i < UVCDeviceBenchmarksRegistryCount; i++ ) {
+      [controllers addObject:[UVCController uvcControllerWithTransport:C->cameras[i] deviceName:@"Simulated UVC Camera" vendorId:0 productId:0 locationId:(UInt32)i]];
+    }
+  }
+}
+
+static int
+UVCDeviceBenchmarksCompareTimes(
+  const void                          *a,
+  const void                          *b
+)
+{
+  NSTimeInterval                      A = *(const NSTimeInterval*)a, B = *(const NSTimeInterval*)b;
+
+  return ( A < B ) ? -1 : (( A > B ) ? 1 : 0);
+}
+
+/*!
+  @function UVCDeviceBenchmarksMedian
+
+  Sorts the count samples in place and returns their median.
+*/
+static NSTimeInterval
+UVCDeviceBenchmarksMedian(
+  NSTimeInterval                      *samples,
+  NSUInteger                          count
+)
+{
+  qsort(samples, count, sizeof(NSTimeInterval), UVCDeviceBenchmarksCompareTimes);
+  return samples[count / 2];
+}
+
+/*!
+  @function UVCDeviceBenchmarksPercentile
+
+  Returns the given percentile of count samples that have already been
+  sorted (e.g. by UVCDeviceBenchmarksMedian).
+*/
+static NSTimeInterval
+UVCDeviceBenchmarksPercentile(
+  const NSTimeInterval                *samples,
+  NSUInteger                          count,
+  double                              percentile
+)
+{
+  NSUInteger                          rank = (NSUInteger)ceil(percentile * count / 100.0);
+
+  return samples[( rank ? rank - 1 : 0 )];
+}
+
+/*!
+  @function UVCDeviceBenchmarksInjectFaults
+
+  Have camera stall and hang at random from now on.
+*/
+static void
+UVCDeviceBenchmarksInjectFaults(
+  UVCSimulatedTransport               *camera
+)
+{
+  [camera setStallProbability:UVCDeviceBenchmarksFaultStallProbability];
+  [camera setHangProbability:UVCDeviceBenchmarksFaultHangProbability];
+  [camera setHangDuration:UVCDeviceBenchmarksFaultHangDuration];
+}
+
+typedef struct {
+  UVCCommandSession       *session;
+  NSArray                 *controls;
+  NSUInteger              cycle;
+} UVCDeviceBenchmarksSoakContext;
+
+static void
+UVCDeviceBenchmarksSoakCycle(
+  void                              *context,
+  NSUInteger                        iterations
+)
+{
+  UVCDeviceBenchmarksSoakContext    *C = (UVCDeviceBenchmarksSoakContext*)context;
+  UVCController                     *controller = [C->session targetDevice];
+
+  while ( iterations-- ) {
+    @autoreleasepool {
+      char                          setCommand[32];
+
+      snprintf(setCommand, sizeof(setCommand), "set brightness=%lu", (unsigned long)(C->cycle++ % 64));
+      [C->session performCommandLine:"get brightness"];
+      [C->session performCommandLine:setCommand];
+      [C->session performCommandLine:"show *"];
+      [C->session performCommand:kUVCCommandDump argument:NULL];
+      [controller readControls:C->controls];
+      [controller refreshCapabilitiesOfControls:C->controls];
+    }
+  }
+}
+
+//
+#if 0
+#pragma mark - Watch callback
+#endif
+//
+
+typedef struct {
+  UVCSimulatedTransport   *camera;
+  NSTimeInterval          latencySum;
+  NSUInteger              eventCount;
+} UVCDeviceBenchmarksWatchContext;
+
+static BOOL
+UVCDeviceBenchmarksWatchCallback(
+  void                            *context,
+  const UVCControlChangeEvent     *event
+)
+{
+  UVCDeviceBenchmarksWatchContext *C = (UVCDeviceBenchmarksWatchContext*)context;
+
+  if ( event->attribute == kUVCControlChangeValue ) {
+    NSTimeInterval                latency = event->timestamp - [C->camera timeOfLastValueChange];
+
+    if ( latency >= 0.0 ) {
+      C->latencySum += latency;
+      C->eventCount++;
+    }
+  }
+  return YES;
+}
+
+//
+#if 0
+#pragma mark - Coalescing producers
+#endif
+//
+
+typedef struct {
+  UVCController           *controller;
+  NSUInteger              controlIndex;
+  UVCType                 *valueType;
+  NSUInteger              producerIndex;
+  NSUInteger              writeCount;
+} UVCDeviceBenchmarksProducer;
+
+static void*
+UVCDeviceBenchmarksProducerMain(
+  void                          *context
+)
+{
+  UVCDeviceBenchmarksProducer   *P = (UVCDeviceBenchmarksProducer*)context;
+  NSAutoreleasePool             *pool = [[NSAutoreleasePool alloc] init];
+  UVCValue                      *value = [UVCValue uvcValueWithType:P->valueType];
+  NSUInteger                    i;
+
+  for ( i = 0; i < P->writeCount; i++ ) {
+    *((SInt16*)[value valuePtr]) = (SInt16)((P->producerIndex * 16 + i) % 64);
+    [P->controller setValue:value forControl:P->controlIndex];
+  }
+  [pool drain];
+  return NULL;
+}
+
+//
+#if 0
+#pragma mark -
+#endif
+//
+
+@implementation UVCBenchmark(UVCDeviceBenchmarks)
+
+  + (void) becomeMultiThreaded:(id)unused
+  {
+  }
+
+//
+
+  - (void) runControlsSuite
+  {
+    UVCDeviceBenchmarksControlsContext  context;
+
+    // Control name look-up is timed by the portable "names" suite.
+    context.controller = UVCDeviceBenchmarksCamera(0.0, 0.0, &context.camera);
+
+    [self measure:"uvcControllerWithTransport" function:UVCDeviceBenchmarksControllerCreate context:&context];
+    [self measure:"controlWithName.create" function:UVCDeviceBenchmarksControlCreate context:&context];
+    [self measure:"controlWithName.cached" function:UVCDeviceBenchmarksControlCached context:&context];
+  }
+
+//
+
+  - (void) runDescriptorsSuite
+  {
+    UVCDeviceBenchmarksDescriptorContext  context;
+    UVCDescriptorParseStatus              status;
+
+    if ( ! (context.graph = malloc(sizeof(UVCDescriptorGraph))) ) return;
+    status = UVCDescriptorGraphParse(context.graph, UVCDeviceBenchmarksDescriptorBlock, sizeof(UVCDeviceBenchmarksDescriptorBlock));
+    if ( status == kUVCDescriptorParseOk ) {
+      [self measure:"UVCDescriptorGraphParse" function:UVCDeviceBenchmarksDescriptorParse context:&context];
+      [self measure:"UVCDescriptorGraphUnitWithId" function:UVCDeviceBenchmarksDescriptorUnitWithId context:&context];
+    } else {
+      fprintf(stderr, "WARNING:  benchmark descriptor block did not parse:  %s\n", UVCDescriptorParseStatusString(status));
+    }
+    free(context.graph);
+  }
+
+//
+
+  - (void) runRequestsSuite
+  {
+    UVCDeviceBenchmarksRequestsContext  context;
+    NSMutableArray                      *controls = [NSMutableArray array];
+    NSEnumerator                        *eNames;
+    NSString                            *name;
+    UVCControl                          *control;
+
+    memset(&context, 0, sizeof(context));
+    context.statistics = [UVCRequestStatistics requestStatistics];
+    context.request.bRequest = 0x81;
+    context.request.wValue = 0x0200;
+    context.request.wIndex = 0x0200;
+    [self measure:"recordRequest" function:UVCDeviceBenchmarksRecordRequest context:&context];
+
+    // Synchronous transfer on an instantaneous device (so this is all host overhead):
+    context.controller = UVCDeviceBenchmarksCamera(0.0, 0.0, NULL);
+    context.control = [context.controller controlWithName:@"brightness"];
+    [self measure:"readIntoCurrentValue.instantaneous" function:UVCDeviceBenchmarksReadOne context:&context];
+
+    // Every control, one at a time vs. pipelined, with 1 ms of per-transfer latency:
+    context.controller = UVCDeviceBenchmarksCamera(0.001, 0.0001, NULL);
+    eNames = [[context.controller controlStrings] objectEnumerator];
+    while ( (name = [eNames nextObject]) ) {
+      if ( (control = [context.controller controlWithName:name]) && [control supportsGetValue] ) [controls addObject:control];
+    }
+    context.controls = controls;
+    [self measure:"readAll.sequential" function:UVCDeviceBenchmarksReadAllSequential context:&context];
+    [self measure:"readAll.pipelined" function:UVCDeviceBenchmarksReadAllPipelined context:&context];
+  }
+
+//
+
+  - (void) runWatchSuite
+  {
+    NSTimeInterval                      duration = 1.0;
+    int                                 mode;
+
+    for ( mode = 0; mode < 2; mode++ ) {
+      NSAutoreleasePool                 *pool = [[NSAutoreleasePool alloc] init];
+      UVCDeviceBenchmarksWatchContext   context;
+      UVCController                     *controller = UVCDeviceBenchmarksCamera(0.000125, 0.0005, &context.camera);
+      NSArray                           *controls = [NSArray arrayWithObjects:[controller controlWithName:@"exposure-time-abs"], [controller controlWithName:@"white-balance-temp"], nil];
+      NSTimeInterval                    cpuTime;
+      char                              name[64];
+
+      context.latencySum = 0.0;
+      context.eventCount = 0;
+      if ( mode == 1 ) [context.camera setHasStatusInterruptEndpoint:NO];
+      [context.camera setValueChangeInterval:0.02];
+      cpuTime = UVCDeviceBenchmarksCPUTime();
+      [controller watchControls:controls pollInterval:0.01 duration:duration callback:UVCDeviceBenchmarksWatchCallback context:&context];
+      cpuTime = UVCDeviceBenchmarksCPUTime() - cpuTime;
+
+      snprintf(name, sizeof(name), "%s.latency", ( mode ? "poll" : "interrupt" ));
+      [self recordValue:( context.eventCount ? 1000.0 * context.latencySum / context.eventCount : 0.0 ) unit:"ms" higherIsBetter:NO forName:name];
+      snprintf(name, sizeof(name), "%s.cpu", ( mode ? "poll" : "interrupt" ));
+      [self recordValue:100.0 * cpuTime / duration unit:"percent" higherIsBetter:NO forName:name];
+      snprintf(name, sizeof(name), "%s.events", ( mode ? "poll" : "interrupt" ));
+      [self recordValue:context.eventCount unit:"count" higherIsBetter:YES forName:name];
+      [pool drain];
+    }
+  }
+
+//
+
+  - (void) runDaemonSuite
+  {
+    UVCDeviceBenchmarksDaemonContext  context;
+    char                              executablePath[PATH_MAX];
+    uint32_t                          executablePathLen = sizeof(executablePath);
+    NSString                          *socketPath = [NSString stringWithFormat:@"/tmp/uvc-util-benchmark-%d.sock", (int)getpid()];
+    char                              daemonOption[PATH_MAX + 16];
+    pid_t                             daemonPid;
+    int                               status, attempt;
+
+    if ( _NSGetExecutablePath(executablePath, &executablePathLen) != 0 ) return;
+    context.executablePath = executablePath;
+    context.client = nil;
+
+    snprintf(daemonOption, sizeof(daemonOption), "--daemon=%s", [socketPath fileSystemRepresentation]);
+    {
+      char *const                     argv[] = { executablePath, "--select-simulated", daemonOption, NULL };
+
+      if ( UVCDeviceBenchmarksSpawn(executablePath, argv, &daemonPid) != 0 ) {
+        fprintf(stderr, "WARNING:  unable to start daemon for benchmark\n");
+        return;
+      }
+    }
+    // Give the daemon up to 5 seconds to start listening:
+    for ( attempt = 0; attempt < 100; attempt++ ) {
+      if ( (context.client = [UVCDaemonClient daemonClientWithSocketPath:socketPath error:NULL]) ) break;
+      [NSThread sleepForTimeInterval:0.05];
+    }
+    if ( context.client ) {
+      [self measure:"request.daemon" function:UVCDeviceBenchmarksDaemonRequest context:&context];
+      [self measure:"request.exec" function:UVCDeviceBenchmarksExecRequest context:&context];
+      context.client = nil;
+    } else {
+      fprintf(stderr, "WARNING:  unable to connect to benchmark daemon\n");
+    }
+    kill(daemonPid, SIGTERM);
+    waitpid(daemonPid, &status, 0);
+  }
+
+//
+
+  - (void) runBatchSuite
+  {
+    static const char       *commands[] = { "get brightness", "set brightness=" };
+    static const char       *names[] = { "get.rate", "set.rate" };
+    UVCCommandSession       *session = [UVCCommandSession commandSession];
+    FILE                    *devNull = fopen("/dev/null", "w");
+    int                     which;
+
+    if ( ! devNull ) return;
+    [session setOutStream:devNull errStream:devNull];
+    if ( [session performCommand:kUVCCommandSelectSimulated argument:NULL] == 0 ) {
+      for ( which = 0; which < 2; which++ ) {
+        char                path[] = "/tmp/uvc-util-benchmark-XXXXXX";
+        int                 fd = mkstemp(path);
+        FILE                *file;
+        NSUInteger          i, run;
+        NSTimeInterval      best = 0.0;
+
+        if ( fd < 0 ) continue;
+        unlink(path);
+        if ( (file = fdopen(dup(fd), "w")) ) {
+          for ( i = 0; i < UVCDeviceBenchmarksBatchCount; i++ ) {
+            if ( which ) {
+              fprintf(file, "%s%lu\n", commands[which], (unsigned long)(i % 64));
+            } else {
+              fprintf(file, "%s\n", commands[which]);
+            }
+          }
+          fclose(file);
+          for ( run = 0; run < _sampleCount; run++ ) {
+            NSAutoreleasePool         *pool = [[NSAutoreleasePool alloc] init];
+            UVCCommandBatchStatistics stats;
+            NSTimeInterval            elapsed = [NSDate timeIntervalSinceReferenceDate];
+
+            lseek(fd, 0, SEEK_SET);
+            [session performCommandsFromFileDescriptor:fd exitOnErrors:NO statistics:&stats];
+            elapsed = [NSDate timeIntervalSinceReferenceDate] - elapsed;
+            if ( (run == 0) || (elapsed < best) ) best = elapsed;
+            [pool drain];
+          }
+          [self recordValue:UVCDeviceBenchmarksBatchCount / best unit:"commands/s" higherIsBetter:YES forName:names[which]];
+        }
+        close(fd);
+      }
+    }
+    fclose(devNull);
+  }
+
+//
+
+  - (void) runEnumerationSuite
+  {
+    UVCDeviceBenchmarksEnumerationContext context;
+    NSMutableArray                        *cameras = [NSMutableArray arrayWithCapacity:UVCDeviceBenchmarksEnumerationCount];
+    NSUInteger                            i;
+
+    for ( i = 0; i < UVCDeviceBenchmarksEnumerationCount; i++ ) [cameras addObject:[UVCSimulatedTransport simulatedCameraWithLatency:0.0 serviceTime:0.0]];
+    context.cameras = cameras;
+    memset(&context.filter, 0, sizeof(context.filter));
+    context.filter.flags = kUVCDeviceFilterLocationId;
+    context.filter.locationId = 0xfa000000 + UVCDeviceBenchmarksEnumerationCount / 2;
+
+    [self measure:"startup.eager" function:UVCDeviceBenchmarksEnumerationEager context:&context];
+    [self measure:"startup.lazy" function:UVCDeviceBenchmarksEnumerationLazy context:&context];
+  }
+
+//
+
+  - (void) runGroupSuite
+  {
+    NSMutableArray          *controllers = [NSMutableArray arrayWithCapacity:UVCDeviceBenchmarksGroupCount];
+    UVCControllerGroup      *group;
+    NSTimeInterval          skewSum = 0.0, skewMax = 0.0, elapsedSum = 0.0;
+    NSUInteger              i, failedCount = 0;
+
+    for ( i = 0; i < UVCDeviceBenchmarksGroupCount; i++ ) {
+      // As select-simulated-group does, each camera in a run of four is slower than the last:
+      [controllers addObject:UVCDeviceBenchmarksCamera(0.000125, 0.0005 * (1 + (i % 4)), NULL)];
+    }
+    group = [UVCControllerGroup controllerGroupWithControllers:controllers];
+    for ( i = 0; i < 20; i++ ) {
+      NSTimeInterval        skew;
+
+      if ( ! [group setControlWithName:@"brightness" fromCString:( (i & 1) ? "10" : "20" ) flags:0] ) failedCount++;
+      skew = [group writeSkewFirstIndex:NULL lastIndex:NULL];
+      skewSum += skew;
+      if ( skew > skewMax ) skewMax = skew;
+      elapsedSum += [group elapsedTime];
+    }
+    [self recordValue:1000.0 * skewSum / 20 unit:"ms" higherIsBetter:NO forName:"set.skew.mean"];
+    [self recordValue:1000.0 * skewMax unit:"ms" higherIsBetter:NO forName:"set.skew.max"];
+    [self recordValue:1000.0 * elapsedSum / 20 unit:"ms" higherIsBetter:NO forName:"set.elapsed.mean"];
+    [self recordValue:failedCount unit:"count" higherIsBetter:NO forName:"set.failed"];
+  }
+
+//
+
+  - (void) runTrajectorySuite
+  {
+    static const double     rates[] = { 30.0, 1000.0 };
+    static const char       *targets[] = { "{36000, 36000}", "{0, 0}" };
+    int                     i;
+
+    for ( i = 0; i < 2; i++ ) {
+      NSAutoreleasePool       *pool = [[NSAutoreleasePool alloc] init];
+      // A device that needs ~2.1 ms per write keeps up with 30 Hz but not 1000 Hz:
+      UVCController           *controller = UVCDeviceBenchmarksCamera(0.000125, 0.002, NULL);
+      UVCControl              *control = [controller controlWithName:@"pan-tilt-abs"];
+      UVCValue                *target = [UVCValue uvcValueWithType:[[control currentValue] valueType]];
+      UVCTrajectory           *trajectory;
+      UVCTrajectoryStatistics stats;
+      char                    name[64];
+
+      [target scanCString:targets[i] flags:0];
+      trajectory = [UVCTrajectory trajectoryWithControl:control target:target duration:0.5];
+      [trajectory setUpdateRate:rates[i]];
+      if ( [trajectory runWithStatistics:&stats] ) {
+        snprintf(name, sizeof(name), "rate%d.achieved", (int)rates[i]);
+        [self recordValue:stats.achievedRate unit:"points/s" higherIsBetter:YES forName:name];
+        snprintf(name, sizeof(name), "rate%d.dropped", (int)rates[i]);
+        [self recordValue:stats.droppedCount unit:"count" higherIsBetter:NO forName:name];
+        snprintf(name, sizeof(name), "rate%d.deadlineMisses", (int)rates[i]);
+        [self recordValue:stats.deadlineMissCount unit:"count" higherIsBetter:NO forName:name];
+        snprintf(name, sizeof(name), "rate%d.maximumLateness", (int)rates[i]);
+        [self recordValue:1000.0 * stats.maximumLateness unit:"ms" higherIsBetter:NO forName:name];
+      } else {
+        fprintf(stderr, "WARNING:  benchmark trajectory failed\n");
+      }
+      [pool drain];
+    }
+  }
+
+//
+
+  - (void) runCoalescingSuite
+  {
+    UVCSimulatedTransport         *camera;
+    UVCController                 *controller = UVCDeviceBenchmarksCamera(0.000125, 0.001, &camera);
+    UVCControl                    *control = [controller controlWithName:@"brightness"];
+    UVCDeviceBenchmarksProducer   producers[UVCDeviceBenchmarksProducerCount];
+    pthread_t                     threads[UVCDeviceBenchmarksProducerCount];
+    BOOL                          isStarted[UVCDeviceBenchmarksProducerCount];
+    UVCWriteQueueStatistics       stats;
+    NSUInteger                    i, transfers;
+    NSTimeInterval                elapsed;
+
+    if ( ! [NSThread isMultiThreaded] ) [NSThread detachNewThreadSelector:@selector(becomeMultiThreaded:) toTarget:[UVCBenchmark class] withObject:nil];
+
+    [controller setCoalescesWrites:YES];
+    [control readIntoCurrentValue];
+    transfers = [camera transferCount];
+    elapsed = [NSDate timeIntervalSinceReferenceDate];
+    for ( i = 0; i < UVCDeviceBenchmarksProducerCount; i++ ) {
+      producers[i].controller = controller;
+      producers[i].controlIndex = [UVCController controlIndexForString:@"brightness"];
+      producers[i].valueType = [[control currentValue] valueType];
+      producers[i].producerIndex = i;
+      producers[i].writeCount = 200;
+      isStarted[i] = ( pthread_create(&threads[i], NULL, UVCDeviceBenchmarksProducerMain, &producers[i]) == 0 );
+    }
+    for ( i = 0; i < UVCDeviceBenchmarksProducerCount; i++ ) {
+      if ( isStarted[i] ) pthread_join(threads[i], NULL);
+    }
+    [controller flushWrites];
+    elapsed = [NSDate timeIntervalSinceReferenceDate] - elapsed;
+    transfers = [camera transferCount] - transfers;
+
+    stats = [[controller writeQueue] statistics];
+    [self recordValue:stats.submittedCount unit:"count" higherIsBetter:NO forName:"submitted"];
+    [self recordValue:stats.coalescedCount unit:"count" higherIsBetter:YES forName:"coalesced"];
+    [self recordValue:stats.unchangedCount unit:"count" higherIsBetter:YES forName:"unchanged"];
+    [self recordValue:stats.writeCount unit:"count" higherIsBetter:NO forName:"written"];
+    [self recordValue:stats.failedCount unit:"count" higherIsBetter:NO forName:"failed"];
+    [self recordValue:transfers unit:"count" higherIsBetter:NO forName:"transfers"];
+    [self recordValue:1000.0 * elapsed unit:"ms" higherIsBetter:NO forName:"elapsed"];
+  }
+
+//
+
+  - (void) runTraceSuite
+  {
+    UVCDeviceBenchmarksTraceContext   context;
+    NSString                          *path = [NSString stringWithFormat:@"/tmp/uvc-util-benchmark-%d.trace", (int)getpid()];
+    UVCController                     *controller;
+    UVCTraceRecorder                  *recorder;
+    NSTimeInterval                    originalTime, replayTime;
+    int                               pass;
+
+    // The cost of recording (encoding and buffering, not the disk) a synchronous
+    // request to an instantaneous device:
+    memset(&context, 0, sizeof(context));
+    context.controller = UVCDeviceBenchmarksCamera(0.0, 0.0, NULL);
+    context.control = [context.controller controlWithName:@"brightness"];
+    [self measure:"read.direct" function:UVCDeviceBenchmarksTraceRead context:&context];
+    if ( ! (recorder = [UVCTraceRecorder traceRecorderForController:context.controller path:@"/dev/null"]) ) return;
+    [context.controller setTransport:recorder];
+    [self measure:"read.recorded" function:UVCDeviceBenchmarksTraceRead context:&context];
+    [context.controller setTransport:[recorder transport]];
+
+    // Record a session that probes every control and reads them all a few times:
+    controller = UVCDeviceBenchmarksCamera(0.001, 0.0001, NULL);
+    if ( ! (recorder = [UVCTraceRecorder traceRecorderForController:controller path:path]) ) {
+      fprintf(stderr, "WARNING:  unable to create benchmark trace %s\n", [path fileSystemRepresentation]);
+      return;
+    }
+    [controller setTransport:recorder];
+    originalTime = [NSDate timeIntervalSinceReferenceDate];
+    context.controls = UVCDeviceBenchmarksTraceControls(controller);
+    for ( pass = 0; pass < 10; pass++ ) [controller readControls:context.controls];
+    originalTime = [NSDate timeIntervalSinceReferenceDate] - originalTime;
+    [recorder flush];
+    [self recordValue:[recorder recordCount] unit:"count" higherIsBetter:NO forName:"records"];
+
+    // Replay the same session with the recorded latencies:
+    if ( (context.replay = [UVCTraceReplayTransport traceReplayTransportWithPath:path timing:kUVCTraceReplayTimingLatency]) ) {
+      context.controller = [context.replay controller];
+      replayTime = [NSDate timeIntervalSinceReferenceDate];
+      context.controls = UVCDeviceBenchmarksTraceControls(context.controller);
+      for ( pass = 0; pass < 10; pass++ ) [context.controller readControls:context.controls];
+      replayTime = [NSDate timeIntervalSinceReferenceDate] - replayTime;
+      [self recordValue:100.0 * fabs(replayTime - originalTime) / originalTime unit:"percent" higherIsBetter:NO forName:"replay.latency.error"];
+      [self recordValue:[context.replay divergedCount] + [context.replay missingCount] unit:"count" higherIsBetter:NO forName:"replay.unmatched"];
+
+      // ...and as fast as possible:
+      [context.replay setTiming:kUVCTraceReplayTimingNone];
+      [self measure:"replay.fast.readAll" function:UVCDeviceBenchmarksTraceReplay context:&context];
+    }
+    unlink([path fileSystemRepresentation]);
+  }
+
+//
+
+  - (void) runArenaSuite
+  {
+    UVCDeviceBenchmarksArenaContext   context;
+    UVCController                     *controller = UVCDeviceBenchmarksCamera(0.0, 0.0, NULL);
+    NSMutableArray                    *snapshotValues = [NSMutableArray array];
+    size_t                            objectBytes = 0, arenaBytes;
+    NSUInteger                        i, iMax;
+
+    memset(&context, 0, sizeof(context));
+    context.arena = [controller valueArena];
+    context.controls = UVCDeviceBenchmarksTraceControls(controller);
+    [controller readControls:context.controls];
+
+    //
+    // Memory:  a standalone UVCValue (object plus buffer) for the current value and
+    // every limit of each control, against the arena plus the views the controls
+    // hold onto it:
+    //
+    arenaBytes = malloc_size(context.arena);
+    iMax = [context.controls count];
+    for ( i = 0; i < iMax; i++ ) {
+      UVCControl                      *control = [context.controls objectAtIndex:i];
+      UVCValue                        *standalone = [UVCValue uvcValueWithType:[[control currentValue] valueType]];
+
+      objectBytes += UVCDeviceBenchmarksArenaValueBytes(control, standalone, standalone);
+      arenaBytes += UVCDeviceBenchmarksArenaValueBytes(control, [control currentValue], [control currentValue]);
+      [standalone copyValue:[control currentValue]];
+      [snapshotValues addObject:standalone];
+    }
+    [self recordValue:objectBytes unit:"bytes" higherIsBetter:NO forName:"memory.objects"];
+    [self recordValue:arenaBytes unit:"bytes" higherIsBetter:NO forName:"memory.arena"];
+    [self recordValue:[context.arena byteSize] unit:"bytes" higherIsBetter:NO forName:"memory.arena.storage"];
+
+    //
+    // Full scans, with one control changed since the snapshot so neither side can
+    // stop early:
+    //
+    context.snapshotValues = snapshotValues;
+    context.snapshot = [context.arena snapshotOfSlot:kUVCValueArenaSlotCurrent];
+    *((SInt16*)[[[controller controlWithName:@"brightness"] currentValue] valuePtr]) += 1;
+    [self measure:"diff.objects" function:UVCDeviceBenchmarksArenaDiffObjects context:&context];
+    [self measure:"diff.arena" function:UVCDeviceBenchmarksArenaDiffSweep context:&context];
+    [self measure:"rangeCheck.objects" function:UVCDeviceBenchmarksArenaRangeObjects context:&context];
+    [self measure:"rangeCheck.arena" function:UVCDeviceBenchmarksArenaRangeSweep context:&context];
+  }
+
+//
+
+  - (void) runDumpSuite
+  {
+    UVCDeviceBenchmarksDumpContext    context;
+
+    if ( ! (context.devNull = fopen("/dev/null", "w")) ) return;
+    context.controller = UVCDeviceBenchmarksCamera(0.001, 0.0001, NULL);
+    context.controls = UVCDeviceBenchmarksTraceControls(context.controller);
+
+    // One --dump of the device vs. a -S and a -g for each control:
+    [self measure:"dump.ndjson" function:UVCDeviceBenchmarksDumpNDJSON context:&context];
+    [self measure:"dump.showAndGet" function:UVCDeviceBenchmarksDumpShowAndGet context:&context];
+    fclose(context.devNull);
+  }
+
+//
+
+  - (void) runListingSuite
+  {
+    UVCDeviceBenchmarksListingContext context;
+
+    context.camera = [UVCSimulatedTransport simulatedCameraWithLatency:0.0005 serviceTime:0.0001];
+    context.descriptors = [NSData dataWithBytes:UVCDeviceBenchmarksDescriptorBlock length:sizeof(UVCDeviceBenchmarksDescriptorBlock)];
+    context.controller = [UVCController uvcControllerWithTransport:context.camera deviceName:@"Simulated UVC Camera" vendorId:0 productId:0 locationId:0 videoControlDescriptors:context.descriptors];
+
+    // -c on a newly-selected device, probing every control vs. the availability mask:
+    [self measure:"list.probe" function:UVCDeviceBenchmarksListingProbe context:&context];
+    [self measure:"list.mask" function:UVCDeviceBenchmarksListingMask context:&context];
+
+    // ...and on a device that is already resident (e.g. in the daemon):
+    [self measure:"list.mask.resident" function:UVCDeviceBenchmarksListingMaskResident context:&context];
+  }
+
+//
+
+  - (void) runCacheSuite
+  {
+    UVCDeviceBenchmarksCacheContext   context;
+    UVCController                     *controller;
+    BOOL                              wasCachingEnabled = [UVCCapabilityCache isCachingEnabled];
+
+    context.camera = [UVCSimulatedTransport simulatedCameraWithLatency:0.0005 serviceTime:0.0001];
+    context.descriptors = [NSData dataWithBytes:UVCDeviceBenchmarksDescriptorBlock length:sizeof(UVCDeviceBenchmarksDescriptorBlock)];
+    [UVCCapabilityCache setIsCachingEnabled:YES];
+
+    // Start-up with the cache flushed:  every control is probed and recorded...
+    [self measure:"controlWithName.cold" function:UVCDeviceBenchmarksCacheCold context:&context];
+
+    // ...and once the cache file has been written, with no probes at all:
+    UVCDeviceBenchmarksCachePass(&context, YES);
+    [self measure:"controlWithName.warm" function:UVCDeviceBenchmarksCacheWarm context:&context];
+
+    // Leave no cache file behind for the simulated device:
+    controller = [UVCController uvcControllerWithTransport:context.camera deviceName:@"Simulated UVC Camera" vendorId:0 productId:0 locationId:0 videoControlDescriptors:context.descriptors];
+    if ( [controller attachCapabilityCache] ) [controller invalidateCapabilityCache];
+    [UVCCapabilityCache setIsCachingEnabled:wasCachingEnabled];
+  }
+
+//
+
+  - (void) runRegistrySuite
+  {
+    UVCDeviceBenchmarksRegistryContext  context;
+    NSTimeInterval                      arrivalLatency[UVCDeviceBenchmarksRegistryEventCount];
+    NSTimeInterval                      removalLatency[UVCDeviceBenchmarksRegistryEventCount];
+    NSArray                             *handles;
+    NSUInteger                          i, changedCount = 0;
+
+    memset(&context, 0, sizeof(context));
+    context.source = [UVCSimulatedDeviceEventSource simulatedDeviceEventSource];
+    context.registry = [UVCDeviceRegistry deviceRegistryWithEventSource:context.source];
+    for ( i = 0; i < UVCDeviceBenchmarksRegistryCount; i++ ) {
+      context.cameras[i] = [UVCSimulatedTransport simulatedCameraWithLatency:0.0 serviceTime:0.0];
+      [context.source postArrivalOfDevice:UVCDeviceBenchmarksRegistryDevice(context.cameras[i], i) deviceId:i];
+    }
+    context.nextDeviceId = UVCDeviceBenchmarksRegistryCount;
+    if ( ! [context.registry start] ) return;
+    handles = [context.registry devices];
+
+    //
+    // Time from an arrival (or removal) being posted to the listeners being
+    // told, with the other devices present:
+    //
+    [context.registry addListener:UVCDeviceBenchmarksRegistryListener context:&context];
+    for ( i = 0; i < UVCDeviceBenchmarksRegistryEventCount; i++ ) {
+      NSAutoreleasePool                 *pool = [[NSAutoreleasePool alloc] init];
+      UInt64                            deviceId = context.nextDeviceId++;
+      UVCDeviceInfo                     *device = UVCDeviceBenchmarksRegistryDevice(context.cameras[i % UVCDeviceBenchmarksRegistryCount], deviceId);
+      NSTimeInterval                    postedAt = [NSDate timeIntervalSinceReferenceDate];
+
+      [context.source postArrivalOfDevice:device deviceId:deviceId];
+      arrivalLatency[i] = context.notifiedAt - postedAt;
+      postedAt = [NSDate timeIntervalSinceReferenceDate];
+      [context.source postRemovalOfDeviceId:deviceId];
+      removalLatency[i] = context.notifiedAt - postedAt;
+      [pool drain];
+    }
+    [context.registry removeListener:UVCDeviceBenchmarksRegistryListener context:&context];
+    [self recordValue:1e6 * UVCDeviceBenchmarksMedian(arrivalLatency, UVCDeviceBenchmarksRegistryEventCount) unit:"us" higherIsBetter:NO forName:"latency.arrival"];
+    [self recordValue:1e6 * UVCDeviceBenchmarksMedian(removalLatency, UVCDeviceBenchmarksRegistryEventCount) unit:"us" higherIsBetter:NO forName:"latency.removal"];
+
+    // Cost of taking in one hotplug incrementally vs. rebuilding every controller:
+    [self measure:"hotplug.incremental" function:UVCDeviceBenchmarksRegistryHotplug context:&context];
+    [self measure:"hotplug.rescan" function:UVCDeviceBenchmarksRegistryRescan context:&context];
+
+    // The devices that never left must still have the handles they started with:
+    for ( i = 0; i < UVCDeviceBenchmarksRegistryCount; i++ ) {
+      if ( [context.registry deviceWithId:i] != [handles objectAtIndex:i] ) changedCount++;
+    }
+    [self recordValue:changedCount unit:"handles" limit:0 forName:"handles.changed"];
+    [context.registry stop];
+  }
+
+//
+
+  - (void) runFaultsSuite
+  {
+    NSTimeInterval                      samples[UVCDeviceBenchmarksFaultSampleCount];
+    NSTimeInterval                      batchSamples[UVCDeviceBenchmarksFaultBatchCount];
+    int                                 policy;
+
+    //
+    // The same camera behavior, first with the old policy (no deadline, no
+    // retries) and then with the defaults:  a timeout and bounded retries:
+    //
+    for ( policy = 0; policy < 2; policy++ ) {
+      NSAutoreleasePool                 *pool = [[NSAutoreleasePool alloc] init];
+      const char                        *policyName = ( policy ? "bounded" : "unbounded" );
+      NSUInteger                        retries = ( policy ? UVCControllerDefaultMaximumRequestRetries : 0 );
+      UVCSimulatedTransport             *camera;
+      UVCController                     *controller = UVCDeviceBenchmarksCamera(0.0005, 0.0005, &camera);
+      UVCControl                        *control = [controller controlWithName:@"brightness"];
+      NSArray                           *controls = [NSArray arrayWithObjects:
+                                                        [controller controlWithName:@"brightness"],
+                                                        [controller controlWithName:@"contrast"],
+                                                        [controller controlWithName:@"saturation"],
+                                                        [controller controlWithName:@"sharpness"],
+                                                        [controller controlWithName:@"gain"],
+                                                        [controller controlWithName:@"exposure-time-abs"],
+                                                        [controller controlWithName:@"pan-tilt-abs"],
+                                                        [controller controlWithName:@"white-balance-temp"],
+                                                        nil
+                                                      ];
+      NSUInteger                        i, failedCount = 0, batchFailedCount = 0;
+      char                              name[64];
+
+      // The controls were created (and probed) while the camera behaved:
+      [controller setRequestTimeout:( policy ? UVCDeviceBenchmarksFaultRequestTimeout : 0.0 )];
+      [controller setMaximumRequestRetries:retries];
+      UVCDeviceBenchmarksInjectFaults(camera);
+      for ( i = 0; i < UVCDeviceBenchmarksFaultSampleCount; i++ ) {
+        NSTimeInterval                  startedAt = [NSDate timeIntervalSinceReferenceDate];
+
+        if ( ! [control readIntoCurrentValue] ) failedCount++;
+        samples[i] = [NSDate timeIntervalSinceReferenceDate] - startedAt;
+      }
+      for ( i = 0; i < UVCDeviceBenchmarksFaultBatchCount; i++ ) {
+        NSTimeInterval                  startedAt = [NSDate timeIntervalSinceReferenceDate];
+
+        if ( ! [controller readControls:controls] ) batchFailedCount++;
+        batchSamples[i] = [NSDate timeIntervalSinceReferenceDate] - startedAt;
+      }
+
+      snprintf(name, sizeof(name), "%s.p50", policyName);
+      [self recordValue:1e3 * UVCDeviceBenchmarksMedian(samples, UVCDeviceBenchmarksFaultSampleCount) unit:"ms" higherIsBetter:NO forName:name];
+      snprintf(name, sizeof(name), "%s.p99", policyName);
+      [self recordValue:1e3 * UVCDeviceBenchmarksPercentile(samples, UVCDeviceBenchmarksFaultSampleCount, 99.0) unit:"ms" higherIsBetter:NO forName:name];
+      snprintf(name, sizeof(name), "%s.max", policyName);
+      if ( policy ) {
+        // One request may spend each of its attempts (and the error code
+        // query that follows it) up to the deadline, plus the backoffs:
+        NSTimeInterval                  bound = 0.0, backoff = [controller requestRetryBackoff];
+
+        for ( i = 0; i <= retries; i++ ) bound += 2 * UVCDeviceBenchmarksFaultRequestTimeout;
+        for ( i = 0; i < retries; i++, backoff *= 2 ) bound += backoff;
+        [self recordValue:1e3 * samples[UVCDeviceBenchmarksFaultSampleCount - 1] unit:"ms" limit:1e3 * bound forName:name];
+      } else {
+        [self recordValue:1e3 * samples[UVCDeviceBenchmarksFaultSampleCount - 1] unit:"ms" higherIsBetter:NO forName:name];
+      }
+      snprintf(name, sizeof(name), "%s.failed", policyName);
+      [self recordValue:failedCount unit:"requests" higherIsBetter:NO forName:name];
+
+      snprintf(name, sizeof(name), "%s.batch.p50", policyName);
+      [self recordValue:1e3 * UVCDeviceBenchmarksMedian(batchSamples, UVCDeviceBenchmarksFaultBatchCount) unit:"ms" higherIsBetter:NO forName:name];
+      snprintf(name, sizeof(name), "%s.batch.max", policyName);
+      [self recordValue:1e3 * batchSamples[UVCDeviceBenchmarksFaultBatchCount - 1] unit:"ms" higherIsBetter:NO forName:name];
+      snprintf(name, sizeof(name), "%s.batch.failed", policyName);
+      [self recordValue:batchFailedCount unit:"batches" higherIsBetter:NO forName:name];
+      [pool drain];
+    }
+  }
+
+//
+
+  - (void) runSoakSuite
+  {
+    UVCDeviceBenchmarksSoakContext    context;
+    FILE                              *devNull = fopen("/dev/null", "w");
+    size_t                            blocks[2], bytes[2], resident[2];
+
+    if ( ! devNull ) return;
+    context.session = [UVCCommandSession commandSession];
+    context.cycle = 0;
+    [context.session setOutStream:devNull errStream:devNull];
+    if ( [context.session performCommand:kUVCCommandSelectSimulated argument:NULL] == 0 ) {
+      context.controls = UVCDeviceBenchmarksTraceControls([context.session targetDevice]);
+
+      //
+      // The timed cycles double as the warm-up:  every cache, pool, and reused
+      // buffer has reached its steady-state size before the first sample...
+      //
+      [self measure:"cycle" function:UVCDeviceBenchmarksSoakCycle context:&context];
+      UVCDeviceBenchmarksSoakCycle(&context, UVCDeviceBenchmarksSoakCycleCount);
+      UVCDeviceBenchmarksMemoryUsage(&blocks[0], &bytes[0], &resident[0]);
+
+      //
+      // ...so anything still growing across the second run of cycles is a leak
+      // or an unbounded structure:
+      //
+      UVCDeviceBenchmarksSoakCycle(&context, UVCDeviceBenchmarksSoakCycleCount);
+      UVCDeviceBenchmarksMemoryUsage(&blocks[1], &bytes[1], &resident[1]);
+      [self recordValue:(double)blocks[1] - (double)blocks[0] unit:"blocks" limit:UVCDeviceBenchmarksSoakBlockLimit forName:"growth.liveBlocks"];
+      [self recordValue:(double)bytes[1] - (double)bytes[0] unit:"bytes" limit:UVCDeviceBenchmarksSoakByteLimit forName:"growth.liveBytes"];
+      [self recordValue:(double)resident[1] - (double)resident[0] unit:"bytes" limit:UVCDeviceBenchmarksSoakResidentLimit forName:"growth.residentSize"];
+    }
+    fclose(devNull);
+  }
+
+@end
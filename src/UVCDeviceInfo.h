@@ -0,0 +1,155 @@
+//
+//  UVCDeviceInfo.h
+//
+//  Lightweight description of a UVC device, read from the I/O Registry
+//  without probing the device.
+//
+//  Copyright © 2016
+//  Dr. Jeffrey Frey, IT-NSS
+//  University of Delaware
+//
+// $Id$
+//
+
+#import "UVCController.h"
+
+/*!
+  @enum UVC device filter flags
+
+  Which fields of a UVCDeviceFilter must match.
+*/
+enum {
+  kUVCDeviceFilterVendorId      = 1 << 0,
+  kUVCDeviceFilterProductId     = 1 << 1,
+  kUVCDeviceFilterLocationId    = 1 << 2,
+  kUVCDeviceFilterName          = 1 << 3
+};
+
+/*!
+  @typedef UVCDeviceFilter
+
+  Selection criteria for UVC devices.  Only the fields whose flag is set in
+  flags are compared; the name comparison is case-insensitive.  The vendor,
+  product, and location ids are pushed into the I/O Registry matching
+  dictionary, so non-matching devices are never examined.
+*/
+typedef struct {
+  UInt32      flags;
+  UInt16      vendorId;
+  UInt16      productId;
+  UInt32      locationId;
+  NSString    *name;
+} UVCDeviceFilter;
+
+/*!
+  @class UVCDeviceInfo
+  @abstract Identification of a UVC device without a UVCController.
+
+  Enumerating devices with UVCController's uvcControllers creates device and
+  interface plug-ins and reads the VideoControl descriptors of every device on
+  the bus.  A UVCDeviceInfo instead holds only what the I/O Registry already
+  knows about the device:  its location, vendor and product ids, and name.
+  A device is considered UVC-capable if the registry shows it has a
+  VideoControl interface.
+
+  The expensive probe is deferred until the controller method is first
+  called, at which point the UVCController is created and retained by the
+  receiver.
+*/
+@interface UVCDeviceInfo : NSObject
+{
+  io_service_t        _ioService;
+  id<UVCTransport>    _transport;
+  NSString            *_deviceName;
+  UInt32              _locationId;
+  UInt16              _vendorId, _productId;
+  UVCController       *_controller;
+  BOOL                _hasProbed;
+}
+
+/*!
+  @method deviceInfosMatchingFilter:
+
+  Returns an array of UVCDeviceInfo for every UVC-capable device in the I/O
+  Registry that matches filter (all such devices if filter is NULL), in
+  registry order.  Returns nil if there are none.
+*/
++ (NSArray*) deviceInfosMatchingFilter:(const UVCDeviceFilter*)filter;
+
+/*!
+  @method deviceInfos:matchingFilter:
+
+  Returns the members of the array of UVCDeviceInfo deviceInfos that match
+  filter, in order.
+*/
++ (NSArray*) deviceInfos:(NSArray*)deviceInfos matchingFilter:(const UVCDeviceFilter*)filter;
+
+/*!
+  @method deviceInfoWithService:
+
+  Returns an autoreleased instance describing the device ioService, or nil if
+  the registry does not show a VideoControl interface on it.  The receiver
+  adds its own reference to ioService.
+*/
++ (UVCDeviceInfo*) deviceInfoWithService:(io_service_t)ioService;
+
+/*!
+  @method deviceInfoWithTransport:deviceName:vendorId:productId:locationId:
+
+  Returns an autoreleased instance describing a device reached through
+  transport (e.g. a UVCSimulatedTransport).  Its controller is created with
+  UVCController's uvcControllerWithTransport:deviceName:vendorId:productId:locationId:.
+*/
++ (UVCDeviceInfo*) deviceInfoWithTransport:(id<UVCTransport>)transport deviceName:(NSString*)deviceName vendorId:(UInt16)vendorId productId:(UInt16)productId locationId:(UInt32)locationId;
+
+/*!
+  @method matchesFilter:
+
+  Returns YES if the receiver satisfies filter (or filter is NULL).
+*/
+- (BOOL) matchesFilter:(const UVCDeviceFilter*)filter;
+
+/*!
+  @method deviceName
+
+  Returns the name of the USB device.
+*/
+- (NSString*) deviceName;
+
+/*!
+  @method locationId
+
+  Returns the 32-bit USB locationId of the device.
+*/
+- (UInt32) locationId;
+
+/*!
+  @method vendorId
+
+  Returns the 16-bit USB vendor identifier of the device.
+*/
+- (UInt16) vendorId;
+
+/*!
+  @method productId
+
+  Returns the 16-bit USB product identifier of the device.
+*/
+- (UInt16) productId;
+
+/*!
+  @method hasProbed
+
+  Returns YES if the controller method has already been called.
+*/
+- (BOOL) hasProbed;
+
+/*!
+  @method controller
+
+  Returns the UVCController for the device, creating it on the first call.
+  Returns nil if the device turned out not to be UVC-compliant.
+*/
+- (UVCController*) controller;
+
+@end
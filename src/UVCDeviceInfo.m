@@ -0,0 +1,324 @@
+//
+//  UVCDeviceInfo.m
+//
+//  Lightweight description of a UVC device, read from the I/O Registry
+//  without probing the device.
+//
+//  Copyright © 2016
+//  Dr. Jeffrey Frey, IT-NSS
+//  University of Delaware
+//
+// $Id$
+//
+
+#import "UVCDeviceInfo.h"
+
+//
+// Interface class/subclass of a UVC VideoControl interface:
+//
+#define UVCDeviceInfoVideoInterfaceClass      0x0E
+#define UVCDeviceInfoVideoControlSubClass     0x01
+
+static void
+UVCDeviceInfoGetNumberProperty(
+  io_service_t      ioService,
+  CFStringRef       key,
+  CFNumberType      numberType,
+  void              *value
+)
+{
+  CFNumberRef       numberObj = IORegistryEntrySearchCFProperty(ioService, kIOUSBPlane, key, kCFAllocatorDefault, 0);
+
+  if ( numberObj ) {
+    CFNumberGetValue(numberObj, numberType, value);
+    CFRelease(numberObj);
+  }
+}
+
+//
+
+/*!
+  @function UVCDeviceInfoHasVideoControlInterface
+
+  Returns YES if one of the registry children of ioService is a USB interface
+  of the video class and VideoControl subclass.  Only registry properties are
+  read; no plug-ins are created.
+*/
+static BOOL
+UVCDeviceInfoHasVideoControlInterface(
+  io_service_t      ioService
+)
+{
+  io_iterator_t     childIter;
+  io_registry_entry_t child;
+  BOOL              isVideoControl = NO;
+
+  if ( IORegistryEntryGetChildIterator(ioService, kIOServicePlane, &childIter) != KERN_SUCCESS ) return NO;
+  while ( ! isVideoControl && (child = IOIteratorNext(childIter)) ) {
+    CFNumberRef     classObj = IORegistryEntryCreateCFProperty(child, CFSTR(kUSBInterfaceClass), kCFAllocatorDefault, 0);
+    CFNumberRef     subClassObj = IORegistryEntryCreateCFProperty(child, CFSTR(kUSBInterfaceSubClass), kCFAllocatorDefault, 0);
+    SInt32          interfaceClass = -1, interfaceSubClass = -1;
+
+    if ( classObj ) {
+      CFNumberGetValue(classObj, kCFNumberSInt32Type, &interfaceClass);
+      CFRelease(classObj);
+    }
+    if ( subClassObj ) {
+      CFNumberGetValue(subClassObj, kCFNumberSInt32Type, &interfaceSubClass);
+      CFRelease(subClassObj);
+    }
+    isVideoControl = ( (interfaceClass == UVCDeviceInfoVideoInterfaceClass) && (interfaceSubClass == UVCDeviceInfoVideoControlSubClass) );
+    IOObjectRelease(child);
+  }
+  IOObjectRelease(childIter);
+  return isVideoControl;
+}
+
+//
+#if 0
+#pragma mark -
+#endif
+//
+
+@interface UVCDeviceInfo(UVCDeviceInfoPrivate)
+
+- (id) initWithService:(io_service_t)ioService;
+- (id) initWithTransport:(id<UVCTransport>)transport deviceName:(NSString*)deviceName vendorId:(UInt16)vendorId productId:(UInt16)productId locationId:(UInt32)locationId;
+
+@end
+
+@implementation UVCDeviceInfo(UVCDeviceInfoPrivate)
+
+  - (id) initWithService:(io_service_t)ioService
+  {
+    if ( (self = [super init]) ) {
+      io_name_t       nameBuffer;
+
+      _ioService = ioService;
+      IOObjectRetain(_ioService);
+      _vendorId = _productId = -1;
+      _locationId = -1;
+      UVCDeviceInfoGetNumberProperty(ioService, CFSTR(kUSBVendorID), kCFNumberSInt16Type, &_vendorId);
+      UVCDeviceInfoGetNumberProperty(ioService, CFSTR(kUSBProductID), kCFNumberSInt16Type, &_productId);
+      UVCDeviceInfoGetNumberProperty(ioService, CFSTR(kUSBDevicePropertyLocationID), kCFNumberSInt32Type, &_locationId);
+      if ( IORegistryEntryGetName(ioService, nameBuffer) == KERN_SUCCESS ) {
+        _deviceName = [[NSString alloc] initWithUTF8String:nameBuffer];
+      }
+    }
+    return self;
+  }
+
+//
+
+  - (id) initWithTransport:(id<UVCTransport>)transport
+    deviceName:(NSString*)deviceName
+    vendorId:(UInt16)vendorId
+    productId:(UInt16)productId
+    locationId:(UInt32)locationId
+  {
+    if ( (self = [super init]) ) {
+      _transport = [transport retain];
+      _deviceName = [deviceName copy];
+      _vendorId = vendorId;
+      _productId = productId;
+      _locationId = locationId;
+    }
+    return self;
+  }
+
+@end
+
+//
+#if 0
+#pragma mark -
+#endif
+//
+
+@implementation UVCDeviceInfo
+
+  + (NSArray*) deviceInfosMatchingFilter:(const UVCDeviceFilter*)filter
+  {
+    NSMutableArray          *deviceInfos = nil;
+    CFMutableDictionaryRef  matchingDict = IOServiceMatching(kIOUSBDeviceClassName);
+    io_iterator_t           deviceIter;
+
+    //
+    // Let the I/O Kit discard devices by id rather than examining each of
+    // them here:
+    //
+    if ( filter && (filter->flags & (kUVCDeviceFilterVendorId | kUVCDeviceFilterProductId | kUVCDeviceFilterLocationId)) ) {
+      CFMutableDictionaryRef  propertiesDict = CFDictionaryCreateMutable(kCFAllocatorDefault, 3,
+                                                  &kCFTypeDictionaryKeyCallBacks,
+                                                  &kCFTypeDictionaryValueCallBacks);
+      CFNumberRef             numberObj;
+
+      if ( filter->flags & kUVCDeviceFilterVendorId ) {
+        numberObj = CFNumberCreate(kCFAllocatorDefault, kCFNumberSInt16Type, &filter->vendorId);
+        CFDictionarySetValue(propertiesDict, CFSTR(kUSBVendorID), numberObj);
+        CFRelease(numberObj);
+      }
+      if ( filter->flags & kUVCDeviceFilterProductId ) {
+        numberObj = CFNumberCreate(kCFAllocatorDefault, kCFNumberSInt16Type, &filter->productId);
+        CFDictionarySetValue(propertiesDict, CFSTR(kUSBProductID), numberObj);
+        CFRelease(numberObj);
+      }
+      if ( filter->flags & kUVCDeviceFilterLocationId ) {
+        numberObj = CFNumberCreate(kCFAllocatorDefault, kCFNumberSInt32Type, &filter->locationId);
+        CFDictionarySetValue(propertiesDict, CFSTR(kUSBDevicePropertyLocationID), numberObj);
+        CFRelease(numberObj);
+      }
+      CFDictionarySetValue(matchingDict, CFSTR(kIOPropertyMatchKey), propertiesDict);
+      CFRelease(propertiesDict);
+    }
+
+    // The matching dictionary is consumed by this call:
+    if ( IOServiceGetMatchingServices(kIOMainPortDefault, matchingDict, &deviceIter) == KERN_SUCCESS ) {
+      io_service_t          device;
+
+      while ( (device = IOIteratorNext(deviceIter)) ) {
+        if ( UVCDeviceInfoHasVideoControlInterface(device) ) {
+          UVCDeviceInfo     *deviceInfo = [[UVCDeviceInfo alloc] initWithService:device];
+
+          if ( deviceInfo ) {
+            if ( [deviceInfo matchesFilter:filter] ) {
+              if ( ! deviceInfos ) deviceInfos = [[NSMutableArray alloc] init];
+              [deviceInfos addObject:deviceInfo];
+            }
+            [deviceInfo release];
+          }
+        }
+        IOObjectRelease(device);
+      }
+      IOObjectRelease(deviceIter);
+    }
+    if ( deviceInfos ) {
+      NSArray               *outArray = [deviceInfos copy];
+
+      [deviceInfos release];
+      return [outArray autorelease];
+    }
+    return nil;
+  }
+
+//
+
+  + (NSArray*) deviceInfos:(NSArray*)deviceInfos
+    matchingFilter:(const UVCDeviceFilter*)filter
+  {
+    NSMutableArray      *matches = [NSMutableArray array];
+    NSEnumerator        *eDeviceInfos = [deviceInfos objectEnumerator];
+    UVCDeviceInfo       *deviceInfo;
+
+    while ( (deviceInfo = [eDeviceInfos nextObject]) ) {
+      if ( [deviceInfo matchesFilter:filter] ) [matches addObject:deviceInfo];
+    }
+    return matches;
+  }
+
+//
+
+  + (UVCDeviceInfo*) deviceInfoWithService:(io_service_t)ioService
+  {
+    if ( ! UVCDeviceInfoHasVideoControlInterface(ioService) ) return nil;
+    return [[[UVCDeviceInfo alloc] initWithService:ioService] autorelease];
+  }
+
+//
+
+  + (UVCDeviceInfo*) deviceInfoWithTransport:(id<UVCTransport>)transport
+    deviceName:(NSString*)deviceName
+    vendorId:(UInt16)vendorId
+    productId:(UInt16)productId
+    locationId:(UInt32)locationId
+  {
+    return [[[UVCDeviceInfo alloc] initWithTransport:transport deviceName:deviceName vendorId:vendorId productId:productId locationId:locationId] autorelease];
+  }
+
+//
+
+  - (void) dealloc
+  {
+    if ( _controller ) [_controller release];
+    if ( _deviceName ) [_deviceName release];
+    if ( _transport ) [_transport release];
+    if ( _ioService ) IOObjectRelease(_ioService);
+    [super dealloc];
+  }
+
+//
+
+  - (NSString*) description
+  {
+    return [NSString stringWithFormat:@"UVCDeviceInfo@%p { name: %@; vendor-id: 0x%04hx; product-id: 0x%04hx; location-id: 0x%08x%s }",
+                        self,
+                        _deviceName,
+                        _vendorId,
+                        _productId,
+                        _locationId,
+                        (_hasProbed ? "; probed" : "")
+                      ];
+  }
+
+//
+
+  - (BOOL) matchesFilter:(const UVCDeviceFilter*)filter
+  {
+    if ( ! filter ) return YES;
+    if ( (filter->flags & kUVCDeviceFilterVendorId) && (filter->vendorId != _vendorId) ) return NO;
+    if ( (filter->flags & kUVCDeviceFilterProductId) && (filter->productId != _productId) ) return NO;
+    if ( (filter->flags & kUVCDeviceFilterLocationId) && (filter->locationId != _locationId) ) return NO;
+    if ( (filter->flags & kUVCDeviceFilterName) && (! _deviceName || ([filter->name compare:_deviceName options:NSCaseInsensitiveSearch] != NSOrderedSame)) ) return NO;
+    return YES;
+  }
+
+//
+
+  - (NSString*) deviceName
+  {
+    return _deviceName;
+  }
+
+//
+
+  - (UInt32) locationId
+  {
+    return _locationId;
+  }
+
+//
+
+  - (UInt16) vendorId
+  {
+    return _vendorId;
+  }
+
+//
+
+  - (UInt16) productId
+  {
+    return _productId;
+  }
+
+//
+
+  - (BOOL) hasProbed
+  {
+    return _hasProbed;
+  }
+
+//
+
+  - (UVCController*) controller
+  {
+    if ( ! _hasProbed ) {
+      if ( _transport ) {
+        _controller = [[UVCController uvcControllerWithTransport:_transport deviceName:_deviceName vendorId:_vendorId productId:_productId locationId:_locationId] retain];
+      } else if ( _ioService ) {
+        _controller = [[UVCController uvcControllerWithService:_ioService] retain];
+      }
+      _hasProbed = YES;
+    }
+    return _controller;
+  }
+
+@end
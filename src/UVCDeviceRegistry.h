@@ -0,0 +1,249 @@
+//
+//  UVCDeviceRegistry.h
+//
+//  Set of present UVC devices kept current by arrival and removal
+//  notifications.
+//
+//  Copyright © 2016
+//  Dr. Jeffrey Frey, IT-NSS
+//  University of Delaware
+//
+// $Id$
+//
+
+#import "UVCDeviceInfo.h"
+
+#include <pthread.h>
+
+@class UVCDeviceRegistry;
+
+/*!
+  @typedef UVCDeviceRegistryEvent
+
+  Changes reported to the listeners of a UVCDeviceRegistry:
+
+    - kUVCDeviceRegistryEventArrival:  the device was added to the registry;
+      its controller has been created
+    - kUVCDeviceRegistryEventRemoval:  the device was removed from the
+      registry; its controller's interface has been closed
+*/
+typedef enum {
+  kUVCDeviceRegistryEventArrival    = 0,
+  kUVCDeviceRegistryEventRemoval    = 1
+} UVCDeviceRegistryEvent;
+
+/*!
+  @typedef UVCDeviceRegistryCallback
+
+  Function called for each device added to or removed from a registry.  It is
+  called on the thread that delivered the notification, after the registry
+  has been updated and without its lock held.
+*/
+typedef void (*UVCDeviceRegistryCallback)(void *context, UVCDeviceRegistry *registry, UVCDeviceRegistryEvent event, UVCDeviceInfo *device);
+
+/*!
+  @protocol UVCDeviceEventSource
+  @abstract Reports UVC device arrivals and removals to a UVCDeviceRegistry.
+
+  Each device is identified by a 64-bit id that the source chooses; the id
+  must stay the same from a device's arrival until its removal and must not
+  be reused for another device while the first is present.
+*/
+@protocol UVCDeviceEventSource <NSObject>
+
+/*!
+  @method startWithRegistry:
+
+  Begin reporting to registry (which is not retained):  every device already
+  present is reported with deviceDidArrive:deviceId:, then subsequent
+  arrivals and removals as they happen.  Returns NO if notifications could
+  not be arranged.
+*/
+- (BOOL) startWithRegistry:(UVCDeviceRegistry*)registry;
+
+/*!
+  @method stop
+
+  Stop reporting; the registry is no longer referenced.
+*/
+- (void) stop;
+
+@end
+
+/*!
+  @class UVCIOKitDeviceEventSource
+  @abstract UVCDeviceEventSource driven by I/O Kit matching notifications.
+
+  A device is reported when its VideoControl interface is published (by then
+  the I/O Registry shows everything UVCDeviceInfo reads) and removed when
+  that interface is terminated; the interface's registry entry id is the
+  device id.  Notifications are delivered through the run loop of the thread
+  that called startWithRegistry:, in its default mode.
+*/
+@interface UVCIOKitDeviceEventSource : NSObject <UVCDeviceEventSource>
+{
+  UVCDeviceRegistry       *_registry;
+  IONotificationPortRef   _notificationPort;
+  CFRunLoopRef            _runLoop;
+  io_iterator_t           _arrivalIterator;
+  io_iterator_t           _removalIterator;
+}
+
+/*!
+  @method ioKitDeviceEventSource
+
+  Returns an autoreleased, stopped instance of the class.
+*/
++ (UVCIOKitDeviceEventSource*) ioKitDeviceEventSource;
+
+@end
+
+/*!
+  @class UVCSimulatedDeviceEventSource
+  @abstract UVCDeviceEventSource fed by explicit calls, e.g. for simulated devices.
+
+  Arrivals and removals are posted by any thread and delivered to the
+  registry synchronously, on that thread.  Devices posted while the source
+  is stopped are remembered and reported as present when it starts.
+*/
+@interface UVCSimulatedDeviceEventSource : NSObject <UVCDeviceEventSource>
+{
+  pthread_mutex_t         _lock;
+  UVCDeviceRegistry       *_registry;
+  NSMutableDictionary     *_devices;
+}
+
+/*!
+  @method simulatedDeviceEventSource
+
+  Returns an autoreleased, stopped instance of the class with no devices.
+*/
++ (UVCSimulatedDeviceEventSource*) simulatedDeviceEventSource;
+
+/*!
+  @method postArrivalOfDevice:deviceId:
+
+  Report that device (e.g. from UVCDeviceInfo's
+  deviceInfoWithTransport:deviceName:vendorId:productId:locationId:) is now
+  present with the given id.
+*/
+- (void) postArrivalOfDevice:(UVCDeviceInfo*)device deviceId:(UInt64)deviceId;
+
+/*!
+  @method postRemovalOfDeviceId:
+
+  Report that the device with the given id is gone.
+*/
+- (void) postRemovalOfDeviceId:(UInt64)deviceId;
+
+@end
+
+/*!
+  @class UVCDeviceRegistry
+  @abstract The UVC devices that are present, maintained incrementally.
+
+  Rather than enumerating (and probing) the whole bus again to notice a
+  change, the registry is told of each arrival and removal by its
+  UVCDeviceEventSource and touches only that device:  an arriving device has
+  its UVCController created, a departing one has its interface closed and is
+  dropped.  Every other device keeps the same UVCDeviceInfo (and controller)
+  for as long as it is present, so callers may hold on to them.  A device
+  whose controller cannot be created is not added.
+
+  Listeners are called after each change.  All methods may be called from
+  any thread.
+*/
+@interface UVCDeviceRegistry : NSObject
+{
+  pthread_mutex_t         _lock;
+  id<UVCDeviceEventSource> _source;
+  NSMutableArray          *_devices;
+  NSMutableDictionary     *_devicesById;
+  void                    *_listeners;
+  NSUInteger              _listenerCount, _listenerCapacity;
+  BOOL                    _isStarted;
+}
+
+/*!
+  @method deviceRegistryWithEventSource:
+
+  Returns an autoreleased, empty registry that will be maintained by source
+  once started.
+*/
++ (UVCDeviceRegistry*) deviceRegistryWithEventSource:(id<UVCDeviceEventSource>)source;
+
+/*!
+  @method eventSource
+
+  Returns the receiver's event source.
+*/
+- (id<UVCDeviceEventSource>) eventSource;
+
+/*!
+  @method start
+
+  Start the event source; the devices already present are added (and the
+  listeners called for each) before this method returns.  Returns NO if the
+  source could not be started.
+*/
+- (BOOL) start;
+
+/*!
+  @method stop
+
+  Stop the event source.  The devices present remain in the receiver.
+*/
+- (void) stop;
+
+/*!
+  @method devices
+
+  Returns the UVCDeviceInfo of every device present, in order of arrival.
+*/
+- (NSArray*) devices;
+
+/*!
+  @method controllers
+
+  Returns the UVCController of every device present, in order of arrival.
+*/
+- (NSArray*) controllers;
+
+/*!
+  @method deviceWithId:
+
+  Returns the present device with the given id, or nil.
+*/
+- (UVCDeviceInfo*) deviceWithId:(UInt64)deviceId;
+
+/*!
+  @method addListener:context:
+
+  Call callback with context for every subsequent arrival and removal.
+*/
+- (void) addListener:(UVCDeviceRegistryCallback)callback context:(void*)context;
+
+/*!
+  @method removeListener:context:
+
+  Stop calling callback with context.
+*/
+- (void) removeListener:(UVCDeviceRegistryCallback)callback context:(void*)context;
+
+/*!
+  @method deviceDidArrive:deviceId:
+
+  For event sources:  add device under deviceId, creating its controller.
+  Nothing happens if a device with that id is already present.
+*/
+- (void) deviceDidArrive:(UVCDeviceInfo*)device deviceId:(UInt64)deviceId;
+
+/*!
+  @method deviceDidDisappear:
+
+  For event sources:  remove the device with the given id, closing its
+  controller's interface.  Nothing happens if no such device is present.
+*/
+- (void) deviceDidDisappear:(UInt64)deviceId;
+
+@end
@@ -0,0 +1,593 @@
+//
+//  UVCDeviceRegistry.m
+//
+//  Set of present UVC devices kept current by arrival and removal
+//  notifications.
+//
+//  Copyright © 2016
+//  Dr. Jeffrey Frey, IT-NSS
+//  University of Delaware
+//
+// $Id$
+//
+
+#import "UVCDeviceRegistry.h"
+#import "UVCController.h"
+
+//
+// Interface class/subclass of a UVC VideoControl interface:
+//
+#define UVCDeviceRegistryVideoInterfaceClass    0x0E
+#define UVCDeviceRegistryVideoControlSubClass   0x01
+
+/*!
+  @typedef UVCDeviceRegistryListener
+
+  A callback and its context, as registered with addListener:context:.
+*/
+typedef struct {
+  UVCDeviceRegistryCallback   callback;
+  void                        *context;
+} UVCDeviceRegistryListener;
+
+//
+#if 0
+#pragma mark -
+#endif
+//
+
+/*!
+  @function UVCIOKitDeviceEventSourceMatching
+
+  Returns a new matching dictionary for USB interfaces of the video class and
+  VideoControl subclass.
+*/
+static CFMutableDictionaryRef
+UVCIOKitDeviceEventSourceMatching(void)
+{
+  CFMutableDictionaryRef  matchingDict = IOServiceMatching(kIOUSBInterfaceClassName);
+  SInt32                  value;
+  CFNumberRef             numberObj;
+
+  if ( matchingDict ) {
+    value = UVCDeviceRegistryVideoInterfaceClass;
+    numberObj = CFNumberCreate(kCFAllocatorDefault, kCFNumberSInt32Type, &value);
+    CFDictionarySetValue(matchingDict, CFSTR(kUSBInterfaceClass), numberObj);
+    CFRelease(numberObj);
+    value = UVCDeviceRegistryVideoControlSubClass;
+    numberObj = CFNumberCreate(kCFAllocatorDefault, kCFNumberSInt32Type, &value);
+    CFDictionarySetValue(matchingDict, CFSTR(kUSBInterfaceSubClass), numberObj);
+    CFRelease(numberObj);
+  }
+  return matchingDict;
+}
+
+//
+
+@interface UVCIOKitDeviceEventSource(UVCIOKitDeviceEventSourcePrivate)
+
+/*!
+  @method interfacesDidArrive:
+
+  Report the device of each VideoControl interface in iterator to the
+  registry (which also re-arms the notification).
+*/
+- (void) interfacesDidArrive:(io_iterator_t)iterator;
+
+/*!
+  @method interfacesDidTerminate:
+
+  Report the removal of the device of each VideoControl interface in
+  iterator to the registry (which also re-arms the notification).
+*/
+- (void) interfacesDidTerminate:(io_iterator_t)iterator;
+
+@end
+
+//
+
+static void
+UVCIOKitDeviceEventSourceArrival(
+  void            *refCon,
+  io_iterator_t   iterator
+)
+{
+  [(UVCIOKitDeviceEventSource*)refCon interfacesDidArrive:iterator];
+}
+
+static void
+UVCIOKitDeviceEventSourceRemoval(
+  void            *refCon,
+  io_iterator_t   iterator
+)
+{
+  [(UVCIOKitDeviceEventSource*)refCon interfacesDidTerminate:iterator];
+}
+
+//
+
+@implementation UVCIOKitDeviceEventSource(UVCIOKitDeviceEventSourcePrivate)
+
+  - (void) interfacesDidArrive:(io_iterator_t)iterator
+  {
+    io_service_t      interface;
+
+    while ( (interface = IOIteratorNext(iterator)) ) {
+      @autoreleasepool {
+        io_registry_entry_t device;
+        uint64_t          entryId;
+
+        if ( (IORegistryEntryGetRegistryEntryID(interface, &entryId) == KERN_SUCCESS) && (IORegistryEntryGetParentEntry(interface, kIOServicePlane, &device) == KERN_SUCCESS) ) {
+          UVCDeviceInfo   *deviceInfo = [UVCDeviceInfo deviceInfoWithService:device];
+
+          if ( deviceInfo && _registry ) [_registry deviceDidArrive:deviceInfo deviceId:entryId];
+          IOObjectRelease(device);
+        }
+      }
+      IOObjectRelease(interface);
+    }
+  }
+
+//
+
+  - (void) interfacesDidTerminate:(io_iterator_t)iterator
+  {
+    io_service_t      interface;
+
+    while ( (interface = IOIteratorNext(iterator)) ) {
+      uint64_t        entryId;
+
+      if ( (IORegistryEntryGetRegistryEntryID(interface, &entryId) == KERN_SUCCESS) && _registry ) [_registry deviceDidDisappear:entryId];
+      IOObjectRelease(interface);
+    }
+  }
+
+@end
+
+//
+
+@implementation UVCIOKitDeviceEventSource
+
+  + (UVCIOKitDeviceEventSource*) ioKitDeviceEventSource
+  {
+    return [[[UVCIOKitDeviceEventSource alloc] init] autorelease];
+  }
+
+//
+
+  - (void) dealloc
+  {
+    [self stop];
+    [super dealloc];
+  }
+
+//
+
+  - (NSString*) description
+  {
+    return [NSString stringWithFormat:@"UVCIOKitDeviceEventSource@%p { is-started: %s }",
+                        self,
+                        (_notificationPort ? "yes" : "no")
+                      ];
+  }
+
+//
+
+  - (BOOL) startWithRegistry:(UVCDeviceRegistry*)registry
+  {
+    CFMutableDictionaryRef  matchingDict;
+
+    if ( _notificationPort ) return NO;
+    if ( ! (_notificationPort = IONotificationPortCreate(kIOMainPortDefault)) ) return NO;
+    _registry = registry;
+    _runLoop = (CFRunLoopRef)CFRetain(CFRunLoopGetCurrent());
+    CFRunLoopAddSource(_runLoop, IONotificationPortGetRunLoopSource(_notificationPort), kCFRunLoopDefaultMode);
+
+    //
+    // Each matching dictionary is consumed by the call it is passed to.  The
+    // terminations are armed first so a device that goes away while the
+    // present ones are being reported is not missed:
+    //
+    if ( (matchingDict = UVCIOKitDeviceEventSourceMatching()) && (IOServiceAddMatchingNotification(_notificationPort, kIOTerminatedNotification, matchingDict, UVCIOKitDeviceEventSourceRemoval, self, &_removalIterator) == KERN_SUCCESS) ) {
+      [self interfacesDidTerminate:_removalIterator];
+      if ( (matchingDict = UVCIOKitDeviceEventSourceMatching()) && (IOServiceAddMatchingNotification(_notificationPort, kIOFirstMatchNotification, matchingDict, UVCIOKitDeviceEventSourceArrival, self, &_arrivalIterator) == KERN_SUCCESS) ) {
+        // Iterating the initial matches reports the devices present and arms the notification:
+        [self interfacesDidArrive:_arrivalIterator];
+        return YES;
+      }
+    }
+    [self stop];
+    return NO;
+  }
+
+//
+
+  - (void) stop
+  {
+    if ( _arrivalIterator ) {
+      IOObjectRelease(_arrivalIterator);
+      _arrivalIterator = 0;
+    }
+    if ( _removalIterator ) {
+      IOObjectRelease(_removalIterator);
+      _removalIterator = 0;
+    }
+    if ( _notificationPort ) {
+      CFRunLoopRemoveSource(_runLoop, IONotificationPortGetRunLoopSource(_notificationPort), kCFRunLoopDefaultMode);
+      IONotificationPortDestroy(_notificationPort);
+      _notificationPort = NULL;
+    }
+    if ( _runLoop ) {
+      CFRelease(_runLoop);
+      _runLoop = NULL;
+    }
+    _registry = nil;
+  }
+
+@end
+
+//
+#if 0
+#pragma mark -
+#endif
+//
+
+@implementation UVCSimulatedDeviceEventSource
+
+  + (UVCSimulatedDeviceEventSource*) simulatedDeviceEventSource
+  {
+    return [[[UVCSimulatedDeviceEventSource alloc] init] autorelease];
+  }
+
+//
+
+  - (id) init
+  {
+    if ( (self = [super init]) ) {
+      pthread_mutex_init(&_lock, NULL);
+      _devices = [[NSMutableDictionary alloc] init];
+    }
+    return self;
+  }
+
+//
+
+  - (void) dealloc
+  {
+    if ( _devices ) [_devices release];
+    pthread_mutex_destroy(&_lock);
+    [super dealloc];
+  }
+
+//
+
+  - (NSString*) description
+  {
+    return [NSString stringWithFormat:@"UVCSimulatedDeviceEventSource@%p { device-count: %lu; is-started: %s }",
+                        self,
+                        (unsigned long)[_devices count],
+                        (_registry ? "yes" : "no")
+                      ];
+  }
+
+//
+
+  - (BOOL) startWithRegistry:(UVCDeviceRegistry*)registry
+  {
+    NSArray             *deviceIds;
+    NSEnumerator        *eDeviceIds;
+    NSNumber            *deviceId;
+
+    pthread_mutex_lock(&_lock);
+    if ( _registry ) {
+      pthread_mutex_unlock(&_lock);
+      return NO;
+    }
+    _registry = registry;
+    deviceIds = [[[_devices allKeys] sortedArrayUsingSelector:@selector(compare:)] retain];
+    pthread_mutex_unlock(&_lock);
+
+    eDeviceIds = [deviceIds objectEnumerator];
+    while ( (deviceId = [eDeviceIds nextObject]) ) {
+      UVCDeviceInfo     *device;
+
+      pthread_mutex_lock(&_lock);
+      device = [[_devices objectForKey:deviceId] retain];
+      pthread_mutex_unlock(&_lock);
+      if ( device ) {
+        [registry deviceDidArrive:device deviceId:[deviceId unsignedLongLongValue]];
+        [device release];
+      }
+    }
+    [deviceIds release];
+    return YES;
+  }
+
+//
+
+  - (void) stop
+  {
+    pthread_mutex_lock(&_lock);
+    _registry = nil;
+    pthread_mutex_unlock(&_lock);
+  }
+
+//
+
+  - (void) postArrivalOfDevice:(UVCDeviceInfo*)device
+    deviceId:(UInt64)deviceId
+  {
+    UVCDeviceRegistry   *registry;
+
+    pthread_mutex_lock(&_lock);
+    [_devices setObject:device forKey:[NSNumber numberWithUnsignedLongLong:deviceId]];
+    registry = _registry;
+    pthread_mutex_unlock(&_lock);
+    if ( registry ) [registry deviceDidArrive:device deviceId:deviceId];
+  }
+
+//
+
+  - (void) postRemovalOfDeviceId:(UInt64)deviceId
+  {
+    UVCDeviceRegistry   *registry;
+
+    pthread_mutex_lock(&_lock);
+    [_devices removeObjectForKey:[NSNumber numberWithUnsignedLongLong:deviceId]];
+    registry = _registry;
+    pthread_mutex_unlock(&_lock);
+    if ( registry ) [registry deviceDidDisappear:deviceId];
+  }
+
+@end
+
+//
+#if 0
+#pragma mark -
+#endif
+//
+
+@interface UVCDeviceRegistry(UVCDeviceRegistryPrivate)
+
+- (id) initWithEventSource:(id<UVCDeviceEventSource>)source;
+
+/*!
+  @method notifyListenersOfEvent:device:
+
+  Call every listener (a copy of the list is taken under the lock, so a
+  listener may add or remove listeners).
+*/
+- (void) notifyListenersOfEvent:(UVCDeviceRegistryEvent)event device:(UVCDeviceInfo*)device;
+
+@end
+
+@implementation UVCDeviceRegistry(UVCDeviceRegistryPrivate)
+
+  - (id) initWithEventSource:(id<UVCDeviceEventSource>)source
+  {
+    if ( (self = [super init]) ) {
+      pthread_mutex_init(&_lock, NULL);
+      _source = [source retain];
+      _devices = [[NSMutableArray alloc] init];
+      _devicesById = [[NSMutableDictionary alloc] init];
+    }
+    return self;
+  }
+
+//
+
+  - (void) notifyListenersOfEvent:(UVCDeviceRegistryEvent)event
+    device:(UVCDeviceInfo*)device
+  {
+    NSUInteger                  i, listenerCount;
+
+    pthread_mutex_lock(&_lock);
+    listenerCount = _listenerCount;
+
+    UVCDeviceRegistryListener   listeners[listenerCount ? listenerCount : 1];
+
+    if ( listenerCount ) memcpy(listeners, _listeners, listenerCount * sizeof(UVCDeviceRegistryListener));
+    pthread_mutex_unlock(&_lock);
+    for ( i = 0; i < listenerCount; i++ ) listeners[i].callback(listeners[i].context, self, event, device);
+  }
+
+@end
+
+//
+
+@implementation UVCDeviceRegistry
+
+  + (UVCDeviceRegistry*) deviceRegistryWithEventSource:(id<UVCDeviceEventSource>)source
+  {
+    return [[[UVCDeviceRegistry alloc] initWithEventSource:source] autorelease];
+  }
+
+//
+
+  - (void) dealloc
+  {
+    [self stop];
+    if ( _source ) [_source release];
+    if ( _devices ) [_devices release];
+    if ( _devicesById ) [_devicesById release];
+    if ( _listeners ) free(_listeners);
+    pthread_mutex_destroy(&_lock);
+    [super dealloc];
+  }
+
+//
+
+  - (NSString*) description
+  {
+    NSString      *description;
+
+    pthread_mutex_lock(&_lock);
+    description = [NSString stringWithFormat:@"UVCDeviceRegistry@%p { source: %@; device-count: %lu; listener-count: %lu; is-started: %s }",
+                        self,
+                        _source,
+                        (unsigned long)[_devices count],
+                        (unsigned long)_listenerCount,
+                        (_isStarted ? "yes" : "no")
+                      ];
+    pthread_mutex_unlock(&_lock);
+    return description;
+  }
+
+//
+
+  - (id<UVCDeviceEventSource>) eventSource
+  {
+    return _source;
+  }
+
+//
+
+  - (BOOL) start
+  {
+    if ( _isStarted ) return YES;
+    if ( ! [_source startWithRegistry:self] ) return NO;
+    _isStarted = YES;
+    return YES;
+  }
+
+//
+
+  - (void) stop
+  {
+    if ( _isStarted ) {
+      [_source stop];
+      _isStarted = NO;
+    }
+  }
+
+//
+
+  - (NSArray*) devices
+  {
+    NSArray       *devices;
+
+    pthread_mutex_lock(&_lock);
+    devices = [[_devices copy] autorelease];
+    pthread_mutex_unlock(&_lock);
+    return devices;
+  }
+
+//
+
+  - (NSArray*) controllers
+  {
+    NSArray       *devices = [self devices];
+    NSUInteger    i, iMax = [devices count];
+    UVCController *controllers[iMax ? iMax : 1];
+
+    // Only devices with a controller are ever added:
+    for ( i = 0; i < iMax; i++ ) controllers[i] = [[devices objectAtIndex:i] controller];
+    return [NSArray arrayWithObjects:controllers count:iMax];
+  }
+
+//
+
+  - (UVCDeviceInfo*) deviceWithId:(UInt64)deviceId
+  {
+    UVCDeviceInfo *device;
+
+    pthread_mutex_lock(&_lock);
+    device = [[[_devicesById objectForKey:[NSNumber numberWithUnsignedLongLong:deviceId]] retain] autorelease];
+    pthread_mutex_unlock(&_lock);
+    return device;
+  }
+
+//
+
+  - (void) addListener:(UVCDeviceRegistryCallback)callback
+    context:(void*)context
+  {
+    pthread_mutex_lock(&_lock);
+    if ( _listenerCount == _listenerCapacity ) {
+      NSUInteger  newCapacity = ( _listenerCapacity ? 2 * _listenerCapacity : 4 );
+      void        *newListeners = realloc(_listeners, newCapacity * sizeof(UVCDeviceRegistryListener));
+
+      if ( ! newListeners ) {
+        pthread_mutex_unlock(&_lock);
+        return;
+      }
+      _listeners = newListeners;
+      _listenerCapacity = newCapacity;
+    }
+    ((UVCDeviceRegistryListener*)_listeners)[_listenerCount].callback = callback;
+    ((UVCDeviceRegistryListener*)_listeners)[_listenerCount].context = context;
+    _listenerCount++;
+    pthread_mutex_unlock(&_lock);
+  }
+
+//
+
+  - (void) removeListener:(UVCDeviceRegistryCallback)callback
+    context:(void*)context
+  {
+    UVCDeviceRegistryListener *listeners;
+    NSUInteger                i = 0;
+
+    pthread_mutex_lock(&_lock);
+    listeners = (UVCDeviceRegistryListener*)_listeners;
+    while ( i < _listenerCount ) {
+      if ( (listeners[i].callback == callback) && (listeners[i].context == context) ) {
+        memmove(&listeners[i], &listeners[i + 1], (--_listenerCount - i) * sizeof(UVCDeviceRegistryListener));
+      } else {
+        i++;
+      }
+    }
+    pthread_mutex_unlock(&_lock);
+  }
+
+//
+
+  - (void) deviceDidArrive:(UVCDeviceInfo*)device
+    deviceId:(UInt64)deviceId
+  {
+    NSNumber      *key = [NSNumber numberWithUnsignedLongLong:deviceId];
+    BOOL          isAdded = NO;
+
+    pthread_mutex_lock(&_lock);
+    if ( [_devicesById objectForKey:key] ) {
+      pthread_mutex_unlock(&_lock);
+      return;
+    }
+    pthread_mutex_unlock(&_lock);
+
+    //
+    // The probe may take a while, so it happens outside the lock; the id is
+    // checked again in case the device was reported twice meanwhile:
+    //
+    if ( ! [device controller] ) return;
+    pthread_mutex_lock(&_lock);
+    if ( ! [_devicesById objectForKey:key] ) {
+      [_devicesById setObject:device forKey:key];
+      [_devices addObject:device];
+      isAdded = YES;
+    }
+    pthread_mutex_unlock(&_lock);
+    if ( isAdded ) [self notifyListenersOfEvent:kUVCDeviceRegistryEventArrival device:device];
+  }
+
+//
+
+  - (void) deviceDidDisappear:(UInt64)deviceId
+  {
+    NSNumber      *key = [NSNumber numberWithUnsignedLongLong:deviceId];
+    UVCDeviceInfo *device;
+
+    pthread_mutex_lock(&_lock);
+    if ( (device = [[_devicesById objectForKey:key] retain]) ) {
+      [_devicesById removeObjectForKey:key];
+      [_devices removeObjectIdenticalTo:device];
+    }
+    pthread_mutex_unlock(&_lock);
+    if ( device ) {
+      [[device controller] setIsInterfaceOpen:NO];
+      [self notifyListenersOfEvent:kUVCDeviceRegistryEventRemoval device:device];
+      [device release];
+    }
+  }
+
+@end
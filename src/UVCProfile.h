@@ -0,0 +1,152 @@
+//
+//  UVCProfile.h
+//
+//  Named sets of UVC control values that can be saved and applied.
+//
+//  Copyright © 2016
+//  Dr. Jeffrey Frey, IT-NSS
+//  University of Delaware
+//
+// $Id$
+//
+
+#import "UVCController.h"
+
+/*!
+  @typedef UVCProfileApplyStatistics
+
+  Summary of the work done by UVCProfile's applyToController:... method:
+
+    - controlCount:  number of controls named in the profile
+    - writeCount:  number of controls written (SET_CUR transfers issued)
+    - unchangedCount:  controls not written because the device already
+      held the profile's value
+    - automaticCount:  controls not written because they were disabled
+      due to an automatic mode
+    - failedCount:  controls that were unavailable, whose value could not
+      be parsed, or which could not be read or written
+    - readCount:  GET_CUR and GET_INFO transfers issued to determine what
+      needed to be written
+*/
+typedef struct {
+  NSUInteger        controlCount;
+  NSUInteger        writeCount;
+  NSUInteger        unchangedCount;
+  NSUInteger        automaticCount;
+  NSUInteger        failedCount;
+  NSUInteger        readCount;
+} UVCProfileApplyStatistics;
+
+/*!
+  @function UVCProfileApplyStatisticsTransfersSaved
+
+  Returns the number of SET_CUR transfers avoided relative to writing every
+  control in the profile.
+*/
+NSUInteger UVCProfileApplyStatisticsTransfersSaved(UVCProfileApplyStatistics *stats);
+
+/*!
+  @class UVCProfile
+  @abstract An ordered list of control names and textual values.
+
+  A profile associates UVC control names with values in the textual form
+  accepted by UVCType (see setCurrentValueFromCString:flags: in UVCControl).
+  On disk a profile is a text file with one control per line:
+
+    # comment
+    brightness=0
+    pan-tilt-abs={pan=0,tilt=3600}
+
+  Applying a profile to a device only writes those controls whose value on
+  the device differs from the profile.  Controls that select automatic modes
+  (e.g. auto-exposure-mode, auto-white-balance-temp) are written first, since
+  they determine whether other controls can be altered at all; any control
+  subsequently flagged as disabled due to an automatic mode is skipped.
+*/
+@interface UVCProfile : NSObject
+{
+  NSMutableArray        *_controlNames;
+  NSMutableDictionary   *_values;
+}
+
+/*!
+  @method profile
+
+  Returns an autoreleased, empty profile.
+*/
++ (UVCProfile*) profile;
+
+/*!
+  @method profileWithContentsOfFile:
+
+  Returns an autoreleased profile read from the file at path, or nil if the
+  file could not be read or contains a malformed line.
+*/
++ (UVCProfile*) profileWithContentsOfFile:(NSString*)path;
+
+/*!
+  @method profileWithController:
+
+  Returns an autoreleased profile containing the current value of every
+  control on the controller's device that can be both read and written.
+*/
++ (UVCProfile*) profileWithController:(UVCController*)controller;
+
+/*!
+  @method defaultProfileWithController:
+
+  Returns an autoreleased profile which sets every control on the
+  controller's device that has a default value to that default value.
+*/
++ (UVCProfile*) defaultProfileWithController:(UVCController*)controller;
+
+/*!
+  @method controlNames
+
+  Returns the names of the controls in the receiver, in order.
+*/
+- (NSArray*) controlNames;
+
+/*!
+  @method valueForControlName:
+
+  Returns the textual value associated with controlName, or nil.
+*/
+- (NSString*) valueForControlName:(NSString*)controlName;
+
+/*!
+  @method setValue:forControlName:
+
+  Associate the textual value with controlName.  Controls added for the first
+  time are appended to the receiver's list of names.
+*/
+- (void) setValue:(NSString*)value forControlName:(NSString*)controlName;
+
+/*!
+  @method profileString
+
+  Returns the receiver in the textual format described above.
+*/
+- (NSString*) profileString;
+
+/*!
+  @method writeToFile:
+
+  Write the receiver's profileString to the file at path.  Returns YES if
+  successful.
+*/
+- (BOOL) writeToFile:(NSString*)path;
+
+/*!
+  @method applyToController:flags:statistics:
+
+  Write the receiver's values to the controller's device, skipping controls
+  which already hold the value and controls disabled due to an automatic
+  mode.  If stats is not NULL it is filled-in with a summary of the work
+  done.  The flags are passed to UVCType when parsing values.
+
+  Returns YES if no control failed.
+*/
+- (BOOL) applyToController:(UVCController*)controller flags:(UVCTypeScanFlags)flags statistics:(UVCProfileApplyStatistics*)stats;
+
+@end
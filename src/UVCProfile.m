@@ -0,0 +1,384 @@
+//
+//  UVCProfile.m
+//
+//  Named sets of UVC control values that can be saved and applied.
+//
+//  Copyright © 2016
+//  Dr. Jeffrey Frey, IT-NSS
+//  University of Delaware
+//
+// $Id$
+//
+
+#import "UVCProfile.h"
+
+NSUInteger
+UVCProfileApplyStatisticsTransfersSaved(
+  UVCProfileApplyStatistics   *stats
+)
+{
+  return stats->unchangedCount + stats->automaticCount;
+}
+
+//
+#if 0
+#pragma mark -
+#endif
+//
+
+@interface UVCProfile(UVCProfilePrivate)
+
+/*!
+  @method automaticModeControlNames
+
+  Returns the set of control names which select an automatic mode for other
+  controls.  These are applied before all other controls.
+*/
++ (NSSet*) automaticModeControlNames;
+
+/*!
+  @method applyTargets:toControls:ofController:checkAutomatic:statistics:
+
+  Read the current value of each control, compare against the corresponding
+  target UVCValue, and write the controls that differ.  If checkAutomatic is
+  YES the controls' capabilities are refreshed first and controls disabled
+  due to an automatic mode are skipped.
+*/
+- (void) applyTargets:(NSArray*)targets toControls:(NSArray*)controls ofController:(UVCController*)controller checkAutomatic:(BOOL)checkAutomatic statistics:(UVCProfileApplyStatistics*)stats;
+
+@end
+
+//
+// Built by +[UVCProfile initialize] so profiles can be applied to several
+// devices from concurrent threads:
+//
+static NSSet *UVCProfileSharedAutomaticModeControlNames = nil;
+
+@implementation UVCProfile(UVCProfilePrivate)
+
+  + (NSSet*) automaticModeControlNames
+  {
+    return UVCProfileSharedAutomaticModeControlNames;
+  }
+
+//
+
+  - (void) applyTargets:(NSArray*)targets
+    toControls:(NSArray*)controls
+    ofController:(UVCController*)controller
+    checkAutomatic:(BOOL)checkAutomatic
+    statistics:(UVCProfileApplyStatistics*)stats
+  {
+    NSMutableArray    *candidates = [NSMutableArray array];
+    NSMutableArray    *candidateTargets = [NSMutableArray array];
+    NSMutableArray    *changedControls = [NSMutableArray array];
+    NSUInteger        i, iMax = [controls count];
+
+    if ( iMax == 0 ) return;
+
+    if ( checkAutomatic ) {
+      // The automatic-mode controls may have just been written, so the GET_INFO
+      // bits we hold could be out of date:
+      [controller refreshCapabilitiesOfControls:controls];
+      stats->readCount += iMax;
+    }
+    for ( i = 0; i < iMax; i++ ) {
+      UVCControl      *control = [controls objectAtIndex:i];
+
+      if ( checkAutomatic && [control isDisabledDueToAutomaticMode] ) {
+        stats->automaticCount++;
+      } else {
+        [candidates addObject:control];
+        [candidateTargets addObject:[targets objectAtIndex:i]];
+      }
+    }
+
+    //
+    // Read all current values; if any one of them fails, fall back to reading
+    // them one at a time so the failures can be isolated:
+    //
+    iMax = [candidates count];
+    stats->readCount += iMax;
+    if ( ! [controller readControls:candidates] ) {
+      i = 0;
+      while ( i < iMax ) {
+        stats->readCount++;
+        if ( ! [[candidates objectAtIndex:i] readIntoCurrentValue] ) {
+          stats->failedCount++;
+          [candidates removeObjectAtIndex:i];
+          [candidateTargets removeObjectAtIndex:i];
+          iMax--;
+        } else {
+          i++;
+        }
+      }
+    }
+
+    for ( i = 0; i < iMax; i++ ) {
+      UVCControl      *control = [candidates objectAtIndex:i];
+      UVCValue        *target = [candidateTargets objectAtIndex:i];
+
+      if ( [target isEqual:[control valueBuffer]] ) {
+        stats->unchangedCount++;
+      } else {
+        [[control valueBuffer] copyValue:target];
+        [changedControls addObject:control];
+      }
+    }
+
+    //
+    // Write the controls that differ; again, isolate failures if the batch
+    // did not succeed:
+    //
+    iMax = [changedControls count];
+    if ( iMax ) {
+      if ( [controller writeControls:changedControls] ) {
+        stats->writeCount += iMax;
+      } else {
+        for ( i = 0; i < iMax; i++ ) {
+          if ( [[changedControls objectAtIndex:i] writeFromCurrentValue] ) {
+            stats->writeCount++;
+          } else {
+            stats->failedCount++;
+          }
+        }
+      }
+    }
+  }
+
+@end
+
+//
+#if 0
+#pragma mark -
+#endif
+//
+
+@implementation UVCProfile
+
+  + (void) initialize
+  {
+    if ( self == [UVCProfile class] ) {
+      UVCProfileSharedAutomaticModeControlNames = [[NSSet alloc] initWithObjects:
+                                              UVCTerminalControlAutoExposureMode,
+                                              UVCTerminalControlAutoFocus,
+                                              UVCProcessingUnitControlAutoWhiteBalanceTemperature,
+                                              UVCProcessingUnitControlAutoWhiteBalanceComponent,
+                                              UVCProcessingUnitControlAutoHue,
+                                              UVCProcessingUnitControlAutoContrast,
+                                              nil
+                                            ];
+    }
+  }
+
+//
+
+  + (UVCProfile*) profile
+  {
+    return [[[self alloc] init] autorelease];
+  }
+
+//
+
+  + (UVCProfile*) profileWithContentsOfFile:(NSString*)path
+  {
+    NSString          *contents = [NSString stringWithContentsOfFile:path encoding:NSUTF8StringEncoding error:NULL];
+
+    if ( ! contents ) return nil;
+
+    UVCProfile        *newProfile = [self profile];
+    NSCharacterSet    *whitespace = [NSCharacterSet whitespaceCharacterSet];
+    NSEnumerator      *eLines = [[contents componentsSeparatedByCharactersInSet:[NSCharacterSet newlineCharacterSet]] objectEnumerator];
+    NSString          *line;
+
+    while ( (line = [eLines nextObject]) ) {
+      line = [line stringByTrimmingCharactersInSet:whitespace];
+      if ( [line length] && ! [line hasPrefix:@"#"] ) {
+        NSRange       equals = [line rangeOfString:@"="];
+        NSString      *controlName, *value;
+
+        if ( equals.location == NSNotFound ) return nil;
+        controlName = [[line substringToIndex:equals.location] stringByTrimmingCharactersInSet:whitespace];
+        value = [[line substringFromIndex:equals.location + 1] stringByTrimmingCharactersInSet:whitespace];
+        if ( ! [controlName length] || ! [value length] ) return nil;
+        [newProfile setValue:value forControlName:controlName];
+      }
+    }
+    return newProfile;
+  }
+
+//
+
+  + (UVCProfile*) profileWithController:(UVCController*)controller
+  {
+    UVCProfile        *newProfile = [self profile];
+    NSMutableArray    *controls = [NSMutableArray array];
+    NSEnumerator      *eNames = [[[UVCController controlStrings] sortedArrayUsingSelector:@selector(compare:)] objectEnumerator];
+    NSString          *name;
+    UVCControl        *control;
+
+    while ( (name = [eNames nextObject]) ) {
+      control = [controller controlWithName:name];
+      if ( control && [control supportsGetValue] && [control supportsSetValue] ) [controls addObject:control];
+    }
+    if ( [controls count] ) {
+      NSEnumerator    *eControls;
+
+      if ( ! [controller readControls:controls] ) {
+        // Drop any control that can't be read:
+        NSUInteger    i = 0;
+
+        while ( i < [controls count] ) {
+          if ( [[controls objectAtIndex:i] readIntoCurrentValue] ) {
+            i++;
+          } else {
+            [controls removeObjectAtIndex:i];
+          }
+        }
+      }
+      eControls = [controls objectEnumerator];
+      while ( (control = [eControls nextObject]) ) {
+        [newProfile setValue:[[control valueBuffer] stringValue] forControlName:[control controlName]];
+      }
+    }
+    return newProfile;
+  }
+
+//
+
+  + (UVCProfile*) defaultProfileWithController:(UVCController*)controller
+  {
+    UVCProfile        *newProfile = [self profile];
+    NSEnumerator      *eNames = [[UVCController controlStrings] objectEnumerator];
+    NSString          *name;
+
+    while ( (name = [eNames nextObject]) ) {
+      UVCControl      *control = [controller controlWithName:name];
+
+      if ( control && [control hasDefaultValue] ) [newProfile setValue:@"default" forControlName:name];
+    }
+    return newProfile;
+  }
+
+//
+
+  - (id) init
+  {
+    if ( (self = [super init]) ) {
+      _controlNames = [[NSMutableArray alloc] init];
+      _values = [[NSMutableDictionary alloc] init];
+    }
+    return self;
+  }
+
+//
+
+  - (void) dealloc
+  {
+    if ( _controlNames ) [_controlNames release];
+    if ( _values ) [_values release];
+    [super dealloc];
+  }
+
+//
+
+  - (NSString*) description
+  {
+    return [NSString stringWithFormat:@"UVCProfile@%p { %@ }", self, _values];
+  }
+
+//
+
+  - (NSArray*) controlNames
+  {
+    return _controlNames;
+  }
+
+//
+
+  - (NSString*) valueForControlName:(NSString*)controlName
+  {
+    return [_values objectForKey:controlName];
+  }
+  - (void) setValue:(NSString*)value
+    forControlName:(NSString*)controlName
+  {
+    if ( ! [_values objectForKey:controlName] ) [_controlNames addObject:controlName];
+    [_values setObject:value forKey:controlName];
+  }
+
+//
+
+  - (NSString*) profileString
+  {
+    NSMutableString   *asString = [[NSMutableString alloc] init];
+    NSEnumerator      *eNames = [_controlNames objectEnumerator];
+    NSString          *name;
+
+    while ( (name = [eNames nextObject]) ) {
+      [asString appendFormat:@"%@=%@\n", name, [_values objectForKey:name]];
+    }
+
+    NSString          *outString = [[asString copy] autorelease];
+    [asString release];
+
+    return outString;
+  }
+
+//
+
+  - (BOOL) writeToFile:(NSString*)path
+  {
+    return [[self profileString] writeToFile:path atomically:YES encoding:NSUTF8StringEncoding error:NULL];
+  }
+
+//
+
+  - (BOOL) applyToController:(UVCController*)controller
+    flags:(UVCTypeScanFlags)flags
+    statistics:(UVCProfileApplyStatistics*)stats
+  {
+    UVCProfileApplyStatistics   localStats;
+    NSSet                       *automaticModeControlNames = [[self class] automaticModeControlNames];
+    NSMutableArray              *automaticControls = [NSMutableArray array], *automaticTargets = [NSMutableArray array];
+    NSMutableArray              *otherControls = [NSMutableArray array], *otherTargets = [NSMutableArray array];
+    NSEnumerator                *eNames = [_controlNames objectEnumerator];
+    NSString                    *name;
+
+    if ( ! stats ) stats = &localStats;
+    memset(stats, 0, sizeof(UVCProfileApplyStatistics));
+    stats->controlCount = [_controlNames count];
+
+    //
+    // Resolve each control and parse its target value:
+    //
+    while ( (name = [eNames nextObject]) ) {
+      UVCControl      *control = [controller controlWithName:name];
+      UVCValue        *target;
+
+      if ( ! control || ! [control supportsGetValue] || ! [control supportsSetValue] ) {
+        stats->failedCount++;
+        continue;
+      }
+      target = [UVCValue uvcValueWithType:[[control valueBuffer] valueType]];
+      if ( ! [target scanCString:[[_values objectForKey:name] UTF8String] flags:flags minimum:[control minimum] maximum:[control maximum] stepSize:[control stepSize] defaultValue:[control defaultValue]] ) {
+        stats->failedCount++;
+        continue;
+      }
+      if ( [automaticModeControlNames containsObject:name] ) {
+        [automaticControls addObject:control];
+        [automaticTargets addObject:target];
+      } else {
+        [otherControls addObject:control];
+        [otherTargets addObject:target];
+      }
+    }
+
+    // Automatic modes first, they determine whether the rest can be written:
+    [self applyTargets:automaticTargets toControls:automaticControls ofController:controller checkAutomatic:NO statistics:stats];
+    [self applyTargets:otherTargets toControls:otherControls ofController:controller checkAutomatic:YES statistics:stats];
+
+    return ( stats->failedCount == 0 );
+  }
+
+@end
@@ -0,0 +1,160 @@
+//
+//  UVCRequestQueue.h
+//
+//  Pipelined delivery of batches of UVC control requests.
+//
+//  Copyright © 2016
+//  Dr. Jeffrey Frey, IT-NSS
+//  University of Delaware
+//
+// $Id$
+//
+
+#import "UVCTransport.h"
+#import "UVCRequestStatistics.h"
+
+/*!
+  @defined UVCRequestQueueDefaultWindowSize
+
+  Default maximum number of requests a UVCRequestQueue keeps in flight.
+*/
+#define UVCRequestQueueDefaultWindowSize  8
+
+/*!
+  @typedef UVCRequestQueueFailureHandler
+
+  Function given each request that failed while others were in flight, once
+  the rest of the batch has been delivered; it may deliver the request again
+  and returns the request's final result.  The request's own callback is
+  invoked afterward with that result.
+*/
+typedef IOReturn (*UVCRequestQueueFailureHandler)(void *context, IOUSBDevRequest *controlRequest, IOReturn result);
+
+/*!
+  @class UVCRequestQueue
+  @abstract A batch of control requests delivered with several in flight.
+
+  Requests are enqueued (each with its own completion callback) and then
+  delivered by the run method.  Up to windowSize independent requests are
+  kept in flight on the transport at any time; as each completes, the next
+  enqueued request is submitted.  Requests are submitted in the order they
+  were enqueued, so requests for a single control are seen by the device in
+  order.
+
+  If the transport does not support asynchronous delivery the requests are
+  sent synchronously, one at a time, by the run method.
+
+  A failure handler (see setFailureHandler:context:) gets a second look at
+  every failed request.  Since the device's request error code describes
+  only the last request it handled, the handler is called after the whole
+  batch has completed, one request at a time, so anything it sends is the
+  only request on the device.
+
+  Completion callbacks are invoked on the thread that called run.  Requests
+  must not be enqueued while run is executing.
+*/
+@interface UVCRequestQueue : NSObject
+{
+  id<UVCTransport>      _transport;
+  NSUInteger            _windowSize;
+  void                  *_entries;
+  NSUInteger            _entryCount, _entryCapacity;
+  NSUInteger            _completedCount, _failedCount;
+  NSUInteger            _droppedCount;
+  UVCRequestStatistics  *_statistics;
+  UVCRequestQueueFailureHandler _failureHandler;
+  void                  *_failureContext;
+}
+
+/*!
+  @method requestQueueWithTransport:
+
+  Returns an autoreleased, empty queue that delivers requests via transport.
+*/
++ (UVCRequestQueue*) requestQueueWithTransport:(id<UVCTransport>)transport;
+
+/*!
+  @method initWithTransport:
+
+  Designated initializer.
+*/
+- (id) initWithTransport:(id<UVCTransport>)transport;
+
+/*!
+  @method transport
+
+  Returns the transport used to deliver the receiver's requests.
+*/
+- (id<UVCTransport>) transport;
+
+/*!
+  @method windowSize
+
+  Returns the maximum number of requests the receiver keeps in flight.
+*/
+- (NSUInteger) windowSize;
+
+/*!
+  @method setWindowSize:
+
+  Set the maximum number of requests the receiver keeps in flight.  A value
+  of 1 delivers the requests serially; zero is treated as 1.
+*/
+- (void) setWindowSize:(NSUInteger)windowSize;
+
+/*!
+  @method statistics
+
+  Returns the object in which the receiver records each request's latency
+  and outcome, or nil.
+*/
+- (UVCRequestStatistics*) statistics;
+
+/*!
+  @method setStatistics:
+
+  Record the latency (from submission to completion) and outcome of each
+  request delivered by the receiver in statistics; nil disables recording.
+*/
+- (void) setStatistics:(UVCRequestStatistics*)statistics;
+
+/*!
+  @method setFailureHandler:context:
+
+  Pass each request that fails to handler (with context) before its
+  callback is invoked; NULL (the default) reports failures as they are.
+*/
+- (void) setFailureHandler:(UVCRequestQueueFailureHandler)handler context:(void*)context;
+
+/*!
+  @method count
+
+  Returns the number of requests currently enqueued.
+*/
+- (NSUInteger) count;
+
+/*!
+  @method enqueueControlRequest:callback:context:
+
+  Add a copy of controlRequest to the receiver.  The data buffer referenced
+  by controlRequest must remain valid until the request's callback has been
+  invoked.  The callback may be NULL.
+
+  If there is no memory to hold the request, it is not delivered:  its
+  callback is invoked at once with kIOReturnNoMemory, and it is counted as
+  failed by the next run.
+*/
+- (void) enqueueControlRequest:(IOUSBDevRequest)controlRequest callback:(UVCTransportCompletionCallback)callback context:(void*)context;
+
+/*!
+  @method run
+
+  Deliver all enqueued requests, returning once every request has completed.
+  The receiver is then emptied and may be reused.
+
+  Returns the number of requests that failed, including any that could not
+  be enqueued.
+*/
+- (NSUInteger) run;
+
+@end
@@ -0,0 +1,245 @@
+//
+//  UVCRequestQueue.m
+//
+//  Pipelined delivery of batches of UVC control requests.
+//
+//  Copyright © 2016
+//  Dr. Jeffrey Frey, IT-NSS
+//  University of Delaware
+//
+// $Id$
+//
+
+#import "UVCRequestQueue.h"
+
+typedef struct {
+  UVCRequestQueue                 *queue;
+  IOUSBDevRequest                 controlRequest;
+  UVCTransportCompletionCallback  callback;
+  void                            *context;
+  UInt64                          startTime;
+  IOReturn                        result;
+  BOOL                            isDeferred;
+} UVCRequestQueueEntry;
+
+//
+#if 0
+#pragma mark -
+#endif
+//
+
+@interface UVCRequestQueue(UVCRequestQueuePrivate)
+
+/*!
+  @method entryDidComplete:result:
+
+  Bookkeeping for a completed request; calls the request's own callback
+  unless the failure handler must see it first.
+*/
+- (void) entryDidComplete:(UVCRequestQueueEntry*)entry result:(IOReturn)result;
+
+@end
+
+//
+
+static void
+UVCRequestQueueCompletion(
+  void              *context,
+  IOUSBDevRequest   *controlRequest,
+  IOReturn          result
+)
+{
+  UVCRequestQueueEntry    *entry = (UVCRequestQueueEntry*)context;
+
+  [entry->queue entryDidComplete:entry result:result];
+}
+
+//
+
+@implementation UVCRequestQueue(UVCRequestQueuePrivate)
+
+  - (void) entryDidComplete:(UVCRequestQueueEntry*)entry
+    result:(IOReturn)result
+  {
+    _completedCount++;
+    if ( _statistics ) [_statistics recordRequest:&entry->controlRequest startTime:entry->startTime result:result];
+    if ( (result != kIOReturnSuccess) && _failureHandler ) {
+      entry->result = result;
+      entry->isDeferred = YES;
+      return;
+    }
+    if ( result != kIOReturnSuccess ) _failedCount++;
+    if ( entry->callback ) entry->callback(entry->context, &entry->controlRequest, result);
+  }
+
+@end
+
+//
+#if 0
+#pragma mark -
+#endif
+//
+
+@implementation UVCRequestQueue
+
+  + (UVCRequestQueue*) requestQueueWithTransport:(id<UVCTransport>)transport
+  {
+    return [[[self alloc] initWithTransport:transport] autorelease];
+  }
+
+//
+
+  - (id) initWithTransport:(id<UVCTransport>)transport
+  {
+    if ( (self = [super init]) ) {
+      _transport = [transport retain];
+      _windowSize = UVCRequestQueueDefaultWindowSize;
+    }
+    return self;
+  }
+
+//
+
+  - (void) dealloc
+  {
+    if ( _entries ) free(_entries);
+    if ( _statistics ) [_statistics release];
+    if ( _transport ) [_transport release];
+    [super dealloc];
+  }
+
+//
+
+  - (NSString*) description
+  {
+    return [NSString stringWithFormat:@"UVCRequestQueue@%p { transport: %@; window-size: %lu; count: %lu }",
+                        self,
+                        _transport,
+                        (unsigned long)_windowSize,
+                        (unsigned long)_entryCount
+                      ];
+  }
+
+//
+
+  - (id<UVCTransport>) transport
+  {
+    return _transport;
+  }
+
+//
+
+  - (NSUInteger) windowSize
+  {
+    return _windowSize;
+  }
+  - (void) setWindowSize:(NSUInteger)windowSize
+  {
+    _windowSize = ( windowSize ? windowSize : 1 );
+  }
+
+//
+
+  - (UVCRequestStatistics*) statistics
+  {
+    return _statistics;
+  }
+  - (void) setStatistics:(UVCRequestStatistics*)statistics
+  {
+    if ( statistics ) [statistics retain];
+    if ( _statistics ) [_statistics release];
+    _statistics = statistics;
+  }
+
+//
+
+  - (void) setFailureHandler:(UVCRequestQueueFailureHandler)handler
+    context:(void*)context
+  {
+    _failureHandler = handler;
+    _failureContext = context;
+  }
+
+//
+
+  - (NSUInteger) count
+  {
+    return _entryCount;
+  }
+
+//
+
+  - (void) enqueueControlRequest:(IOUSBDevRequest)controlRequest
+    callback:(UVCTransportCompletionCallback)callback
+    context:(void*)context
+  {
+    if ( _entryCount == _entryCapacity ) {
+      NSUInteger        newCapacity = ( _entryCapacity ? 2 * _entryCapacity : 16 );
+      void              *newEntries = realloc(_entries, newCapacity * sizeof(UVCRequestQueueEntry));
+
+      if ( ! newEntries ) {
+        // Never silently lose a request:  the caller hears of it, and so does run:
+        _droppedCount++;
+        if ( callback ) callback(context, &controlRequest, kIOReturnNoMemory);
+        return;
+      }
+      _entries = newEntries;
+      _entryCapacity = newCapacity;
+    }
+
+    UVCRequestQueueEntry  *entry = ((UVCRequestQueueEntry*)_entries) + _entryCount++;
+
+    entry->queue = self;
+    entry->controlRequest = controlRequest;
+    entry->callback = callback;
+    entry->context = context;
+    entry->isDeferred = NO;
+  }
+
+//
+
+  - (NSUInteger) run
+  {
+    UVCRequestQueueEntry  *entries = (UVCRequestQueueEntry*)_entries;
+    NSUInteger            nextEntry = 0;
+    NSUInteger            failedCount;
+    BOOL                  isAsync = ( _windowSize > 1 );
+
+    _completedCount = _failedCount = 0;
+    while ( _completedCount < _entryCount ) {
+      // Fill the window:
+      while ( (nextEntry < _entryCount) && ((nextEntry - _completedCount) < _windowSize) ) {
+        UVCRequestQueueEntry  *entry = &entries[nextEntry++];
+
+        if ( _statistics ) entry->startTime = UVCRequestStatisticsTimestamp();
+        if ( isAsync ) {
+          IOReturn            rc = [_transport submitControlRequest:&entry->controlRequest callback:UVCRequestQueueCompletion context:entry];
+
+          if ( rc == kIOReturnSuccess ) continue;
+          if ( rc == kIOReturnUnsupported ) isAsync = NO;
+          // Not in flight; if the transport can't do async, try it synchronously:
+          if ( ! isAsync ) rc = [_transport sendControlRequest:&entry->controlRequest];
+          [self entryDidComplete:entry result:rc];
+        } else {
+          [self entryDidComplete:entry result:[_transport sendControlRequest:&entry->controlRequest]];
+        }
+      }
+      if ( _completedCount < _entryCount ) [_transport waitForCompletions];
+    }
+    if ( _failureHandler ) {
+      for ( nextEntry = 0; nextEntry < _entryCount; nextEntry++ ) {
+        UVCRequestQueueEntry  *entry = &entries[nextEntry];
+        IOReturn              rc;
+
+        if ( ! entry->isDeferred ) continue;
+        rc = _failureHandler(_failureContext, &entry->controlRequest, entry->result);
+        if ( rc != kIOReturnSuccess ) _failedCount++;
+        if ( entry->callback ) entry->callback(entry->context, &entry->controlRequest, rc);
+      }
+    }
+    failedCount = _failedCount + _droppedCount;
+    _entryCount = _completedCount = _failedCount = _droppedCount = 0;
+    return failedCount;
+  }
+
+@end
@@ -0,0 +1,221 @@
+//
+//  UVCRequestStatistics.h
+//
+//  Latency and failure accounting for UVC control requests.
+//
+//  Copyright © 2016
+//  Dr. Jeffrey Frey, IT-NSS
+//  University of Delaware
+//
+// $Id$
+//
+
+#import <Foundation/Foundation.h>
+
+#include <IOKit/IOKitLib.h>
+#include <IOKit/usb/IOUSBLib.h>
+#include <mach/mach_time.h>
+#include <pthread.h>
+
+/*!
+  @defined UVCRequestStatisticsBucketCount
+
+  Number of buckets in a latency histogram.  Bucket 0 counts requests that
+  took less than 1 microsecond; bucket i (i > 0) those that took at least
+  2^(i-1) but less than 2^i microseconds.  The last bucket also counts
+  anything slower (about 4 seconds and up).
+*/
+#define UVCRequestStatisticsBucketCount       24
+
+/*!
+  @defined UVCRequestStatisticsMaxFailureCodes
+
+  Number of distinct IOReturn failure codes counted individually; further
+  codes are counted together as "other."
+*/
+#define UVCRequestStatisticsMaxFailureCodes   16
+
+/*!
+  @typedef UVCRequestStatisticsEntry
+
+  Accumulated statistics for one kind of request to one control:  the
+  unit/terminal id and control selector (the high bytes of wIndex and wValue)
+  and the bRequest code (UVC_GET_CUR, UVC_SET_CUR, ...).  Times are in
+  nanoseconds.
+*/
+typedef struct {
+  UInt8             unitId;
+  UInt8             selector;
+  UInt8             request;
+  UInt64            count;
+  UInt64            failedCount;
+  UInt64            totalTime;
+  UInt64            minimumTime;
+  UInt64            maximumTime;
+  UInt64            buckets[UVCRequestStatisticsBucketCount];
+} UVCRequestStatisticsEntry;
+
+/*!
+  @function UVCRequestStatisticsTimestamp
+
+  Returns the current time in the units expected by recordRequest:startTime:result:.
+  Cheap enough to call around every request.
+*/
+static inline UInt64
+UVCRequestStatisticsTimestamp(void)
+{
+  return mach_absolute_time();
+}
+
+/*!
+  @function UVCRequestStatisticsRequestName
+
+  Returns the UVC name of the bRequest code request ("GET_CUR", "SET_CUR", ...)
+  or "UNKNOWN".
+*/
+const char* UVCRequestStatisticsRequestName(UInt8 request);
+
+/*!
+  @function UVCRequestStatisticsBucketLimit
+
+  Returns the (exclusive) upper bound of histogram bucket index, in
+  microseconds.
+*/
+UInt64 UVCRequestStatisticsBucketLimit(NSUInteger index);
+
+/*!
+  @function UVCRequestStatisticsEntryPercentile
+
+  Returns an estimate, in microseconds, of the given percentile (0 to 100)
+  of the latencies accumulated in entry:  the upper bound of the histogram
+  bucket that contains it, but no more than the entry's maximum.
+*/
+double UVCRequestStatisticsEntryPercentile(const UVCRequestStatisticsEntry *entry, double percentile);
+
+/*!
+  @class UVCRequestStatistics
+  @abstract Per-device latency histograms and failure counts.
+
+  A UVCController records every control request it delivers -- synchronously
+  or through a UVCRequestQueue -- in its UVCRequestStatistics:  the elapsed
+  time goes into a log2 histogram for the (unit, selector, bRequest) of the
+  request, and a failed request is counted for that entry and by its
+  IOReturn code.  Interface open and close events are also counted.
+
+  Recording takes a mutex and does no allocation once a (unit, selector,
+  bRequest) has been seen, so it can be left enabled.  All methods may be
+  called from any thread.
+*/
+@interface UVCRequestStatistics : NSObject
+{
+  pthread_mutex_t             _lock;
+  UVCRequestStatisticsEntry   *_entries;
+  NSUInteger                  _entryCount, _entryCapacity;
+  UInt16                      *_index;
+  NSUInteger                  _indexCapacity;
+  IOReturn                    _failureCodes[UVCRequestStatisticsMaxFailureCodes];
+  UInt64                      _failureCodeCounts[UVCRequestStatisticsMaxFailureCodes];
+  NSUInteger                  _failureCodeCount;
+  UInt64                      _otherFailureCount;
+  UInt64                      _requestCount, _failedCount;
+  UInt64                      _interfaceOpenCount, _interfaceCloseCount;
+}
+
+/*!
+  @method requestStatistics
+
+  Returns an autoreleased, empty instance.
+*/
++ (UVCRequestStatistics*) requestStatistics;
+
+/*!
+  @method recordRequest:startTime:result:
+
+  Account for controlRequest, which was started at startTime (a value
+  returned by UVCRequestStatisticsTimestamp()) and has just completed with
+  result.
+*/
+- (void) recordRequest:(const IOUSBDevRequest*)controlRequest startTime:(UInt64)startTime result:(IOReturn)result;
+
+/*!
+  @method recordInterfaceOpen:
+
+  Count an interface open (isOpen is YES) or close event.
+*/
+- (void) recordInterfaceOpen:(BOOL)isOpen;
+
+/*!
+  @method requestCount
+
+  Returns the number of requests recorded.
+*/
+- (UInt64) requestCount;
+
+/*!
+  @method failedCount
+
+  Returns the number of recorded requests that failed.
+*/
+- (UInt64) failedCount;
+
+/*!
+  @method interfaceOpenCount
+
+  Returns the number of interface open events recorded.
+*/
+- (UInt64) interfaceOpenCount;
+
+/*!
+  @method interfaceCloseCount
+
+  Returns the number of interface close events recorded.
+*/
+- (UInt64) interfaceCloseCount;
+
+/*!
+  @method entryCount
+
+  Returns the number of distinct (unit, selector, bRequest) entries.
+*/
+- (NSUInteger) entryCount;
+
+/*!
+  @method getEntry:atIndex:
+
+  Copy the entry at index (entries are kept in the order they were first
+  recorded) to *entry.  Returns NO if index is out of range.
+*/
+- (BOOL) getEntry:(UVCRequestStatisticsEntry*)entry atIndex:(NSUInteger)index;
+
+/*!
+  @method failureCodeCount
+
+  Returns the number of distinct IOReturn codes counted individually.
+*/
+- (NSUInteger) failureCodeCount;
+
+/*!
+  @method failureCodeAtIndex:count:
+
+  Returns the IOReturn code at index and sets *count (if not NULL) to the
+  number of failures with that code.  Returns kIOReturnSuccess if index is
+  out of range.
+*/
+- (IOReturn) failureCodeAtIndex:(NSUInteger)index count:(UInt64*)count;
+
+/*!
+  @method otherFailureCount
+
+  Returns the number of failures whose IOReturn code was not counted
+  individually (see UVCRequestStatisticsMaxFailureCodes).
+*/
+- (UInt64) otherFailureCount;
+
+/*!
+  @method reset
+
+  Discard everything recorded so far.
+*/
+- (void) reset;
+
+@end
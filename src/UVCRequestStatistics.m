@@ -0,0 +1,431 @@
+//
+//  UVCRequestStatistics.m
+//
+//  Latency and failure accounting for UVC control requests.
+//
+//  Copyright © 2016
+//  Dr. Jeffrey Frey, IT-NSS
+//  University of Delaware
+//
+// $Id$
+//
+
+#import "UVCRequestStatistics.h"
+
+#include <math.h>
+
+/*!
+  @defined UVCRequestStatisticsKey
+
+  Index key for a (unit, selector, bRequest) triple.
+*/
+#define UVCRequestStatisticsKey(U, S, R)  (((UInt32)(R) << 16) | ((UInt32)(U) << 8) | (UInt32)(S))
+
+//
+
+static mach_timebase_info_data_t UVCRequestStatisticsTimebase = { 1, 1 };
+
+//
+
+const char*
+UVCRequestStatisticsRequestName(
+  UInt8     request
+)
+{
+  switch ( request ) {
+    case 0x01:  return "SET_CUR";
+    case 0x81:  return "GET_CUR";
+    case 0x82:  return "GET_MIN";
+    case 0x83:  return "GET_MAX";
+    case 0x84:  return "GET_RES";
+    case 0x85:  return "GET_LEN";
+    case 0x86:  return "GET_INFO";
+    case 0x87:  return "GET_DEF";
+  }
+  return "UNKNOWN";
+}
+
+//
+
+UInt64
+UVCRequestStatisticsBucketLimit(
+  NSUInteger  index
+)
+{
+  return ( (UInt64)1 << index );
+}
+
+//
+
+double
+UVCRequestStatisticsEntryPercentile(
+  const UVCRequestStatisticsEntry *entry,
+  double                          percentile
+)
+{
+  UInt64                          rank, seen = 0;
+  NSUInteger                      i;
+  double                          maximum;
+
+  if ( ! entry->count ) return 0.0;
+  maximum = entry->maximumTime / 1000.0;
+  if ( percentile <= 0.0 ) return entry->minimumTime / 1000.0;
+  if ( percentile >= 100.0 ) return maximum;
+
+  // The 1-based rank of the sample at the given percentile:
+  rank = (UInt64)ceil(percentile * entry->count / 100.0);
+  if ( rank < 1 ) rank = 1;
+  for ( i = 0; i < UVCRequestStatisticsBucketCount; i++ ) {
+    seen += entry->buckets[i];
+    if ( seen >= rank ) {
+      double                      limit = (double)UVCRequestStatisticsBucketLimit(i);
+
+      return ( limit < maximum ) ? limit : maximum;
+    }
+  }
+  return maximum;
+}
+
+//
+#if 0
+#pragma mark -
+#endif
+//
+
+@interface UVCRequestStatistics(UVCRequestStatisticsPrivate)
+
+/*!
+  @method entryForRequest:
+
+  Returns the entry for the unit, selector, and bRequest of controlRequest,
+  creating it if necessary.  Returns NULL if memory is exhausted.  Must be
+  called with the lock held.
+*/
+- (UVCRequestStatisticsEntry*) entryForRequest:(const IOUSBDevRequest*)controlRequest;
+
+/*!
+  @method growIndex
+
+  Double the capacity of the hash index and re-insert every entry.  Must be
+  called with the lock held.
+*/
+- (BOOL) growIndex;
+
+@end
+
+@implementation UVCRequestStatistics(UVCRequestStatisticsPrivate)
+
+  - (UVCRequestStatisticsEntry*) entryForRequest:(const IOUSBDevRequest*)controlRequest
+  {
+    UInt8                       unitId = (controlRequest->wIndex >> 8) & 0xFF;
+    UInt8                       selector = (controlRequest->wValue >> 8) & 0xFF;
+    UInt32                      key = UVCRequestStatisticsKey(unitId, selector, controlRequest->bRequest);
+    NSUInteger                  mask = _indexCapacity - 1;
+    NSUInteger                  slot = (key * 0x9E3779B1) & mask;
+    UVCRequestStatisticsEntry   *entry;
+
+    while ( _index[slot] ) {
+      entry = &_entries[_index[slot] - 1];
+      if ( UVCRequestStatisticsKey(entry->unitId, entry->selector, entry->request) == key ) return entry;
+      slot = (slot + 1) & mask;
+    }
+
+    // First time we've seen this one:
+    if ( _entryCount == _entryCapacity ) {
+      NSUInteger                newCapacity = 2 * _entryCapacity;
+      void                      *newEntries;
+
+      if ( newCapacity > 0xFFFF ) return NULL;
+      if ( ! (newEntries = realloc(_entries, newCapacity * sizeof(UVCRequestStatisticsEntry))) ) return NULL;
+      _entries = newEntries;
+      _entryCapacity = newCapacity;
+    }
+    if ( 2 * (_entryCount + 1) > _indexCapacity ) {
+      if ( ! [self growIndex] ) return NULL;
+      return [self entryForRequest:controlRequest];
+    }
+    entry = &_entries[_entryCount++];
+    memset(entry, 0, sizeof(*entry));
+    entry->unitId = unitId;
+    entry->selector = selector;
+    entry->request = controlRequest->bRequest;
+    entry->minimumTime = UINT64_MAX;
+    _index[slot] = _entryCount;
+    return entry;
+  }
+
+//
+
+  - (BOOL) growIndex
+  {
+    NSUInteger                  newCapacity = 2 * _indexCapacity, i;
+    UInt16                      *newIndex = calloc(newCapacity, sizeof(UInt16));
+
+    if ( ! newIndex ) return NO;
+    for ( i = 0; i < _entryCount; i++ ) {
+      UVCRequestStatisticsEntry *entry = &_entries[i];
+      NSUInteger                slot = (UVCRequestStatisticsKey(entry->unitId, entry->selector, entry->request) * 0x9E3779B1) & (newCapacity - 1);
+
+      while ( newIndex[slot] ) slot = (slot + 1) & (newCapacity - 1);
+      newIndex[slot] = i + 1;
+    }
+    free(_index);
+    _index = newIndex;
+    _indexCapacity = newCapacity;
+    return YES;
+  }
+
+@end
+
+//
+#if 0
+#pragma mark -
+#endif
+//
+
+@implementation UVCRequestStatistics
+
+  + (void) initialize
+  {
+    if ( self == [UVCRequestStatistics class] ) {
+      mach_timebase_info(&UVCRequestStatisticsTimebase);
+    }
+  }
+
+//
+
+  + (UVCRequestStatistics*) requestStatistics
+  {
+    return [[[UVCRequestStatistics alloc] init] autorelease];
+  }
+
+//
+
+  - (id) init
+  {
+    if ( (self = [super init]) ) {
+      // Enough for every request type on a typical camera's controls:
+      _entryCapacity = 64;
+      _indexCapacity = 128;
+      _entries = malloc(_entryCapacity * sizeof(UVCRequestStatisticsEntry));
+      _index = calloc(_indexCapacity, sizeof(UInt16));
+      if ( ! _entries || ! _index ) {
+        [self release];
+        return nil;
+      }
+      pthread_mutex_init(&_lock, NULL);
+    }
+    return self;
+  }
+
+//
+
+  - (void) dealloc
+  {
+    if ( _entries && _index ) pthread_mutex_destroy(&_lock);
+    if ( _entries ) free(_entries);
+    if ( _index ) free(_index);
+    [super dealloc];
+  }
+
+//
+
+  - (NSString*) description
+  {
+    return [NSString stringWithFormat:@"UVCRequestStatistics@%p { requests: %llu; failed: %llu; entries: %lu; opens: %llu; closes: %llu }",
+                        self,
+                        (unsigned long long)[self requestCount],
+                        (unsigned long long)[self failedCount],
+                        (unsigned long)[self entryCount],
+                        (unsigned long long)[self interfaceOpenCount],
+                        (unsigned long long)[self interfaceCloseCount]
+                      ];
+  }
+
+//
+
+  - (void) recordRequest:(const IOUSBDevRequest*)controlRequest
+    startTime:(UInt64)startTime
+    result:(IOReturn)result
+  {
+    UInt64                      elapsed = UVCRequestStatisticsTimestamp() - startTime;
+    UInt64                      micros;
+    NSUInteger                  bucket;
+    UVCRequestStatisticsEntry   *entry;
+
+    // Convert to nanoseconds (the timebase is 1/1 on Intel):
+    if ( UVCRequestStatisticsTimebase.numer != UVCRequestStatisticsTimebase.denom ) elapsed = elapsed * UVCRequestStatisticsTimebase.numer / UVCRequestStatisticsTimebase.denom;
+    micros = elapsed / 1000;
+    bucket = ( micros ? (64 - __builtin_clzll(micros)) : 0 );
+    if ( bucket >= UVCRequestStatisticsBucketCount ) bucket = UVCRequestStatisticsBucketCount - 1;
+
+    pthread_mutex_lock(&_lock);
+    _requestCount++;
+    if ( (entry = [self entryForRequest:controlRequest]) ) {
+      entry->count++;
+      entry->totalTime += elapsed;
+      if ( elapsed < entry->minimumTime ) entry->minimumTime = elapsed;
+      if ( elapsed > entry->maximumTime ) entry->maximumTime = elapsed;
+      entry->buckets[bucket]++;
+      if ( result != kIOReturnSuccess ) entry->failedCount++;
+    }
+    if ( result != kIOReturnSuccess ) {
+      NSUInteger                i = 0;
+
+      _failedCount++;
+      while ( (i < _failureCodeCount) && (_failureCodes[i] != result) ) i++;
+      if ( i < _failureCodeCount ) {
+        _failureCodeCounts[i]++;
+      } else if ( _failureCodeCount < UVCRequestStatisticsMaxFailureCodes ) {
+        _failureCodes[_failureCodeCount] = result;
+        _failureCodeCounts[_failureCodeCount++] = 1;
+      } else {
+        _otherFailureCount++;
+      }
+    }
+    pthread_mutex_unlock(&_lock);
+  }
+
+//
+
+  - (void) recordInterfaceOpen:(BOOL)isOpen
+  {
+    pthread_mutex_lock(&_lock);
+    if ( isOpen ) {
+      _interfaceOpenCount++;
+    } else {
+      _interfaceCloseCount++;
+    }
+    pthread_mutex_unlock(&_lock);
+  }
+
+//
+
+  - (UInt64) requestCount
+  {
+    UInt64              count;
+
+    pthread_mutex_lock(&_lock);
+    count = _requestCount;
+    pthread_mutex_unlock(&_lock);
+    return count;
+  }
+
+//
+
+  - (UInt64) failedCount
+  {
+    UInt64              count;
+
+    pthread_mutex_lock(&_lock);
+    count = _failedCount;
+    pthread_mutex_unlock(&_lock);
+    return count;
+  }
+
+//
+
+  - (UInt64) interfaceOpenCount
+  {
+    UInt64              count;
+
+    pthread_mutex_lock(&_lock);
+    count = _interfaceOpenCount;
+    pthread_mutex_unlock(&_lock);
+    return count;
+  }
+
+//
+
+  - (UInt64) interfaceCloseCount
+  {
+    UInt64              count;
+
+    pthread_mutex_lock(&_lock);
+    count = _interfaceCloseCount;
+    pthread_mutex_unlock(&_lock);
+    return count;
+  }
+
+//
+
+  - (NSUInteger) entryCount
+  {
+    NSUInteger          count;
+
+    pthread_mutex_lock(&_lock);
+    count = _entryCount;
+    pthread_mutex_unlock(&_lock);
+    return count;
+  }
+
+//
+
+  - (BOOL) getEntry:(UVCRequestStatisticsEntry*)entry
+    atIndex:(NSUInteger)index
+  {
+    BOOL                rc = NO;
+
+    pthread_mutex_lock(&_lock);
+    if ( index < _entryCount ) {
+      *entry = _entries[index];
+      rc = YES;
+    }
+    pthread_mutex_unlock(&_lock);
+    return rc;
+  }
+
+//
+
+  - (NSUInteger) failureCodeCount
+  {
+    NSUInteger          count;
+
+    pthread_mutex_lock(&_lock);
+    count = _failureCodeCount;
+    pthread_mutex_unlock(&_lock);
+    return count;
+  }
+
+//
+
+  - (IOReturn) failureCodeAtIndex:(NSUInteger)index
+    count:(UInt64*)count
+  {
+    IOReturn            code = kIOReturnSuccess;
+
+    pthread_mutex_lock(&_lock);
+    if ( index < _failureCodeCount ) {
+      code = _failureCodes[index];
+      if ( count ) *count = _failureCodeCounts[index];
+    }
+    pthread_mutex_unlock(&_lock);
+    return code;
+  }
+
+//
+
+  - (UInt64) otherFailureCount
+  {
+    UInt64              count;
+
+    pthread_mutex_lock(&_lock);
+    count = _otherFailureCount;
+    pthread_mutex_unlock(&_lock);
+    return count;
+  }
+
+//
+
+  - (void) reset
+  {
+    pthread_mutex_lock(&_lock);
+    _entryCount = 0;
+    memset(_index, 0, _indexCapacity * sizeof(UInt16));
+    _failureCodeCount = 0;
+    _otherFailureCount = _requestCount = _failedCount = 0;
+    _interfaceOpenCount = _interfaceCloseCount = 0;
+    pthread_mutex_unlock(&_lock);
+  }
+
+@end
@@ -0,0 +1,211 @@
+//
+//  UVCSimulatedTransport.h
+//
+//  In-process simulated UVC device.
+//
+//  Copyright © 2016
+//  Dr. Jeffrey Frey, IT-NSS
+//  University of Delaware
+//
+// $Id$
+//
+
+#import "UVCTransport.h"
+
+/*!
+  @defined UVCSimulatedControlMaxValueSize
+
+  Largest control value (in bytes) the simulated device can hold.
+*/
+#define UVCSimulatedControlMaxValueSize  32
+
+/*!
+  @class UVCSimulatedTransport
+  @abstract UVCTransport that answers requests from an in-memory device model.
+
+  The simulated device holds a table of controls, each identified by unit id
+  and selector, with GET_INFO capabilities and minimum, maximum, resolution,
+  default, and current values (all in USB byte order).  Requests addressed
+  to a control that is not in the table stall, as would a real device; so
+  does any request whose wLength does not match the control's size, or a
+  SET_CUR to a control whose capabilities lack the set bit.
+
+  Two timing parameters model the cost of a transfer:
+
+    - the latency is the round-trip overhead of a single transfer, which
+      overlaps across requests that are in flight simultaneously
+    - the service time is spent by the device on each transfer, and does
+      not overlap (the device handles one request at a time)
+
+  A synchronous request therefore costs latency + serviceTime, while N
+  pipelined requests cost roughly latency + N * serviceTime.
+
+  The device can also change the value of its auto-update controls (those
+  whose capabilities include bit 3) on its own, at a fixed interval.  If the
+  device has a status interrupt endpoint, each change is reported with a
+  VideoControl status packet that arrives one latency after the change.
+  Changes are generated lazily, whenever the transport is used, so the
+  simulation needs no thread of its own.
+
+  The device implements the VideoControl interface's
+  VC_REQUEST_ERROR_CODE_CONTROL (unit 0, selector 0x02), which reports why
+  the previous request stalled.  Faults can be injected at random (with a
+  fixed seed, so runs are repeatable):  a stalled transfer fails at once with
+  the "not ready" error code, while a hung transfer takes hangDuration longer
+  than usual.  A request that cannot complete within the request timeout
+  fails with kIOReturnTimeout when the timeout expires, without having been
+  performed.
+*/
+@interface UVCSimulatedTransport : NSObject <UVCTransport>
+{
+  NSMutableData         *_controls;
+  NSMutableData         *_pendingRequests;
+  NSMutableData         *_statusPackets;
+  NSTimeInterval        _latency, _serviceTime;
+  NSTimeInterval        _deviceBusyUntil;
+  NSTimeInterval        _valueChangeInterval, _nextValueChangeAt, _lastValueChangeAt;
+  NSUInteger            _valueChangeIndex, _valueChangeCount;
+  NSUInteger            _transferCount;
+  double                _stallProbability, _hangProbability;
+  NSTimeInterval        _hangDuration, _requestTimeout;
+  UInt64                _faultState;
+  NSUInteger            _faultCount;
+  UInt8                 _requestErrorCode;
+  BOOL                  _isOpen;
+  BOOL                  _hasStatusInterruptEndpoint;
+}
+
+/*!
+  @method simulatedTransportWithLatency:serviceTime:
+
+  Returns an autoreleased instance of the class with no controls and the given
+  timing parameters (in seconds).
+*/
++ (UVCSimulatedTransport*) simulatedTransportWithLatency:(NSTimeInterval)latency serviceTime:(NSTimeInterval)serviceTime;
+
+/*!
+  @method simulatedCameraWithLatency:serviceTime:
+
+  Returns an autoreleased instance of the class populated with a typical set
+  of webcam controls on input terminal 1 and processing unit 2.
+*/
++ (UVCSimulatedTransport*) simulatedCameraWithLatency:(NSTimeInterval)latency serviceTime:(NSTimeInterval)serviceTime;
+
+/*!
+  @method latency
+
+  Returns the per-transfer round-trip latency, in seconds.
+*/
+- (NSTimeInterval) latency;
+- (void) setLatency:(NSTimeInterval)latency;
+
+/*!
+  @method serviceTime
+
+  Returns the per-transfer device service time, in seconds.
+*/
+- (NSTimeInterval) serviceTime;
+- (void) setServiceTime:(NSTimeInterval)serviceTime;
+
+/*!
+  @method transferCount
+
+  Returns the number of control transfers the simulated device has handled.
+*/
+- (NSUInteger) transferCount;
+
+/*!
+  @method stallProbability
+
+  Returns the probability (0 through 1) that a transfer stalls transiently.
+*/
+- (double) stallProbability;
+- (void) setStallProbability:(double)stallProbability;
+
+/*!
+  @method hangProbability
+
+  Returns the probability (0 through 1) that a transfer hangs.
+*/
+- (double) hangProbability;
+- (void) setHangProbability:(double)hangProbability;
+
+/*!
+  @method hangDuration
+
+  Returns the time (in seconds) a hung transfer adds to its completion.
+*/
+- (NSTimeInterval) hangDuration;
+- (void) setHangDuration:(NSTimeInterval)hangDuration;
+
+/*!
+  @method faultCount
+
+  Returns the number of stalls and hangs injected so far.
+*/
+- (NSUInteger) faultCount;
+
+/*!
+  @method setHasStatusInterruptEndpoint:
+
+  Determines whether the simulated device reports value changes through a
+  status interrupt endpoint (the default for simulatedCameraWithLatency:serviceTime:)
+  or offers no endpoint, leaving clients to poll.
+*/
+- (void) setHasStatusInterruptEndpoint:(BOOL)hasStatusInterruptEndpoint;
+
+/*!
+  @method valueChangeInterval
+
+  Returns the interval (in seconds) at which the device changes the value of
+  one of its auto-update controls; zero (the default) means never.
+*/
+- (NSTimeInterval) valueChangeInterval;
+
+/*!
+  @method setValueChangeInterval:
+
+  Start (or, with zero, stop) device-originated value changes.  Each change
+  moves the next auto-update control (round-robin) to its maximum, or back to
+  its minimum if it is already at its maximum.
+*/
+- (void) setValueChangeInterval:(NSTimeInterval)valueChangeInterval;
+
+/*!
+  @method valueChangeCount
+
+  Returns the number of device-originated value changes so far.
+*/
+- (NSUInteger) valueChangeCount;
+
+/*!
+  @method timeOfLastValueChange
+
+  Returns the time (as seconds since the reference date) at which the most
+  recent device-originated value change occurred, or zero.
+*/
+- (NSTimeInterval) timeOfLastValueChange;
+
+/*!
+  @method changeValueOfControlWithUnitId:selector:value:
+
+  Have the device itself change the current value of a control (e.g. as an
+  automatic mode would), queueing a status packet if the device has a status
+  interrupt endpoint.  The value is in USB byte order.  Returns NO if there is
+  no such control.
+*/
+- (BOOL) changeValueOfControlWithUnitId:(UInt8)unitId selector:(UInt8)selector value:(const void*)value;
+
+/*!
+  @method addControlWithUnitId:selector:byteSize:info:minimum:maximum:stepSize:defaultValue:
+
+  Add a control to the simulated device.  The value pointers each reference
+  byteSize bytes in USB (little-endian) byte order; a NULL pointer makes the
+  corresponding GET_MIN/GET_MAX/GET_RES/GET_DEF request stall.  The current
+  value starts as the default value (or zeroes).
+
+  Returns NO if byteSize exceeds UVCSimulatedControlMaxValueSize.
+*/
+- (BOOL) addControlWithUnitId:(UInt8)unitId selector:(UInt8)selector byteSize:(NSUInteger)byteSize info:(UInt8)info minimum:(const void*)minimum maximum:(const void*)maximum stepSize:(const void*)stepSize defaultValue:(const void*)defaultValue;
+
+@end
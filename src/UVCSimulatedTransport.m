@@ -0,0 +1,832 @@
+//
+//  UVCSimulatedTransport.m
+//
+//  In-process simulated UVC device.
+//
+//  Copyright © 2016
+//  Dr. Jeffrey Frey, IT-NSS
+//  University of Delaware
+//
+// $Id$
+//
+
+#import "UVCSimulatedTransport.h"
+
+//
+// UVC request opcodes understood by the simulated device:
+//
+#define UVC_SET_CUR   0x01
+#define UVC_GET_CUR   0x81
+#define UVC_GET_MIN   0x82
+#define UVC_GET_MAX   0x83
+#define UVC_GET_RES   0x84
+#define UVC_GET_LEN   0x85
+#define UVC_GET_INFO  0x86
+#define UVC_GET_DEF   0x87
+
+//
+// The VideoControl interface's own request error code control, and the
+// codes the simulated device reports through it:
+//
+#define UVC_VC_REQUEST_ERROR_CODE_CONTROL   0x02
+
+#define UVC_ERROR_NONE              0x00
+#define UVC_ERROR_NOT_READY         0x01
+#define UVC_ERROR_INVALID_CONTROL   0x06
+#define UVC_ERROR_INVALID_REQUEST   0x07
+
+//
+// Seed of the fault-injection generator:
+//
+#define UVCSimulatedFaultSeed       0x9e3779b97f4a7c15ULL
+
+/*!
+  @enum Simulated control value slots
+*/
+enum {
+  kUVCSimulatedValueMinimum = 0,
+  kUVCSimulatedValueMaximum,
+  kUVCSimulatedValueStepSize,
+  kUVCSimulatedValueDefault,
+  kUVCSimulatedValueCurrent,
+  kUVCSimulatedValueCount
+};
+
+typedef struct {
+  UInt8               unitId;
+  UInt8               selector;
+  UInt8               info;
+  UInt8               byteSize;
+  UInt8               hasValue[kUVCSimulatedValueCount];
+  UInt8               values[kUVCSimulatedValueCount][UVCSimulatedControlMaxValueSize];
+} UVCSimulatedControl;
+
+typedef struct {
+  IOUSBDevRequest                 *controlRequest;
+  UVCTransportCompletionCallback  callback;
+  void                            *context;
+  NSTimeInterval                  completeAt;
+  IOReturn                        result;
+} UVCSimulatedPendingRequest;
+
+//
+// A VideoControl status packet:  bStatusType, bOriginator, bEvent, bSelector,
+// bAttribute, bValue[n]:
+//
+typedef struct {
+  NSTimeInterval                  deliverAt;
+  NSUInteger                      length;
+  UInt8                           bytes[5 + UVCSimulatedControlMaxValueSize];
+} UVCSimulatedStatusPacket;
+
+//
+// A device with no reader drops status packets once this many are queued:
+//
+#define UVCSimulatedStatusPacketQueueDepth  64
+
+//
+
+static void
+UVCSimulatedTransportAddIntegerControl(
+  UVCSimulatedTransport   *transport,
+  UInt8                   unitId,
+  UInt8                   selector,
+  UInt8                   info,
+  NSUInteger              byteSize,
+  SInt32                  minimum,
+  SInt32                  maximum,
+  SInt32                  stepSize,
+  SInt32                  defaultValue
+)
+{
+  SInt32                  hostValues[4] = { minimum, maximum, stepSize, defaultValue };
+  UInt8                   usbValues[4][4];
+  int                     i, j;
+
+  for ( i = 0; i < 4; i++ ) {
+    UInt32                v = (UInt32)hostValues[i];
+
+    for ( j = 0; j < 4; j++ ) {
+      usbValues[i][j] = v & 0xFF;
+      v >>= 8;
+    }
+  }
+  [transport addControlWithUnitId:unitId selector:selector byteSize:byteSize info:info
+        minimum:usbValues[0]
+        maximum:usbValues[1]
+        stepSize:usbValues[2]
+        defaultValue:usbValues[3]
+      ];
+}
+
+//
+#if 0
+#pragma mark -
+#endif
+//
+
+@interface UVCSimulatedTransport(UVCSimulatedTransportPrivate)
+
+/*!
+  @method controlForUnitId:selector:
+
+  Returns a pointer to the control record with the given address, or NULL if
+  the simulated device has no such control.
+*/
+- (UVCSimulatedControl*) controlForUnitId:(UInt8)unitId selector:(UInt8)selector;
+
+/*!
+  @method performControlRequest:
+
+  Apply controlRequest to the device model (updating wLenDone) and return the
+  result of the transfer.
+*/
+- (IOReturn) performControlRequest:(IOUSBDevRequest*)controlRequest;
+
+/*!
+  @method performRequestErrorCodeRequest:
+
+  Answer a request addressed to VC_REQUEST_ERROR_CODE_CONTROL.
+*/
+- (IOReturn) performRequestErrorCodeRequest:(IOUSBDevRequest*)controlRequest;
+
+/*!
+  @method scheduleTransfer
+
+  Account for the device and bus time of a single transfer and return the
+  time at which it completes.
+*/
+- (NSTimeInterval) scheduleTransfer;
+
+/*!
+  @method nextFaultSample
+
+  Returns the next value (uniform in [0, 1)) from the fault-injection
+  generator.
+*/
+- (double) nextFaultSample;
+
+/*!
+  @method deliverControlRequest:completeAt:
+
+  Schedule controlRequest, inject any fault, and (unless it hangs past the
+  request timeout) apply it to the device model.  Returns the result of the
+  transfer and sets completeAt to the time it completes.
+*/
+- (IOReturn) deliverControlRequest:(IOUSBDevRequest*)controlRequest completeAt:(NSTimeInterval*)completeAt;
+
+/*!
+  @method queueStatusPacketForControl:changedAt:
+
+  If the device has a status interrupt endpoint, queue a value-change status
+  packet carrying control's current value, to arrive one latency after
+  changedAt.
+*/
+- (void) queueStatusPacketForControl:(UVCSimulatedControl*)control changedAt:(NSTimeInterval)changedAt;
+
+/*!
+  @method generateValueChangesUntil:
+
+  Perform every device-originated value change due at or before now.
+*/
+- (void) generateValueChangesUntil:(NSTimeInterval)now;
+
+@end
+
+@implementation UVCSimulatedTransport(UVCSimulatedTransportPrivate)
+
+  - (UVCSimulatedControl*) controlForUnitId:(UInt8)unitId
+    selector:(UInt8)selector
+  {
+    UVCSimulatedControl   *control = (UVCSimulatedControl*)[_controls mutableBytes];
+    NSUInteger            count = [_controls length] / sizeof(UVCSimulatedControl);
+
+    while ( count-- ) {
+      if ( (control->unitId == unitId) && (control->selector == selector) ) return control;
+      control++;
+    }
+    return NULL;
+  }
+
+//
+
+  - (IOReturn) performControlRequest:(IOUSBDevRequest*)controlRequest
+  {
+    UVCSimulatedControl   *control = [self controlForUnitId:(controlRequest->wIndex >> 8) selector:(controlRequest->wValue >> 8)];
+    int                   slot = -1;
+
+    _transferCount++;
+    controlRequest->wLenDone = 0;
+    if ( ! control ) {
+      _requestErrorCode = UVC_ERROR_INVALID_CONTROL;
+      return kIOUSBPipeStalled;
+    }
+    
+    // Anything that stalls from here on is a request the control does not
+    // accept:
+    _requestErrorCode = UVC_ERROR_INVALID_REQUEST;
+
+    switch ( controlRequest->bRequest ) {
+
+      case UVC_GET_INFO:
+        if ( controlRequest->wLength != 1 ) return kIOUSBPipeStalled;
+        *((UInt8*)controlRequest->pData) = control->info;
+        controlRequest->wLenDone = 1;
+        _requestErrorCode = UVC_ERROR_NONE;
+        return kIOReturnSuccess;
+
+      case UVC_GET_LEN:
+        if ( controlRequest->wLength != 2 ) return kIOUSBPipeStalled;
+        ((UInt8*)controlRequest->pData)[0] = control->byteSize;
+        ((UInt8*)controlRequest->pData)[1] = 0;
+        controlRequest->wLenDone = 2;
+        _requestErrorCode = UVC_ERROR_NONE;
+        return kIOReturnSuccess;
+
+      case UVC_SET_CUR:
+        if ( ! (control->info & 0x02) || (controlRequest->wLength != control->byteSize) ) return kIOUSBPipeStalled;
+        memcpy(control->values[kUVCSimulatedValueCurrent], controlRequest->pData, control->byteSize);
+        control->hasValue[kUVCSimulatedValueCurrent] = YES;
+        controlRequest->wLenDone = control->byteSize;
+        _requestErrorCode = UVC_ERROR_NONE;
+        return kIOReturnSuccess;
+
+      case UVC_GET_CUR:
+        if ( ! (control->info & 0x01) ) return kIOUSBPipeStalled;
+        slot = kUVCSimulatedValueCurrent;
+        break;
+      case UVC_GET_MIN:
+        slot = kUVCSimulatedValueMinimum;
+        break;
+      case UVC_GET_MAX:
+        slot = kUVCSimulatedValueMaximum;
+        break;
+      case UVC_GET_RES:
+        slot = kUVCSimulatedValueStepSize;
+        break;
+      case UVC_GET_DEF:
+        slot = kUVCSimulatedValueDefault;
+        break;
+
+    }
+    if ( (slot < 0) || ! control->hasValue[slot] || (controlRequest->wLength != control->byteSize) ) return kIOUSBPipeStalled;
+    memcpy(controlRequest->pData, control->values[slot], control->byteSize);
+    controlRequest->wLenDone = control->byteSize;
+    _requestErrorCode = UVC_ERROR_NONE;
+    return kIOReturnSuccess;
+  }
+
+//
+
+  - (IOReturn) performRequestErrorCodeRequest:(IOUSBDevRequest*)controlRequest
+  {
+    _transferCount++;
+    controlRequest->wLenDone = 0;
+    if ( controlRequest->wLength != 1 ) return kIOUSBPipeStalled;
+    switch ( controlRequest->bRequest ) {
+      
+      case UVC_GET_INFO:
+        *((UInt8*)controlRequest->pData) = 0x01;
+        break;
+      
+      case UVC_GET_CUR:
+        // Reading the code does not change it:
+        *((UInt8*)controlRequest->pData) = _requestErrorCode;
+        break;
+      
+      default:
+        return kIOUSBPipeStalled;
+        
+    }
+    controlRequest->wLenDone = 1;
+    return kIOReturnSuccess;
+  }
+
+//
+
+  - (NSTimeInterval) scheduleTransfer
+  {
+    NSTimeInterval      now = [NSDate timeIntervalSinceReferenceDate];
+    NSTimeInterval      start = ( _deviceBusyUntil > now ) ? _deviceBusyUntil : now;
+
+    _deviceBusyUntil = start + _serviceTime;
+    return _deviceBusyUntil + _latency;
+  }
+
+//
+
+  - (double) nextFaultSample
+  {
+    // xorshift64*:
+    _faultState ^= _faultState >> 12;
+    _faultState ^= _faultState << 25;
+    _faultState ^= _faultState >> 27;
+    return (double)((_faultState * 0x2545f4914f6cdd1dULL) >> 11) / (double)(1ULL << 53);
+  }
+
+//
+
+  - (IOReturn) deliverControlRequest:(IOUSBDevRequest*)controlRequest
+    completeAt:(NSTimeInterval*)completeAt
+  {
+    NSTimeInterval      now = [NSDate timeIntervalSinceReferenceDate];
+    
+    [self generateValueChangesUntil:now];
+    *completeAt = [self scheduleTransfer];
+    
+    // The error code control answers even when the device is misbehaving:
+    if ( ((controlRequest->wIndex >> 8) == 0) && ((controlRequest->wValue >> 8) == UVC_VC_REQUEST_ERROR_CODE_CONTROL) ) {
+      return [self performRequestErrorCodeRequest:controlRequest];
+    }
+    if ( (_stallProbability > 0) && ([self nextFaultSample] < _stallProbability) ) {
+      _faultCount++;
+      _transferCount++;
+      controlRequest->wLenDone = 0;
+      _requestErrorCode = UVC_ERROR_NOT_READY;
+      return kIOUSBPipeStalled;
+    }
+    if ( (_hangProbability > 0) && ([self nextFaultSample] < _hangProbability) ) {
+      _faultCount++;
+      *completeAt += _hangDuration;
+    }
+    if ( (_requestTimeout > 0) && (*completeAt > now + _requestTimeout) ) {
+      // The host gives up on the transfer; the device never acts on it:
+      *completeAt = now + _requestTimeout;
+      controlRequest->wLenDone = 0;
+      return kIOReturnTimeout;
+    }
+    return [self performControlRequest:controlRequest];
+  }
+
+//
+
+  - (void) queueStatusPacketForControl:(UVCSimulatedControl*)control
+    changedAt:(NSTimeInterval)changedAt
+  {
+    UVCSimulatedStatusPacket  packet;
+    
+    if ( ! _hasStatusInterruptEndpoint ) return;
+    if ( [_statusPackets length] >= UVCSimulatedStatusPacketQueueDepth * sizeof(UVCSimulatedStatusPacket) ) return;
+    
+    packet.deliverAt = changedAt + _latency;
+    packet.length = 5 + control->byteSize;
+    packet.bytes[0] = 0x01;           // VideoControl interface
+    packet.bytes[1] = control->unitId;
+    packet.bytes[2] = 0x00;           // control change
+    packet.bytes[3] = control->selector;
+    packet.bytes[4] = 0x00;           // value change
+    memcpy(&packet.bytes[5], control->values[kUVCSimulatedValueCurrent], control->byteSize);
+    [_statusPackets appendBytes:&packet length:sizeof(packet)];
+  }
+
+//
+
+  - (void) generateValueChangesUntil:(NSTimeInterval)now
+  {
+    if ( _valueChangeInterval <= 0 ) return;
+    
+    UVCSimulatedControl   *controls = (UVCSimulatedControl*)[_controls mutableBytes];
+    NSUInteger            count = [_controls length] / sizeof(UVCSimulatedControl);
+    
+    while ( _nextValueChangeAt <= now ) {
+      NSUInteger          tries = count;
+      
+      // Find the next auto-update control with a range:
+      while ( tries-- ) {
+        UVCSimulatedControl *control = &controls[_valueChangeIndex++ % count];
+        
+        if ( (control->info & 0x08) && control->hasValue[kUVCSimulatedValueMinimum] && control->hasValue[kUVCSimulatedValueMaximum] ) {
+          int               slot = kUVCSimulatedValueMaximum;
+          
+          if ( memcmp(control->values[kUVCSimulatedValueCurrent], control->values[kUVCSimulatedValueMaximum], control->byteSize) == 0 ) slot = kUVCSimulatedValueMinimum;
+          memcpy(control->values[kUVCSimulatedValueCurrent], control->values[slot], control->byteSize);
+          [self queueStatusPacketForControl:control changedAt:_nextValueChangeAt];
+          _valueChangeCount++;
+          _lastValueChangeAt = _nextValueChangeAt;
+          break;
+        }
+      }
+      _nextValueChangeAt += _valueChangeInterval;
+    }
+  }
+
+@end
+
+//
+#if 0
+#pragma mark -
+#endif
+//
+
+@implementation UVCSimulatedTransport
+
+  + (UVCSimulatedTransport*) simulatedTransportWithLatency:(NSTimeInterval)latency
+    serviceTime:(NSTimeInterval)serviceTime
+  {
+    UVCSimulatedTransport   *newTransport = [[self alloc] init];
+
+    if ( newTransport ) {
+      newTransport->_latency = latency;
+      newTransport->_serviceTime = serviceTime;
+    }
+    return [newTransport autorelease];
+  }
+
+//
+
+  + (UVCSimulatedTransport*) simulatedCameraWithLatency:(NSTimeInterval)latency
+    serviceTime:(NSTimeInterval)serviceTime
+  {
+    UVCSimulatedTransport   *newTransport = [self simulatedTransportWithLatency:latency serviceTime:serviceTime];
+
+    if ( newTransport ) {
+      UInt8                 aeModeRes = 0x09, aeModeDef = 0x08;
+      UInt8                 panTiltMin[8] = { 0x40, 0x1c, 0xf6, 0xff, 0x40, 0x1c, 0xf6, 0xff };
+      UInt8                 panTiltMax[8] = { 0xc0, 0xe3, 0x09, 0x00, 0xc0, 0xe3, 0x09, 0x00 };
+      UInt8                 panTiltRes[8] = { 0x10, 0x0e, 0x00, 0x00, 0x10, 0x0e, 0x00, 0x00 };
+      UInt8                 panTiltDef[8] = { 0 };
+
+      //
+      // Input (camera) terminal, unit 1:
+      //
+      [newTransport addControlWithUnitId:1 selector:0x02 byteSize:1 info:0x03 minimum:NULL maximum:NULL stepSize:&aeModeRes defaultValue:&aeModeDef];
+      UVCSimulatedTransportAddIntegerControl(newTransport, 1, 0x03, 0x03, 1, 0, 1, 1, 0);
+      UVCSimulatedTransportAddIntegerControl(newTransport, 1, 0x04, 0x0b, 4, 3, 2047, 1, 250);
+      UVCSimulatedTransportAddIntegerControl(newTransport, 1, 0x06, 0x03, 2, 0, 250, 5, 0);
+      UVCSimulatedTransportAddIntegerControl(newTransport, 1, 0x08, 0x03, 1, 0, 1, 1, 1);
+      UVCSimulatedTransportAddIntegerControl(newTransport, 1, 0x0b, 0x03, 2, 100, 500, 1, 100);
+      [newTransport addControlWithUnitId:1 selector:0x0d byteSize:8 info:0x03 minimum:panTiltMin maximum:panTiltMax stepSize:panTiltRes defaultValue:panTiltDef];
+
+      //
+      // Processing unit, unit 2:
+      //
+      UVCSimulatedTransportAddIntegerControl(newTransport, 2, 0x01, 0x03, 2, 0, 1, 1, 0);
+      UVCSimulatedTransportAddIntegerControl(newTransport, 2, 0x02, 0x03, 2, -64, 64, 1, 0);
+      UVCSimulatedTransportAddIntegerControl(newTransport, 2, 0x03, 0x03, 2, 0, 95, 1, 32);
+      UVCSimulatedTransportAddIntegerControl(newTransport, 2, 0x04, 0x03, 2, 0, 255, 1, 0);
+      UVCSimulatedTransportAddIntegerControl(newTransport, 2, 0x05, 0x03, 1, 0, 2, 1, 1);
+      UVCSimulatedTransportAddIntegerControl(newTransport, 2, 0x06, 0x03, 2, -2000, 2000, 100, 0);
+      UVCSimulatedTransportAddIntegerControl(newTransport, 2, 0x07, 0x03, 2, 0, 100, 1, 64);
+      UVCSimulatedTransportAddIntegerControl(newTransport, 2, 0x08, 0x03, 2, 0, 7, 1, 3);
+      UVCSimulatedTransportAddIntegerControl(newTransport, 2, 0x09, 0x03, 2, 100, 500, 1, 300);
+      UVCSimulatedTransportAddIntegerControl(newTransport, 2, 0x0a, 0x0b, 2, 2800, 6500, 10, 4600);
+      UVCSimulatedTransportAddIntegerControl(newTransport, 2, 0x0b, 0x03, 1, 0, 1, 1, 1);
+      
+      // Exposure time and white balance temperature are auto-update controls,
+      // reported through the status endpoint:
+      newTransport->_hasStatusInterruptEndpoint = YES;
+    }
+    return newTransport;
+  }
+
+//
+
+  - (id) init
+  {
+    if ( (self = [super init]) ) {
+      _controls = [[NSMutableData alloc] init];
+      _pendingRequests = [[NSMutableData alloc] init];
+      _statusPackets = [[NSMutableData alloc] init];
+      _faultState = UVCSimulatedFaultSeed;
+    }
+    return self;
+  }
+
+//
+
+  - (void) dealloc
+  {
+    [self close];
+    if ( _controls ) [_controls release];
+    if ( _pendingRequests ) [_pendingRequests release];
+    if ( _statusPackets ) [_statusPackets release];
+    [super dealloc];
+  }
+
+//
+
+  - (NSString*) description
+  {
+    return [NSString stringWithFormat:@"UVCSimulatedTransport@%p { controls: %lu; latency: %.6f; service-time: %.6f; transfers: %lu; in-flight: %lu%s }",
+                        self,
+                        (unsigned long)([_controls length] / sizeof(UVCSimulatedControl)),
+                        _latency, _serviceTime,
+                        (unsigned long)_transferCount,
+                        (unsigned long)[self requestsInFlight],
+                        (_isOpen ? "; is-open" : "")
+                      ];
+  }
+
+//
+
+  - (NSTimeInterval) latency
+  {
+    return _latency;
+  }
+  - (void) setLatency:(NSTimeInterval)latency
+  {
+    _latency = latency;
+  }
+
+//
+
+  - (NSTimeInterval) serviceTime
+  {
+    return _serviceTime;
+  }
+  - (void) setServiceTime:(NSTimeInterval)serviceTime
+  {
+    _serviceTime = serviceTime;
+  }
+
+//
+
+  - (NSUInteger) transferCount
+  {
+    return _transferCount;
+  }
+
+//
+
+  - (double) stallProbability
+  {
+    return _stallProbability;
+  }
+  - (void) setStallProbability:(double)stallProbability
+  {
+    _stallProbability = stallProbability;
+  }
+
+//
+
+  - (double) hangProbability
+  {
+    return _hangProbability;
+  }
+  - (void) setHangProbability:(double)hangProbability
+  {
+    _hangProbability = hangProbability;
+  }
+
+//
+
+  - (NSTimeInterval) hangDuration
+  {
+    return _hangDuration;
+  }
+  - (void) setHangDuration:(NSTimeInterval)hangDuration
+  {
+    _hangDuration = hangDuration;
+  }
+
+//
+
+  - (NSUInteger) faultCount
+  {
+    return _faultCount;
+  }
+
+//
+
+  - (void) setHasStatusInterruptEndpoint:(BOOL)hasStatusInterruptEndpoint
+  {
+    _hasStatusInterruptEndpoint = hasStatusInterruptEndpoint;
+    if ( ! hasStatusInterruptEndpoint ) [_statusPackets setLength:0];
+  }
+
+//
+
+  - (NSTimeInterval) valueChangeInterval
+  {
+    return _valueChangeInterval;
+  }
+  - (void) setValueChangeInterval:(NSTimeInterval)valueChangeInterval
+  {
+    _valueChangeInterval = valueChangeInterval;
+    _nextValueChangeAt = [NSDate timeIntervalSinceReferenceDate] + valueChangeInterval;
+  }
+
+//
+
+  - (NSUInteger) valueChangeCount
+  {
+    return _valueChangeCount;
+  }
+
+//
+
+  - (NSTimeInterval) timeOfLastValueChange
+  {
+    return _lastValueChangeAt;
+  }
+
+//
+
+  - (BOOL) changeValueOfControlWithUnitId:(UInt8)unitId
+    selector:(UInt8)selector
+    value:(const void*)value
+  {
+    UVCSimulatedControl   *control = [self controlForUnitId:unitId selector:selector];
+    
+    if ( ! control ) return NO;
+    memcpy(control->values[kUVCSimulatedValueCurrent], value, control->byteSize);
+    _lastValueChangeAt = [NSDate timeIntervalSinceReferenceDate];
+    [self queueStatusPacketForControl:control changedAt:_lastValueChangeAt];
+    return YES;
+  }
+
+//
+
+  - (BOOL) addControlWithUnitId:(UInt8)unitId
+    selector:(UInt8)selector
+    byteSize:(NSUInteger)byteSize
+    info:(UInt8)info
+    minimum:(const void*)minimum
+    maximum:(const void*)maximum
+    stepSize:(const void*)stepSize
+    defaultValue:(const void*)defaultValue
+  {
+    UVCSimulatedControl   newControl;
+    const void            *values[kUVCSimulatedValueDefault + 1] = { minimum, maximum, stepSize, defaultValue };
+    int                   slot;
+
+    if ( byteSize > UVCSimulatedControlMaxValueSize ) return NO;
+
+    memset(&newControl, 0, sizeof(newControl));
+    newControl.unitId = unitId;
+    newControl.selector = selector;
+    newControl.info = info;
+    newControl.byteSize = (UInt8)byteSize;
+    for ( slot = kUVCSimulatedValueMinimum; slot <= kUVCSimulatedValueDefault; slot++ ) {
+      if ( values[slot] ) {
+        memcpy(newControl.values[slot], values[slot], byteSize);
+        newControl.hasValue[slot] = YES;
+      }
+    }
+    memcpy(newControl.values[kUVCSimulatedValueCurrent], newControl.values[kUVCSimulatedValueDefault], byteSize);
+    newControl.hasValue[kUVCSimulatedValueCurrent] = YES;
+
+    UVCSimulatedControl   *existingControl = [self controlForUnitId:unitId selector:selector];
+
+    if ( existingControl ) {
+      *existingControl = newControl;
+    } else {
+      [_controls appendBytes:&newControl length:sizeof(newControl)];
+    }
+    return YES;
+  }
+
+//
+
+  - (BOOL) isOpen
+  {
+    return _isOpen;
+  }
+
+//
+
+  - (BOOL) open
+  {
+    _isOpen = YES;
+    return YES;
+  }
+
+//
+
+  - (void) close
+  {
+    while ( [self requestsInFlight] ) [self waitForCompletions];
+    _isOpen = NO;
+  }
+
+//
+
+  - (IOReturn) sendControlRequest:(IOUSBDevRequest*)controlRequest
+  {
+    if ( ! _isOpen && ! [self open] ) return kIOReturnNotOpen;
+
+    NSTimeInterval      completeAt;
+    IOReturn            result = [self deliverControlRequest:controlRequest completeAt:&completeAt];
+    NSTimeInterval      delay = completeAt - [NSDate timeIntervalSinceReferenceDate];
+
+    if ( delay > 0 ) [NSThread sleepForTimeInterval:delay];
+    return result;
+  }
+
+//
+
+  - (IOReturn) submitControlRequest:(IOUSBDevRequest*)controlRequest
+    callback:(UVCTransportCompletionCallback)callback
+    context:(void*)context
+  {
+    if ( ! _isOpen && ! [self open] ) return kIOReturnNotOpen;
+
+    UVCSimulatedPendingRequest  pending = {
+                                    .controlRequest = controlRequest,
+                                    .callback = callback,
+                                    .context = context,
+                                    .completeAt = 0,
+                                    .result = kIOReturnSuccess
+                                  };
+
+    // The device model is updated in submission order, which is also the
+    // order in which the device services the requests:
+    pending.result = [self deliverControlRequest:controlRequest completeAt:&pending.completeAt];
+    [_pendingRequests appendBytes:&pending length:sizeof(pending)];
+    return kIOReturnSuccess;
+  }
+
+//
+
+  - (NSUInteger) requestsInFlight
+  {
+    return [_pendingRequests length] / sizeof(UVCSimulatedPendingRequest);
+  }
+
+//
+
+  - (void) waitForCompletions
+  {
+    NSUInteger                  count = [self requestsInFlight];
+
+    if ( count == 0 ) return;
+
+    UVCSimulatedPendingRequest  *pending = (UVCSimulatedPendingRequest*)[_pendingRequests mutableBytes];
+    NSTimeInterval              earliest = pending[0].completeAt, now;
+    NSUInteger                  i, doneCount = 0, keepCount = 0;
+
+    for ( i = 1; i < count; i++ ) if ( pending[i].completeAt < earliest ) earliest = pending[i].completeAt;
+    now = [NSDate timeIntervalSinceReferenceDate];
+    if ( earliest > now ) {
+      [NSThread sleepForTimeInterval:(earliest - now)];
+      now = [NSDate timeIntervalSinceReferenceDate];
+    }
+
+    // Split the finished requests off before calling any callbacks, since a
+    // callback may submit additional requests:
+    UVCSimulatedPendingRequest  done[count];
+
+    for ( i = 0; i < count; i++ ) {
+      if ( pending[i].completeAt <= now ) {
+        done[doneCount++] = pending[i];
+      } else {
+        pending[keepCount++] = pending[i];
+      }
+    }
+    [_pendingRequests setLength:keepCount * sizeof(UVCSimulatedPendingRequest)];
+    for ( i = 0; i < doneCount; i++ ) done[i].callback(done[i].context, done[i].controlRequest, done[i].result);
+  }
+
+//
+
+  - (BOOL) hasStatusInterruptEndpoint
+  {
+    return _hasStatusInterruptEndpoint;
+  }
+
+//
+
+  - (IOReturn) readStatusPacket:(void*)buffer
+    length:(NSUInteger*)length
+    timeout:(NSTimeInterval)timeout
+  {
+    NSTimeInterval            now = [NSDate timeIntervalSinceReferenceDate];
+    NSTimeInterval            deadline = now + timeout;
+
+    if ( ! _hasStatusInterruptEndpoint ) return kIOReturnUnsupported;
+    if ( ! _isOpen && ! [self open] ) return kIOReturnNotOpen;
+
+    while ( 1 ) {
+      UVCSimulatedStatusPacket  *packet = (UVCSimulatedStatusPacket*)[_statusPackets mutableBytes];
+      NSTimeInterval            wakeAt = deadline;
+
+      [self generateValueChangesUntil:now];
+      if ( [_statusPackets length] ) {
+        // Packets are queued in order of delivery:
+        if ( packet->deliverAt <= now ) {
+          if ( *length > packet->length ) *length = packet->length;
+          memcpy(buffer, packet->bytes, *length);
+          [_statusPackets replaceBytesInRange:NSMakeRange(0, sizeof(UVCSimulatedStatusPacket)) withBytes:NULL length:0];
+          return kIOReturnSuccess;
+        }
+        if ( packet->deliverAt < wakeAt ) wakeAt = packet->deliverAt;
+      }
+      if ( (_valueChangeInterval > 0) && (_nextValueChangeAt < wakeAt) ) wakeAt = _nextValueChangeAt;
+      if ( now >= deadline ) return kIOReturnTimeout;
+      if ( wakeAt > now ) [NSThread sleepForTimeInterval:(wakeAt - now)];
+      now = [NSDate timeIntervalSinceReferenceDate];
+    }
+  }
+
+//
+
+  - (NSTimeInterval) requestTimeout
+  {
+    return _requestTimeout;
+  }
+  - (void) setRequestTimeout:(NSTimeInterval)requestTimeout
+  {
+    _requestTimeout = ( requestTimeout > 0 ) ? requestTimeout : 0;
+  }
+
+@end
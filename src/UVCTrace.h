@@ -0,0 +1,268 @@
+//
+//  UVCTrace.h
+//
+//  Recording and replay of UVC control transfers.
+//
+//  Copyright © 2016
+//  Dr. Jeffrey Frey, IT-NSS
+//  University of Delaware
+//
+// $Id$
+//
+
+#import "UVCTransport.h"
+
+@class UVCController;
+
+/*!
+  @defined UVCTraceMagic
+
+  The eight bytes at the start of every trace file.
+*/
+#define UVCTraceMagic                 "UVCTRACE"
+
+/*!
+  @defined UVCTraceVersion
+
+  Version of the trace format written by UVCTraceRecorder.
+*/
+#define UVCTraceVersion               1
+
+/*!
+  @defined UVCTraceHeaderSize
+
+  Size (in bytes) of the fixed part of the trace file header.
+*/
+#define UVCTraceHeaderSize            24
+
+/*!
+  @defined UVCTraceRecordHeaderSize
+
+  Size (in bytes) of the fixed part of each trace record.
+*/
+#define UVCTraceRecordHeaderSize      24
+
+/*!
+  @defined UVCTraceReplaySearchWindow
+
+  Number of trace records, starting at the first one not yet replayed, in
+  which UVCTraceReplayTransport looks for a request.  Requests that were
+  pipelined complete (and so are recorded) in an order that need not match
+  the order in which they are replayed.
+*/
+#define UVCTraceReplaySearchWindow    64
+
+/*!
+  @enum UVCTraceRecordFlags
+
+  Flags in the record header:
+
+    - kUVCTraceRecordAsynchronous:  the request was submitted with
+      submitControlRequest:callback:context: rather than sent synchronously
+*/
+enum {
+  kUVCTraceRecordAsynchronous     = 1 << 0
+};
+
+/*!
+  @typedef UVCTraceReplayTiming
+
+  How UVCTraceReplayTransport paces its answers:
+
+    - kUVCTraceReplayTimingNone:  requests complete as soon as they are made
+      (as fast as possible)
+    - kUVCTraceReplayTimingLatency:  each request takes as long as it did
+      when the trace was recorded
+    - kUVCTraceReplayTimingOriginal:  in addition, a request does not start
+      before the offset (from the start of the trace) at which it was
+      originally made, reproducing the original session's timeline
+*/
+typedef enum {
+  kUVCTraceReplayTimingNone       = 0,
+  kUVCTraceReplayTimingLatency,
+  kUVCTraceReplayTimingOriginal
+} UVCTraceReplayTiming;
+
+/*!
+  @function UVCTraceReplayTimingWithName
+
+  Returns the timing mode named "none" (or "fast"), "latency", or "original"
+  in *timing.  Returns NO if name is not recognized.
+*/
+BOOL UVCTraceReplayTimingWithName(const char *name, UVCTraceReplayTiming *timing);
+
+/*!
+  @class UVCTraceRecorder
+  @abstract UVCTransport that records every control transfer to a trace file.
+
+  A recorder wraps another transport and forwards every request to it,
+  appending a record to the trace as each request completes.  The trace is a
+  compact binary file, all integers little-endian:
+
+    header (24 bytes):
+      magic[8] "UVCTRACE", version (UInt16), vendorId (UInt16),
+      productId (UInt16), nameLength (UInt16), locationId (UInt32),
+      descriptorLength (UInt16), reserved (UInt16)
+    device name (nameLength bytes of UTF-8)
+    VideoControl descriptor block (descriptorLength bytes)
+    records, each:
+      startDelta (SInt32, microseconds since the previous record's start;
+        the first record's is relative to the start of the trace),
+      duration (UInt32, microseconds from submission to completion),
+      result (UInt32, the IOReturn), bmRequestType, bRequest (UInt8),
+      wValue, wIndex, wLength, wLenDone (UInt16), flags, reserved (UInt8)
+      payload:  the wLenDone bytes returned by the device for a
+        device-to-host request, the wLength bytes sent for a host-to-device
+        request
+
+  Records are written in order of completion.  Status packets read from the
+  wrapped transport's interrupt endpoint are passed through but not recorded.
+*/
+@interface UVCTraceRecorder : NSObject <UVCTransport>
+{
+  id<UVCTransport>      _transport;
+  FILE                  *_traceFile;
+  NSTimeInterval        _startTime, _lastRecordStart;
+  NSUInteger            _recordCount;
+}
+
+/*!
+  @method traceRecorderForController:path:
+
+  Returns an autoreleased instance that wraps the transport of controller and
+  writes a trace (with the controller's device name, ids, and descriptor
+  block in its header) to the file at path.  The caller makes it the
+  controller's transport with setTransport:.
+
+  Returns nil if the file could not be created.
+*/
++ (UVCTraceRecorder*) traceRecorderForController:(UVCController*)controller path:(NSString*)path;
+
+/*!
+  @method transport
+
+  Returns the transport the receiver forwards requests to.
+*/
+- (id<UVCTransport>) transport;
+
+/*!
+  @method recordCount
+
+  Returns the number of records written so far.
+*/
+- (NSUInteger) recordCount;
+
+/*!
+  @method flush
+
+  Write any buffered records to the trace file.
+*/
+- (void) flush;
+
+@end
+
+/*!
+  @class UVCTraceReplayTransport
+  @abstract UVCTransport that answers requests from a recorded trace.
+
+  The trace is read into memory when the transport is created.  Each request
+  is matched against the trace by its setup fields (bmRequestType, bRequest,
+  wValue, wIndex, wLength):  the first unreplayed record in the next
+  UVCTraceReplaySearchWindow records that matches is used, so a session that
+  repeats the recorded one replays the trace in order.  A request that has no
+  such record (the session diverged from the recorded one) is answered by the
+  closest matching record anywhere in the trace; a request that was never
+  recorded stalls, as would a device that lacks the control.
+
+  Device-to-host requests receive the recorded payload; the recorded result
+  is returned for every request.  The trace does not change as values are
+  written, so reading a control after setting it returns the recorded value.
+*/
+@interface UVCTraceReplayTransport : NSObject <UVCTransport>
+{
+  NSData                *_traceData;
+  NSString              *_deviceName;
+  UInt16                _vendorId, _productId;
+  UInt32                _locationId;
+  NSData                *_videoControlDescriptors;
+  void                  *_records;
+  NSUInteger            _recordCount;
+  UInt8                 *_isReplayed;
+  NSUInteger            _cursor;
+  NSMutableData         *_pendingRequests;
+  UVCTraceReplayTiming  _timing;
+  NSTimeInterval        _replayStartTime;
+  NSUInteger            _replayedCount, _divergedCount, _missingCount;
+  BOOL                  _isOpen;
+}
+
+/*!
+  @method traceReplayTransportWithPath:timing:
+
+  Returns an autoreleased instance that replays the trace at path with the
+  given timing.  Returns nil if the file could not be read or is not a valid
+  trace.
+*/
++ (UVCTraceReplayTransport*) traceReplayTransportWithPath:(NSString*)path timing:(UVCTraceReplayTiming)timing;
+
+/*!
+  @method controller
+
+  Returns an autoreleased UVCController that delivers its requests via the
+  receiver, with the device name, ids, and descriptor block recorded in the
+  trace.
+*/
+- (UVCController*) controller;
+
+/*!
+  @method timing
+
+  Returns the receiver's replay timing mode.
+*/
+- (UVCTraceReplayTiming) timing;
+
+/*!
+  @method setTiming:
+
+  Set the receiver's replay timing mode.  The original timeline (see
+  kUVCTraceReplayTimingOriginal) starts over with the next request.
+*/
+- (void) setTiming:(UVCTraceReplayTiming)timing;
+
+/*!
+  @method recordCount
+
+  Returns the number of records in the trace.
+*/
+- (NSUInteger) recordCount;
+
+/*!
+  @method replayedCount
+
+  Returns the number of requests answered in trace order.
+*/
+- (NSUInteger) replayedCount;
+
+/*!
+  @method divergedCount
+
+  Returns the number of requests answered by a record outside the search
+  window (the session diverged from the recorded one).
+*/
+- (NSUInteger) divergedCount;
+
+/*!
+  @method missingCount
+
+  Returns the number of requests that had no matching record at all.
+*/
+- (NSUInteger) missingCount;
+
+/*!
+  @method rewind
+
+  Start replaying the trace from its first record again.
+*/
+- (void) rewind;
+
+@end
@@ -0,0 +1,812 @@
+//
+//  UVCTrace.m
+//
+//  Recording and replay of UVC control transfers.
+//
+//  Copyright © 2016
+//  Dr. Jeffrey Frey, IT-NSS
+//  University of Delaware
+//
+// $Id$
+//
+
+#import "UVCTrace.h"
+#import "UVCController.h"
+
+#include <math.h>
+#include <strings.h>
+
+/*!
+  @typedef UVCTraceReplayRecord
+
+  A trace record decoded by UVCTraceReplayTransport; the payload remains in
+  the trace data.
+*/
+typedef struct {
+  NSTimeInterval                  startOffset;
+  NSTimeInterval                  duration;
+  IOReturn                        result;
+  UInt8                           bmRequestType;
+  UInt8                           bRequest;
+  UInt8                           flags;
+  UInt16                          wValue, wIndex, wLength, wLenDone;
+  NSUInteger                      payloadOffset, payloadLength;
+} UVCTraceReplayRecord;
+
+typedef struct {
+  IOUSBDevRequest                 *controlRequest;
+  UVCTransportCompletionCallback  callback;
+  void                            *context;
+  NSTimeInterval                  completeAt;
+  IOReturn                        result;
+} UVCTraceReplayPendingRequest;
+
+typedef struct {
+  UVCTraceRecorder                *recorder;
+  UVCTransportCompletionCallback  callback;
+  void                            *context;
+  NSTimeInterval                  startTime;
+} UVCTraceRecorderPendingRequest;
+
+//
+
+static inline void
+UVCTraceWriteU16(
+  UInt8       *p,
+  UInt16      v
+)
+{
+  p[0] = v & 0xFF;
+  p[1] = (v >> 8) & 0xFF;
+}
+
+static inline void
+UVCTraceWriteU32(
+  UInt8       *p,
+  UInt32      v
+)
+{
+  p[0] = v & 0xFF;
+  p[1] = (v >> 8) & 0xFF;
+  p[2] = (v >> 16) & 0xFF;
+  p[3] = (v >> 24) & 0xFF;
+}
+
+static inline UInt16
+UVCTraceReadU16(
+  const UInt8 *p
+)
+{
+  return (UInt16)p[0] | ((UInt16)p[1] << 8);
+}
+
+static inline UInt32
+UVCTraceReadU32(
+  const UInt8 *p
+)
+{
+  return (UInt32)p[0] | ((UInt32)p[1] << 8) | ((UInt32)p[2] << 16) | ((UInt32)p[3] << 24);
+}
+
+//
+
+/*!
+  @function UVCTracePayloadLength
+
+  Returns the number of payload bytes that accompany a request in the trace.
+*/
+static inline NSUInteger
+UVCTracePayloadLength(
+  UInt8       bmRequestType,
+  UInt16      wLength,
+  UInt16      wLenDone
+)
+{
+  return ( (bmRequestType & 0x80) ? ((wLenDone < wLength) ? wLenDone : wLength) : wLength );
+}
+
+//
+
+BOOL
+UVCTraceReplayTimingWithName(
+  const char            *name,
+  UVCTraceReplayTiming  *timing
+)
+{
+  if ( ! name ) return NO;
+  if ( strcasecmp(name, "none") == 0 || strcasecmp(name, "fast") == 0 ) {
+    *timing = kUVCTraceReplayTimingNone;
+  } else if ( strcasecmp(name, "latency") == 0 ) {
+    *timing = kUVCTraceReplayTimingLatency;
+  } else if ( strcasecmp(name, "original") == 0 ) {
+    *timing = kUVCTraceReplayTimingOriginal;
+  } else {
+    return NO;
+  }
+  return YES;
+}
+
+//
+#if 0
+#pragma mark -
+#endif
+//
+
+@interface UVCTraceRecorder(UVCTraceRecorderPrivate)
+
+/*!
+  @method initWithTransport:traceFile:
+
+  Designated initializer; the receiver takes ownership of traceFile, whose
+  header has already been written.
+*/
+- (id) initWithTransport:(id<UVCTransport>)transport traceFile:(FILE*)traceFile;
+
+/*!
+  @method writeRecordForRequest:startTime:result:flags:
+
+  Append a record of the completed controlRequest (made at startTime) to the
+  trace.
+*/
+- (void) writeRecordForRequest:(const IOUSBDevRequest*)controlRequest startTime:(NSTimeInterval)startTime result:(IOReturn)result flags:(UInt8)flags;
+
+@end
+
+//
+
+static void
+UVCTraceRecorderCompletion(
+  void                            *context,
+  IOUSBDevRequest                 *controlRequest,
+  IOReturn                        result
+)
+{
+  UVCTraceRecorderPendingRequest  *pending = (UVCTraceRecorderPendingRequest*)context;
+
+  [pending->recorder writeRecordForRequest:controlRequest startTime:pending->startTime result:result flags:kUVCTraceRecordAsynchronous];
+  pending->callback(pending->context, controlRequest, result);
+  free(pending);
+}
+
+//
+
+@implementation UVCTraceRecorder(UVCTraceRecorderPrivate)
+
+  - (id) initWithTransport:(id<UVCTransport>)transport
+    traceFile:(FILE*)traceFile
+  {
+    if ( (self = [super init]) ) {
+      _transport = [transport retain];
+      _traceFile = traceFile;
+      _startTime = _lastRecordStart = [NSDate timeIntervalSinceReferenceDate];
+    }
+    return self;
+  }
+
+//
+
+  - (void) writeRecordForRequest:(const IOUSBDevRequest*)controlRequest
+    startTime:(NSTimeInterval)startTime
+    result:(IOReturn)result
+    flags:(UInt8)flags
+  {
+    UInt8                 header[UVCTraceRecordHeaderSize];
+    double                startDelta = round(1e6 * (startTime - _lastRecordStart));
+    double                duration = round(1e6 * ([NSDate timeIntervalSinceReferenceDate] - startTime));
+    NSUInteger            payloadLength = UVCTracePayloadLength(controlRequest->bmRequestType, controlRequest->wLength, controlRequest->wLenDone);
+
+    if ( startDelta > INT32_MAX ) startDelta = INT32_MAX;
+    if ( startDelta < INT32_MIN ) startDelta = INT32_MIN;
+    if ( duration < 0 ) duration = 0;
+    if ( duration > UINT32_MAX ) duration = UINT32_MAX;
+
+    // Accumulate the rounded deltas so that start times do not drift:
+    _lastRecordStart += startDelta / 1e6;
+
+    UVCTraceWriteU32(&header[0], (UInt32)(SInt32)startDelta);
+    UVCTraceWriteU32(&header[4], (UInt32)duration);
+    UVCTraceWriteU32(&header[8], (UInt32)result);
+    header[12] = controlRequest->bmRequestType;
+    header[13] = controlRequest->bRequest;
+    UVCTraceWriteU16(&header[14], controlRequest->wValue);
+    UVCTraceWriteU16(&header[16], controlRequest->wIndex);
+    UVCTraceWriteU16(&header[18], controlRequest->wLength);
+    UVCTraceWriteU16(&header[20], (UInt16)controlRequest->wLenDone);
+    header[22] = flags;
+    header[23] = 0;
+    fwrite(header, sizeof(header), 1, _traceFile);
+    if ( payloadLength && controlRequest->pData ) fwrite(controlRequest->pData, payloadLength, 1, _traceFile);
+    _recordCount++;
+  }
+
+@end
+
+//
+#if 0
+#pragma mark -
+#endif
+//
+
+@implementation UVCTraceRecorder
+
+  + (UVCTraceRecorder*) traceRecorderForController:(UVCController*)controller
+    path:(NSString*)path
+  {
+    NSData                *name = [[controller deviceName] dataUsingEncoding:NSUTF8StringEncoding];
+    NSData                *descriptors = [controller videoControlDescriptors];
+    UInt8                 header[UVCTraceHeaderSize];
+    FILE                  *traceFile;
+
+    if ( [name length] > 0xFFFF ) name = [name subdataWithRange:NSMakeRange(0, 0xFFFF)];
+    if ( [descriptors length] > 0xFFFF ) descriptors = nil;
+
+    if ( ! (traceFile = fopen([path fileSystemRepresentation], "wb")) ) return nil;
+
+    memcpy(header, UVCTraceMagic, 8);
+    UVCTraceWriteU16(&header[8], UVCTraceVersion);
+    UVCTraceWriteU16(&header[10], [controller vendorId]);
+    UVCTraceWriteU16(&header[12], [controller productId]);
+    UVCTraceWriteU16(&header[14], (UInt16)[name length]);
+    UVCTraceWriteU32(&header[16], [controller locationId]);
+    UVCTraceWriteU16(&header[20], (UInt16)[descriptors length]);
+    UVCTraceWriteU16(&header[22], 0);
+    if ( (fwrite(header, sizeof(header), 1, traceFile) != 1) ||
+         ([name length] && (fwrite([name bytes], [name length], 1, traceFile) != 1)) ||
+         ([descriptors length] && (fwrite([descriptors bytes], [descriptors length], 1, traceFile) != 1))
+    ) {
+      fclose(traceFile);
+      return nil;
+    }
+    return [[[self alloc] initWithTransport:[controller transport] traceFile:traceFile] autorelease];
+  }
+
+//
+
+  - (void) dealloc
+  {
+    if ( _traceFile ) fclose(_traceFile);
+    if ( _transport ) [_transport release];
+    [super dealloc];
+  }
+
+//
+
+  - (NSString*) description
+  {
+    return [NSString stringWithFormat:@"UVCTraceRecorder@%p { records: %lu; transport: %@ }",
+                        self,
+                        (unsigned long)_recordCount,
+                        _transport
+                      ];
+  }
+
+//
+
+  - (id<UVCTransport>) transport
+  {
+    return _transport;
+  }
+
+//
+
+  - (NSUInteger) recordCount
+  {
+    return _recordCount;
+  }
+
+//
+
+  - (void) flush
+  {
+    if ( _traceFile ) fflush(_traceFile);
+  }
+
+//
+
+  - (BOOL) isOpen
+  {
+    return [_transport isOpen];
+  }
+
+//
+
+  - (BOOL) open
+  {
+    return [_transport open];
+  }
+
+//
+
+  - (void) close
+  {
+    [_transport close];
+    [self flush];
+  }
+
+//
+
+  - (IOReturn) sendControlRequest:(IOUSBDevRequest*)controlRequest
+  {
+    NSTimeInterval      startTime = [NSDate timeIntervalSinceReferenceDate];
+    IOReturn            result = [_transport sendControlRequest:controlRequest];
+
+    [self writeRecordForRequest:controlRequest startTime:startTime result:result flags:0];
+    return result;
+  }
+
+//
+
+  - (IOReturn) submitControlRequest:(IOUSBDevRequest*)controlRequest
+    callback:(UVCTransportCompletionCallback)callback
+    context:(void*)context
+  {
+    UVCTraceRecorderPendingRequest  *pending = malloc(sizeof(UVCTraceRecorderPendingRequest));
+    IOReturn                        result;
+
+    if ( ! pending ) return kIOReturnNoMemory;
+    pending->recorder = self;
+    pending->callback = callback;
+    pending->context = context;
+    pending->startTime = [NSDate timeIntervalSinceReferenceDate];
+    result = [_transport submitControlRequest:controlRequest callback:UVCTraceRecorderCompletion context:pending];
+    if ( result != kIOReturnSuccess ) {
+      // A request the transport refused never reaches the device:
+      free(pending);
+    }
+    return result;
+  }
+
+//
+
+  - (NSUInteger) requestsInFlight
+  {
+    return [_transport requestsInFlight];
+  }
+
+//
+
+  - (void) waitForCompletions
+  {
+    [_transport waitForCompletions];
+  }
+
+//
+
+  - (BOOL) hasStatusInterruptEndpoint
+  {
+    if ( [_transport respondsToSelector:@selector(hasStatusInterruptEndpoint)] ) return [_transport hasStatusInterruptEndpoint];
+    return NO;
+  }
+
+//
+
+  - (IOReturn) readStatusPacket:(void*)buffer
+    length:(NSUInteger*)length
+    timeout:(NSTimeInterval)timeout
+  {
+    if ( [_transport respondsToSelector:@selector(readStatusPacket:length:timeout:)] ) return [_transport readStatusPacket:buffer length:length timeout:timeout];
+    return kIOReturnUnsupported;
+  }
+
+//
+
+  - (NSTimeInterval) requestTimeout
+  {
+    if ( [_transport respondsToSelector:@selector(requestTimeout)] ) return [_transport requestTimeout];
+    return 0;
+  }
+  - (void) setRequestTimeout:(NSTimeInterval)requestTimeout
+  {
+    if ( [_transport respondsToSelector:@selector(setRequestTimeout:)] ) [_transport setRequestTimeout:requestTimeout];
+  }
+
+@end
+
+//
+#if 0
+#pragma mark -
+#endif
+//
+
+@interface UVCTraceReplayTransport(UVCTraceReplayTransportPrivate)
+
+/*!
+  @method initWithTraceData:timing:
+
+  Designated initializer.  Returns nil if traceData is not a valid trace.  A
+  trace that ends part-way through a record (e.g. the recording process was
+  killed) is accepted up to its last complete record.
+*/
+- (id) initWithTraceData:(NSData*)traceData timing:(UVCTraceReplayTiming)timing;
+
+/*!
+  @method recordForRequest:
+
+  Returns the trace record that answers controlRequest, or NULL if the trace
+  has none.
+*/
+- (const UVCTraceReplayRecord*) recordForRequest:(const IOUSBDevRequest*)controlRequest;
+
+/*!
+  @method answerRequest:withRecord:completeAt:
+
+  Fill-in controlRequest's data and wLenDone from record and return the
+  recorded result.  The time at which the request completes, according to the
+  receiver's timing mode, is returned in completeAt.
+*/
+- (IOReturn) answerRequest:(IOUSBDevRequest*)controlRequest withRecord:(const UVCTraceReplayRecord*)record completeAt:(NSTimeInterval*)completeAt;
+
+@end
+
+@implementation UVCTraceReplayTransport(UVCTraceReplayTransportPrivate)
+
+  - (id) initWithTraceData:(NSData*)traceData
+    timing:(UVCTraceReplayTiming)timing
+  {
+    const UInt8             *bytes = [traceData bytes];
+    NSUInteger              length = [traceData length], offset, nameLength, descriptorLength, capacity = 0;
+    NSTimeInterval          startOffset = 0.0;
+
+    if ( ! (self = [super init]) ) return nil;
+
+    if ( (length < UVCTraceHeaderSize) || memcmp(bytes, UVCTraceMagic, 8) || (UVCTraceReadU16(&bytes[8]) != UVCTraceVersion) ) {
+      [self release];
+      return nil;
+    }
+    nameLength = UVCTraceReadU16(&bytes[14]);
+    descriptorLength = UVCTraceReadU16(&bytes[20]);
+    if ( UVCTraceHeaderSize + nameLength + descriptorLength > length ) {
+      [self release];
+      return nil;
+    }
+    _traceData = [traceData retain];
+    _vendorId = UVCTraceReadU16(&bytes[10]);
+    _productId = UVCTraceReadU16(&bytes[12]);
+    _locationId = UVCTraceReadU32(&bytes[16]);
+    _deviceName = [[NSString alloc] initWithBytes:&bytes[UVCTraceHeaderSize] length:nameLength encoding:NSUTF8StringEncoding];
+    if ( ! _deviceName ) _deviceName = [@"Replayed UVC Camera" retain];
+    if ( descriptorLength ) _videoControlDescriptors = [[NSData alloc] initWithBytes:&bytes[UVCTraceHeaderSize + nameLength] length:descriptorLength];
+    _timing = timing;
+    _pendingRequests = [[NSMutableData alloc] init];
+
+    // Decode the records:
+    offset = UVCTraceHeaderSize + nameLength + descriptorLength;
+    while ( offset + UVCTraceRecordHeaderSize <= length ) {
+      const UInt8           *p = &bytes[offset];
+      UVCTraceReplayRecord  record;
+
+      startOffset += (SInt32)UVCTraceReadU32(&p[0]) / 1e6;
+      record.startOffset = startOffset;
+      record.duration = UVCTraceReadU32(&p[4]) / 1e6;
+      record.result = (IOReturn)UVCTraceReadU32(&p[8]);
+      record.bmRequestType = p[12];
+      record.bRequest = p[13];
+      record.wValue = UVCTraceReadU16(&p[14]);
+      record.wIndex = UVCTraceReadU16(&p[16]);
+      record.wLength = UVCTraceReadU16(&p[18]);
+      record.wLenDone = UVCTraceReadU16(&p[20]);
+      record.flags = p[22];
+      record.payloadOffset = offset + UVCTraceRecordHeaderSize;
+      record.payloadLength = UVCTracePayloadLength(record.bmRequestType, record.wLength, record.wLenDone);
+      if ( record.payloadOffset + record.payloadLength > length ) break;
+
+      if ( _recordCount == capacity ) {
+        void                *newRecords;
+
+        capacity = ( capacity ? 2 * capacity : 256 );
+        if ( ! (newRecords = realloc(_records, capacity * sizeof(UVCTraceReplayRecord))) ) {
+          [self release];
+          return nil;
+        }
+        _records = newRecords;
+      }
+      ((UVCTraceReplayRecord*)_records)[_recordCount++] = record;
+      offset = record.payloadOffset + record.payloadLength;
+    }
+    if ( ! (_isReplayed = calloc(_recordCount ? _recordCount : 1, sizeof(UInt8))) ) {
+      [self release];
+      return nil;
+    }
+    return self;
+  }
+
+//
+
+  - (const UVCTraceReplayRecord*) recordForRequest:(const IOUSBDevRequest*)controlRequest
+  {
+    UVCTraceReplayRecord    *records = (UVCTraceReplayRecord*)_records;
+    NSUInteger              i, windowEnd;
+
+#define UVCTraceReplayRecordMatches(R) ( \
+          ((R)->bRequest == controlRequest->bRequest) && \
+          ((R)->wValue == controlRequest->wValue) && \
+          ((R)->wIndex == controlRequest->wIndex) && \
+          ((R)->wLength == controlRequest->wLength) && \
+          ((R)->bmRequestType == controlRequest->bmRequestType) \
+        )
+
+    while ( (_cursor < _recordCount) && _isReplayed[_cursor] ) _cursor++;
+    windowEnd = _cursor + UVCTraceReplaySearchWindow;
+    if ( windowEnd > _recordCount ) windowEnd = _recordCount;
+
+    for ( i = _cursor; i < windowEnd; i++ ) {
+      if ( ! _isReplayed[i] && UVCTraceReplayRecordMatches(&records[i]) ) {
+        _isReplayed[i] = YES;
+        _replayedCount++;
+        return &records[i];
+      }
+    }
+
+    // Off-script:  prefer the latest matching record before the window, then
+    // the earliest one after it:
+    i = _cursor;
+    while ( i-- > 0 ) {
+      if ( UVCTraceReplayRecordMatches(&records[i]) ) {
+        _divergedCount++;
+        return &records[i];
+      }
+    }
+    for ( i = windowEnd; i < _recordCount; i++ ) {
+      if ( UVCTraceReplayRecordMatches(&records[i]) ) {
+        _divergedCount++;
+        return &records[i];
+      }
+    }
+    _missingCount++;
+    return NULL;
+
+#undef UVCTraceReplayRecordMatches
+  }
+
+//
+
+  - (IOReturn) answerRequest:(IOUSBDevRequest*)controlRequest
+    withRecord:(const UVCTraceReplayRecord*)record
+    completeAt:(NSTimeInterval*)completeAt
+  {
+    NSTimeInterval          now = [NSDate timeIntervalSinceReferenceDate];
+
+    *completeAt = now;
+    controlRequest->wLenDone = 0;
+    if ( ! record ) return kIOUSBPipeStalled;
+
+    switch ( _timing ) {
+
+      case kUVCTraceReplayTimingNone:
+        break;
+
+      case kUVCTraceReplayTimingOriginal: {
+        NSTimeInterval      startAt;
+
+        // The timeline starts with the first request replayed:
+        if ( _replayStartTime <= 0.0 ) _replayStartTime = now - record->startOffset;
+        startAt = _replayStartTime + record->startOffset;
+        *completeAt = ( (startAt > now) ? startAt : now ) + record->duration;
+        break;
+      }
+
+      case kUVCTraceReplayTimingLatency:
+        *completeAt = now + record->duration;
+        break;
+
+    }
+    if ( controlRequest->bmRequestType & 0x80 ) {
+      NSUInteger            count = ( (record->payloadLength < controlRequest->wLength) ? record->payloadLength : controlRequest->wLength );
+
+      if ( count && controlRequest->pData ) memcpy(controlRequest->pData, (const UInt8*)[_traceData bytes] + record->payloadOffset, count);
+      controlRequest->wLenDone = (UInt32)count;
+    } else {
+      controlRequest->wLenDone = ( (record->wLenDone < controlRequest->wLength) ? record->wLenDone : controlRequest->wLength );
+    }
+    return record->result;
+  }
+
+@end
+
+//
+#if 0
+#pragma mark -
+#endif
+//
+
+@implementation UVCTraceReplayTransport
+
+  + (UVCTraceReplayTransport*) traceReplayTransportWithPath:(NSString*)path
+    timing:(UVCTraceReplayTiming)timing
+  {
+    NSData                  *traceData = [NSData dataWithContentsOfFile:path options:NSDataReadingMappedIfSafe error:NULL];
+
+    if ( ! traceData ) return nil;
+    return [[[self alloc] initWithTraceData:traceData timing:timing] autorelease];
+  }
+
+//
+
+  - (void) dealloc
+  {
+    [self close];
+    if ( _records ) free(_records);
+    if ( _isReplayed ) free(_isReplayed);
+    if ( _pendingRequests ) [_pendingRequests release];
+    if ( _videoControlDescriptors ) [_videoControlDescriptors release];
+    if ( _deviceName ) [_deviceName release];
+    if ( _traceData ) [_traceData release];
+    [super dealloc];
+  }
+
+//
+
+  - (NSString*) description
+  {
+    return [NSString stringWithFormat:@"UVCTraceReplayTransport@%p { device: %@; records: %lu; replayed: %lu; diverged: %lu; missing: %lu; in-flight: %lu%s }",
+                        self,
+                        _deviceName,
+                        (unsigned long)_recordCount,
+                        (unsigned long)_replayedCount,
+                        (unsigned long)_divergedCount,
+                        (unsigned long)_missingCount,
+                        (unsigned long)[self requestsInFlight],
+                        (_isOpen ? "; is-open" : "")
+                      ];
+  }
+
+//
+
+  - (UVCController*) controller
+  {
+    return [UVCController uvcControllerWithTransport:self
+                              deviceName:_deviceName
+                              vendorId:_vendorId
+                              productId:_productId
+                              locationId:_locationId
+                              videoControlDescriptors:_videoControlDescriptors
+                            ];
+  }
+
+//
+
+  - (UVCTraceReplayTiming) timing
+  {
+    return _timing;
+  }
+  - (void) setTiming:(UVCTraceReplayTiming)timing
+  {
+    _timing = timing;
+    _replayStartTime = 0.0;
+  }
+
+//
+
+  - (NSUInteger) recordCount
+  {
+    return _recordCount;
+  }
+
+//
+
+  - (NSUInteger) replayedCount
+  {
+    return _replayedCount;
+  }
+
+//
+
+  - (NSUInteger) divergedCount
+  {
+    return _divergedCount;
+  }
+
+//
+
+  - (NSUInteger) missingCount
+  {
+    return _missingCount;
+  }
+
+//
+
+  - (void) rewind
+  {
+    while ( [self requestsInFlight] ) [self waitForCompletions];
+    if ( _recordCount ) memset(_isReplayed, 0, _recordCount);
+    _cursor = 0;
+    _replayStartTime = 0.0;
+  }
+
+//
+
+  - (BOOL) isOpen
+  {
+    return _isOpen;
+  }
+
+//
+
+  - (BOOL) open
+  {
+    _isOpen = YES;
+    return YES;
+  }
+
+//
+
+  - (void) close
+  {
+    while ( [self requestsInFlight] ) [self waitForCompletions];
+    _isOpen = NO;
+  }
+
+//
+
+  - (IOReturn) sendControlRequest:(IOUSBDevRequest*)controlRequest
+  {
+    NSTimeInterval          completeAt, delay;
+    IOReturn                result;
+
+    if ( ! _isOpen && ! [self open] ) return kIOReturnNotOpen;
+    result = [self answerRequest:controlRequest withRecord:[self recordForRequest:controlRequest] completeAt:&completeAt];
+    delay = completeAt - [NSDate timeIntervalSinceReferenceDate];
+    if ( delay > 0 ) [NSThread sleepForTimeInterval:delay];
+    return result;
+  }
+
+//
+
+  - (IOReturn) submitControlRequest:(IOUSBDevRequest*)controlRequest
+    callback:(UVCTransportCompletionCallback)callback
+    context:(void*)context
+  {
+    UVCTraceReplayPendingRequest  pending = {
+                                      .controlRequest = controlRequest,
+                                      .callback = callback,
+                                      .context = context
+                                    };
+
+    if ( ! _isOpen && ! [self open] ) return kIOReturnNotOpen;
+    pending.result = [self answerRequest:controlRequest withRecord:[self recordForRequest:controlRequest] completeAt:&pending.completeAt];
+    [_pendingRequests appendBytes:&pending length:sizeof(pending)];
+    return kIOReturnSuccess;
+  }
+
+//
+
+  - (NSUInteger) requestsInFlight
+  {
+    return [_pendingRequests length] / sizeof(UVCTraceReplayPendingRequest);
+  }
+
+//
+
+  - (void) waitForCompletions
+  {
+    NSUInteger                    count = [self requestsInFlight];
+
+    if ( count == 0 ) return;
+
+    UVCTraceReplayPendingRequest  *pending = (UVCTraceReplayPendingRequest*)[_pendingRequests mutableBytes];
+    NSTimeInterval                earliest = pending[0].completeAt, now;
+    NSUInteger                    i, doneCount = 0, keepCount = 0;
+
+    for ( i = 1; i < count; i++ ) if ( pending[i].completeAt < earliest ) earliest = pending[i].completeAt;
+    now = [NSDate timeIntervalSinceReferenceDate];
+    if ( earliest > now ) {
+      [NSThread sleepForTimeInterval:(earliest - now)];
+      now = [NSDate timeIntervalSinceReferenceDate];
+    }
+
+    // Split the finished requests off before calling any callbacks, since a
+    // callback may submit additional requests:
+    UVCTraceReplayPendingRequest  done[count];
+
+    for ( i = 0; i < count; i++ ) {
+      if ( pending[i].completeAt <= now ) {
+        done[doneCount++] = pending[i];
+      } else {
+        pending[keepCount++] = pending[i];
+      }
+    }
+    [_pendingRequests setLength:keepCount * sizeof(UVCTraceReplayPendingRequest)];
+    for ( i = 0; i < doneCount; i++ ) done[i].callback(done[i].context, done[i].controlRequest, done[i].result);
+  }
+
+@end
@@ -0,0 +1,144 @@
+//
+//  UVCTrajectory.h
+//
+//  Rate-limited, deadline-driven moves of absolute UVC controls.
+//
+//  Copyright © 2016
+//  Dr. Jeffrey Frey, IT-NSS
+//  University of Delaware
+//
+// $Id$
+//
+
+#import "UVCController.h"
+
+/*!
+  @defined UVCTrajectoryDefaultUpdateRate
+
+  Default number of points per second written by a UVCTrajectory.
+*/
+#define UVCTrajectoryDefaultUpdateRate    30.0
+
+/*!
+  @typedef UVCTrajectoryStatistics
+
+  Summary of a UVCTrajectory run:
+
+    - pointCount:  points in the trajectory (one per tick of the update
+      rate; the last is the target value)
+    - writeCount:  points written to the device (SET_CUR transfers issued)
+    - unchangedCount:  points not written because, once aligned to the
+      control's step size, they equalled the previous point
+    - droppedCount:  points skipped because their deadline had already
+      passed when the device was ready for the next write
+    - deadlineMissCount:  writes that completed after the next point's
+      deadline (each is the cause of one or more dropped points unless it
+      was the last)
+    - failedCount:  writes the device rejected (the run stops at the first)
+    - elapsedTime:  duration of the run, from its start until the last
+      write completed
+    - maximumLateness:  largest delay between a point's deadline and the
+      start of its write
+    - achievedRate:  points delivered to the device (written or unchanged)
+      per second of elapsedTime
+*/
+typedef struct {
+  NSUInteger        pointCount;
+  NSUInteger        writeCount;
+  NSUInteger        unchangedCount;
+  NSUInteger        droppedCount;
+  NSUInteger        deadlineMissCount;
+  NSUInteger        failedCount;
+  NSTimeInterval    elapsedTime;
+  NSTimeInterval    maximumLateness;
+  double            achievedRate;
+} UVCTrajectoryStatistics;
+
+/*!
+  @class UVCTrajectory
+  @abstract A timed move of a control from its current value to a target.
+
+  Absolute controls like pan-tilt-abs, zoom-abs, and focus-abs jump straight
+  to a new value when written.  A trajectory instead moves the control
+  there over a given duration (or at a given velocity) by writing a series
+  of intermediate values at a fixed update rate.
+
+  Each integer component of the control is interpolated linearly between
+  the value read from the device when the run starts and the target; the
+  intermediate values are aligned to multiples of the control's step size
+  (counting from its minimum) and kept within its minimum and maximum.
+  Other components (booleans, bitmaps) take the target value at the first
+  point.
+
+  Writes are paced by deadlines:  point i is due i / updateRate seconds
+  after the start.  The run waits for each deadline; if a write takes so
+  long that later deadlines have already passed, those points are dropped
+  (rather than queued) and the most recent due point is written next.  The
+  final point -- the target itself -- is never dropped.
+*/
+@interface UVCTrajectory : NSObject
+{
+  UVCControl          *_control;
+  UVCValue            *_target;
+  NSTimeInterval      _duration;
+  double              _velocity;
+  double              _updateRate;
+}
+
+/*!
+  @method trajectoryWithControl:target:duration:
+
+  Returns an autoreleased trajectory that moves control to the value target
+  (of the control's type, in host byte order) over duration seconds.
+*/
++ (UVCTrajectory*) trajectoryWithControl:(UVCControl*)control target:(UVCValue*)target duration:(NSTimeInterval)duration;
+
+/*!
+  @method trajectoryWithControl:target:velocity:
+
+  Returns an autoreleased trajectory that moves control to the value target
+  at velocity units per second.  The duration is determined when the run
+  starts, by the component with the furthest to travel.
+*/
++ (UVCTrajectory*) trajectoryWithControl:(UVCControl*)control target:(UVCValue*)target velocity:(double)velocity;
+
+/*!
+  @method control
+
+  Returns the control the receiver moves.
+*/
+- (UVCControl*) control;
+
+/*!
+  @method target
+
+  Returns the value the receiver moves the control to.
+*/
+- (UVCValue*) target;
+
+/*!
+  @method updateRate
+
+  Returns the number of points per second the receiver writes.
+*/
+- (double) updateRate;
+
+/*!
+  @method setUpdateRate:
+
+  Set the number of points per second the receiver writes (default
+  UVCTrajectoryDefaultUpdateRate).  Non-positive values are ignored.
+*/
+- (void) setUpdateRate:(double)updateRate;
+
+/*!
+  @method runWithStatistics:
+
+  Read the control's current value and move it to the target, returning
+  when the target has been written.  If stats is not NULL it is filled-in
+  with a summary of the run.  Returns NO if the control could not be read
+  or a write failed.
+*/
+- (BOOL) runWithStatistics:(UVCTrajectoryStatistics*)stats;
+
+@end
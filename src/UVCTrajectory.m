@@ -0,0 +1,412 @@
+//
+//  UVCTrajectory.m
+//
+//  Rate-limited, deadline-driven moves of absolute UVC controls.
+//
+//  Copyright © 2016
+//  Dr. Jeffrey Frey, IT-NSS
+//  University of Delaware
+//
+// $Id$
+//
+
+#import "UVCTrajectory.h"
+#import "UVCValue.h"
+
+#include <math.h>
+
+/*!
+  @typedef UVCTrajectoryComponent
+
+  Interpolation plan for one field of the control's value:  where it starts
+  and ends, and the grid (minimum, maximum, step size) its intermediate
+  values are aligned to.
+*/
+typedef struct {
+  UVCTypeComponentType  componentType;
+  NSUInteger            offset;
+  BOOL                  isInterpolated;
+  BOOL                  hasRange;
+  double                start, end;
+  double                minimum, maximum, step;
+} UVCTrajectoryComponent;
+
+//
+
+static BOOL
+UVCTrajectoryComponentTypeIsInterpolated(
+  UVCTypeComponentType  componentType
+)
+{
+  switch ( componentType ) {
+    case kUVCTypeComponentTypeSInt8:
+    case kUVCTypeComponentTypeUInt8:
+    case kUVCTypeComponentTypeSInt16:
+    case kUVCTypeComponentTypeUInt16:
+    case kUVCTypeComponentTypeSInt32:
+    case kUVCTypeComponentTypeUInt32:
+    case kUVCTypeComponentTypeSInt64:
+    case kUVCTypeComponentTypeUInt64:
+      return YES;
+    default:
+      return NO;
+  }
+}
+
+//
+
+static double
+UVCTrajectoryGetComponent(
+  UVCTypeComponentType  componentType,
+  const void            *buffer
+)
+{
+  switch ( componentType ) {
+    case kUVCTypeComponentTypeSInt8:
+      return *((const SInt8*)buffer);
+    case kUVCTypeComponentTypeUInt8:
+      return *((const UInt8*)buffer);
+    case kUVCTypeComponentTypeSInt16: {
+      SInt16    v;
+
+      memcpy(&v, buffer, sizeof(v));
+      return v;
+    }
+    case kUVCTypeComponentTypeUInt16: {
+      UInt16    v;
+
+      memcpy(&v, buffer, sizeof(v));
+      return v;
+    }
+    case kUVCTypeComponentTypeSInt32: {
+      SInt32    v;
+
+      memcpy(&v, buffer, sizeof(v));
+      return v;
+    }
+    case kUVCTypeComponentTypeUInt32: {
+      UInt32    v;
+
+      memcpy(&v, buffer, sizeof(v));
+      return v;
+    }
+    case kUVCTypeComponentTypeSInt64: {
+      SInt64    v;
+
+      memcpy(&v, buffer, sizeof(v));
+      return v;
+    }
+    case kUVCTypeComponentTypeUInt64: {
+      UInt64    v;
+
+      memcpy(&v, buffer, sizeof(v));
+      return v;
+    }
+    default:
+      return 0.0;
+  }
+}
+
+//
+
+static void
+UVCTrajectorySetComponent(
+  UVCTypeComponentType  componentType,
+  void                  *buffer,
+  double                value
+)
+{
+  switch ( componentType ) {
+    case kUVCTypeComponentTypeSInt8:
+      *((SInt8*)buffer) = (SInt8)value;
+      break;
+    case kUVCTypeComponentTypeUInt8:
+      *((UInt8*)buffer) = (UInt8)value;
+      break;
+    case kUVCTypeComponentTypeSInt16: {
+      SInt16    v = (SInt16)value;
+
+      memcpy(buffer, &v, sizeof(v));
+      break;
+    }
+    case kUVCTypeComponentTypeUInt16: {
+      UInt16    v = (UInt16)value;
+
+      memcpy(buffer, &v, sizeof(v));
+      break;
+    }
+    case kUVCTypeComponentTypeSInt32: {
+      SInt32    v = (SInt32)value;
+
+      memcpy(buffer, &v, sizeof(v));
+      break;
+    }
+    case kUVCTypeComponentTypeUInt32: {
+      UInt32    v = (UInt32)value;
+
+      memcpy(buffer, &v, sizeof(v));
+      break;
+    }
+    case kUVCTypeComponentTypeSInt64: {
+      SInt64    v = (SInt64)value;
+
+      memcpy(buffer, &v, sizeof(v));
+      break;
+    }
+    case kUVCTypeComponentTypeUInt64: {
+      UInt64    v = (UInt64)value;
+
+      memcpy(buffer, &v, sizeof(v));
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+//
+
+/*!
+  @function UVCTrajectoryComponentValueAt
+
+  Returns the value of component at fraction (0 to 1) of the way from its
+  start to its end, aligned to a multiple of its step size from its minimum
+  (or from its start if it has no range) and kept within its range.
+*/
+static double
+UVCTrajectoryComponentValueAt(
+  const UVCTrajectoryComponent  *component,
+  double                        fraction
+)
+{
+  double                        value = component->start + (component->end - component->start) * fraction;
+
+  if ( component->hasRange ) {
+    double                      steps = round((value - component->minimum) / component->step);
+    double                      maxSteps = floor((component->maximum - component->minimum) / component->step);
+
+    if ( steps < 0.0 ) steps = 0.0;
+    if ( steps > maxSteps ) steps = maxSteps;
+    return component->minimum + steps * component->step;
+  }
+  return component->start + round((value - component->start) / component->step) * component->step;
+}
+
+//
+#if 0
+#pragma mark -
+#endif
+//
+
+@interface UVCTrajectory(UVCTrajectoryPrivate)
+
+- (id) initWithControl:(UVCControl*)control target:(UVCValue*)target duration:(NSTimeInterval)duration velocity:(double)velocity;
+
+@end
+
+@implementation UVCTrajectory(UVCTrajectoryPrivate)
+
+  - (id) initWithControl:(UVCControl*)control
+    target:(UVCValue*)target
+    duration:(NSTimeInterval)duration
+    velocity:(double)velocity
+  {
+    if ( (self = [super init]) ) {
+      _control = [control retain];
+      _target = [target retain];
+      _duration = duration;
+      _velocity = velocity;
+      _updateRate = UVCTrajectoryDefaultUpdateRate;
+    }
+    return self;
+  }
+
+@end
+
+//
+#if 0
+#pragma mark -
+#endif
+//
+
+@implementation UVCTrajectory
+
+  + (UVCTrajectory*) trajectoryWithControl:(UVCControl*)control
+    target:(UVCValue*)target
+    duration:(NSTimeInterval)duration
+  {
+    if ( ! control || ! target || (duration < 0.0) ) return nil;
+    return [[[UVCTrajectory alloc] initWithControl:control target:target duration:duration velocity:0.0] autorelease];
+  }
+
+//
+
+  + (UVCTrajectory*) trajectoryWithControl:(UVCControl*)control
+    target:(UVCValue*)target
+    velocity:(double)velocity
+  {
+    if ( ! control || ! target || (velocity <= 0.0) ) return nil;
+    return [[[UVCTrajectory alloc] initWithControl:control target:target duration:0.0 velocity:velocity] autorelease];
+  }
+
+//
+
+  - (void) dealloc
+  {
+    if ( _target ) [_target release];
+    if ( _control ) [_control release];
+    [super dealloc];
+  }
+
+//
+
+  - (NSString*) description
+  {
+    return [NSString stringWithFormat:@"UVCTrajectory@%p { control: %@; target: %@; %@: %g; update-rate: %g }",
+                        self,
+                        [_control controlName],
+                        [_target stringValue],
+                        (_velocity > 0.0 ? @"velocity" : @"duration"),
+                        (_velocity > 0.0 ? _velocity : _duration),
+                        _updateRate
+                      ];
+  }
+
+//
+
+  - (UVCControl*) control
+  {
+    return _control;
+  }
+
+//
+
+  - (UVCValue*) target
+  {
+    return _target;
+  }
+
+//
+
+  - (double) updateRate
+  {
+    return _updateRate;
+  }
+  - (void) setUpdateRate:(double)updateRate
+  {
+    if ( updateRate > 0.0 ) _updateRate = updateRate;
+  }
+
+//
+
+  - (BOOL) runWithStatistics:(UVCTrajectoryStatistics*)stats
+  {
+    UVCTrajectoryStatistics   localStats;
+    UVCValue                  *value = [_control valueBuffer];
+    UVCType                   *valueType = [value valueType];
+    NSUInteger                fieldCount = [valueType fieldCount], byteSize = [value byteSize], i;
+    UVCTrajectoryComponent    components[fieldCount];
+    UInt8                     lastWritten[byteSize];
+    UInt8                     *valuePtr = (UInt8*)[value valuePtr];
+    const UInt8               *targetPtr = (const UInt8*)[_target valuePtr];
+    UVCValue                  *minimum = [_control minimum], *maximum = [_control maximum], *stepSize = [_control stepSize];
+    NSTimeInterval            duration = _duration, period, startTime, now;
+    double                    longestDistance = 0.0;
+    NSUInteger                point, pointCount;
+    BOOL                      rc = YES;
+
+    if ( ! stats ) stats = &localStats;
+    memset(stats, 0, sizeof(UVCTrajectoryStatistics));
+    if ( [_target byteSize] != byteSize ) return NO;
+    if ( ! [_control readIntoCurrentValue] ) return NO;
+    memcpy(lastWritten, valuePtr, byteSize);
+
+    //
+    // Plan each component:
+    //
+    for ( i = 0; i < fieldCount; i++ ) {
+      UVCTrajectoryComponent  *component = &components[i];
+
+      component->componentType = [valueType fieldTypeAtIndex:i];
+      component->offset = [valueType offsetToFieldAtIndex:i];
+      component->isInterpolated = UVCTrajectoryComponentTypeIsInterpolated(component->componentType);
+      if ( ! component->isInterpolated ) continue;
+      component->start = UVCTrajectoryGetComponent(component->componentType, valuePtr + component->offset);
+      component->end = UVCTrajectoryGetComponent(component->componentType, targetPtr + component->offset);
+      component->step = ( stepSize ? UVCTrajectoryGetComponent(component->componentType, (UInt8*)[stepSize valuePtr] + component->offset) : 1.0 );
+      if ( component->step < 1.0 ) component->step = 1.0;
+      if ( (component->hasRange = (minimum && maximum)) ) {
+        component->minimum = UVCTrajectoryGetComponent(component->componentType, (UInt8*)[minimum valuePtr] + component->offset);
+        component->maximum = UVCTrajectoryGetComponent(component->componentType, (UInt8*)[maximum valuePtr] + component->offset);
+        if ( component->maximum < component->minimum ) component->hasRange = NO;
+      }
+      if ( fabs(component->end - component->start) > longestDistance ) longestDistance = fabs(component->end - component->start);
+    }
+    if ( _velocity > 0.0 ) duration = longestDistance / _velocity;
+
+    //
+    // One point per tick of the update rate, the last landing exactly at the
+    // end of the duration:
+    //
+    pointCount = (NSUInteger)ceil(duration * _updateRate - 1e-9);
+    if ( pointCount < 1 ) pointCount = 1;
+    period = duration / pointCount;
+    stats->pointCount = pointCount;
+
+    startTime = now = [NSDate timeIntervalSinceReferenceDate];
+    point = 1;
+    while ( point <= pointCount ) {
+      NSTimeInterval          deadline = startTime + point * period;
+
+      now = [NSDate timeIntervalSinceReferenceDate];
+      if ( now < deadline ) {
+        [NSThread sleepForTimeInterval:deadline - now];
+        now = [NSDate timeIntervalSinceReferenceDate];
+      } else if ( (point < pointCount) && (period > 0.0) ) {
+        // Behind schedule:  skip ahead to the latest point already due:
+        NSUInteger            duePoint = (NSUInteger)floor((now - startTime) / period);
+
+        if ( duePoint > pointCount ) duePoint = pointCount;
+        if ( duePoint > point ) {
+          stats->droppedCount += duePoint - point;
+          point = duePoint;
+          deadline = startTime + point * period;
+        }
+      }
+      if ( now - deadline > stats->maximumLateness ) stats->maximumLateness = now - deadline;
+
+      if ( point == pointCount ) {
+        memcpy(valuePtr, targetPtr, byteSize);
+      } else {
+        double                fraction = (double)point / (double)pointCount;
+
+        for ( i = 0; i < fieldCount; i++ ) {
+          UVCTrajectoryComponent  *component = &components[i];
+
+          if ( component->isInterpolated ) {
+            UVCTrajectorySetComponent(component->componentType, valuePtr + component->offset, UVCTrajectoryComponentValueAt(component, fraction));
+          } else {
+            memcpy(valuePtr + component->offset, targetPtr + component->offset, UVCTypeComponentByteSize(component->componentType));
+          }
+        }
+      }
+      if ( memcmp(valuePtr, lastWritten, byteSize) == 0 ) {
+        stats->unchangedCount++;
+      } else if ( [_control writeFromCurrentValue] ) {
+        stats->writeCount++;
+        memcpy(lastWritten, valuePtr, byteSize);
+        now = [NSDate timeIntervalSinceReferenceDate];
+        if ( (point < pointCount) && (now > deadline + period) ) stats->deadlineMissCount++;
+      } else {
+        stats->failedCount++;
+        rc = NO;
+        break;
+      }
+      point++;
+    }
+    stats->elapsedTime = [NSDate timeIntervalSinceReferenceDate] - startTime;
+    if ( stats->elapsedTime > 0.0 ) stats->achievedRate = (stats->writeCount + stats->unchangedCount) / stats->elapsedTime;
+    return rc;
+  }
+
+@end
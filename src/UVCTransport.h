@@ -0,0 +1,200 @@
+//
+//  UVCTransport.h
+//
+//  Abstract delivery mechanism for UVC control requests.
+//
+//  Copyright © 2016
+//  Dr. Jeffrey Frey, IT-NSS
+//  University of Delaware
+//
+// $Id$
+//
+
+#import <Foundation/Foundation.h>
+
+#include <IOKit/IOKitLib.h>
+#include <IOKit/usb/IOUSBLib.h>
+
+/*!
+  @typedef UVCTransportCompletionCallback
+
+  Function called when an asynchronous control request submitted to a
+  transport has finished.  The controlRequest is the same pointer that was
+  passed to submitControlRequest:callback:context: and its wLenDone field has
+  been updated.  The result is kIOReturnSuccess if the transfer completed
+  successfully.
+*/
+typedef void (*UVCTransportCompletionCallback)(void *context, IOUSBDevRequest *controlRequest, IOReturn result);
+
+/*!
+  @defined UVCTransportStatusPacketMaxSize
+
+  Largest status packet a transport will return from readStatusPacket:length:timeout:.
+  A VideoControl status packet is a five-byte header followed by at most one control
+  value, so this is ample.
+*/
+#define UVCTransportStatusPacketMaxSize   64
+
+/*!
+  @protocol UVCTransport
+  @abstract Delivers USB control requests to a UVC device.
+
+  UVCController never talks to IOKit directly when sending control requests;
+  it hands them to an object conforming to this protocol.  Synchronous
+  requests block until the transfer is complete.  Asynchronous requests return
+  immediately and have their completion callback invoked from within the
+  waitForCompletions method, on the calling thread.
+
+  The controlRequest structures (and the data buffers they reference) passed
+  to the asynchronous method must remain valid until the completion callback
+  has been invoked.
+*/
+@protocol UVCTransport <NSObject>
+
+/*!
+  @method isOpen
+
+  Returns YES if the transport is ready to deliver requests.
+*/
+- (BOOL) isOpen;
+
+/*!
+  @method open
+
+  Prepare the transport to deliver requests.  Returns YES if successful.
+*/
+- (BOOL) open;
+
+/*!
+  @method close
+
+  Release any resources associated with delivering requests.  Any
+  asynchronous requests that are still in flight are completed before
+  the transport is closed.
+*/
+- (void) close;
+
+/*!
+  @method sendControlRequest:
+
+  Synchronously deliver controlRequest to the device.
+*/
+- (IOReturn) sendControlRequest:(IOUSBDevRequest*)controlRequest;
+
+/*!
+  @method submitControlRequest:callback:context:
+
+  Begin asynchronous delivery of controlRequest to the device.  Returns
+  kIOReturnSuccess if the request was accepted, in which case callback will
+  be invoked exactly once from a subsequent call to waitForCompletions.
+
+  Transports that cannot deliver requests asynchronously return
+  kIOReturnUnsupported.
+*/
+- (IOReturn) submitControlRequest:(IOUSBDevRequest*)controlRequest callback:(UVCTransportCompletionCallback)callback context:(void*)context;
+
+/*!
+  @method requestsInFlight
+
+  Returns the number of asynchronous requests that have been submitted but
+  whose completion callback has not yet been invoked.
+*/
+- (NSUInteger) requestsInFlight;
+
+/*!
+  @method waitForCompletions
+
+  Block until at least one in-flight asynchronous request has completed,
+  invoking the completion callback of every request that has finished.
+  Returns immediately if no requests are in flight.
+*/
+- (void) waitForCompletions;
+
+@optional
+
+/*!
+  @method hasStatusInterruptEndpoint
+
+  Returns YES if the device's VideoControl interface has an interrupt endpoint
+  for status packets and the transport is able to read from it.
+*/
+- (BOOL) hasStatusInterruptEndpoint;
+
+/*!
+  @method readStatusPacket:length:timeout:
+
+  Wait up to timeout seconds for a status packet from the device's interrupt
+  endpoint.  On entry, length holds the size of buffer; on successful return
+  it holds the number of bytes copied to buffer.
+
+  Returns kIOReturnTimeout if no packet arrived in time, kIOReturnUnsupported
+  if the device has no status interrupt endpoint.  A read left outstanding by
+  a timeout remains queued, so no packet is lost between calls.
+*/
+- (IOReturn) readStatusPacket:(void*)buffer length:(NSUInteger*)length timeout:(NSTimeInterval)timeout;
+
+/*!
+  @method requestTimeout
+
+  Returns the deadline (in seconds) applied to each control request; zero
+  means requests wait for the device indefinitely.
+*/
+- (NSTimeInterval) requestTimeout;
+
+/*!
+  @method setRequestTimeout:
+
+  Bound each subsequent control request (synchronous or asynchronous) to
+  requestTimeout seconds; a request the device has not completed by then
+  fails with kIOReturnTimeout or kIOUSBTransactionTimeout.  Zero removes the
+  deadline.
+*/
+- (void) setRequestTimeout:(NSTimeInterval)requestTimeout;
+
+@end
+
+/*!
+  @class UVCIOKitTransport
+  @abstract UVCTransport backed by an IOKit USB interface.
+
+  Synchronous requests are delivered with the interface's ControlRequest
+  function; asynchronous requests use ControlRequestAsync with completions
+  dispatched by the current thread's run loop.  Once a request timeout is
+  set, the ControlRequestTO and ControlRequestAsyncTO variants are used
+  instead, with the timeout as both the no-data and completion timeouts.  A transport may be used from
+  different threads over its lifetime (one at a time):  the completion source
+  follows the thread that submits requests whenever none are outstanding.
+
+  If the interface is already opened exclusively by another process (e.g.
+  the system's video driver) the transport still considers itself open and
+  will not attempt to close the interface.  The interface's pipes are not
+  accessible in that case, so status interrupts are only available when the
+  transport opened the interface itself.
+*/
+@interface UVCIOKitTransport : NSObject <UVCTransport>
+{
+  IOUSBInterfaceInterface220    **_controllerInterface;
+  CFRunLoopSourceRef            _asyncEventSource;
+  CFRunLoopRef                  _asyncRunLoop;
+  NSUInteger                    _requestsInFlight;
+  BOOL                          _isOpen;
+  BOOL                          _shouldNotCloseInterface;
+  BOOL                          _hasSearchedForStatusPipe;
+  UInt8                         _statusPipeRef;
+  UInt16                        _statusPacketSize;
+  void                          *_statusBuffer;
+  BOOL                          _statusReadPending, _statusReadComplete;
+  IOReturn                      _statusReadResult;
+  UInt32                        _statusReadLength;
+  UInt32                        _requestTimeoutMS;
+}
+
+/*!
+  @method initWithInterface:
+
+  Designated initializer.  The transport adds a reference to
+  controllerInterface which is released when the transport is deallocated.
+*/
+- (id) initWithInterface:(IOUSBInterfaceInterface220**)controllerInterface;
+
+@end
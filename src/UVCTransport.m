@@ -0,0 +1,410 @@
+//
+//  UVCTransport.m
+//
+//  Abstract delivery mechanism for UVC control requests.
+//
+//  Copyright © 2016
+//  Dr. Jeffrey Frey, IT-NSS
+//  University of Delaware
+//
+// $Id$
+//
+
+#import "UVCTransport.h"
+
+#include <math.h>
+
+/*!
+  @typedef UVCIOKitTransportAsyncRecord
+
+  Book-keeping for a single in-flight asynchronous request; passed as the
+  refCon to ControlRequestAsync.
+*/
+typedef struct {
+  UVCIOKitTransport               *transport;
+  IOUSBDevRequest                 *controlRequest;
+  IOUSBDevRequestTO               timeoutRequest;
+  UVCTransportCompletionCallback  callback;
+  void                            *context;
+} UVCIOKitTransportAsyncRecord;
+
+//
+
+static inline void
+UVCIOKitTransportMakeTimeoutRequest(
+  IOUSBDevRequestTO   *timeoutRequest,
+  IOUSBDevRequest     *controlRequest,
+  UInt32              timeoutMS
+)
+{
+  timeoutRequest->bmRequestType = controlRequest->bmRequestType;
+  timeoutRequest->bRequest = controlRequest->bRequest;
+  timeoutRequest->wValue = controlRequest->wValue;
+  timeoutRequest->wIndex = controlRequest->wIndex;
+  timeoutRequest->wLength = controlRequest->wLength;
+  timeoutRequest->pData = controlRequest->pData;
+  timeoutRequest->wLenDone = 0;
+  timeoutRequest->noDataTimeout = timeoutMS;
+  timeoutRequest->completionTimeout = timeoutMS;
+}
+
+//
+#if 0
+#pragma mark -
+#endif
+//
+
+@interface UVCIOKitTransport(UVCIOKitTransportPrivate)
+
+/*!
+  @method asyncRequestDidComplete:result:bytesTransferred:
+
+  Invoked by the IOKit completion function for each asynchronous request.
+*/
+- (void) asyncRequestDidComplete:(UVCIOKitTransportAsyncRecord*)record result:(IOReturn)result bytesTransferred:(UInt32)bytesTransferred;
+
+/*!
+  @method statusReadDidComplete:bytesTransferred:
+
+  Invoked by the IOKit completion function for the outstanding status
+  endpoint read.
+*/
+- (void) statusReadDidComplete:(IOReturn)result bytesTransferred:(UInt32)bytesTransferred;
+
+/*!
+  @method addAsyncEventSource
+
+  Create the interface's asynchronous event source (if not already done) and
+  add it to the current thread's run loop.
+*/
+- (IOReturn) addAsyncEventSource;
+
+/*!
+  @method findStatusPipe
+
+  Locate the interrupt IN pipe of the (open) interface.  Returns YES if one
+  was found.
+*/
+- (BOOL) findStatusPipe;
+
+@end
+
+//
+
+static void
+UVCIOKitTransportAsyncCallback(
+  void      *refCon,
+  IOReturn  result,
+  void      *arg0
+)
+{
+  UVCIOKitTransportAsyncRecord    *record = (UVCIOKitTransportAsyncRecord*)refCon;
+
+  [record->transport asyncRequestDidComplete:record result:result bytesTransferred:(UInt32)(uintptr_t)arg0];
+}
+
+//
+
+static void
+UVCIOKitTransportStatusCallback(
+  void      *refCon,
+  IOReturn  result,
+  void      *arg0
+)
+{
+  [(UVCIOKitTransport*)refCon statusReadDidComplete:result bytesTransferred:(UInt32)(uintptr_t)arg0];
+}
+
+//
+
+@implementation UVCIOKitTransport(UVCIOKitTransportPrivate)
+
+  - (void) asyncRequestDidComplete:(UVCIOKitTransportAsyncRecord*)record
+    result:(IOReturn)result
+    bytesTransferred:(UInt32)bytesTransferred
+  {
+    record->controlRequest->wLenDone = bytesTransferred;
+    _requestsInFlight--;
+    record->callback(record->context, record->controlRequest, result);
+    free(record);
+  }
+
+//
+
+  - (void) statusReadDidComplete:(IOReturn)result
+    bytesTransferred:(UInt32)bytesTransferred
+  {
+    _statusReadPending = NO;
+    _statusReadComplete = YES;
+    _statusReadResult = result;
+    _statusReadLength = bytesTransferred;
+  }
+
+//
+
+  - (IOReturn) addAsyncEventSource
+  {
+    CFRunLoopRef    runLoop = CFRunLoopGetCurrent();
+    
+    if ( ! _asyncEventSource ) {
+      IOReturn      rc = (*_controllerInterface)->CreateInterfaceAsyncEventSource(_controllerInterface, &_asyncEventSource);
+      
+      if ( rc != kIOReturnSuccess ) return rc;
+    }
+    else if ( _asyncRunLoop != runLoop ) {
+      // Completions are delivered to the run loop that was waiting for them:
+      if ( _requestsInFlight || _statusReadPending ) return kIOReturnBusy;
+      CFRunLoopRemoveSource(_asyncRunLoop, _asyncEventSource, kCFRunLoopDefaultMode);
+      CFRelease(_asyncRunLoop);
+      _asyncRunLoop = NULL;
+    }
+    if ( ! _asyncRunLoop ) {
+      CFRunLoopAddSource(runLoop, _asyncEventSource, kCFRunLoopDefaultMode);
+      _asyncRunLoop = (CFRunLoopRef)CFRetain(runLoop);
+    }
+    return kIOReturnSuccess;
+  }
+
+//
+
+  - (BOOL) findStatusPipe
+  {
+    UInt8           endpointCount = 0, pipeRef;
+    
+    _hasSearchedForStatusPipe = YES;
+    if ( (*_controllerInterface)->GetNumEndpoints(_controllerInterface, &endpointCount) != kIOReturnSuccess ) return NO;
+    
+    // Pipe zero is the default control pipe:
+    for ( pipeRef = 1; pipeRef <= endpointCount; pipeRef++ ) {
+      UInt8         direction, number, transferType, interval;
+      UInt16        maxPacketSize;
+      
+      if ( (*_controllerInterface)->GetPipeProperties(_controllerInterface, pipeRef, &direction, &number, &transferType, &maxPacketSize, &interval) != kIOReturnSuccess ) continue;
+      if ( (direction == kUSBIn) && (transferType == kUSBInterrupt) && maxPacketSize ) {
+        if ( (_statusBuffer = malloc(maxPacketSize)) ) {
+          _statusPipeRef = pipeRef;
+          _statusPacketSize = maxPacketSize;
+          return YES;
+        }
+        break;
+      }
+    }
+    return NO;
+  }
+
+@end
+
+//
+#if 0
+#pragma mark -
+#endif
+//
+
+@implementation UVCIOKitTransport
+
+  - (id) initWithInterface:(IOUSBInterfaceInterface220**)controllerInterface
+  {
+    if ( (self = [super init]) ) {
+      _controllerInterface = controllerInterface;
+      (*_controllerInterface)->AddRef(_controllerInterface);
+    }
+    return self;
+  }
+
+//
+
+  - (void) dealloc
+  {
+    [self close];
+    if ( _asyncEventSource ) {
+      CFRunLoopSourceInvalidate(_asyncEventSource);
+      CFRelease(_asyncEventSource);
+    }
+    if ( _asyncRunLoop ) CFRelease(_asyncRunLoop);
+    if ( _controllerInterface ) (*_controllerInterface)->Release(_controllerInterface);
+    if ( _statusBuffer ) free(_statusBuffer);
+    [super dealloc];
+  }
+
+//
+
+  - (NSString*) description
+  {
+    return [NSString stringWithFormat:@"UVCIOKitTransport@%p { interface: %p; in-flight: %lu%s }",
+                        self,
+                        _controllerInterface,
+                        (unsigned long)_requestsInFlight,
+                        (_isOpen ? "; is-open" : "")
+                      ];
+  }
+
+//
+
+  - (BOOL) isOpen
+  {
+    return _isOpen;
+  }
+
+//
+
+  - (BOOL) open
+  {
+    if ( ! _isOpen ) {
+      IOReturn          rc = (*_controllerInterface)->USBInterfaceOpen(_controllerInterface);
+
+      if ( rc == kIOReturnSuccess ) {
+        _isOpen = YES;
+        _shouldNotCloseInterface = NO;
+      }
+      else if ( rc == kIOReturnExclusiveAccess ) {
+        // Someone else (e.g. the video driver) has it open, but control
+        // requests can still be delivered; just don't close it later:
+        _isOpen = YES;
+        _shouldNotCloseInterface = YES;
+      }
+    }
+    return _isOpen;
+  }
+
+//
+
+  - (void) close
+  {
+    while ( _requestsInFlight ) [self waitForCompletions];
+    if ( _statusReadPending ) {
+      // The abort completes the read with kIOReturnAborted:
+      (*_controllerInterface)->AbortPipe(_controllerInterface, _statusPipeRef);
+      while ( _statusReadPending ) CFRunLoopRunInMode(kCFRunLoopDefaultMode, 1.0, true);
+    }
+    _statusReadComplete = NO;
+    if ( _isOpen ) {
+      if ( ! _shouldNotCloseInterface ) {
+        if ( (*_controllerInterface)->USBInterfaceClose(_controllerInterface) != kIOReturnSuccess ) return;
+      }
+      _isOpen = NO;
+    }
+  }
+
+//
+
+  - (IOReturn) sendControlRequest:(IOUSBDevRequest*)controlRequest
+  {
+    if ( ! _isOpen && ! [self open] ) return kIOReturnNotOpen;
+    if ( _requestTimeoutMS ) {
+      IOUSBDevRequestTO   timeoutRequest;
+      IOReturn            rc;
+      
+      UVCIOKitTransportMakeTimeoutRequest(&timeoutRequest, controlRequest, _requestTimeoutMS);
+      rc = (*_controllerInterface)->ControlRequestTO(_controllerInterface, 0, &timeoutRequest);
+      controlRequest->wLenDone = timeoutRequest.wLenDone;
+      return rc;
+    }
+    return (*_controllerInterface)->ControlRequest(_controllerInterface, 0, controlRequest);
+  }
+
+//
+
+  - (IOReturn) submitControlRequest:(IOUSBDevRequest*)controlRequest
+    callback:(UVCTransportCompletionCallback)callback
+    context:(void*)context
+  {
+    UVCIOKitTransportAsyncRecord    *record;
+    IOReturn                        rc;
+
+    if ( ! _isOpen && ! [self open] ) return kIOReturnNotOpen;
+    if ( (rc = [self addAsyncEventSource]) != kIOReturnSuccess ) return rc;
+    if ( ! (record = malloc(sizeof(UVCIOKitTransportAsyncRecord))) ) return kIOReturnNoMemory;
+    record->transport = self;
+    record->controlRequest = controlRequest;
+    record->callback = callback;
+    record->context = context;
+    if ( _requestTimeoutMS ) {
+      UVCIOKitTransportMakeTimeoutRequest(&record->timeoutRequest, controlRequest, _requestTimeoutMS);
+      rc = (*_controllerInterface)->ControlRequestAsyncTO(_controllerInterface, 0, &record->timeoutRequest, UVCIOKitTransportAsyncCallback, record);
+    } else {
+      rc = (*_controllerInterface)->ControlRequestAsync(_controllerInterface, 0, controlRequest, UVCIOKitTransportAsyncCallback, record);
+    }
+    if ( rc == kIOReturnSuccess ) {
+      _requestsInFlight++;
+    } else {
+      free(record);
+    }
+    return rc;
+  }
+
+//
+
+  - (NSUInteger) requestsInFlight
+  {
+    return _requestsInFlight;
+  }
+
+//
+
+  - (void) waitForCompletions
+  {
+    NSUInteger      startCount = _requestsInFlight;
+
+    while ( _requestsInFlight && (_requestsInFlight == startCount) ) {
+      CFRunLoopRunInMode(kCFRunLoopDefaultMode, 1.0, true);
+    }
+  }
+
+//
+
+  - (BOOL) hasStatusInterruptEndpoint
+  {
+    if ( ! _isOpen && ! [self open] ) return NO;
+    
+    // Without our own open of the interface there are no pipes to read:
+    if ( _shouldNotCloseInterface ) return NO;
+    if ( ! _hasSearchedForStatusPipe ) [self findStatusPipe];
+    return ( _statusPipeRef != 0 );
+  }
+
+//
+
+  - (IOReturn) readStatusPacket:(void*)buffer
+    length:(NSUInteger*)length
+    timeout:(NSTimeInterval)timeout
+  {
+    NSTimeInterval    deadline = [NSDate timeIntervalSinceReferenceDate] + timeout;
+    IOReturn          rc;
+    
+    if ( ! [self hasStatusInterruptEndpoint] ) return kIOReturnUnsupported;
+    if ( ! _statusReadPending && ! _statusReadComplete ) {
+      if ( (rc = [self addAsyncEventSource]) != kIOReturnSuccess ) return rc;
+      rc = (*_controllerInterface)->ReadPipeAsync(_controllerInterface, _statusPipeRef, _statusBuffer, _statusPacketSize, UVCIOKitTransportStatusCallback, self);
+      if ( rc != kIOReturnSuccess ) return rc;
+      _statusReadPending = YES;
+    }
+    while ( _statusReadPending ) {
+      NSTimeInterval  remaining = deadline - [NSDate timeIntervalSinceReferenceDate];
+      
+      if ( remaining <= 0 ) return kIOReturnTimeout;
+      CFRunLoopRunInMode(kCFRunLoopDefaultMode, remaining, true);
+    }
+    _statusReadComplete = NO;
+    if ( _statusReadResult != kIOReturnSuccess ) {
+      // A stalled interrupt pipe must be cleared before it can be read again:
+      if ( _statusReadResult == kIOUSBPipeStalled ) (*_controllerInterface)->ClearPipeStallBothEnds(_controllerInterface, _statusPipeRef);
+      return _statusReadResult;
+    }
+    if ( *length > _statusReadLength ) *length = _statusReadLength;
+    memcpy(buffer, _statusBuffer, *length);
+    return kIOReturnSuccess;
+  }
+
+//
+
+  - (NSTimeInterval) requestTimeout
+  {
+    return 0.001 * _requestTimeoutMS;
+  }
+  - (void) setRequestTimeout:(NSTimeInterval)requestTimeout
+  {
+    // IOKit counts in whole milliseconds; never round a deadline down to none:
+    _requestTimeoutMS = ( requestTimeout > 0 ) ? (UInt32)ceil(requestTimeout * 1000.0) : 0;
+  }
+
+@end
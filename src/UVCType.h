@@ -69,6 +69,71 @@ typedef enum {
   kUVCTypeScanFlagShowInfo        = 1 << 1
 } UVCTypeScanFlags;
 
+/*!
+  @typedef UVCTypeScanStatus
+  
+  Values returned by the scanCString:intoBuffer:flags:minimum:maximum:stepSize:defaultValue:errorOffset:
+  method of UVCType:
+  
+    - kUVCTypeScanOk:  all component fields were set
+    - kUVCTypeScanInvalidValue:  a component value could not be scanned
+    - kUVCTypeScanLimitUnavailable:  "default," "minimum," or "maximum" was
+      used but the control did not provide that value
+    - kUVCTypeScanUnknownField:  a named field is not defined by the type
+    - kUVCTypeScanMissingFields:  the value ended before all component fields
+      were set
+    - kUVCTypeScanMixedAssignment:  named-value and in-order assignments were
+      mixed in a single value
+    - kUVCTypeScanExpectedBrace:  a multi-field value was not enclosed in
+      curly braces
+*/
+typedef enum {
+  kUVCTypeScanOk                  = 0,
+  kUVCTypeScanInvalidValue,
+  kUVCTypeScanLimitUnavailable,
+  kUVCTypeScanUnknownField,
+  kUVCTypeScanMissingFields,
+  kUVCTypeScanMixedAssignment,
+  kUVCTypeScanExpectedBrace
+} UVCTypeScanStatus;
+
+/*!
+  @function UVCTypeScanStatusString
+  
+  Returns a constant, human-readable description of status.
+*/
+const char* UVCTypeScanStatusString(UVCTypeScanStatus status);
+
+/*!
+  @typedef UVCTypeFormat
+  
+  Enumerates the textual forms produced by the formatBuffer:format:intoCString:length:
+  method of UVCType:
+  
+    kUVCTypeFormatDefault   {pan=3600,tilt=-360000}
+    kUVCTypeFormatJSON      {"pan":3600,"tilt":-360000}
+    kUVCTypeFormatCSV       3600,-360000
+  
+  A type with a single field is formatted as just its value in all three forms.
+*/
+typedef enum {
+  kUVCTypeFormatDefault           = 0,
+  kUVCTypeFormatJSON,
+  kUVCTypeFormatCSV
+} UVCTypeFormat;
+
+/*!
+  @typedef UVCTypeFieldDescriptor
+  
+  Static description of a single component field, used to build a UVCType
+  from a compile-time table rather than by parsing a type description string.
+  A single-field type may use an empty fieldName.
+*/
+typedef struct {
+  const char              *fieldName;
+  UVCTypeComponentType    fieldType;
+} UVCTypeFieldDescriptor;
+
 /*!
   @class UVCType
   @abstract Abstract data type comprised of UVCTypeComponentType atomic types
@@ -87,7 +152,9 @@ typedef enum {
   
   Methods are included to calculate relative byte offsets of the component fields,
   either by index of the name of the field.  Also, the number of bytes occupied
-  by the UVCType is available via the byteSize method.
+  by the UVCType is available via the byteSize method.  Field offsets, the byte
+  size, and a hashed index of the (case-folded) field names are computed once when
+  the instance is created, so these are constant-time look-ups.
   
   Methods are also provided to initialize an external buffer structured by a
   UVCType using textual input (from a C string).
@@ -95,8 +162,15 @@ typedef enum {
 @interface UVCType : NSObject
 {
   NSUInteger    _fieldCount;
+  NSUInteger    _byteSize;
   BOOL          _needsNoByteSwap;
   void          *_fields;
+  void          *_swapRuns;
+  NSUInteger    _swapRunCount;
+  NSUInteger    *_nameSlots;
+  NSUInteger    _nameSlotMask;
+  NSUInteger    _maximumFieldNameLength;
+  NSUInteger    _maximumFormattedLength;
 }
 
 /*!
@@ -157,6 +231,14 @@ typedef enum {
 */
 + (UVCType*) uvcTypeWithFieldCount:(NSUInteger)count names:(NSString**)names types:(UVCTypeComponentType*)types;
 
+/*!
+  @method uvcTypeWithFieldCount:descriptors:
+  
+  Returns an autoreleased instance of UVCType initialized using a C array of count
+  UVCTypeFieldDescriptor structures.
+*/
++ (UVCType*) uvcTypeWithFieldCount:(NSUInteger)count descriptors:(const UVCTypeFieldDescriptor*)descriptors;
+
 /*!
   @method fieldCount
   
@@ -190,6 +272,15 @@ typedef enum {
 */
 - (NSUInteger) indexOfFieldWithName:(NSString*)fieldName;
 
+/*!
+  @method indexOfFieldWithCString:length:
+  
+  Same as indexOfFieldWithName: but for the length characters at fieldName (which need
+  not be NUL-terminated).  The lookup is a single probe of a hashed index of the field
+  names built when the receiver was created; nothing is allocated.
+*/
+- (NSUInteger) indexOfFieldWithCString:(const char*)fieldName length:(NSUInteger)length;
+
 /*!
   @method byteSize
   
@@ -219,6 +310,29 @@ typedef enum {
 */
 - (NSUInteger) offsetToFieldWithName:(NSString*)fieldName;
 
+/*!
+  @method needsByteSwap
+  
+  Returns YES if data structured according to the receiver's component field types
+  must be byte swapped to/from USB (little) endian on this host.
+*/
+- (BOOL) needsByteSwap;
+
+/*!
+  @method byteSwapBuffer:count:
+  
+  Given an external buffer holding count consecutive values structured according to the
+  receiver's component field types, reverse the byte order of every multi-byte component
+  field REGARDLESS of the host byte order.
+  
+  The receiver compiles a swap plan when it is created (runs of adjacent fields of the
+  same width, with single-byte fields omitted) so no per-field type dispatch happens here.
+  This is the primitive behind the endian-conversion methods below; it is also useful for
+  exercising the swap path on a little-endian host, or converting data recorded on a host
+  of the opposite byte order.
+*/
+- (void) byteSwapBuffer:(void*)buffer count:(NSUInteger)count;
+
 /*!
   @method byteSwapHostToUSBEndian:
   
@@ -228,6 +342,13 @@ typedef enum {
 */
 - (void) byteSwapHostToUSBEndian:(void*)buffer;
 
+/*!
+  @method byteSwapHostToUSBEndian:count:
+  
+  Same as byteSwapHostToUSBEndian: but for count consecutive values in buffer.
+*/
+- (void) byteSwapHostToUSBEndian:(void*)buffer count:(NSUInteger)count;
+
 /*!
   @method byteSwapUSBToHostEndian:
   
@@ -237,6 +358,13 @@ typedef enum {
 */
 - (void) byteSwapUSBToHostEndian:(void*)buffer;
 
+/*!
+  @method byteSwapUSBToHostEndian:count:
+  
+  Same as byteSwapUSBToHostEndian: but for count consecutive values in buffer.
+*/
+- (void) byteSwapUSBToHostEndian:(void*)buffer count:(NSUInteger)count;
+
 /*!
   @method scanCString:intoBuffer:flags:
   
@@ -305,6 +433,52 @@ typedef enum {
 */
 - (BOOL) scanCString:(const char*)cString intoBuffer:(void*)buffer flags:(UVCTypeScanFlags)flags minimum:(void*)minimum maximum:(void*)maximum stepSize:(void*)stepSize defaultValue:(void*)defaultValue;
 
+/*!
+  @method scanCString:intoBuffer:flags:minimum:maximum:stepSize:defaultValue:errorOffset:
+  
+  Identical to scanCString:intoBuffer:flags:minimum:maximum:stepSize:defaultValue: but returns a
+  UVCTypeScanStatus describing why cString was rejected.  If errorOffset is non-NULL and the scan
+  fails, it is set to the character offset in cString at which the offending text begins (e.g.
+  the start of the bad value or unknown field name, or the point at which the value ended early).
+  
+  The input is processed in a single pass and no memory is allocated, so this is suitable for
+  high-rate use.  On failure, any fields scanned ahead of the error will have been set in buffer.
+*/
+- (UVCTypeScanStatus) scanCString:(const char*)cString intoBuffer:(void*)buffer flags:(UVCTypeScanFlags)flags minimum:(void*)minimum maximum:(void*)maximum stepSize:(void*)stepSize defaultValue:(void*)defaultValue errorOffset:(NSUInteger*)errorOffset;
+
+/*!
+  @method maximumFormattedLength
+  
+  Returns an upper bound on the number of characters (excluding the terminating NUL)
+  that formatBuffer:format:intoCString:length: can produce for the receiver in any
+  format.
+*/
+- (NSUInteger) maximumFormattedLength;
+
+/*!
+  @method formatBuffer:format:intoCString:length:
+  
+  Format the data in buffer, structured according to the receiver's component field
+  types, into the caller-provided outString of outLength bytes.  No objects are
+  allocated.  The output is always NUL-terminated (if outLength is non-zero) and is
+  truncated if necessary.
+  
+  Returns the length of the complete formatted text, excluding the NUL; as with
+  snprintf(), a return value of outLength or more indicates truncation.
+*/
+- (NSUInteger) formatBuffer:(const void*)buffer format:(UVCTypeFormat)format intoCString:(char*)outString length:(NSUInteger)outLength;
+
+/*!
+  @method isBuffer:withinMinimum:maximum:
+  
+  Returns YES if every numeric component field in buffer lies in the range given by the
+  same field in minimum and maximum (all three structured according to the receiver's
+  component field types, in host byte order).  Signed fields are compared as signed
+  values; boolean and bitmap fields are not compared.  A NULL minimum or maximum leaves
+  that end of the range open.
+*/
+- (BOOL) isBuffer:(const void*)buffer withinMinimum:(const void*)minimum maximum:(const void*)maximum;
+
 /*!
   @method stringFromBuffer:
   
@@ -316,6 +490,17 @@ typedef enum {
 */
 - (NSString*) stringFromBuffer:(void*)buffer;
 
+/*!
+  @method writeLayoutAsJSONToStream:
+  
+  Write the receiver's structure to stream as a single JSON object (no trailing newline):
+  
+    {"byte-size":8,"fields":[{"name":"pan","type":"S4","offset":0},{"name":"tilt","type":"S4","offset":4}]}
+  
+  Field types use the compact codes accepted by uvcTypeWithCString: (B, S1, U1, M1, S2, ...).
+*/
+- (void) writeLayoutAsJSONToStream:(FILE*)stream;
+
 /*!
   @method typeSummaryString
   
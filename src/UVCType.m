@@ -42,6 +42,32 @@ UVCTypeComponentByteSize(UVCTypeComponentType componentType)
 
 //
 
+const char*
+UVCTypeScanStatusString(
+  UVCTypeScanStatus   status
+)
+{
+  switch ( status ) {
+    case kUVCTypeScanOk:
+      return "ok";
+    case kUVCTypeScanInvalidValue:
+      return "invalid value";
+    case kUVCTypeScanLimitUnavailable:
+      return "no such default/minimum/maximum value provided by the control";
+    case kUVCTypeScanUnknownField:
+      return "field name not defined for this type";
+    case kUVCTypeScanMissingFields:
+      return "not all fields were provided";
+    case kUVCTypeScanMixedAssignment:
+      return "named-value and in-order fields cannot be mixed";
+    case kUVCTypeScanExpectedBrace:
+      return "multi-field values must be enclosed in curly braces";
+  }
+  return "unknown error";
+}
+
+//
+
 const char*
 __UVCTypeComponentTypeString(UVCTypeComponentType componentType)
 {
@@ -1183,9 +1209,565 @@ __UVCTypeComponentTypeScanf(
 
 typedef struct {
   NSString                *fieldName;
-  UVCTypeComponentType   fieldType;
+  UVCTypeComponentType    fieldType;
+  NSUInteger              fieldOffset;
+  const char              *foldedName;
+  NSUInteger              foldedNameLength;
+  const char              *nameBytes;
+  NSUInteger              nameLength;
 } UVCTypeField;
 
+//
+// A byte-swap plan is a list of runs of consecutive, same-width multi-byte
+// fields; single-byte fields never need swapping and don't appear in it:
+//
+typedef struct {
+  NSUInteger              offset;
+  NSUInteger              width;
+  NSUInteger              count;
+} UVCTypeSwapRun;
+
+//
+
+static inline void
+__UVCTypeSwapElements(
+  void          *buffer,
+  NSUInteger    width,
+  NSUInteger    count
+)
+{
+  //
+  // The loads and stores go through memcpy since fields need not be aligned;
+  // the compiler reduces each iteration to a load, a byte-reverse, and a store,
+  // and will vectorize the loop where it can:
+  //
+  switch ( width ) {
+  
+    case 2: {
+      UInt8     *p = (UInt8*)buffer, *pMax = p + 2 * count;
+      UInt16    v;
+      
+      while ( p < pMax ) {
+        memcpy(&v, p, 2); v = NSSwapShort(v); memcpy(p, &v, 2);
+        p += 2;
+      }
+      break;
+    }
+    
+    case 4: {
+      UInt8     *p = (UInt8*)buffer, *pMax = p + 4 * count;
+      UInt32    v;
+      
+      while ( p < pMax ) {
+        memcpy(&v, p, 4); v = NSSwapInt(v); memcpy(p, &v, 4);
+        p += 4;
+      }
+      break;
+    }
+    
+    case 8: {
+      UInt8     *p = (UInt8*)buffer, *pMax = p + 8 * count;
+      UInt64    v;
+      
+      while ( p < pMax ) {
+        memcpy(&v, p, 8); v = NSSwapLongLong(v); memcpy(p, &v, 8);
+        p += 8;
+      }
+      break;
+    }
+    
+  }
+}
+
+//
+// The field-name index is an open-addressed (linear probing) table of
+// 1 + field index, zero marking an empty slot.  It is sized to a power of
+// two at least twice the field count, so probes are short and always
+// terminate:
+//
+static inline NSUInteger
+__UVCTypeNameSlotCount(
+  NSUInteger    fieldCount
+)
+{
+  NSUInteger    slotCount = 4;
+  
+  while ( slotCount < 2 * fieldCount ) slotCount <<= 1;
+  return slotCount;
+}
+
+//
+
+static inline UInt32
+__UVCTypeFieldNameHash(
+  const char    *name,
+  NSUInteger    length
+)
+{
+  UInt32        hash = 0x811c9dc5;
+  
+  while ( length-- ) {
+    hash ^= (UInt8)tolower(*name++);
+    hash *= 0x01000193;
+  }
+  return hash;
+}
+
+//
+// Bounded output for the formatter:  everything appended is counted, but
+// only what fits (less room for a NUL) is actually written:
+//
+typedef struct {
+  char          *p;
+  char          *end;
+  NSUInteger    length;
+} UVCTypeFormatWriter;
+
+static inline void
+__UVCTypeFormatWriterAppend(
+  UVCTypeFormatWriter *writer,
+  const char          *s,
+  NSUInteger          n
+)
+{
+  if ( writer->p < writer->end ) {
+    NSUInteger        room = writer->end - writer->p;
+    
+    if ( n < room ) room = n;
+    memcpy(writer->p, s, room);
+    writer->p += room;
+  }
+  writer->length += n;
+}
+
+static inline void
+__UVCTypeFormatWriterAppendChar(
+  UVCTypeFormatWriter *writer,
+  char                c
+)
+{
+  if ( writer->p < writer->end ) *writer->p++ = c;
+  writer->length++;
+}
+
+//
+
+static const char __UVCTypeDigitPairs[201] =
+                        "00010203040506070809"
+                        "10111213141516171819"
+                        "20212223242526272829"
+                        "30313233343536373839"
+                        "40414243444546474849"
+                        "50515253545556575859"
+                        "60616263646566676869"
+                        "70717273747576777879"
+                        "80818283848586878889"
+                        "90919293949596979899";
+
+static void
+__UVCTypeFormatWriterAppendInteger(
+  UVCTypeFormatWriter *writer,
+  UInt64              magnitude,
+  BOOL                isNegative
+)
+{
+  char                digits[21];
+  char                *p = digits + sizeof(digits);
+  
+  // Two digits at a time, right to left:
+  while ( magnitude >= 100 ) {
+    const char        *pair = &__UVCTypeDigitPairs[2 * (magnitude % 100)];
+    
+    magnitude /= 100;
+    *--p = pair[1];
+    *--p = pair[0];
+  }
+  if ( magnitude >= 10 ) {
+    *--p = __UVCTypeDigitPairs[2 * magnitude + 1];
+    *--p = __UVCTypeDigitPairs[2 * magnitude];
+  } else {
+    *--p = '0' + magnitude;
+  }
+  if ( isNegative ) *--p = '-';
+  __UVCTypeFormatWriterAppend(writer, p, digits + sizeof(digits) - p);
+}
+
+//
+
+static void
+__UVCTypeFormatWriterAppendComponent(
+  UVCTypeFormatWriter   *writer,
+  UVCTypeComponentType  componentType,
+  const void            *buffer
+)
+{
+  SInt64                sValue = 0;
+  UInt64                uValue = 0;
+  BOOL                  isSigned = NO;
+  
+  switch ( componentType ) {
+    case kUVCTypeComponentTypeBoolean:
+      if ( *((const UInt8*)buffer) ) {
+        __UVCTypeFormatWriterAppend(writer, "true", 4);
+      } else {
+        __UVCTypeFormatWriterAppend(writer, "false", 5);
+      }
+      return;
+    case kUVCTypeComponentTypeSInt8: {
+      sValue = *((const SInt8*)buffer);
+      isSigned = YES;
+      break;
+    }
+    case kUVCTypeComponentTypeUInt8:
+    case kUVCTypeComponentTypeBitmap8: {
+      uValue = *((const UInt8*)buffer);
+      break;
+    }
+    case kUVCTypeComponentTypeSInt16: {
+      SInt16            v;
+      
+      memcpy(&v, buffer, sizeof(v));
+      sValue = v;
+      isSigned = YES;
+      break;
+    }
+    case kUVCTypeComponentTypeUInt16:
+    case kUVCTypeComponentTypeBitmap16: {
+      UInt16            v;
+      
+      memcpy(&v, buffer, sizeof(v));
+      uValue = v;
+      break;
+    }
+    case kUVCTypeComponentTypeSInt32: {
+      SInt32            v;
+      
+      memcpy(&v, buffer, sizeof(v));
+      sValue = v;
+      isSigned = YES;
+      break;
+    }
+    case kUVCTypeComponentTypeUInt32:
+    case kUVCTypeComponentTypeBitmap32: {
+      UInt32            v;
+      
+      memcpy(&v, buffer, sizeof(v));
+      uValue = v;
+      break;
+    }
+    case kUVCTypeComponentTypeSInt64: {
+      memcpy(&sValue, buffer, sizeof(sValue));
+      isSigned = YES;
+      break;
+    }
+    case kUVCTypeComponentTypeUInt64:
+    case kUVCTypeComponentTypeBitmap64: {
+      memcpy(&uValue, buffer, sizeof(uValue));
+      break;
+    }
+    case kUVCTypeComponentTypeMax:
+    case kUVCTypeComponentTypeInvalid:
+      // Should never get here!
+      return;
+  }
+  if ( isSigned && (sValue < 0) ) {
+    // Careful not to overflow negating the most negative value:
+    __UVCTypeFormatWriterAppendInteger(writer, (UInt64)(-(sValue + 1)) + 1, YES);
+  } else {
+    __UVCTypeFormatWriterAppendInteger(writer, isSigned ? (UInt64)sValue : uValue, NO);
+  }
+}
+
+//
+
+static void
+__UVCTypeFormatWriterAppendJSONString(
+  UVCTypeFormatWriter *writer,
+  const char          *s,
+  NSUInteger          n
+)
+{
+  const char          *run = s, *sMax = s + n;
+  
+  __UVCTypeFormatWriterAppendChar(writer, '"');
+  while ( s < sMax ) {
+    unsigned char     c = *s;
+    
+    if ( (c == '"') || (c == '\\') || (c < 0x20) ) {
+      char            escape[7];
+      
+      __UVCTypeFormatWriterAppend(writer, run, s - run);
+      if ( c < 0x20 ) {
+        snprintf(escape, sizeof(escape), "\\u%04x", c);
+        __UVCTypeFormatWriterAppend(writer, escape, 6);
+      } else {
+        escape[0] = '\\'; escape[1] = c;
+        __UVCTypeFormatWriterAppend(writer, escape, 2);
+      }
+      run = s + 1;
+    }
+    s++;
+  }
+  __UVCTypeFormatWriterAppend(writer, run, s - run);
+  __UVCTypeFormatWriterAppendChar(writer, '"');
+}
+
+//
+
+//
+// Case-insensitive field-name lookup against a type's hashed name index:
+//
+static inline NSUInteger
+__UVCTypeIndexOfFieldName(
+  const UVCTypeField  *fields,
+  const NSUInteger    *nameSlots,
+  NSUInteger          nameSlotMask,
+  const char          *name,
+  NSUInteger          length
+)
+{
+  NSUInteger          slot = __UVCTypeFieldNameHash(name, length) & nameSlotMask;
+  
+  while ( nameSlots[slot] ) {
+    const UVCTypeField  *FIELD_PTR = &fields[nameSlots[slot] - 1];
+    
+    if ( (FIELD_PTR->foldedNameLength == length) && (strncasecmp(FIELD_PTR->foldedName, name, length) == 0) ) return nameSlots[slot] - 1;
+    slot = (slot + 1) & nameSlotMask;
+  }
+  return UVCTypeInvalidIndex;
+}
+
+//
+// Once a component value has failed to scan, distinguish a reference to a limit
+// the control did not provide from a plain malformed value:
+//
+static UVCTypeScanStatus
+__UVCTypeScanStatusForValue(
+  const char  *cString,
+  void        *minimum,
+  void        *maximum,
+  void        *defaultValue
+)
+{
+  if ( strncasecmp(cString, "default", 7) == 0 ) return ( defaultValue ? kUVCTypeScanInvalidValue : kUVCTypeScanLimitUnavailable );
+  if ( strncasecmp(cString, "minimum", 7) == 0 ) return ( minimum ? kUVCTypeScanInvalidValue : kUVCTypeScanLimitUnavailable );
+  if ( strncasecmp(cString, "maximum", 7) == 0 ) return ( maximum ? kUVCTypeScanInvalidValue : kUVCTypeScanLimitUnavailable );
+  return kUVCTypeScanInvalidValue;
+}
+
+//
+// The value parser proper.  The input is walked once, left to right:  each
+// component value is converted in place by __UVCTypeComponentTypeScanf() and
+// named fields are resolved through the hashed name index, so nothing is
+// allocated.  The only lookahead is over the first field of a braced value,
+// to see whether it is a "name=" assignment.
+//
+// On failure, *errorOffset (if non-NULL) is set to the character offset in the
+// original string at which the offending text starts.
+//
+static UVCTypeScanStatus
+__UVCTypeScanCString(
+  const UVCTypeField  *fields,
+  NSUInteger          fieldCount,
+  NSUInteger          byteSize,
+  const NSUInteger    *nameSlots,
+  NSUInteger          nameSlotMask,
+  const char          *cString,
+  void                *buffer,
+  UVCTypeScanFlags    flags,
+  void                *minimum,
+  void                *maximum,
+  void                *stepSize,
+  void                *defaultValue,
+  NSUInteger          *errorOffset
+)
+{
+  const char          *start = cString;
+  UVCTypeScanStatus   status = kUVCTypeScanInvalidValue;
+  NSUInteger          nChar;
+  
+  //
+  // We at least need to drop leading whitespace:
+  //
+  while ( isspace(*cString) ) cString++;
+  
+  //
+  // If the string doesn't lead with a brace...
+  //
+  if ( *cString != '{' ) {
+    BOOL              isLimit = NO;
+    
+    //
+    // If it's "default," "minimum," or "maximum" then set the WHOLE THING to
+    // the corresponding limit:
+    //
+    if ( strncasecmp(cString, "default", 7) == 0 ) {
+      isLimit = YES;
+      if ( defaultValue ) {
+        if ( (flags & kUVCTypeScanFlagShowInfo) ) fprintf(stderr, "INFO: Copying default value provided by this control\n");
+        memcpy(buffer, defaultValue, byteSize);
+        status = kUVCTypeScanOk;
+      } else {
+        if ( (flags & kUVCTypeScanFlagShowWarnings) ) fprintf(stderr, "WARNING: No default value provided by this control\n");
+      }
+    }
+    else if ( strncasecmp(cString, "minimum", 7) == 0 ) {
+      isLimit = YES;
+      if ( minimum ) {
+        if ( (flags & kUVCTypeScanFlagShowInfo) ) fprintf(stderr, "INFO: Copying minimum value provided by this control\n");
+        memcpy(buffer, minimum, byteSize);
+        status = kUVCTypeScanOk;
+      } else {
+        if ( (flags & kUVCTypeScanFlagShowWarnings) ) fprintf(stderr, "WARNING: No minimum value provided by this control\n");
+      }
+    }
+    else if ( strncasecmp(cString, "maximum", 7) == 0 ) {
+      isLimit = YES;
+      if ( maximum ) {
+        if ( (flags & kUVCTypeScanFlagShowInfo) ) fprintf(stderr, "INFO: Copying maximum value provided by this control\n");
+        memcpy(buffer, maximum, byteSize);
+        status = kUVCTypeScanOk;
+      } else {
+        if ( (flags & kUVCTypeScanFlagShowWarnings) ) fprintf(stderr, "WARNING: No maximum value provided by this control\n");
+      }
+    }
+    if ( fieldCount == 1 ) {
+      //
+      // ...we have a single field, so try just scanning its value:
+      //
+      if ( __UVCTypeComponentTypeScanf(cString, fields->fieldType, buffer, flags, minimum, maximum, stepSize, defaultValue, &nChar) ) {
+        status = kUVCTypeScanOk;
+      } else {
+        status = __UVCTypeScanStatusForValue(cString, minimum, maximum, defaultValue);
+      }
+    }
+    else if ( status != kUVCTypeScanOk ) {
+      status = ( isLimit ? kUVCTypeScanLimitUnavailable : kUVCTypeScanExpectedBrace );
+    }
+  } else {
+    const char        *p;
+    BOOL              usesNamedValues;
+    NSUInteger        fieldIdx = 0, fieldsUsedCount = 0;
+    UInt8             fieldsUsed[fieldCount ? fieldCount : 1];
+    
+    // Skip-over the brace:
+    cString++;
+    
+    //
+    // The first field decides between named-value and in-order assignment:
+    //
+    p = cString;
+    while ( *p && (*p != '=') && (*p != ',') && (*p != '}') ) p++;
+    usesNamedValues = ( *p == '=' );
+    if ( usesNamedValues ) memset(fieldsUsed, 0, fieldCount);
+    
+    if ( (flags & kUVCTypeScanFlagShowInfo) ) fprintf(stderr, "INFO: Using %s field assignments\n", (usesNamedValues ? "named-value" : "in-order"));
+    
+    while ( *cString && (fieldIdx < fieldCount) ) {
+      NSUInteger      fieldOffset;
+      
+      if ( (flags & kUVCTypeScanFlagShowInfo) ) fprintf(stderr, "INFO: Processing substring '%s'\n", cString);
+      
+      //
+      // When doing named values, read the field name first:
+      //
+      if ( usesNamedValues ) {
+        // Drop leading whitespace:
+        while ( isspace(*cString) ) cString++;
+        
+        // Isolate the name:
+        const char    *namePtr = cString;
+        while ( *cString && (*cString != '=') ) cString++;
+        
+        NSUInteger    nameLen = cString - namePtr;
+        
+        if ( *cString == '=' ) cString++;
+        fieldIdx = __UVCTypeIndexOfFieldName(fields, nameSlots, nameSlotMask, namePtr, nameLen);
+        if ( fieldIdx == UVCTypeInvalidIndex ) {
+          if ( (flags & kUVCTypeScanFlagShowWarnings) ) fprintf(stderr, "WARNING: Field name '%.*s' not defined for this type\n", (int)nameLen, namePtr);
+          if ( errorOffset ) *errorOffset = namePtr - start;
+          return kUVCTypeScanUnknownField;
+        }
+      }
+      
+      fieldOffset = fields[fieldIdx].fieldOffset;
+      
+      // Scan a value:
+      if ( ! __UVCTypeComponentTypeScanf(
+                    cString,
+                    fields[fieldIdx].fieldType,
+                    buffer + fieldOffset,
+                    flags,
+                    minimum ? minimum + fieldOffset : NULL,
+                    maximum ? maximum + fieldOffset : NULL,
+                    stepSize ? stepSize + fieldOffset : NULL,
+                    defaultValue ? defaultValue + fieldOffset : NULL,
+                    &nChar
+                  )
+      ) {
+        //
+        // A bad value is only fatal for named-value assignment if it leaves
+        // some field unset:
+        //
+        if ( usesNamedValues && (fieldsUsedCount == fieldCount) ) break;
+        while ( isspace(*cString) ) cString++;
+        if ( errorOffset ) *errorOffset = cString - start;
+        if ( ! usesNamedValues ) {
+          p = cString;
+          while ( *p && (*p != '=') && (*p != ',') && (*p != '}') ) p++;
+          if ( *p == '=' ) return kUVCTypeScanMixedAssignment;
+        }
+        return __UVCTypeScanStatusForValue(cString, minimum, maximum, defaultValue);
+      }
+      
+      // Skip trailing whitespace/commas:
+      cString += nChar;
+      while ( isspace(*cString) || (*cString == ',') ) cString++;
+      
+      // If not doing named values, increase the field index; for named-values,
+      // make note of the fact that we set the value at this index:
+      if ( ! usesNamedValues ) {
+        fieldIdx++;
+      } else if ( ! fieldsUsed[fieldIdx] ) {
+        fieldsUsed[fieldIdx] = 1;
+        fieldsUsedCount++;
+      }
+      
+      // If the closing brace, then exit:
+      if ( *cString == '}' ) break;
+    }
+    if ( usesNamedValues ) {
+      if ( fieldsUsedCount < fieldCount ) {
+        NSUInteger    zeroCount = fieldCount - fieldsUsedCount;
+        
+        if ( (flags & kUVCTypeScanFlagShowWarnings) ) fprintf(stderr, "WARNING: %lu named field%s %s not provided\n", zeroCount, ((zeroCount == 1) ? "" : "s"), ((zeroCount == 1) ? "was" : "were"));
+        status = kUVCTypeScanMissingFields;
+      } else {
+        status = kUVCTypeScanOk;
+      }
+    } else if ( fieldIdx >= fieldCount ) {
+      //
+      // An assignment anywhere past the first field is not valid in an
+      // in-order value, even in text after the last field:
+      //
+      if ( (p = strchr(cString, '=')) ) {
+        cString = p;
+        status = kUVCTypeScanMixedAssignment;
+      } else {
+        status = kUVCTypeScanOk;
+      }
+    } else {
+      status = kUVCTypeScanMissingFields;
+    }
+  }
+  if ( status == kUVCTypeScanOk ) {
+    if ( (flags & kUVCTypeScanFlagShowInfo) ) fprintf(stderr, "INFO: Successfully scanned all fields for this type\n");
+  } else if ( errorOffset ) {
+    *errorOffset = cString - start;
+  }
+  return status;
+}
+
 //
 
 @implementation UVCType
@@ -1317,7 +1899,7 @@ typedef struct {
     
     if ( name ) {
       NSString                *nextName = name;
-      UVCTypeComponentType   nextType = kUVCTypeComponentTypeInvalid;
+      UVCTypeComponentType    nextType = kUVCTypeComponentTypeInvalid;
       
       va_start(vargs, name);
       while ( (nextType = va_arg(vargs, UVCTypeComponentType)) ) {
@@ -1329,32 +1911,19 @@ typedef struct {
       va_end(vargs);
       
       if ( fieldCount ) {
-        UVCType*      newType = class_createInstance(self, fieldCount * sizeof(UVCTypeField));
+        NSString                *fieldNames[fieldCount];
+        UVCTypeComponentType    fieldTypes[fieldCount];
+        NSUInteger              i = 0;
         
-        if ( newType && (newType = [newType init]) ) {
-          newType->_fieldCount = fieldCount;
-          if ( (newType->_fields = object_getIndexedIvars(newType)) > 0 ) {
-            UVCTypeField    *FIELD_PTR = (UVCTypeField*)newType->_fields;
-            NSUInteger      i = 0;
-            BOOL            needsNoByteSwap = YES;
-            
-            nextName = name;
-            va_start(vargs, name);
-            while ( i < fieldCount ) {
-              FIELD_PTR->fieldName = [name copy];
-              FIELD_PTR->fieldType = va_arg(vargs, UVCTypeComponentType);
-              if ( UVCTypeComponentByteSize(FIELD_PTR->fieldType) != 1 ) needsNoByteSwap = NO;
-              i++; FIELD_PTR++;
-              
-              name = va_arg(vargs, NSString*);
-            }
-            va_end(vargs);
-            newType->_needsNoByteSwap = needsNoByteSwap || (NSHostByteOrder() == NS_LittleEndian);
-            
-            [newType autorelease];
-          }
+        va_start(vargs, name);
+        while ( i < fieldCount ) {
+          fieldNames[i] = name;
+          fieldTypes[i] = va_arg(vargs, UVCTypeComponentType);
+          i++;
+          name = va_arg(vargs, NSString*);
         }
-        return newType;
+        va_end(vargs);
+        return [self uvcTypeWithFieldCount:fieldCount names:fieldNames types:fieldTypes];
       }
     }
     return nil;
@@ -1366,28 +1935,92 @@ typedef struct {
     names:(NSString**)names
     types:(UVCTypeComponentType*)types
   {
-    NSUInteger      i = 0;
+    NSUInteger      i = 0, nameBytes = 0;
     
     while ( i < count ) {
       if ( ! names[i] || (types[i] >= kUVCTypeComponentTypeMax) ) break;
+      nameBytes += 2 * ([names[i] lengthOfBytesUsingEncoding:NSUTF8StringEncoding] + 1);
       i++;
     }
-    if ( i == count ) {
-      UVCType*      newType = class_createInstance(self, count * sizeof(UVCTypeField));
+    if ( count && (i == count) ) {
+      //
+      // Everything lives in the instance's indexed ivars:  the field records, the
+      // byte-swap plan, the name index slots, then the case-folded and original
+      // names:
+      //
+      NSUInteger    slotCount = __UVCTypeNameSlotCount(count);
+      UVCType*      newType = class_createInstance(self, count * (sizeof(UVCTypeField) + sizeof(UVCTypeSwapRun)) + slotCount * sizeof(NSUInteger) + nameBytes);
       
       if ( newType && (newType = [newType init]) ) {
         newType->_fieldCount = count;
         if ( (newType->_fields = object_getIndexedIvars(newType)) > 0 ) {
           UVCTypeField    *FIELD_PTR = (UVCTypeField*)newType->_fields;
+          UVCTypeSwapRun  *swapRuns = (UVCTypeSwapRun*)(FIELD_PTR + count);
+          NSUInteger      *slots = (NSUInteger*)(swapRuns + count);
+          char            *foldedNames = (char*)(slots + slotCount);
+          NSUInteger      byteOffset = 0;
           BOOL            needsNoByteSwap = YES;
           
+          newType->_swapRuns = swapRuns;
+          newType->_nameSlots = slots;
+          newType->_nameSlotMask = slotCount - 1;
           i = 0;
           while ( i < count ) {
+            const char    *nameStr = [names[i] UTF8String];
+            NSUInteger    nameLen = strlen(nameStr), slot, j;
+            
+            NSUInteger    width = UVCTypeComponentByteSize(types[i]);
+            
             FIELD_PTR->fieldName = [names[i] copy];
             FIELD_PTR->fieldType = types[i];
-            if ( UVCTypeComponentByteSize(types[i]) != 1 ) needsNoByteSwap = NO;
+            FIELD_PTR->fieldOffset = byteOffset;
+            if ( width > 1 ) {
+              UVCTypeSwapRun  *lastRun = newType->_swapRunCount ? &swapRuns[newType->_swapRunCount - 1] : NULL;
+              
+              needsNoByteSwap = NO;
+              // Extend the previous run if this field continues it:
+              if ( lastRun && (lastRun->width == width) && (lastRun->offset + lastRun->width * lastRun->count == byteOffset) ) {
+                lastRun->count++;
+              } else {
+                swapRuns[newType->_swapRunCount].offset = byteOffset;
+                swapRuns[newType->_swapRunCount].width = width;
+                swapRuns[newType->_swapRunCount].count = 1;
+                newType->_swapRunCount++;
+              }
+            }
+            byteOffset += width;
+            
+            for ( j = 0; j < nameLen; j++ ) foldedNames[j] = tolower(nameStr[j]);
+            foldedNames[nameLen] = '\0';
+            FIELD_PTR->foldedName = foldedNames;
+            FIELD_PTR->foldedNameLength = nameLen;
+            foldedNames += nameLen + 1;
+            memcpy(foldedNames, nameStr, nameLen + 1);
+            FIELD_PTR->nameBytes = foldedNames;
+            FIELD_PTR->nameLength = nameLen;
+            foldedNames += nameLen + 1;
+            if ( nameLen > newType->_maximumFieldNameLength ) newType->_maximumFieldNameLength = nameLen;
+            
+            // Worst case is a JSON-escaped name, quotes, colon, sign + 20 digits, comma:
+            newType->_maximumFormattedLength += 6 * nameLen + 3 + 21 + 1;
+            
+            //
+            // Add to the name index; a repeated name keeps the first field's slot,
+            // just as a front-to-back search would:
+            //
+            slot = __UVCTypeFieldNameHash(FIELD_PTR->foldedName, nameLen) & newType->_nameSlotMask;
+            while ( slots[slot] ) {
+              UVCTypeField  *other = (UVCTypeField*)newType->_fields + (slots[slot] - 1);
+              
+              if ( (other->foldedNameLength == nameLen) && (memcmp(other->foldedName, FIELD_PTR->foldedName, nameLen) == 0) ) break;
+              slot = (slot + 1) & newType->_nameSlotMask;
+            }
+            if ( ! slots[slot] ) slots[slot] = i + 1;
+            
             i++; FIELD_PTR++;
           }
+          newType->_byteSize = byteOffset;
+          newType->_maximumFormattedLength += 2;
           newType->_needsNoByteSwap = needsNoByteSwap || (NSHostByteOrder() == NS_LittleEndian);
             
           [newType autorelease];
@@ -1398,6 +2031,27 @@ typedef struct {
     return nil;
   }
   
+//
+
+  + (UVCType*) uvcTypeWithFieldCount:(NSUInteger)count
+    descriptors:(const UVCTypeFieldDescriptor*)descriptors
+  {
+    if ( count ) {
+      NSString                *fieldNames[count];
+      UVCTypeComponentType    fieldTypes[count];
+      NSUInteger              i = 0;
+      
+      while ( i < count ) {
+        if ( ! descriptors[i].fieldName ) return nil;
+        fieldNames[i] = [NSString stringWithCString:descriptors[i].fieldName encoding:NSASCIIStringEncoding];
+        fieldTypes[i] = descriptors[i].fieldType;
+        i++;
+      }
+      return [self uvcTypeWithFieldCount:count names:fieldNames types:fieldTypes];
+    }
+    return nil;
+  }
+  
 //
 
   - (void) dealloc
@@ -1469,7 +2123,7 @@ typedef struct {
 
   - (NSString*) fieldNameAtIndex:(NSUInteger)index
   {
-    if ( index > _fieldCount ) return NULL;
+    if ( index >= _fieldCount ) return NULL;
     
     return ((UVCTypeField*)_fields)[index].fieldName;
   }
@@ -1478,7 +2132,7 @@ typedef struct {
 
   - (UVCTypeComponentType) fieldTypeAtIndex:(NSUInteger)index
   {
-    if ( index > _fieldCount ) return kUVCTypeComponentTypeInvalid;
+    if ( index >= _fieldCount ) return kUVCTypeComponentTypeInvalid;
     
     return ((UVCTypeField*)_fields)[index].fieldType;
   }
@@ -1487,188 +2141,109 @@ typedef struct {
 
   - (NSUInteger) indexOfFieldWithName:(NSString*)fieldName
   {
-    UVCTypeField    *FIELD_PTR = (UVCTypeField*)_fields;
-    UVCTypeField    *FIELD_MAX = FIELD_PTR + _fieldCount;
-    NSUInteger      fieldIdx = 0;
+    char            nameStr[_maximumFieldNameLength + 1];
     
-    while ( FIELD_PTR < FIELD_MAX ) {
-      if ( [FIELD_PTR->fieldName caseInsensitiveCompare:fieldName] == NSOrderedSame ) return fieldIdx;
-      FIELD_PTR++;
-      fieldIdx++;
-    }
-    return UVCTypeInvalidIndex;
+    // A name that doesn't fit can't match any of ours:
+    if ( ! [fieldName getCString:nameStr maxLength:sizeof(nameStr) encoding:NSUTF8StringEncoding] ) return UVCTypeInvalidIndex;
+    return [self indexOfFieldWithCString:nameStr length:strlen(nameStr)];
+  }
+
+//
+
+  - (NSUInteger) indexOfFieldWithCString:(const char*)fieldName
+    length:(NSUInteger)length
+  {
+    return __UVCTypeIndexOfFieldName((UVCTypeField*)_fields, _nameSlots, _nameSlotMask, fieldName, length);
   }
 
 //
 
   - (UVCTypeComponentType) typeWithName:(NSString*)fieldName
   {
-    UVCTypeField    *FIELD_PTR = (UVCTypeField*)_fields;
-    UVCTypeField    *FIELD_MAX = FIELD_PTR + _fieldCount;
+    NSUInteger      index = [self indexOfFieldWithName:fieldName];
     
-    while ( FIELD_PTR < FIELD_MAX ) {
-      if ( [FIELD_PTR->fieldName caseInsensitiveCompare:fieldName] == NSOrderedSame ) return FIELD_PTR->fieldType;
-      FIELD_PTR++;
-    }
-    return kUVCTypeComponentTypeInvalid;
+    if ( index == UVCTypeInvalidIndex ) return kUVCTypeComponentTypeInvalid;
+    return ((UVCTypeField*)_fields)[index].fieldType;
   }
 
 //
 
   - (NSUInteger) byteSize
   {
-    UVCTypeField    *FIELD_PTR = (UVCTypeField*)_fields;
-    UVCTypeField    *FIELD_MAX = FIELD_PTR + _fieldCount;
-    NSUInteger      byteSize = 0;
-    
-    while ( FIELD_PTR < FIELD_MAX ) {
-      byteSize += UVCTypeComponentByteSize(FIELD_PTR->fieldType);
-      FIELD_PTR++;
-    }
-    return byteSize;
+    return _byteSize;
   }
   
 //
 
   - (NSUInteger) offsetToFieldAtIndex:(NSUInteger)index
   {
-    NSUInteger      byteOffset = 0;
-    
-    if ( index > _fieldCount ) {
-      byteOffset = UVCTypeInvalidIndex;
-    } else {
-      UVCTypeField    *FIELD_PTR = (UVCTypeField*)_fields;
-      
-      while ( index-- ) {
-        byteOffset += UVCTypeComponentByteSize(FIELD_PTR->fieldType);
-        FIELD_PTR++;
-      }
-    }
-    return byteOffset;
+    if ( index >= _fieldCount ) return UVCTypeInvalidIndex;
+    return ((UVCTypeField*)_fields)[index].fieldOffset;
   }
   
 //
 
   - (NSUInteger) offsetToFieldWithName:(NSString*)fieldName
   {
-    NSUInteger      byteOffset = 0;
-    UVCTypeField    *FIELD_PTR = (UVCTypeField*)_fields;
-    UVCTypeField    *FIELD_MAX = FIELD_PTR + _fieldCount;
-    
-    while ( FIELD_PTR < FIELD_MAX ) {
-      if ( [FIELD_PTR->fieldName caseInsensitiveCompare:fieldName] == NSOrderedSame ) break;
-      byteOffset += UVCTypeComponentByteSize(FIELD_PTR->fieldType);
-      FIELD_PTR++;
-    }
-    if ( FIELD_PTR == FIELD_MAX ) byteOffset = UVCTypeInvalidIndex;
-    return byteOffset;
+    return [self offsetToFieldAtIndex:[self indexOfFieldWithName:fieldName]];
   }
 
 //
 
-  - (void) byteSwapHostToUSBEndian:(void*)buffer
+  - (BOOL) needsByteSwap
   {
-    if ( _needsNoByteSwap ) return;
-  
-    UVCTypeField    *FIELD_PTR = (UVCTypeField*)_fields;
-    UVCTypeField    *FIELD_MAX = FIELD_PTR + _fieldCount;
-    
-    while ( FIELD_PTR < FIELD_MAX ) {
-      switch ( FIELD_PTR->fieldType ) {
-        case kUVCTypeComponentTypeBoolean:
-        case kUVCTypeComponentTypeBitmap8:
-        case kUVCTypeComponentTypeSInt8:
-        case kUVCTypeComponentTypeUInt8:
-          buffer++;
-          break;
-        case kUVCTypeComponentTypeSInt16:
-        case kUVCTypeComponentTypeUInt16:
-        case kUVCTypeComponentTypeBitmap16: {
-          UInt16   *asInt16Ptr = (UInt16*)buffer;
-          
-          *asInt16Ptr = NSSwapHostShortToLittle(*asInt16Ptr);
-          buffer += 2;
-          break;
-        }
-        case kUVCTypeComponentTypeSInt32:
-        case kUVCTypeComponentTypeUInt32:
-        case kUVCTypeComponentTypeBitmap32: {
-          UInt32   *asInt32Ptr = (UInt32*)buffer;
-          
-          *asInt32Ptr = NSSwapHostIntToLittle(*asInt32Ptr);
-          buffer += 4;
-          break;
-        }
-        case kUVCTypeComponentTypeSInt64:
-        case kUVCTypeComponentTypeUInt64:
-        case kUVCTypeComponentTypeBitmap64: {
-          UInt64   *asInt64Ptr = (UInt64*)buffer;
-          
-          *asInt64Ptr = NSSwapHostLongLongToLittle(*asInt64Ptr);
-          buffer += 8;
-          break;
-        }
-        case kUVCTypeComponentTypeMax:
-        case kUVCTypeComponentTypeInvalid:
-          // Should never get here!
-          break;
-      }
-      FIELD_PTR++;
-    }
+    return ! _needsNoByteSwap;
   }
 
 //
 
-  - (void) byteSwapUSBToHostEndian:(void*)buffer
+  - (void) byteSwapBuffer:(void*)buffer
+    count:(NSUInteger)count
   {
-    if ( _needsNoByteSwap ) return;
+    UVCTypeSwapRun  *RUN_PTR = (UVCTypeSwapRun*)_swapRuns;
+    UVCTypeSwapRun  *RUN_MAX = RUN_PTR + _swapRunCount;
     
-    UVCTypeField    *FIELD_PTR = (UVCTypeField*)_fields;
-    UVCTypeField    *FIELD_MAX = FIELD_PTR + _fieldCount;
+    if ( ! _swapRunCount || ! count ) return;
     
-    while ( FIELD_PTR < FIELD_MAX ) {
-      switch ( FIELD_PTR->fieldType ) {
-        case kUVCTypeComponentTypeBoolean:
-        case kUVCTypeComponentTypeBitmap8:
-        case kUVCTypeComponentTypeSInt8:
-        case kUVCTypeComponentTypeUInt8:
-          buffer++;
-          break;
-        case kUVCTypeComponentTypeSInt16:
-        case kUVCTypeComponentTypeUInt16:
-        case kUVCTypeComponentTypeBitmap16: {
-          UInt16   *asInt16Ptr = (UInt16*)buffer;
-          
-          *asInt16Ptr = NSSwapLittleShortToHost(*asInt16Ptr);
-          buffer += 2;
-          break;
-        }
-        case kUVCTypeComponentTypeSInt32:
-        case kUVCTypeComponentTypeUInt32:
-        case kUVCTypeComponentTypeBitmap32: {
-          UInt32   *asInt32Ptr = (UInt32*)buffer;
-          
-          *asInt32Ptr = NSSwapLittleIntToHost(*asInt32Ptr);
-          buffer += 4;
-          break;
-        }
-        case kUVCTypeComponentTypeSInt64:
-        case kUVCTypeComponentTypeUInt64:
-        case kUVCTypeComponentTypeBitmap64: {
-          UInt64   *asInt64Ptr = (UInt64*)buffer;
-          
-          *asInt64Ptr = NSSwapLittleLongLongToHost(*asInt64Ptr);
-          buffer += 8;
-          break;
-        }
-        case kUVCTypeComponentTypeMax:
-        case kUVCTypeComponentTypeInvalid:
-          // Should never get here!
-          break;
+    //
+    // When one run covers the entire type (e.g. all fields are 16-bit) an array
+    // of the type is just one long run of elements:
+    //
+    if ( (_swapRunCount == 1) && (RUN_PTR->width * RUN_PTR->count == _byteSize) ) {
+      __UVCTypeSwapElements(buffer, RUN_PTR->width, RUN_PTR->count * count);
+      return;
+    }
+    while ( count-- ) {
+      for ( RUN_PTR = (UVCTypeSwapRun*)_swapRuns; RUN_PTR < RUN_MAX; RUN_PTR++ ) {
+        __UVCTypeSwapElements(buffer + RUN_PTR->offset, RUN_PTR->width, RUN_PTR->count);
       }
-      FIELD_PTR++;
+      buffer += _byteSize;
     }
   }
+
+//
+
+  - (void) byteSwapHostToUSBEndian:(void*)buffer
+  {
+    if ( ! _needsNoByteSwap ) [self byteSwapBuffer:buffer count:1];
+  }
+  - (void) byteSwapHostToUSBEndian:(void*)buffer
+    count:(NSUInteger)count
+  {
+    if ( ! _needsNoByteSwap ) [self byteSwapBuffer:buffer count:count];
+  }
+
+//
+
+  - (void) byteSwapUSBToHostEndian:(void*)buffer
+  {
+    if ( ! _needsNoByteSwap ) [self byteSwapBuffer:buffer count:1];
+  }
+  - (void) byteSwapUSBToHostEndian:(void*)buffer
+    count:(NSUInteger)count
+  {
+    if ( ! _needsNoByteSwap ) [self byteSwapBuffer:buffer count:count];
+  }
   
 //
 
@@ -1699,7 +2274,7 @@ typedef struct {
     maximum:(void*)maximum
     stepSize:(void*)stepSize
   {
-    return [self scanCString:cString intoBuffer:buffer flags:flags minimum:minimum maximum:maximum stepSize:nil defaultValue:nil];
+    return [self scanCString:cString intoBuffer:buffer flags:flags minimum:minimum maximum:maximum stepSize:stepSize defaultValue:nil];
   }
 
 //
@@ -1712,295 +2287,170 @@ typedef struct {
     stepSize:(void*)stepSize
     defaultValue:(void*)defaultValue
   {
-    UVCTypeField    *FIELD_PTR = (UVCTypeField*)_fields;
-    BOOL            rc = NO;
-    NSUInteger      nChar;
-    
-    //
-    // We at least need to drop leading whitespace:
-    //
-    while ( isspace(*cString) ) cString++;
+    return ([self scanCString:cString intoBuffer:buffer flags:flags minimum:minimum maximum:maximum stepSize:stepSize defaultValue:defaultValue errorOffset:NULL] == kUVCTypeScanOk) ? YES : NO;
+  }
+
+//
+
+  - (UVCTypeScanStatus) scanCString:(const char*)cString
+    intoBuffer:(void*)buffer
+    flags:(UVCTypeScanFlags)flags
+    minimum:(void*)minimum
+    maximum:(void*)maximum
+    stepSize:(void*)stepSize
+    defaultValue:(void*)defaultValue
+    errorOffset:(NSUInteger*)errorOffset
+  {
+    return __UVCTypeScanCString(
+                (UVCTypeField*)_fields,
+                _fieldCount,
+                _byteSize,
+                _nameSlots,
+                _nameSlotMask,
+                cString,
+                buffer,
+                flags,
+                minimum,
+                maximum,
+                stepSize,
+                defaultValue,
+                errorOffset
+              );
+  }
+
+//
+
+  - (NSUInteger) maximumFormattedLength
+  {
+    return _maximumFormattedLength;
+  }
+
+//
+
+  - (NSUInteger) formatBuffer:(const void*)buffer
+    format:(UVCTypeFormat)format
+    intoCString:(char*)outString
+    length:(NSUInteger)outLength
+  {
+    UVCTypeField          *FIELD_PTR = (UVCTypeField*)_fields;
+    UVCTypeField          *FIELD_MAX = FIELD_PTR + _fieldCount;
+    UVCTypeFormatWriter   writer = { .p = outString, .end = outString + (outLength ? outLength - 1 : 0), .length = 0 };
+    BOOL                  isStructured = ( (_fieldCount > 1) && (format != kUVCTypeFormatCSV) );
     
-    //
-    // If the string doesn't lead with a brace...
-    //
-    if ( *cString != '{' ) {
-      //
-      // If it's "default" then set the WHOLE THING to the default:
-      //
-      if ( strncasecmp(cString, "default", 7) == 0 ) {
-        if ( defaultValue ) {
-          if ( (flags & kUVCTypeScanFlagShowInfo) ) fprintf(stderr, "INFO: Copying default value provided by this control\n");
-          memcpy(buffer, defaultValue, [self byteSize]);
-          rc = YES;
-        } else {
-          if ( (flags & kUVCTypeScanFlagShowWarnings) ) fprintf(stderr, "WARNING: No default value provided by this control\n");
-        }
-      }
-      //
-      // If it's "minimum" then set the WHOLE THING to the minimum:
-      //
-      if ( strncasecmp(cString, "minimum", 7) == 0 ) {
-        if ( minimum ) {
-          if ( (flags & kUVCTypeScanFlagShowInfo) ) fprintf(stderr, "INFO: Copying minimum value provided by this control\n");
-          memcpy(buffer, minimum, [self byteSize]);
-          rc = YES;
-        } else {
-          if ( (flags & kUVCTypeScanFlagShowWarnings) ) fprintf(stderr, "WARNING: No minimum value provided by this control\n");
-        }
-      }
-      //
-      // If it's "maximum" then set the WHOLE THING to the maximum:
-      //
-      if ( strncasecmp(cString, "maximum", 7) == 0 ) {
-        if ( maximum ) {
-          if ( (flags & kUVCTypeScanFlagShowInfo) ) fprintf(stderr, "INFO: Copying maximum value provided by this control\n");
-          memcpy(buffer, maximum, [self byteSize]);
-          rc = YES;
-        } else {
-          if ( (flags & kUVCTypeScanFlagShowWarnings) ) fprintf(stderr, "WARNING: No maximum value provided by this control\n");
-        }
-      }
-      if ( _fieldCount == 1 ) {
-        //
-        // ...we have a single field, so try just scanning its value:
-        //
-        rc = __UVCTypeComponentTypeScanf(
-                    cString,
-                    FIELD_PTR->fieldType,
-                    buffer,
-                    flags,
-                    minimum,
-                    maximum,
-                    stepSize,
-                    defaultValue,
-                    &nChar
-                  );
-      }
-    } else {
-      BOOL                  usesNamedValues = strchr(cString, '=') ? YES : NO;
-      NSUInteger            fieldIdx = 0;
-      CFMutableBitVectorRef fieldsUsed = usesNamedValues ? CFBitVectorCreateMutable(kCFAllocatorDefault, _fieldCount) : NULL;
-      
-      if ( (flags & kUVCTypeScanFlagShowInfo) ) fprintf(stderr, "INFO: Using %s field assignments\n", (usesNamedValues ? "named-value" : "in-order"));
-      
-      // Skip-over the brace:
-      cString++;
-      while ( *cString && (fieldIdx < _fieldCount) ) {
-        NSString    *fieldName = nil;
-        NSUInteger  fieldOffset;
-        
-        if ( (flags & kUVCTypeScanFlagShowInfo) ) fprintf(stderr, "INFO: Processing substring '%s'\n", cString);
-        
-        //
-        // When doing named values, read the field name first:
-        //
-        if ( usesNamedValues ) {
-          // Drop leading whitespace:
-          while ( isspace(*cString) ) cString++;
-          
-          // Isolate the name:
-          const char      *namePtr = cString;
-          while ( *cString && (*cString != '=') ) cString++;
-          if ( 1 ) {
-            NSUInteger    i = 0, iMax = cString - namePtr;
-            char          nameStr[iMax + 1];
-            
-            while ( i < iMax ) {
-              nameStr[i] = tolower(namePtr[i]);
-              i++;
-            }
-            nameStr[i] = '\0';
-            fieldName = [[NSString alloc] initWithCString:nameStr encoding:NSASCIIStringEncoding];
-            
-            if ( *cString == '=' ) cString++;
-            fieldIdx = [self indexOfFieldWithName:fieldName];
-            [fieldName release];
-            if ( fieldIdx == UVCTypeInvalidIndex ) {
-              CFRelease(fieldsUsed);
-              if ( (flags & kUVCTypeScanFlagShowWarnings) ) fprintf(stderr, "WARNING: Field name '%s' not defined for this type\n", nameStr);
-              return NO;
-            }
-          }
-        }
-          
-        fieldOffset = [self offsetToFieldAtIndex:fieldIdx];
-        
-        void        *valuePtr = buffer + fieldOffset;
-        void        *minimumPtr = minimum ? minimum + fieldOffset : NULL;
-        void        *maximumPtr = maximum ? maximum + fieldOffset : NULL;
-        void        *stepSizePtr = stepSize ? stepSize + fieldOffset : NULL;
-        void        *defaultValuePtr = defaultValue ? defaultValue + fieldOffset : NULL;
-        
-        // Scan a value:
-        BOOL        scanned = __UVCTypeComponentTypeScanf(
-                                    cString,
-                                    FIELD_PTR[fieldIdx].fieldType,
-                                    valuePtr,
-                                    flags,
-                                    minimumPtr,
-                                    maximumPtr,
-                                    stepSizePtr,
-                                    defaultValuePtr,
-                                    &nChar
-                                  );
-        if ( ! scanned ) break;
-        
-        // Skip trailing whitespace/commas:
-        cString += nChar;
-        while ( isspace(*cString) || (*cString == ',') ) cString++;
-        
-        // If not doing named values, increase the field index; for named-values,
-        // make note of the fact that we set the value at this index:
-        if ( ! usesNamedValues ) {
-          fieldIdx++;
-        } else {
-          CFBitVectorSetBits(fieldsUsed, CFRangeMake(fieldIdx, 1), 1);
-        }
-        
-        // If the closing brace, then exit:
-        if ( *cString == '}' ) break;
-      }
-      if ( fieldsUsed ) {
-        if ( CFBitVectorContainsBit(fieldsUsed, CFRangeMake(0, _fieldCount), 0) ) {
-          CFIndex     zeroCount = CFBitVectorGetCountOfBit(fieldsUsed, CFRangeMake(0, _fieldCount), 0);
-          
-          if ( (flags & kUVCTypeScanFlagShowWarnings) ) fprintf(stderr, "WARNING: %ld named field%s %s not provided\n", zeroCount, ((zeroCount == 1) ? "" : "s"), ((zeroCount == 1) ? "was" : "were"));
+    if ( isStructured ) __UVCTypeFormatWriterAppendChar(&writer, '{');
+    while ( FIELD_PTR < FIELD_MAX ) {
+      if ( FIELD_PTR != (UVCTypeField*)_fields ) __UVCTypeFormatWriterAppendChar(&writer, ',');
+      if ( isStructured ) {
+        if ( format == kUVCTypeFormatJSON ) {
+          __UVCTypeFormatWriterAppendJSONString(&writer, FIELD_PTR->nameBytes, FIELD_PTR->nameLength);
+          __UVCTypeFormatWriterAppendChar(&writer, ':');
         } else {
-          rc = YES;
+          __UVCTypeFormatWriterAppend(&writer, FIELD_PTR->nameBytes, FIELD_PTR->nameLength);
+          __UVCTypeFormatWriterAppendChar(&writer, '=');
         }
-        CFRelease(fieldsUsed);
-      } else if ( fieldIdx >= _fieldCount ) {
-        rc = YES;
       }
+      __UVCTypeFormatWriterAppendComponent(&writer, FIELD_PTR->fieldType, buffer + FIELD_PTR->fieldOffset);
+      FIELD_PTR++;
     }
-    if ( (flags & kUVCTypeScanFlagShowInfo) && rc ) fprintf(stderr, "INFO: Successfully scanned all fields for this type\n");
-    return rc;
+    if ( isStructured ) __UVCTypeFormatWriterAppendChar(&writer, '}');
+    if ( outLength ) *writer.p = '\0';
+    return writer.length;
   }
 
 //
 
-  - (NSString*) stringFromBuffer:(void*)buffer
+  - (BOOL) isBuffer:(const void*)buffer
+    withinMinimum:(const void*)minimum
+    maximum:(const void*)maximum
   {
-    UVCTypeField    *FIELD_PTR = (UVCTypeField*)_fields;
-    UVCTypeField    *FIELD_MAX = FIELD_PTR + _fieldCount;
+    UVCTypeField          *FIELD_PTR = (UVCTypeField*)_fields;
+    UVCTypeField          *FIELD_MAX = FIELD_PTR + _fieldCount;
     
-    if ( _fieldCount == 1 ) {
-      switch ( FIELD_PTR->fieldType ) {
-        case kUVCTypeComponentTypeBoolean: {
-          return *((UInt8*)buffer) ? @"true" : @"false";
-        }
-        case kUVCTypeComponentTypeSInt8: {
-          return [NSString stringWithFormat:@"%hhd", *((SInt8*)buffer)];
+    while ( FIELD_PTR < FIELD_MAX ) {
+      NSUInteger          offset = FIELD_PTR->fieldOffset;
+      
+#define __UVCTYPE_RANGE_CHECK(T) \
+        { \
+          T   v = *((T*)(buffer + offset)); \
+          if ( minimum && (v < *((T*)(minimum + offset))) ) return NO; \
+          if ( maximum && (v > *((T*)(maximum + offset))) ) return NO; \
+          break; \
         }
+      switch ( FIELD_PTR->fieldType ) {
+        case kUVCTypeComponentTypeSInt8:
+          __UVCTYPE_RANGE_CHECK(SInt8)
         case kUVCTypeComponentTypeUInt8:
-        case kUVCTypeComponentTypeBitmap8: {
-          return [NSString stringWithFormat:@"%hhu", *((UInt8*)buffer)];
-        }
-        case kUVCTypeComponentTypeSInt16: {
-          return [NSString stringWithFormat:@"%hd", *((SInt16*)buffer)];
-        }
+          __UVCTYPE_RANGE_CHECK(UInt8)
+        case kUVCTypeComponentTypeSInt16:
+          __UVCTYPE_RANGE_CHECK(SInt16)
         case kUVCTypeComponentTypeUInt16:
-        case kUVCTypeComponentTypeBitmap16: {
-          return [NSString stringWithFormat:@"%hu", *((UInt16*)buffer)];
-        }
-        case kUVCTypeComponentTypeSInt32: {
-          return [NSString stringWithFormat:@"%d", *((SInt32*)buffer)];
-        }
+          __UVCTYPE_RANGE_CHECK(UInt16)
+        case kUVCTypeComponentTypeSInt32:
+          __UVCTYPE_RANGE_CHECK(SInt32)
         case kUVCTypeComponentTypeUInt32:
-        case kUVCTypeComponentTypeBitmap32: {
-          return [NSString stringWithFormat:@"%u", *((UInt32*)buffer)];
-        }
-        case kUVCTypeComponentTypeSInt64: {
-          return [NSString stringWithFormat:@"%lld", *((SInt64*)buffer)];
-        }
+          __UVCTYPE_RANGE_CHECK(UInt32)
+        case kUVCTypeComponentTypeSInt64:
+          __UVCTYPE_RANGE_CHECK(SInt64)
         case kUVCTypeComponentTypeUInt64:
-        case kUVCTypeComponentTypeBitmap64: {
-          return [NSString stringWithFormat:@"%llu", *((UInt64*)buffer)];
-        }
-        case kUVCTypeComponentTypeMax:
-        case kUVCTypeComponentTypeInvalid:
-          // Should never get here!
-          return nil;
+          __UVCTYPE_RANGE_CHECK(UInt64)
+        default:
+          break;
       }
+#undef __UVCTYPE_RANGE_CHECK
+      FIELD_PTR++;
     }
+    return YES;
+  }
+
+//
+
+  - (NSString*) stringFromBuffer:(void*)buffer
+  {
+    char            localBuffer[256];
+    NSUInteger      length = [self formatBuffer:buffer format:kUVCTypeFormatDefault intoCString:localBuffer length:sizeof(localBuffer)];
+    
+    if ( length < sizeof(localBuffer) ) return [[[NSString alloc] initWithBytes:localBuffer length:length encoding:NSUTF8StringEncoding] autorelease];
+    
+    // Unusually long; size a buffer exactly:
+    char            *bigBuffer = malloc(length + 1);
+    NSString        *outString = nil;
     
-    NSMutableString *asString = [[NSMutableString alloc] initWithString:@"{"];
-    BOOL            shouldIncludeComma = NO;
+    if ( bigBuffer ) {
+      [self formatBuffer:buffer format:kUVCTypeFormatDefault intoCString:bigBuffer length:length + 1];
+      outString = [[[NSString alloc] initWithBytes:bigBuffer length:length encoding:NSUTF8StringEncoding] autorelease];
+      free(bigBuffer);
+    }
+    return outString;
+  }
+
+//
+
+  - (void) writeLayoutAsJSONToStream:(FILE*)stream
+  {
+    UVCTypeField    *FIELD_PTR = (UVCTypeField*)_fields;
+    UVCTypeField    *FIELD_MAX = FIELD_PTR + _fieldCount;
     
+    fprintf(stream, "{\"byte-size\":%lu,\"fields\":[", (unsigned long)_byteSize);
     while ( FIELD_PTR < FIELD_MAX ) {
-      switch ( FIELD_PTR->fieldType ) {
-        case kUVCTypeComponentTypeBoolean: {
-          [asString appendFormat:@"%s%@=%s", shouldIncludeComma ? "," : "", FIELD_PTR->fieldName, *((UInt8*)buffer) ? "true" : "false"];
-          shouldIncludeComma = YES;
-          buffer++;
-          break;
-        }     
-        case kUVCTypeComponentTypeSInt8: {
-          [asString appendFormat:@"%s%@=%hhd", shouldIncludeComma ? "," : "", FIELD_PTR->fieldName, *((SInt8*)buffer)];
-          shouldIncludeComma = YES;
-          buffer++;
-          break;
-        }
-        case kUVCTypeComponentTypeUInt8:
-        case kUVCTypeComponentTypeBitmap8: {
-          [asString appendFormat:@"%s%@=%hhu", shouldIncludeComma ? "," : "", FIELD_PTR->fieldName, *((UInt8*)buffer)];
-          shouldIncludeComma = YES;
-          buffer++;
-          break;
-        }
-        case kUVCTypeComponentTypeSInt16: {
-          [asString appendFormat:@"%s%@=%hd", shouldIncludeComma ? "," : "", FIELD_PTR->fieldName, *((SInt16*)buffer)];
-          shouldIncludeComma = YES;
-          buffer += 2;
-          break;
-        }
-        case kUVCTypeComponentTypeUInt16:
-        case kUVCTypeComponentTypeBitmap16: {
-          [asString appendFormat:@"%s%@=%hu", shouldIncludeComma ? "," : "", FIELD_PTR->fieldName, *((UInt16*)buffer)];
-          shouldIncludeComma = YES;
-          buffer += 2;
-          break;
-        }
-        case kUVCTypeComponentTypeSInt32: {
-          [asString appendFormat:@"%s%@=%d", shouldIncludeComma ? "," : "", FIELD_PTR->fieldName, *((SInt32*)buffer)];
-          shouldIncludeComma = YES;
-          buffer += 4;
-          break;
-        }
-        case kUVCTypeComponentTypeUInt32:
-        case kUVCTypeComponentTypeBitmap32: {
-          [asString appendFormat:@"%s%@=%u", shouldIncludeComma ? "," : "", FIELD_PTR->fieldName, *((UInt32*)buffer)];
-          shouldIncludeComma = YES;
-          buffer += 4;
-          break;
-        }
-        case kUVCTypeComponentTypeSInt64: {
-          [asString appendFormat:@"%s%@=%lld", shouldIncludeComma ? "," : "", FIELD_PTR->fieldName, *((SInt64*)buffer)];
-          shouldIncludeComma = YES;
-          buffer += 8;
-          break;
-        }
-        case kUVCTypeComponentTypeUInt64:
-        case kUVCTypeComponentTypeBitmap64: {
-          [asString appendFormat:@"%s%@=%llu", shouldIncludeComma ? "," : "", FIELD_PTR->fieldName, *((UInt64*)buffer)];
-          shouldIncludeComma = YES;
-          buffer += 8;
-          break;
+      const char    *p = FIELD_PTR->nameBytes, *pEnd = p + FIELD_PTR->nameLength;
+      
+      fputs(( FIELD_PTR == (UVCTypeField*)_fields ) ? "{\"name\":\"" : ",{\"name\":\"", stream);
+      while ( p < pEnd ) {
+        unsigned char c = *p++;
+        
+        if ( c == '"' || c == '\\' ) {
+          fputc('\\', stream);
+          fputc(c, stream);
+        } else if ( c < 0x20 ) {
+          fprintf(stream, "\\u%04x", c);
+        } else {
+          fputc(c, stream);
         }
-        case kUVCTypeComponentTypeMax:
-        case kUVCTypeComponentTypeInvalid:
-          // Should never get here!
-          break;
       }
+      fprintf(stream, "\",\"type\":\"%s\",\"offset\":%lu}", __UVCTypeComponentTypeString(FIELD_PTR->fieldType), (unsigned long)FIELD_PTR->fieldOffset);
       FIELD_PTR++;
     }
-    [asString appendString:@"}"];
-    
-    NSString      *outString = [[asString copy] autorelease];
-    [asString release];
-    
-    return outString;
+    fputs("]}", stream);
   }
 
 //
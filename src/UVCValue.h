@@ -23,12 +23,17 @@
   Many of the methods provided by UVCType are duplicated in UVCValue, but
   lack the specification of an external buffer (since UVCValue itself contains
   the buffer in question).
+  
+  A UVCValue can instead be a view onto bytes that belong to another object
+  (e.g. a slot in a UVCValueArena); the view retains that object for as long
+  as it exists.
 */
 @interface UVCValue : NSObject
 {
   BOOL                _isSwappedToUSBEndian;
   UVCType             *_valueType;
   void                *_valuePtr;
+  id                  _owner;
 }
 
 /*!
@@ -40,6 +45,17 @@
 */
 + (UVCValue*) uvcValueWithType:(UVCType*)valueType;
 
+/*!
+  @method uvcValueWithType:bytes:owner:
+  
+  Returns an autoreleased instance of UVCValue that uses valueType as its
+  structural meta-data and the [valueType byteSize] bytes at bytes as its
+  memory buffer, rather than a buffer of its own.  The instance retains owner,
+  the object responsible for the bytes, so they remain valid for the lifetime
+  of the instance.  The bytes are not altered.
+*/
++ (UVCValue*) uvcValueWithType:(UVCType*)valueType bytes:(void*)bytes owner:(id)owner;
+
 /*!
   @method valueType
   
@@ -109,6 +125,15 @@
 */
 - (void) byteSwapUSBToHostEndian;
 
+/*!
+  @method byteSwapFromUSBEndian
+  
+  The receiver's memory buffer has just been filled with USB (little) endian
+  data (e.g. by a GET request to the device):  byte swap it to host endian
+  regardless of the receiver's recorded state.
+*/
+- (void) byteSwapFromUSBEndian;
+
 /*!
   @method scanCString:flags:
   
@@ -150,6 +175,18 @@
 */
 - (BOOL) scanCString:(const char*)cString flags:(UVCTypeScanFlags)flags minimum:(UVCValue*)minimum maximum:(UVCValue*)maximum stepSize:(UVCValue*)stepSize defaultValue:(UVCValue*)defaultValue;
 
+/*!
+  @method scanCString:flags:minimum:maximum:stepSize:defaultValue:errorOffset:
+  
+  Send the scanCString:intoBuffer:flags:minimum:maximum:stepSize:defaultValue:errorOffset:
+  message to the receiver's UVCType, using the receiver's valuePtr as the buffer.
+  
+  Returns kUVCTypeScanOk if all component fields of the receiver's memory buffer
+  were successfully set; otherwise, errorOffset (if non-NULL) is set to the
+  character offset in cString at which scanning failed.
+*/
+- (UVCTypeScanStatus) scanCString:(const char*)cString flags:(UVCTypeScanFlags)flags minimum:(UVCValue*)minimum maximum:(UVCValue*)maximum stepSize:(UVCValue*)stepSize defaultValue:(UVCValue*)defaultValue errorOffset:(NSUInteger*)errorOffset;
+
 /*!
   @method stringValue
   
@@ -163,12 +200,24 @@
 */
 - (NSString*) stringValue;
 
+/*!
+  @method formatAs:intoCString:length:
+  
+  Write a textual description of the receiver's data in the given format into the
+  caller-provided outString of outLength bytes, without allocating any objects.  See
+  the formatBuffer:format:intoCString:length: method of UVCType; a buffer of
+  [[value valueType] maximumFormattedLength] + 1 bytes is always sufficient.
+  
+  Returns the length of the complete formatted text, excluding the NUL.
+*/
+- (NSUInteger) formatAs:(UVCTypeFormat)format intoCString:(char*)outString length:(NSUInteger)outLength;
+
 /*!
   @method copyValue:
   
   If [otherValue valueType] matches the receiver's UVCType (same layout of atomic
   types) then the requisite number of bytes from [otherValue valuePtr] are copied
-  to the receiver's memory buffer.
+  to the receiver's memory buffer (along with its byte order) and YES is returned.
 */
 - (BOOL) copyValue:(UVCValue*)otherValue;
 
@@ -33,12 +33,33 @@
     }
     return newValue;
   }
+
+//
+
+  + (UVCValue*) uvcValueWithType:(UVCType*)valueType
+    bytes:(void*)bytes
+    owner:(id)owner
+  {
+    UVCValue        *newValue = nil;
+    if ( valueType && bytes ) {
+      newValue = class_createInstance(self, 0);
+      if ( newValue && (newValue = [newValue init]) ) {
+        newValue->_valueType = [valueType retain];
+        newValue->_valuePtr = bytes;
+        newValue->_owner = [owner retain];
+        
+        [newValue autorelease];
+      }
+    }
+    return newValue;
+  }
   
 //
 
   - (void) dealloc
   {
     [_valueType release];
+    if ( _owner ) [_owner release];
     [super dealloc];
   }
 
@@ -103,7 +124,7 @@
   {
     NSUInteger      offset = [_valueType offsetToFieldAtIndex:index];
     
-    if ( offset != kUVCTypeComponentTypeInvalid ) return (_valuePtr + offset);
+    if ( offset != UVCTypeInvalidIndex ) return (_valuePtr + offset);
     return NULL;
   }
   
@@ -113,7 +134,7 @@
   {
     NSUInteger      offset = [_valueType offsetToFieldWithName:fieldName];
     
-    if ( offset != kUVCTypeComponentTypeInvalid ) return (_valuePtr + offset);
+    if ( offset != UVCTypeInvalidIndex ) return (_valuePtr + offset);
     return NULL;
   }
   
@@ -144,6 +165,14 @@
     }
   }
 
+//
+
+  - (void) byteSwapFromUSBEndian
+  {
+    [_valueType byteSwapUSBToHostEndian:_valuePtr];
+    _isSwappedToUSBEndian = NO;
+  }
+
 //
 
   - (BOOL) scanCString:(const char*)cString
@@ -206,12 +235,42 @@
                       ];
   }
 
+//
+
+  - (UVCTypeScanStatus) scanCString:(const char*)cString
+    flags:(UVCTypeScanFlags)flags
+    minimum:(UVCValue*)minimum
+    maximum:(UVCValue*)maximum
+    stepSize:(UVCValue*)stepSize
+    defaultValue:(UVCValue*)defaultValue
+    errorOffset:(NSUInteger*)errorOffset
+  {
+    return [_valueType scanCString:cString
+                        intoBuffer:_valuePtr
+                        flags:flags
+                        minimum:(minimum ? [minimum valuePtr] : NULL)
+                        maximum:(maximum ? [maximum valuePtr] : NULL)
+                        stepSize:(stepSize ? [stepSize valuePtr] : NULL)
+                        defaultValue:(defaultValue ? [defaultValue valuePtr] : NULL)
+                        errorOffset:errorOffset
+                      ];
+  }
+
 //
 
   - (NSString*) stringValue
   {
     return [_valueType stringFromBuffer:_valuePtr];
   }
+
+//
+
+  - (NSUInteger) formatAs:(UVCTypeFormat)format
+    intoCString:(char*)outString
+    length:(NSUInteger)outLength
+  {
+    return [_valueType formatBuffer:_valuePtr format:format intoCString:outString length:outLength];
+  }
   
 //
 
@@ -219,6 +278,8 @@
   {
     if ( [_valueType isEqual:[otherValue valueType]] ) {
       memcpy(_valuePtr, [otherValue valuePtr], [_valueType byteSize]);
+      _isSwappedToUSBEndian = [otherValue isSwappedToUSBEndian];
+      return YES;
     }
     return NO;
   }
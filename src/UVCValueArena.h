@@ -0,0 +1,179 @@
+//
+//  UVCValueArena.h
+//
+//  Struct-of-arrays storage for the values of a controller's controls.
+//
+//  Copyright © 2016
+//  Dr. Jeffrey Frey, IT-NSS
+//  University of Delaware
+//
+// $Id$
+//
+
+#import "UVCValue.h"
+
+/*!
+  @typedef UVCValueArenaSlot
+
+  The values kept for each control in a UVCValueArena:
+
+    - kUVCValueArenaSlotCurrent:  the control's current value (as last read
+      from or written to the device)
+    - kUVCValueArenaSlotMinimum, kUVCValueArenaSlotMaximum:  the control's range
+    - kUVCValueArenaSlotStepSize:  the control's resolution
+    - kUVCValueArenaSlotDefault:  the control's default value
+*/
+typedef enum {
+  kUVCValueArenaSlotCurrent     = 0,
+  kUVCValueArenaSlotMinimum,
+  kUVCValueArenaSlotMaximum,
+  kUVCValueArenaSlotStepSize,
+  kUVCValueArenaSlotDefault,
+  kUVCValueArenaSlotCount
+} UVCValueArenaSlot;
+
+/*!
+  @class UVCValueArena
+  @abstract Packed storage for the current value and limits of a set of controls.
+
+  An arena holds, for each of count controls (identified by index), one value
+  per UVCValueArenaSlot.  The values of a slot form a single contiguous plane
+  in which each control's value sits at an offset computed (from the controls'
+  UVCTypes) when the arena is created; all planes share the same layout and
+  live in a single allocation along with the offsets and per-control slot
+  presence bits.
+
+  Individual values are exposed as UVCValue instances that view the arena's
+  bytes (see uvcValueWithType:bytes:owner: in UVCValue) rather than copies, so
+  writing through a view updates the arena.  Operations over every control --
+  snapshots, diffs, range checks -- walk the planes linearly instead of
+  visiting one object per value.
+
+  Values are kept in host byte order.
+*/
+@interface UVCValueArena : NSObject
+{
+  NSUInteger        _count;
+  NSUInteger        _planeSize;
+  UVCType           **_types;
+  NSUInteger        *_offsets;
+  UInt8             *_slotMasks;
+  void              *_planes;
+}
+
+/*!
+  @method valueArenaWithTypes:count:
+
+  Returns an autoreleased arena holding values for count controls, the value
+  of control index i structured according to types[i].  A NULL entry in types
+  reserves no storage for that index.  All values start out zeroed, and no
+  slot is present.
+*/
++ (UVCValueArena*) valueArenaWithTypes:(UVCType**)types count:(NSUInteger)count;
+
+/*!
+  @method count
+
+  Returns the number of control indexes in the receiver.
+*/
+- (NSUInteger) count;
+
+/*!
+  @method planeSize
+
+  Returns the size (in bytes) of each slot's plane of values.
+*/
+- (NSUInteger) planeSize;
+
+/*!
+  @method byteSize
+
+  Returns the total size (in bytes) of the storage allocated with the
+  receiver:  every plane plus the types, offsets, and slot presence bits.
+*/
+- (NSUInteger) byteSize;
+
+/*!
+  @method typeAtIndex:
+
+  Returns the UVCType of the values at index, or nil if index is out of range
+  or has no storage.
+*/
+- (UVCType*) typeAtIndex:(NSUInteger)index;
+
+/*!
+  @method offsetOfIndex:
+
+  Returns the offset (in bytes) of index's values within each plane, or
+  UVCTypeInvalidIndex if index is out of range.
+*/
+- (NSUInteger) offsetOfIndex:(NSUInteger)index;
+
+/*!
+  @method bytesOfSlot:
+
+  Returns the base address of slot's plane of values.
+*/
+- (void*) bytesOfSlot:(UVCValueArenaSlot)slot;
+
+/*!
+  @method pointerToSlot:atIndex:
+
+  Returns the address of the value of index in slot's plane, or NULL if index
+  is out of range or has no storage.
+*/
+- (void*) pointerToSlot:(UVCValueArenaSlot)slot atIndex:(NSUInteger)index;
+
+/*!
+  @method hasSlot:atIndex:
+
+  Returns YES if slot has been marked present for index (e.g. the device
+  provided that limit for the control).
+*/
+- (BOOL) hasSlot:(UVCValueArenaSlot)slot atIndex:(NSUInteger)index;
+
+/*!
+  @method setSlot:atIndex:isPresent:
+
+  Mark slot present (or not) for index.  Only present values take part in
+  snapshots, diffs, and range checks.
+*/
+- (void) setSlot:(UVCValueArenaSlot)slot atIndex:(NSUInteger)index isPresent:(BOOL)isPresent;
+
+/*!
+  @method valueForSlot:atIndex:
+
+  Returns an autoreleased UVCValue that views the value of index in slot's
+  plane (whether or not the slot is present) and retains the receiver.
+  Returns nil if index is out of range or has no storage.
+*/
+- (UVCValue*) valueForSlot:(UVCValueArenaSlot)slot atIndex:(NSUInteger)index;
+
+/*!
+  @method snapshotOfSlot:
+
+  Returns a copy of slot's entire plane of values.
+*/
+- (NSData*) snapshotOfSlot:(UVCValueArenaSlot)slot;
+
+/*!
+  @method indexesOfSlot:differingFromSnapshot:
+
+  Returns the indexes at which slot is present and its value differs from the
+  value in snapshot, a plane previously returned by snapshotOfSlot:.  When
+  nothing changed this is a single memcmp() of the plane.
+
+  Returns nil if snapshot is not the size of a plane.
+*/
+- (NSIndexSet*) indexesOfSlot:(UVCValueArenaSlot)slot differingFromSnapshot:(NSData*)snapshot;
+
+/*!
+  @method indexesOutOfRange
+
+  Returns the indexes at which the current value, minimum, and maximum are all
+  present and some numeric component of the current value lies outside the
+  range (see isBuffer:withinMinimum:maximum: in UVCType).
+*/
+- (NSIndexSet*) indexesOutOfRange;
+
+@end
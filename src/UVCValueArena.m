@@ -0,0 +1,250 @@
+//
+//  UVCValueArena.m
+//
+//  Struct-of-arrays storage for the values of a controller's controls.
+//
+//  Copyright © 2016
+//  Dr. Jeffrey Frey, IT-NSS
+//  University of Delaware
+//
+// $Id$
+//
+
+#import "UVCValueArena.h"
+
+#import <objc/runtime.h>
+
+//
+// Values are placed at their natural alignment (up to 8 bytes) within a plane,
+// and planes are padded to a multiple of 8 bytes so every plane starts aligned:
+//
+static inline NSUInteger
+__UVCValueArenaAlignment(
+  NSUInteger    byteSize
+)
+{
+  if ( byteSize >= 8 ) return 8;
+  if ( byteSize >= 4 ) return 4;
+  if ( byteSize >= 2 ) return 2;
+  return 1;
+}
+
+//
+
+@implementation UVCValueArena
+
+  + (UVCValueArena*) valueArenaWithTypes:(UVCType**)types
+    count:(NSUInteger)count
+  {
+    UVCValueArena     *newArena = nil;
+    NSUInteger        planeSize = 0, i;
+    NSUInteger        offsets[count ? count : 1];
+
+    for ( i = 0; i < count; i++ ) {
+      NSUInteger      byteSize = ( types[i] ? [types[i] byteSize] : 0 );
+      NSUInteger      alignment = __UVCValueArenaAlignment(byteSize);
+
+      planeSize = (planeSize + alignment - 1) & ~(alignment - 1);
+      offsets[i] = planeSize;
+      planeSize += byteSize;
+    }
+    planeSize = (planeSize + 7) & ~((NSUInteger)7);
+
+    //
+    // Types and offsets come first (both pointer-sized, so the planes that
+    // follow them are 8-byte aligned), then the planes, then the presence bits:
+    //
+    newArena = class_createInstance(self, count * (sizeof(UVCType*) + sizeof(NSUInteger) + sizeof(UInt8)) + kUVCValueArenaSlotCount * planeSize);
+    if ( newArena && (newArena = [newArena init]) ) {
+      void            *base = object_getIndexedIvars(newArena);
+
+      newArena->_count = count;
+      newArena->_planeSize = planeSize;
+      newArena->_types = (UVCType**)base;
+      newArena->_offsets = (NSUInteger*)(base + count * sizeof(UVCType*));
+      newArena->_planes = base + count * (sizeof(UVCType*) + sizeof(NSUInteger));
+      newArena->_slotMasks = (UInt8*)(newArena->_planes + kUVCValueArenaSlotCount * planeSize);
+
+      memset(newArena->_planes, 0, kUVCValueArenaSlotCount * planeSize + count);
+      for ( i = 0; i < count; i++ ) {
+        newArena->_types[i] = ( types[i] ? [types[i] retain] : nil );
+        newArena->_offsets[i] = offsets[i];
+      }
+      [newArena autorelease];
+    }
+    return newArena;
+  }
+
+//
+
+  - (void) dealloc
+  {
+    NSUInteger      i;
+
+    for ( i = 0; i < _count; i++ ) if ( _types[i] ) [_types[i] release];
+    [super dealloc];
+  }
+
+//
+
+  - (NSString*) description
+  {
+    NSUInteger      i, present[kUVCValueArenaSlotCount] = { 0, 0, 0, 0, 0 };
+
+    for ( i = 0; i < _count; i++ ) {
+      UVCValueArenaSlot   slot;
+
+      for ( slot = kUVCValueArenaSlotCurrent; slot < kUVCValueArenaSlotCount; slot++ ) if ( _slotMasks[i] & (1 << slot) ) present[slot]++;
+    }
+    return [NSString stringWithFormat:@"UVCValueArena@%p { count: %lu; plane-size: %lu; byte-size: %lu; present: { current: %lu; minimum: %lu; maximum: %lu; step-size: %lu; default: %lu } }",
+                self,
+                (unsigned long)_count,
+                (unsigned long)_planeSize,
+                (unsigned long)[self byteSize],
+                (unsigned long)present[kUVCValueArenaSlotCurrent],
+                (unsigned long)present[kUVCValueArenaSlotMinimum],
+                (unsigned long)present[kUVCValueArenaSlotMaximum],
+                (unsigned long)present[kUVCValueArenaSlotStepSize],
+                (unsigned long)present[kUVCValueArenaSlotDefault]
+              ];
+  }
+
+//
+
+  - (NSUInteger) count
+  {
+    return _count;
+  }
+
+//
+
+  - (NSUInteger) planeSize
+  {
+    return _planeSize;
+  }
+
+//
+
+  - (NSUInteger) byteSize
+  {
+    return _count * (sizeof(UVCType*) + sizeof(NSUInteger) + sizeof(UInt8)) + kUVCValueArenaSlotCount * _planeSize;
+  }
+
+//
+
+  - (UVCType*) typeAtIndex:(NSUInteger)index
+  {
+    if ( index >= _count ) return nil;
+    return _types[index];
+  }
+
+//
+
+  - (NSUInteger) offsetOfIndex:(NSUInteger)index
+  {
+    if ( index >= _count ) return UVCTypeInvalidIndex;
+    return _offsets[index];
+  }
+
+//
+
+  - (void*) bytesOfSlot:(UVCValueArenaSlot)slot
+  {
+    if ( slot >= kUVCValueArenaSlotCount ) return NULL;
+    return _planes + slot * _planeSize;
+  }
+
+//
+
+  - (void*) pointerToSlot:(UVCValueArenaSlot)slot
+    atIndex:(NSUInteger)index
+  {
+    if ( (slot >= kUVCValueArenaSlotCount) || (index >= _count) || ! _types[index] ) return NULL;
+    return _planes + slot * _planeSize + _offsets[index];
+  }
+
+//
+
+  - (BOOL) hasSlot:(UVCValueArenaSlot)slot
+    atIndex:(NSUInteger)index
+  {
+    if ( (slot >= kUVCValueArenaSlotCount) || (index >= _count) ) return NO;
+    return ( (_slotMasks[index] & (1 << slot)) != 0 );
+  }
+
+//
+
+  - (void) setSlot:(UVCValueArenaSlot)slot
+    atIndex:(NSUInteger)index
+    isPresent:(BOOL)isPresent
+  {
+    if ( (slot >= kUVCValueArenaSlotCount) || (index >= _count) || ! _types[index] ) return;
+    if ( isPresent ) {
+      _slotMasks[index] |= (1 << slot);
+    } else {
+      _slotMasks[index] &= ~(1 << slot);
+    }
+  }
+
+//
+
+  - (UVCValue*) valueForSlot:(UVCValueArenaSlot)slot
+    atIndex:(NSUInteger)index
+  {
+    void            *bytes = [self pointerToSlot:slot atIndex:index];
+
+    if ( ! bytes ) return nil;
+    return [UVCValue uvcValueWithType:_types[index] bytes:bytes owner:self];
+  }
+
+//
+
+  - (NSData*) snapshotOfSlot:(UVCValueArenaSlot)slot
+  {
+    if ( slot >= kUVCValueArenaSlotCount ) return nil;
+    return [NSData dataWithBytes:_planes + slot * _planeSize length:_planeSize];
+  }
+
+//
+
+  - (NSIndexSet*) indexesOfSlot:(UVCValueArenaSlot)slot
+    differingFromSnapshot:(NSData*)snapshot
+  {
+    NSMutableIndexSet   *indexes;
+    const void          *plane, *oldPlane;
+    UInt8               mask = (1 << slot);
+    NSUInteger          i;
+
+    if ( (slot >= kUVCValueArenaSlotCount) || ([snapshot length] != _planeSize) ) return nil;
+
+    plane = _planes + slot * _planeSize;
+    oldPlane = [snapshot bytes];
+    if ( memcmp(plane, oldPlane, _planeSize) == 0 ) return [NSIndexSet indexSet];
+
+    indexes = [NSMutableIndexSet indexSet];
+    for ( i = 0; i < _count; i++ ) {
+      if ( (_slotMasks[i] & mask) && memcmp(plane + _offsets[i], oldPlane + _offsets[i], [_types[i] byteSize]) ) [indexes addIndex:i];
+    }
+    return indexes;
+  }
+
+//
+
+  - (NSIndexSet*) indexesOutOfRange
+  {
+    NSMutableIndexSet   *indexes = [NSMutableIndexSet indexSet];
+    const void          *current = _planes + kUVCValueArenaSlotCurrent * _planeSize;
+    const void          *minimum = _planes + kUVCValueArenaSlotMinimum * _planeSize;
+    const void          *maximum = _planes + kUVCValueArenaSlotMaximum * _planeSize;
+    UInt8               mask = (1 << kUVCValueArenaSlotCurrent) | (1 << kUVCValueArenaSlotMinimum) | (1 << kUVCValueArenaSlotMaximum);
+    NSUInteger          i;
+
+    for ( i = 0; i < _count; i++ ) {
+      NSUInteger        offset = _offsets[i];
+
+      if ( ((_slotMasks[i] & mask) == mask) && ! [_types[i] isBuffer:current + offset withinMinimum:minimum + offset maximum:maximum + offset] ) [indexes addIndex:i];
+    }
+    return indexes;
+  }
+
+@end
@@ -0,0 +1,156 @@
+//
+//  UVCWriteQueue.h
+//
+//  Coalescing queue of pending control writes (last writer wins).
+//
+//  Copyright © 2016
+//  Dr. Jeffrey Frey, IT-NSS
+//  University of Delaware
+//
+// $Id$
+//
+
+#import "UVCValue.h"
+
+#include <pthread.h>
+
+/*!
+  @typedef UVCWriteQueueStatistics
+
+  Counters maintained by a UVCWriteQueue:
+
+    - submittedCount:  values enqueued
+    - coalescedCount:  pending values replaced (or cancelled) by a newer
+      value for the same control before they were written
+    - unchangedCount:  values discarded because they equalled the value
+      last known to be on the device
+    - writeCount:  values written to the device
+    - failedCount:  writes that failed
+*/
+typedef struct {
+  NSUInteger        submittedCount;
+  NSUInteger        coalescedCount;
+  NSUInteger        unchangedCount;
+  NSUInteger        writeCount;
+  NSUInteger        failedCount;
+} UVCWriteQueueStatistics;
+
+/*!
+  @class UVCWriteQueue
+  @abstract Per-device queue holding at most one pending write per control.
+
+  Values are enqueued by control index.  A control has at most one pending
+  value:  enqueueing a value for a control that already has one replaces it
+  (the last writer wins).  A value equal to the one last known to be on the
+  device -- last written through the queue, being written, or reported with
+  noteDeviceValue:atIndex: -- is not queued at all, and cancels a pending
+  value for the control.
+
+  Pending controls are written in the order they first became pending, so
+  a control that is updated continuously cannot starve the others:  once
+  written, it goes to the back of the line.
+
+  The queue does no I/O itself.  Whichever thread is told by enqueue that it
+  must flush (or successfully calls beginFlush) becomes the flusher:  it
+  takes values with dequeueValueAtIndex: and reports each outcome with
+  didWriteValueAtIndex:successfully: until dequeue returns nil.  While a
+  flush is in progress, other threads' values simply join the queue and
+  are written by the flusher.  All methods may be called from any thread.
+
+  Values are held (and compared) in host byte order.
+*/
+@interface UVCWriteQueue : NSObject
+{
+  pthread_mutex_t             _lock;
+  void                        *_slots;
+  NSUInteger                  _slotCount;
+  NSUInteger                  *_order;
+  NSUInteger                  _orderHead, _orderCount;
+  NSUInteger                  _pendingCount;
+  BOOL                        _isFlushing;
+  UVCWriteQueueStatistics     _statistics;
+}
+
+/*!
+  @method writeQueueWithControlCount:
+
+  Returns an autoreleased, empty queue for control indices less than
+  controlCount.
+*/
++ (UVCWriteQueue*) writeQueueWithControlCount:(NSUInteger)controlCount;
+
+/*!
+  @method enqueueValue:atIndex:
+
+  Queue a copy of value as the next value to write to the control at index.
+  Returns YES if the caller must now flush the queue (there are pending
+  values and no other thread is flushing it).
+*/
+- (BOOL) enqueueValue:(UVCValue*)value atIndex:(NSUInteger)index;
+
+/*!
+  @method beginFlush
+
+  Returns YES if the caller has become the flusher:  values are pending and
+  no other thread is flushing the queue.
+*/
+- (BOOL) beginFlush;
+
+/*!
+  @method dequeueValueAtIndex:
+
+  For the flusher:  returns the next pending value and sets *index to its
+  control index.  The value belongs to the queue and remains valid until
+  didWriteValueAtIndex:successfully: is called for it.  Returns nil (and
+  ends the flush) when nothing is pending.
+*/
+- (UVCValue*) dequeueValueAtIndex:(NSUInteger*)index;
+
+/*!
+  @method didWriteValueAtIndex:successfully:
+
+  For the flusher:  record the outcome of writing the value dequeued for the
+  control at index.  A successful write becomes the device's last-known
+  value.
+*/
+- (void) didWriteValueAtIndex:(NSUInteger)index successfully:(BOOL)successfully;
+
+/*!
+  @method noteDeviceValue:atIndex:
+
+  Record value (e.g. just read from the device) as the last-known device
+  value of the control at index.
+*/
+- (void) noteDeviceValue:(UVCValue*)value atIndex:(NSUInteger)index;
+
+/*!
+  @method cancelValueAtIndex:
+
+  Drop the pending value (if any) of the control at index, e.g. because a
+  newer value is being written to the device by other means.  A cancelled
+  value counts as coalesced.
+*/
+- (void) cancelValueAtIndex:(NSUInteger)index;
+
+/*!
+  @method pendingCount
+
+  Returns the number of controls with a value waiting to be written.
+*/
+- (NSUInteger) pendingCount;
+
+/*!
+  @method statistics
+
+  Returns a snapshot of the receiver's counters.
+*/
+- (UVCWriteQueueStatistics) statistics;
+
+/*!
+  @method resetStatistics
+
+  Zero the receiver's counters.
+*/
+- (void) resetStatistics;
+
+@end
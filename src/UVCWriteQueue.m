@@ -0,0 +1,338 @@
+//
+//  UVCWriteQueue.m
+//
+//  Coalescing queue of pending control writes (last writer wins).
+//
+//  Copyright © 2016
+//  Dr. Jeffrey Frey, IT-NSS
+//  University of Delaware
+//
+// $Id$
+//
+
+#import "UVCWriteQueue.h"
+
+/*!
+  @typedef UVCWriteQueueSlot
+
+  State of one control.  The pending and writing values are swapped when
+  the flusher dequeues, so a new value can be accepted while the previous
+  one is still being written; all three values are created on first use.
+*/
+typedef struct {
+  UVCValue      *pendingValue;
+  UVCValue      *writingValue;
+  UVCValue      *lastKnownValue;
+  BOOL          isPending;
+  BOOL          isQueued;
+  BOOL          isWriting;
+  BOOL          hasLastKnown;
+} UVCWriteQueueSlot;
+
+//
+
+/*!
+  @function UVCWriteQueueSlotPrepare
+
+  Create the slot's values (of valueType) if not already done.  Returns NO if
+  the slot holds values of a different size.
+*/
+static BOOL
+UVCWriteQueueSlotPrepare(
+  UVCWriteQueueSlot   *slot,
+  UVCType             *valueType
+)
+{
+  if ( ! slot->pendingValue ) {
+    slot->pendingValue = [[UVCValue uvcValueWithType:valueType] retain];
+    slot->writingValue = [[UVCValue uvcValueWithType:valueType] retain];
+    slot->lastKnownValue = [[UVCValue uvcValueWithType:valueType] retain];
+  }
+  return ( [slot->pendingValue byteSize] == [valueType byteSize] );
+}
+
+//
+
+/*!
+  @function UVCWriteQueueCopyToHost
+
+  Copy the bytes of value into buffer in host byte order.
+*/
+static void
+UVCWriteQueueCopyToHost(
+  void        *buffer,
+  UVCValue    *value
+)
+{
+  memcpy(buffer, [value valuePtr], [value byteSize]);
+  if ( [value isSwappedToUSBEndian] ) [[value valueType] byteSwapUSBToHostEndian:buffer];
+}
+
+//
+#if 0
+#pragma mark -
+#endif
+//
+
+@interface UVCWriteQueue(UVCWriteQueuePrivate)
+
+- (id) initWithControlCount:(NSUInteger)controlCount;
+
+@end
+
+@implementation UVCWriteQueue(UVCWriteQueuePrivate)
+
+  - (id) initWithControlCount:(NSUInteger)controlCount
+  {
+    if ( (self = [super init]) ) {
+      _slotCount = controlCount;
+      _slots = calloc(controlCount ? controlCount : 1, sizeof(UVCWriteQueueSlot));
+      _order = calloc(controlCount ? controlCount : 1, sizeof(NSUInteger));
+      if ( ! _slots || ! _order ) {
+        [self release];
+        return nil;
+      }
+      pthread_mutex_init(&_lock, NULL);
+    }
+    return self;
+  }
+
+@end
+
+//
+#if 0
+#pragma mark -
+#endif
+//
+
+@implementation UVCWriteQueue
+
+  + (UVCWriteQueue*) writeQueueWithControlCount:(NSUInteger)controlCount
+  {
+    return [[[UVCWriteQueue alloc] initWithControlCount:controlCount] autorelease];
+  }
+
+//
+
+  - (void) dealloc
+  {
+    if ( _slots ) {
+      UVCWriteQueueSlot *slot = (UVCWriteQueueSlot*)_slots;
+      NSUInteger        i;
+
+      for ( i = 0; i < _slotCount; i++, slot++ ) {
+        if ( slot->pendingValue ) [slot->pendingValue release];
+        if ( slot->writingValue ) [slot->writingValue release];
+        if ( slot->lastKnownValue ) [slot->lastKnownValue release];
+      }
+      free(_slots);
+      pthread_mutex_destroy(&_lock);
+    }
+    if ( _order ) free(_order);
+    [super dealloc];
+  }
+
+//
+
+  - (NSString*) description
+  {
+    UVCWriteQueueStatistics   stats = [self statistics];
+
+    return [NSString stringWithFormat:@"UVCWriteQueue@%p { pending: %lu; submitted: %lu; coalesced: %lu; unchanged: %lu; written: %lu; failed: %lu }",
+                        self,
+                        (unsigned long)[self pendingCount],
+                        (unsigned long)stats.submittedCount,
+                        (unsigned long)stats.coalescedCount,
+                        (unsigned long)stats.unchangedCount,
+                        (unsigned long)stats.writeCount,
+                        (unsigned long)stats.failedCount
+                      ];
+  }
+
+//
+
+  - (BOOL) enqueueValue:(UVCValue*)value
+    atIndex:(NSUInteger)index
+  {
+    UVCWriteQueueSlot   *slot = (UVCWriteQueueSlot*)_slots + index;
+    NSUInteger          byteSize = [value byteSize];
+    UInt8               hostValue[byteSize ? byteSize : 1];
+    UVCValue            *deviceValue;
+    BOOL                shouldFlush = NO;
+
+    if ( (index >= _slotCount) || ! value || ! byteSize || (byteSize != [[value valueType] byteSize]) ) return NO;
+    UVCWriteQueueCopyToHost(hostValue, value);
+
+    pthread_mutex_lock(&_lock);
+    if ( UVCWriteQueueSlotPrepare(slot, [value valueType]) ) {
+      _statistics.submittedCount++;
+
+      // What the device will hold once nothing more is written:
+      deviceValue = ( slot->isWriting ? slot->writingValue : (slot->hasLastKnown ? slot->lastKnownValue : nil) );
+      if ( deviceValue && (memcmp(hostValue, [deviceValue valuePtr], byteSize) == 0) ) {
+        if ( slot->isPending ) {
+          // Cancels the pending value; the queue entry is skipped when dequeued:
+          slot->isPending = NO;
+          _pendingCount--;
+          _statistics.coalescedCount++;
+        } else {
+          _statistics.unchangedCount++;
+        }
+      } else {
+        memcpy([slot->pendingValue valuePtr], hostValue, byteSize);
+        if ( slot->isPending ) {
+          _statistics.coalescedCount++;
+        } else {
+          slot->isPending = YES;
+          _pendingCount++;
+          if ( ! slot->isQueued ) {
+            _order[(_orderHead + _orderCount) % _slotCount] = index;
+            _orderCount++;
+            slot->isQueued = YES;
+          }
+        }
+      }
+      if ( _pendingCount && ! _isFlushing ) shouldFlush = _isFlushing = YES;
+    }
+    pthread_mutex_unlock(&_lock);
+    return shouldFlush;
+  }
+
+//
+
+  - (BOOL) beginFlush
+  {
+    BOOL                shouldFlush = NO;
+
+    pthread_mutex_lock(&_lock);
+    if ( _pendingCount && ! _isFlushing ) shouldFlush = _isFlushing = YES;
+    pthread_mutex_unlock(&_lock);
+    return shouldFlush;
+  }
+
+//
+
+  - (UVCValue*) dequeueValueAtIndex:(NSUInteger*)index
+  {
+    UVCValue            *value = nil;
+
+    pthread_mutex_lock(&_lock);
+    while ( _orderCount ) {
+      NSUInteger        slotIndex = _order[_orderHead];
+      UVCWriteQueueSlot *slot = (UVCWriteQueueSlot*)_slots + slotIndex;
+
+      _orderHead = (_orderHead + 1) % _slotCount;
+      _orderCount--;
+      slot->isQueued = NO;
+      if ( slot->isPending ) {
+        value = slot->pendingValue;
+        slot->pendingValue = slot->writingValue;
+        slot->writingValue = value;
+        slot->isPending = NO;
+        slot->isWriting = YES;
+        _pendingCount--;
+        *index = slotIndex;
+        break;
+      }
+    }
+    // Nothing left, so the next enqueue will find a flusher is needed:
+    if ( ! value ) _isFlushing = NO;
+    pthread_mutex_unlock(&_lock);
+    return value;
+  }
+
+//
+
+  - (void) didWriteValueAtIndex:(NSUInteger)index
+    successfully:(BOOL)successfully
+  {
+    UVCWriteQueueSlot   *slot = (UVCWriteQueueSlot*)_slots + index;
+
+    if ( index >= _slotCount ) return;
+    pthread_mutex_lock(&_lock);
+    slot->isWriting = NO;
+    if ( successfully ) {
+      memcpy([slot->lastKnownValue valuePtr], [slot->writingValue valuePtr], [slot->writingValue byteSize]);
+      slot->hasLastKnown = YES;
+      _statistics.writeCount++;
+    } else {
+      // Who knows what the device holds now:
+      slot->hasLastKnown = NO;
+      _statistics.failedCount++;
+    }
+    pthread_mutex_unlock(&_lock);
+  }
+
+//
+
+  - (void) noteDeviceValue:(UVCValue*)value
+    atIndex:(NSUInteger)index
+  {
+    UVCWriteQueueSlot   *slot = (UVCWriteQueueSlot*)_slots + index;
+    NSUInteger          byteSize = [value byteSize];
+    UInt8               hostValue[byteSize ? byteSize : 1];
+
+    // Without a genuine value there is nothing to know:
+    if ( (index >= _slotCount) || ! value || ! byteSize || (byteSize != [[value valueType] byteSize]) ) return;
+    UVCWriteQueueCopyToHost(hostValue, value);
+
+    pthread_mutex_lock(&_lock);
+    // A write in progress will supersede whatever was read:
+    if ( UVCWriteQueueSlotPrepare(slot, [value valueType]) && ! slot->isWriting ) {
+      memcpy([slot->lastKnownValue valuePtr], hostValue, byteSize);
+      slot->hasLastKnown = YES;
+    }
+    pthread_mutex_unlock(&_lock);
+  }
+
+//
+
+  - (void) cancelValueAtIndex:(NSUInteger)index
+  {
+    UVCWriteQueueSlot   *slot = (UVCWriteQueueSlot*)_slots + index;
+
+    if ( index >= _slotCount ) return;
+    pthread_mutex_lock(&_lock);
+    if ( slot->isPending ) {
+      // The queue entry is skipped when dequeued:
+      slot->isPending = NO;
+      _pendingCount--;
+      _statistics.coalescedCount++;
+    }
+    pthread_mutex_unlock(&_lock);
+  }
+
+//
+
+  - (NSUInteger) pendingCount
+  {
+    NSUInteger          pendingCount;
+
+    pthread_mutex_lock(&_lock);
+    pendingCount = _pendingCount;
+    pthread_mutex_unlock(&_lock);
+    return pendingCount;
+  }
+
+//
+
+  - (UVCWriteQueueStatistics) statistics
+  {
+    UVCWriteQueueStatistics stats;
+
+    pthread_mutex_lock(&_lock);
+    stats = _statistics;
+    pthread_mutex_unlock(&_lock);
+    return stats;
+  }
+
+//
+
+  - (void) resetStatistics
+  {
+    pthread_mutex_lock(&_lock);
+    memset(&_statistics, 0, sizeof(_statistics));
+    pthread_mutex_unlock(&_lock);
+  }
+
+@end
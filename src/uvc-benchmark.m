@@ -0,0 +1,164 @@
+//
+// uvc-benchmark.m
+//
+// Stand-alone driver for the portable UVCBenchmark suites ("type," "value,"
+// and "names").  It links only UVCType, UVCValue, UVCControlNames, and
+// UVCBenchmark, so it builds wherever Foundation is available -- including
+// GNUstep on Linux (see the GNUmakefile in this directory).  uvc-util's
+// --benchmark option runs the same suites, plus the ones that need
+// UVCController.
+//
+// Copyright © 2016
+// Dr. Jeffrey Frey, IT-NSS
+// University of Delaware
+//
+// $Id$
+//
+
+#import <Foundation/Foundation.h>
+#include <getopt.h>
+#include <errno.h>
+#include <stdlib.h>
+
+#import "UVCBenchmark.h"
+
+//
+
+static struct option uvcBenchmarkOptions[] = {
+                                         { "baseline",                        required_argument, NULL, 'b' },
+                                         { "sample-count",                    required_argument, NULL, 'n' },
+                                         { "sample-time",                     required_argument, NULL, 't' },
+                                         { "tolerance",                       required_argument, NULL, 'T' },
+                                         { "help",                            no_argument,       NULL, 'h' },
+                                         { NULL,                              0,                 NULL,  0  }
+                                       };
+
+//
+
+void
+usage(
+  const char  *exe
+)
+{
+  printf(
+      "usage:\n"
+      "\n"
+      "    %s {options} {<suite>{,<suite>..} ..}\n"
+      "\n"
+      "  Options:\n"
+      "\n"
+      "    -h/--help                              Show this information\n"
+      "    -b <file>/--baseline=<file>            Compare against the JSON results of an earlier run\n"
+      "    -n <count>/--sample-count=<count>      Number of timed samples of each operation (default %d)\n"
+      "    -t <seconds>/--sample-time=<seconds>   Minimum duration of a timed sample (default %g)\n"
+      "    -T <fraction>/--tolerance=<fraction>   Fraction by which a result may be worse than its\n"
+      "                                           baseline before it is a regression (default %g)\n"
+      "\n"
+      "  With no <suite> named, every available suite is run:  %s\n"
+      "\n"
+      "  The results are written to stdout as JSON.  The exit status is ENOENT if a suite\n"
+      "  or the baseline could not be found, and ERANGE if any result regressed against\n"
+      "  the baseline or exceeded its limit.\n"
+      "\n",
+      exe,
+      UVCBenchmarkDefaultSampleCount,
+      UVCBenchmarkDefaultMinimumSampleTime,
+      UVCBenchmarkDefaultTolerance,
+      [[[UVCBenchmark suiteNames] componentsJoinedByString:@","] UTF8String]
+    );
+}
+
+//
+
+int
+main(
+  int                 argc,
+  char*               argv[]
+)
+{
+  NSAutoreleasePool   *pool = [[NSAutoreleasePool alloc] init];
+  UVCBenchmark        *benchmark = [UVCBenchmark benchmarkWithStream:stdout];
+  NSMutableArray      *suiteNames = nil;
+  int                 rc = 0;
+  int                 optCh;
+
+  while ( (optCh = getopt_long(argc, argv, "b:n:t:T:h", uvcBenchmarkOptions, NULL)) != -1 ) {
+    switch ( optCh ) {
+
+      case 'h': {
+        usage(argv[0]);
+        goto cleanupAndExit;
+      }
+
+      case 'b': {
+        if ( ! [benchmark loadBaselineFromFile:[NSString stringWithUTF8String:optarg]] ) {
+          fprintf(stderr, "ERROR:  unable to read benchmark baseline from %s\n", optarg);
+          rc = ENOENT;
+          goto cleanupAndExit;
+        }
+        break;
+      }
+
+      case 'n': {
+        long          sampleCount = strtol(optarg, NULL, 10);
+
+        if ( sampleCount < 1 ) {
+          fprintf(stderr, "ERROR:  invalid sample count:  %s\n", optarg);
+          rc = EINVAL;
+          goto cleanupAndExit;
+        }
+        [benchmark setSampleCount:(NSUInteger)sampleCount];
+        break;
+      }
+
+      case 't': {
+        double        sampleTime = strtod(optarg, NULL);
+
+        if ( sampleTime <= 0.0 ) {
+          fprintf(stderr, "ERROR:  invalid sample time:  %s\n", optarg);
+          rc = EINVAL;
+          goto cleanupAndExit;
+        }
+        [benchmark setMinimumSampleTime:sampleTime];
+        break;
+      }
+
+      case 'T': {
+        double        tolerance = strtod(optarg, NULL);
+
+        if ( tolerance < 0.0 ) {
+          fprintf(stderr, "ERROR:  invalid tolerance:  %s\n", optarg);
+          rc = EINVAL;
+          goto cleanupAndExit;
+        }
+        [benchmark setTolerance:tolerance];
+        break;
+      }
+
+      default: {
+        usage(argv[0]);
+        rc = EINVAL;
+        goto cleanupAndExit;
+      }
+
+    }
+  }
+
+  //
+  // Remaining arguments name suites, each possibly a comma-separated list:
+  //
+  while ( optind < argc ) {
+    if ( ! suiteNames ) suiteNames = [NSMutableArray array];
+    [suiteNames addObjectsFromArray:[[NSString stringWithUTF8String:argv[optind++]] componentsSeparatedByString:@","]];
+  }
+  if ( (rc = [benchmark runSuitesWithNames:suiteNames]) ) {
+    fprintf(stderr, "ERROR:  unknown benchmark suite in %s (available: %s)\n", [[suiteNames componentsJoinedByString:@","] UTF8String], [[[UVCBenchmark suiteNames] componentsJoinedByString:@","] UTF8String]);
+  } else if ( [benchmark regressionCount] ) {
+    fprintf(stderr, "ERROR:  %lu benchmark result(s) regressed against the baseline or exceeded their limit\n", (unsigned long)[benchmark regressionCount]);
+    rc = ERANGE;
+  }
+
+cleanupAndExit:
+  [pool drain];
+  return rc;
+}
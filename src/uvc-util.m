@@ -14,9 +14,17 @@
 
 #import <Foundation/Foundation.h>
 #include <getopt.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 #import "UVCController.h"
 #import "UVCValue.h"
+#import "UVCCapabilityCache.h"
+#import "UVCCommandSession.h"
+#import "UVCDaemon.h"
+#import "UVCTrajectory.h"
+#import "UVCDeviceBenchmarks.h"
+#import "UVCTrace.h"
 
 //
 
@@ -77,6 +85,54 @@ UVCUtilVersionString(void)
   return (const char*)versionString;
 }
 
+//
+
+/*!
+  @enum uvc-util long-only options
+  
+  Values returned by getopt_long() for options that have no single-character
+  equivalent.
+*/
+enum {
+  kUVCUtilOptionNoCache       = 0x100,
+  kUVCUtilOptionFlushCache,
+  kUVCUtilOptionSaveProfile,
+  kUVCUtilOptionApplyProfile,
+  kUVCUtilOptionDumpDescriptors,
+  kUVCUtilOptionParseDescriptors,
+  kUVCUtilOptionWatch,
+  kUVCUtilOptionPollInterval,
+  kUVCUtilOptionDaemon,
+  kUVCUtilOptionConnect,
+  kUVCUtilOptionBatch,
+  kUVCUtilOptionSelectSimulated,
+  kUVCUtilOptionSelectAll,
+  kUVCUtilOptionSelectAllByVendorAndProductId,
+  kUVCUtilOptionSelectAllByLocationId,
+  kUVCUtilOptionSelectSimulatedGroup,
+  kUVCUtilOptionMove,
+  kUVCUtilOptionMoveDuration,
+  kUVCUtilOptionMoveVelocity,
+  kUVCUtilOptionMoveRate,
+  kUVCUtilOptionStats,
+  kUVCUtilOptionDump,
+  kUVCUtilOptionRecordTrace,
+  kUVCUtilOptionReplayTrace,
+  kUVCUtilOptionReplayTiming,
+  kUVCUtilOptionBenchmark,
+  kUVCUtilOptionBenchmarkBaseline,
+  kUVCUtilOptionRequestTimeout,
+  kUVCUtilOptionRequestRetries
+};
+
+/*!
+  @defined UVCUtilDefaultPollInterval
+
+  Default interval (in seconds) at which --watch reads controls that the device
+  does not report through its status interrupt endpoint.
+*/
+#define UVCUtilDefaultPollInterval  0.25
+
 //
                           
 static struct option uvcUtilOptions[] = {
@@ -92,16 +148,137 @@ static struct option uvcUtilOptions[] = {
                                          { "select-by-location-id",           required_argument, NULL, 'L' },
                                          { "select-by-name",                  required_argument, NULL, 'N' },
                                          { "select-by-index",                 required_argument, NULL, 'I' },
+                                         { "select-all",                      no_argument,       NULL, kUVCUtilOptionSelectAll },
+                                         { "select-all-by-vendor-and-product-id", required_argument, NULL, kUVCUtilOptionSelectAllByVendorAndProductId },
+                                         { "select-all-by-location-id",       required_argument, NULL, kUVCUtilOptionSelectAllByLocationId },
                                          { "keep-running",                    no_argument,       NULL, 'k' },
+                                         { "no-cache",                        no_argument,       NULL, kUVCUtilOptionNoCache },
+                                         { "flush-cache",                     no_argument,       NULL, kUVCUtilOptionFlushCache },
+                                         { "request-timeout",                 required_argument, NULL, kUVCUtilOptionRequestTimeout },
+                                         { "request-retries",                 required_argument, NULL, kUVCUtilOptionRequestRetries },
+                                         { "save-profile",                    required_argument, NULL, kUVCUtilOptionSaveProfile },
+                                         { "apply-profile",                   required_argument, NULL, kUVCUtilOptionApplyProfile },
+                                         { "dump-descriptors",                required_argument, NULL, kUVCUtilOptionDumpDescriptors },
+                                         { "parse-descriptors",               required_argument, NULL, kUVCUtilOptionParseDescriptors },
+                                         { "watch",                           required_argument, NULL, kUVCUtilOptionWatch },
+                                         { "poll-interval",                   required_argument, NULL, kUVCUtilOptionPollInterval },
+                                         { "daemon",                          required_argument, NULL, kUVCUtilOptionDaemon },
+                                         { "connect",                         required_argument, NULL, kUVCUtilOptionConnect },
+                                         { "batch",                           required_argument, NULL, kUVCUtilOptionBatch },
+                                         { "move",                            required_argument, NULL, kUVCUtilOptionMove },
+                                         { "move-duration",                   required_argument, NULL, kUVCUtilOptionMoveDuration },
+                                         { "move-velocity",                   required_argument, NULL, kUVCUtilOptionMoveVelocity },
+                                         { "move-rate",                       required_argument, NULL, kUVCUtilOptionMoveRate },
+                                         { "stats",                           no_argument,       NULL, kUVCUtilOptionStats },
+                                         { "dump",                            no_argument,       NULL, kUVCUtilOptionDump },
+                                         { "record-trace",                    required_argument, NULL, kUVCUtilOptionRecordTrace },
+                                         { "replay-trace",                    required_argument, NULL, kUVCUtilOptionReplayTrace },
+                                         { "replay-timing",                   required_argument, NULL, kUVCUtilOptionReplayTiming },
                                          { "help",                            no_argument,       NULL, 'h' },
                                          { "version",                         no_argument,       NULL, 'v' },
                                          // We don't publish the existence of the --debug/-D flag:
                                          { "debug",                           no_argument,       NULL, 'D' },
+                                         // ...nor the simulated camera used for testing and benchmarking:
+                                         { "select-simulated",                no_argument,       NULL, kUVCUtilOptionSelectSimulated },
+                                         { "select-simulated-group",          required_argument, NULL, kUVCUtilOptionSelectSimulatedGroup },
+                                         { "benchmark",                       optional_argument, NULL, kUVCUtilOptionBenchmark },
+                                         { "benchmark-baseline",              required_argument, NULL, kUVCUtilOptionBenchmarkBaseline },
                                          { NULL,                              0,                 NULL,  0  }
                                        };
 
 //
 
+void
+printDescriptorGraph(
+  const UVCDescriptorGraph  *graph
+)
+{
+  unsigned int              i, j;
+  
+  printf("VideoControl descriptors:  UVC %d.%02x, %hu bytes, clock %u Hz, %hhu streaming interface(s)\n",
+      (short)(graph->uvcVersion >> 8), (graph->uvcVersion & 0xFF),
+      graph->totalLength,
+      graph->clockFrequency,
+      graph->interfaceCount
+    );
+  printf("----- -------------------- -------- ---------------- ------------------------\n");
+  printf("%-5s %-20s %-8s %-16s %s\n", "Id", "Type", "Terminal", "Sources", "Controls");
+  printf("----- -------------------- -------- ---------------- ------------------------\n");
+  for ( i = 0; i < graph->unitCount; i++ ) {
+    const UVCDescriptorUnit *unit = &graph->units[i];
+    const uint8_t           *controls = UVCDescriptorUnitControls(graph, unit);
+    char                    sources[64] = "-";
+    size_t                  sourcesLen = 0;
+    
+    for ( j = 0; j < unit->sourceCount; j++ ) {
+      if ( sourcesLen + 5 >= sizeof(sources) ) break;
+      sourcesLen += snprintf(sources + sourcesLen, sizeof(sources) - sourcesLen, "%s%hhu", (j ? "," : ""), UVCDescriptorUnitSourceId(graph, unit, j));
+    }
+    if ( unit->terminalType ) {
+      printf("%-5hhu %-20s 0x%04hx   %-16s ", unit->unitId, UVCDescriptorSubtypeName(unit->subtype), unit->terminalType, sources);
+    } else {
+      printf("%-5hhu %-20s %-8s %-16s ", unit->unitId, UVCDescriptorSubtypeName(unit->subtype), "-", sources);
+    }
+    if ( controls ) {
+      for ( j = 0; j < unit->controlSize; j++ ) printf("%s%02hhx", (j ? ":" : ""), controls[j]);
+      printf("\n");
+    } else {
+      printf("-\n");
+    }
+  }
+  printf("----- -------------------- -------- ---------------- ------------------------\n");
+}
+
+//
+
+BOOL
+printControlChange(
+  void                        *context,
+  const UVCControlChangeEvent *event
+)
+{
+  const char                  *controlName = [[event->control controlName] cStringUsingEncoding:NSASCIIStringEncoding];
+  UVCValue                    *value = nil;
+  const char                  *suffix = "";
+  
+  switch ( event->attribute ) {
+  
+    case kUVCControlChangeValue:
+      value = [event->control valueBuffer];
+      break;
+      
+    case kUVCControlChangeMinimum:
+      value = [event->control minimum];
+      suffix = ".minimum";
+      break;
+      
+    case kUVCControlChangeMaximum:
+      value = [event->control maximum];
+      suffix = ".maximum";
+      break;
+      
+    case kUVCControlChangeInfo:
+      printf("%s: capabilities changed (%s)\n", controlName, ([event->control isDisabledDueToAutomaticMode] ? "disabled due to automatic mode" : "enabled"));
+      break;
+      
+    case kUVCControlChangeFailure:
+      printf("%s: asynchronous request failed (error code %hhu)\n", controlName, event->failureCode);
+      break;
+      
+  }
+  if ( value ) {
+    char                      valueStr[[[value valueType] maximumFormattedLength] + 1];
+    
+    [value formatAs:kUVCTypeFormatDefault intoCString:valueStr length:sizeof(valueStr)];
+    printf("%s%s = %s\n", controlName, suffix, valueStr);
+  }
+  // Consumers read us through a pipe, so don't sit on changes:
+  fflush(stdout);
+  return YES;
+}
+
+//
+
 void
 usage(
   const char  *exe
@@ -118,16 +295,51 @@ usage(
       "    -v/--version                           Show the version of the program\n"
       "    -k/--keep-running                      Continue processing additional actions despite\n"
       "                                           encountering errors\n"
+      "    --no-cache                             Do not use the on-disk cache of control capabilities\n"
+      "                                           and limits (must precede device selection)\n"
+      "    --request-timeout=<seconds>            Give up on a control request the device has not completed\n"
+      "                                           in <seconds> (default 1; 0 waits indefinitely; must precede\n"
+      "                                           device selection)\n"
+      "    --request-retries=<n>                  Retry a control request the device was not ready for up to\n"
+      "                                           <n> times (default 2; must precede device selection)\n"
+      "    --connect=<socket-path>                Send all subsequent actions and device selections to the\n"
+      "                                           daemon listening at <socket-path> (see --daemon)\n"
+      "    --replay-timing=(none|latency|original)\n"
+      "                                           How --replay-trace paces its answers:  as fast as\n"
+      "                                           possible, with each request's recorded latency (the\n"
+      "                                           default), or also at the recorded time of each request\n"
+      "                                           (must precede --replay-trace)\n"
       "\n"
       "  Actions:\n"
       "\n"
       "    -d/--list-devices                      Display a list of all UVC-capable devices\n"
       "    -c/--list-controls                     Display a list of UVC controls implemented\n"
+      "    --flush-cache                          Remove all cached control capabilities and limits\n"
+      "    --parse-descriptors=<file>             Parse and display a VideoControl descriptor block\n"
+      "                                           saved by --dump-descriptors (no device needed)\n"
+      "    --daemon=<socket-path>                 Enumerate all devices once, keep their interfaces open,\n"
+      "                                           and serve device selections and actions sent by\n"
+      "                                           --connect clients until interrupted; a device selected\n"
+      "                                           beforehand is each client's initial target device\n"
+      "    --batch=(<file>|-)                     Execute newline-delimited commands read from <file> (or\n"
+      "                                           stdin for \"-\"), writing each result as it completes;\n"
+      "                                           see below for the command syntax\n"
+      "    --stats                                Display, as JSON, a latency histogram (in microseconds)\n"
+      "                                           for each control and request type, failure counts by\n"
+      "                                           IOReturn code, and interface open/close counts for the\n"
+      "                                           target device or devices (or every device used so far\n"
+      "                                           when none is selected)\n"
+      "    --dump                                 Write one line of JSON per control (capabilities, type\n"
+      "                                           layout, minimum, maximum, resolution, default, and current\n"
+      "                                           value) for the target device or devices, or every device\n"
+      "                                           when none is selected; each line is written as soon as\n"
+      "                                           its value has been read\n"
       "\n"
       "    Available after a target device is selected:\n"
       "\n"
       "    -c/--list-controls                     Display a list of UVC controls available for\n"
-      "                                           the target device\n"
+      "                                           the target device (as declared by its descriptors;\n"
+      "                                           the controls are not probed)\n"
       "\n"
       "    -S (<control-name>|*)                  Display available information for the given\n"
       "    --show-control=(<control-name>|*)      UVC control (or all controls for \"*\").  Component\n"
@@ -155,6 +367,46 @@ usage(
       "    --set=<control-name>=<value>           description of <value>\n"
       "\n"
       "    -r/--reset-all                         Reset all controls with a default value to that value\n"
+      "                                           (only controls not already at their default are written)\n"
+      "\n"
+      "    --save-profile=<file>                  Write the current value of every readable and writable\n"
+      "                                           control to a profile file\n"
+      "    --apply-profile=<file>                 Set controls to the values in a profile file; only\n"
+      "                                           controls whose value differs are written, automatic\n"
+      "                                           modes are set first, and controls disabled due to an\n"
+      "                                           automatic mode are skipped\n"
+      "\n"
+      "    --flush-cache                          Remove the cached control capabilities and limits\n"
+      "                                           for the target device\n"
+      "\n"
+      "    --dump-descriptors=<file>              Write the target device's VideoControl descriptor\n"
+      "                                           block to a file\n"
+      "\n"
+      "    --record-trace=<file>                  Record every subsequent control transfer to the target\n"
+      "                                           device (setup fields, payload, result, and timing) to\n"
+      "                                           a binary trace file (see --replay-trace)\n"
+      "\n"
+      "    --watch=(<control-name>[,...]|*)       Display the value of the given controls (or all controls\n"
+      "                                           for \"*\") and then every change to them, until\n"
+      "                                           interrupted.  Changes the device reports through its\n"
+      "                                           status interrupt endpoint are displayed as they occur;\n"
+      "                                           other controls are read periodically (see --poll-interval)\n"
+      "    --poll-interval=<seconds>              Interval at which --watch reads controls the device does\n"
+      "                                           not report (default 0.25; 0 disables polling); must\n"
+      "                                           precede --watch\n"
+      "\n"
+      "    --move=<control-name>=<value>          Move a control from its current value to <value> by\n"
+      "                                           writing evenly-spaced intermediate values (aligned to the\n"
+      "                                           control's step size) at a fixed rate, e.g. a smooth\n"
+      "                                           pan-tilt-abs, zoom-abs, or focus-abs move.  Points whose\n"
+      "                                           time has passed while the device was busy are dropped.\n"
+      "                                           The achieved rate and deadline misses are displayed\n"
+      "    --move-duration=<seconds>              Duration of --move (default 1)\n"
+      "    --move-velocity=<units-per-second>     Speed of --move instead of a duration, in the units of\n"
+      "                                           the component with the furthest to travel\n"
+      "    --move-rate=<points-per-second>        Rate at which --move writes values (default 30)\n"
+      "                                           (--move-duration, --move-velocity, and --move-rate must\n"
+      "                                           precede --move)\n"
       "\n"
       "    Specifying <value> for -s/--set:\n"
       "\n"
@@ -191,6 +443,21 @@ usage(
       "            -s pan-tilt-abs=\"{default,minimum}\"\n"
       "            -s pan-tilt-abs=\"{tilt=-648000,pan=default}\"\n"
       "\n"
+      "  Commands for --batch (one per line; blank lines and lines starting with \"#\" are ignored):\n"
+      "\n"
+      "    select (index <device-index>|location <location-id>|vendor-product <vendor-id>:<product-id>|\n"
+      "            name <device-name>|none|all|all-vendor-product <vendor-id>:<product-id>|\n"
+      "            all-location <location-id>[,<location-id>...])\n"
+      "    get <control-name>\n"
+      "    get-value <control-name>\n"
+      "    set <control-name>=<value>\n"
+      "    show (<control-name>|*)\n"
+      "    reset\n"
+      "\n"
+      "    Any long option name above that selects a device or performs an action is also accepted\n"
+      "    (e.g. \"select-by-location-id 0x14200000\", \"apply-profile <file>\").  Consecutive get\n"
+      "    commands are combined into a single pipelined read of their controls.\n"
+      "\n"
       "  Methods for selecting the target device:\n"
       "\n"
       "    -0\n"
@@ -219,6 +486,31 @@ usage(
       "    --select-by-name=<device-name>\n"
       "\n"
       "         Provide the USB product name (e.g. \"AV.io HDMI Video\")\n"
+      "\n"
+      "    --replay-trace=<file>\n"
+      "\n"
+      "         A device that answers control transfers from a trace saved by --record-trace\n"
+      "         (no camera needed); see --replay-timing\n"
+      "\n"
+      "  Methods for selecting a group of target devices:\n"
+      "\n"
+      "    --select-all\n"
+      "\n"
+      "         Every UVC-capable device\n"
+      "\n"
+      "    --select-all-by-vendor-and-product-id=<vendor-id>:<product-id>\n"
+      "\n"
+      "         Every device with the given vendor and product identifier\n"
+      "\n"
+      "    --select-all-by-location-id=<location-id>[,<location-id>...]\n"
+      "\n"
+      "         The devices with the given USB locationID attributes\n"
+      "\n"
+      "    With a group selected, -s/--set, -r/--reset-all, and --apply-profile are performed on\n"
+      "    every device at once (one thread per device).  Each device's failure (and profile\n"
+      "    statistics) is displayed, followed by a summary with the time between the first and\n"
+      "    last device's write completing (the write skew).  Selecting a single device drops the\n"
+      "    group.\n"
       "\n",
       exe
     );
@@ -226,71 +518,24 @@ usage(
 
 //
 
-UVCController*
-UVCUtilGetControllerWithName(
-  NSArray     *uvcDevices,
-  NSString    *name
-)
-{
-  NSEnumerator  *eDevices = [uvcDevices objectEnumerator];
-  UVCController *controller;
-  
-  while ( (controller = [eDevices nextObject]) ) {
-    if ( [name compare:[controller deviceName] options:NSCaseInsensitiveSearch] == NSOrderedSame ) return controller;
-  }
-  return nil;
-}
-
-//
-
-UVCController*
-UVCUtilGetControllerWithVendorAndProductId(
-  NSArray         *uvcDevices,
-  unsigned short  vendorId,
-  unsigned short  productId
-)
-{
-  NSEnumerator  *eDevices = [uvcDevices objectEnumerator];
-  UVCController *controller;
-  
-  while ( (controller = [eDevices nextObject]) ) {
-    if ( ([controller vendorId] == vendorId) && ([controller productId] == productId) ) return controller;
-  }
-  return nil;
-}
-
-//
-
-UVCController*
-UVCUtilGetControllerWithLocationId(
-  NSArray         *uvcDevices,
-  unsigned        locationId
-)
-{
-  NSEnumerator  *eDevices = [uvcDevices objectEnumerator];
-  UVCController *controller;
-  
-  while ( (controller = [eDevices nextObject]) ) {
-    if ( [controller locationId] == locationId ) return controller;
-  }
-  return nil;
-}
-
-//
-
 int
 main(
-  int               argc,
-  char*             argv[]
+  int                 argc,
+  char*               argv[]
 )
 {
-  const char        *exe = argv[0];
-  int               rc = 0;
-  NSArray           *uvcDevices = nil;
-  UVCController     *targetDevice = nil;
-  int               optCh;
-  BOOL              exitOnErrors = YES;
-  UVCTypeScanFlags  uvcScanFlags = kUVCTypeScanFlagShowWarnings;
+  const char          *exe = argv[0];
+  int                 rc = 0;
+  UVCCommandSession   *session = nil;
+  UVCDaemonClient     *daemonClient = nil;
+  int                 optCh;
+  BOOL                exitOnErrors = YES;
+  NSTimeInterval      pollInterval = UVCUtilDefaultPollInterval;
+  NSTimeInterval      moveDuration = 1.0;
+  double              moveVelocity = 0.0;
+  double              moveRate = UVCTrajectoryDefaultUpdateRate;
+  const char          *benchmarkBaseline = NULL;
+  UVCTraceReplayTiming  replayTiming = kUVCTraceReplayTimingLatency;
   
   //
   // No CLI arguments, we've got nothing to do:
@@ -301,7 +546,18 @@ main(
   }
 
 @autoreleasepool {
+  session = [UVCCommandSession commandSession];
   while ( (optCh = getopt_long(argc, argv, "dcS:s:g:o:r0V:L:N:I:khfFvD", uvcUtilOptions, NULL)) != -1 ) {
+    //
+    // Each option gets its own pool, so a long command line (or an embedding
+    // process) doesn't accumulate every temporary object.  Anything that must
+    // outlive the option is retained by the session or below; a goto out of the
+    // loop leaves the pool to be drained with the enclosing one:
+    //
+    NSAutoreleasePool *optionPool = [[NSAutoreleasePool alloc] init];
+    UVCController     *targetDevice = [session targetDevice];
+    UVCCommand        command = kUVCCommandNone;
+    
     switch ( optCh ) {
     
       case 'h': {
@@ -321,391 +577,483 @@ main(
       }
       
       case 'D': {
-        uvcScanFlags |= kUVCTypeScanFlagShowInfo;
+        [session setScanFlags:[session scanFlags] | kUVCTypeScanFlagShowInfo];
         break;
       }
       
-      case 'd': {
-        if ( ! uvcDevices ) uvcDevices = [[UVCController uvcControllers] retain];
-        if ( uvcDevices && [uvcDevices count] ) {
-          NSEnumerator    *eDevices = [uvcDevices objectEnumerator];
-          UVCController   *device;
-          unsigned long   deviceIndex = 0;
-          
-          printf("------------ -------------- ------------ ------------ ------------------------------------------------\n");
-          printf("%-12s %-14s %-12s %-12s %s\n", "Index", "Vend:Prod", "LocationID", "UVC Version", "Device name");
-          printf("------------ -------------- ------------ ------------ ------------------------------------------------\n");
-          while ( (device = [eDevices nextObject]) ) {
-            UInt16      uvcVersion = [device uvcVersion];
-            char        versionStr[8];
-            
-            snprintf(versionStr, sizeof(versionStr), "%d.%02x", (short)(uvcVersion >> 8), (uvcVersion &0xFF));
-            printf("%-12lu 0x%04x:0x%04x  0x%08x   %-5s        %s\n", deviceIndex++, [device vendorId], [device productId], [device locationId], versionStr, [[device deviceName] cStringUsingEncoding:NSASCIIStringEncoding]);
-          }
-          printf("------------ -------------- ------------ ------------ ------------------------------------------------\n");
+      case kUVCUtilOptionNoCache: {
+        [UVCCapabilityCache setIsCachingEnabled:NO];
+        break;
+      }
+      
+      case kUVCUtilOptionRequestTimeout: {
+        char              *endPtr = NULL;
+        double            timeout = strtod(optarg, &endPtr);
+        
+        if ( (endPtr > optarg) && ! *endPtr && (timeout >= 0) ) {
+          [UVCController setDefaultRequestTimeout:timeout];
         } else {
-          fprintf(stderr, "ERROR:  no UVC-capable devices available\n");
-          rc = ENODEV;
+          fprintf(stderr, "ERROR:  invalid request timeout: %s\n", optarg);
+          rc = EINVAL;
           if ( exitOnErrors ) goto cleanupAndExit;
         }
         break;
       }
       
-      case 'c': {
-        if ( targetDevice ) {
-          NSArray     *controlNames = [UVCController controlStrings];
-          
-          if ( controlNames && [controlNames count] ) {
-            NSEnumerator  *eNames = [controlNames objectEnumerator];
-            NSString      *name;
-            
-            printf("UVC controls implemented by this device:\n");
-            while ( (name = [eNames nextObject]) ) {
-              UVCControl  *control = [targetDevice controlWithName:name];
-              
-              if ( control ) printf("  %s\n", [name cStringUsingEncoding:NSASCIIStringEncoding]);
-            }
-          } else {
-            fprintf(stderr, "WARNING:  no controls implemented by this device\n");
-          }
+      case kUVCUtilOptionRequestRetries: {
+        char              *endPtr = NULL;
+        long              retries = strtol(optarg, &endPtr, 10);
+        
+        if ( (endPtr > optarg) && ! *endPtr && (retries >= 0) ) {
+          [UVCController setDefaultMaximumRequestRetries:(NSUInteger)retries];
         } else {
-          NSArray     *controlNames = [UVCController controlStrings];
-          
-          if ( controlNames ) {
-            NSEnumerator  *eNames = [controlNames objectEnumerator];
-            NSString      *name;
-            
-            printf("UVC controls implemented by this program:\n");
-            while ( (name = [eNames nextObject]) ) printf("  %s\n", [name cStringUsingEncoding:NSASCIIStringEncoding]);
-          }
+          fprintf(stderr, "ERROR:  invalid request retry count: %s\n", optarg);
+          rc = EINVAL;
+          if ( exitOnErrors ) goto cleanupAndExit;
         }
         break;
       }
       
-      case '0': {
-        targetDevice = nil;
+      case kUVCUtilOptionFlushCache: {
+        if ( daemonClient ) {
+          fprintf(stderr, "ERROR:  --flush-cache is not available with --connect\n");
+          rc = ENOTSUP;
+          if ( exitOnErrors ) goto cleanupAndExit;
+        } else if ( targetDevice ) {
+          [targetDevice invalidateCapabilityCache];
+        } else if ( ! [UVCCapabilityCache invalidateAllCaches] ) {
+          fprintf(stderr, "ERROR:  unable to remove cache files from %s\n", [[UVCCapabilityCache cacheDirectory] fileSystemRepresentation]);
+          rc = EACCES;
+          if ( exitOnErrors ) goto cleanupAndExit;
+        }
         break;
       }
       
-      case 'I': {
-        if ( optarg && *optarg ) {
-          char              *endPtr = NULL;
-          unsigned long     deviceIndex = strtoul(optarg, &endPtr, 10);
+      case kUVCUtilOptionDumpDescriptors: {
+        if ( daemonClient ) {
+          fprintf(stderr, "ERROR:  --dump-descriptors is not available with --connect\n");
+          rc = ENOTSUP;
+          if ( exitOnErrors ) goto cleanupAndExit;
+        } else if ( targetDevice ) {
+          NSData          *descriptors = [targetDevice videoControlDescriptors];
           
-          if ( endPtr > optarg ) {
-            if ( ! uvcDevices ) uvcDevices = [[UVCController uvcControllers] retain];
-            if ( uvcDevices ) {
-              if ( deviceIndex < [uvcDevices count] ) {
-                targetDevice = [uvcDevices objectAtIndex:deviceIndex];
-                if ( ! targetDevice ) {
-                  fprintf(stderr, "ERROR:  no UVC-capable device with the name \"%s\"\n", optarg);
-                  rc = ENODEV;
-                  if ( exitOnErrors ) goto cleanupAndExit;
-                }
-              } else {
-                fprintf(stderr, "ERROR:  invalid device index: %lu\n", deviceIndex);
-                rc = EINVAL;
-                if ( exitOnErrors ) goto cleanupAndExit;
-              }
-            } else {
-              fprintf(stderr, "ERROR:  no UVC-capable devices available\n");
-              rc = ENODEV;
-              if ( exitOnErrors ) goto cleanupAndExit;
-            }
-          } else {
-            fprintf(stderr, "ERROR:  invalid device index: %s\n", optarg);
-            rc = EINVAL;
+          if ( ! descriptors ) {
+            fprintf(stderr, "ERROR:  target device provided no VideoControl descriptors\n");
+            rc = ENOENT;
+            if ( exitOnErrors ) goto cleanupAndExit;
+          }
+          else if ( ! [descriptors writeToFile:[NSString stringWithUTF8String:optarg] atomically:YES] ) {
+            fprintf(stderr, "ERROR:  unable to write descriptors to %s\n", optarg);
+            rc = EACCES;
             if ( exitOnErrors ) goto cleanupAndExit;
           }
         } else {
-          fprintf(stderr, "ERROR:  missing argument to -I/--select-by-index\n");
-          rc = EINVAL;
+          fprintf(stderr, "ERROR:  no target device selected\n");
+          rc = ENODEV;
           if ( exitOnErrors ) goto cleanupAndExit;
         }
         break;
       }
       
-      case 'N': {
-        if ( optarg && *optarg ) {
-          if ( ! uvcDevices ) uvcDevices = [[UVCController uvcControllers] retain];
-          if ( uvcDevices ) {
-            targetDevice = UVCUtilGetControllerWithName(uvcDevices, [NSString stringWithCString:optarg encoding:NSASCIIStringEncoding]);
-            if ( ! targetDevice ) {
-              fprintf(stderr, "ERROR:  no UVC-capable device with the name \"%s\"\n", optarg);
-              rc = ENODEV;
-              if ( exitOnErrors ) goto cleanupAndExit;
-            }
-          } else {
-            fprintf(stderr, "ERROR:  no UVC-capable devices available\n");
-            rc = ENODEV;
+      case kUVCUtilOptionParseDescriptors: {
+        NSData                      *descriptors = [NSData dataWithContentsOfFile:[NSString stringWithUTF8String:optarg]];
+        
+        if ( descriptors ) {
+          UVCDescriptorGraph        *graph = malloc(sizeof(UVCDescriptorGraph));
+          UVCDescriptorParseStatus  status;
+          
+          if ( ! graph ) {
+            rc = ENOMEM;
+            goto cleanupAndExit;
+          }
+          status = UVCDescriptorGraphParse(graph, [descriptors bytes], [descriptors length]);
+          printDescriptorGraph(graph);
+          free(graph);
+          if ( status != kUVCDescriptorParseOk ) {
+            fprintf(stderr, "ERROR:  %s: %s\n", optarg, UVCDescriptorParseStatusString(status));
+            rc = EINVAL;
             if ( exitOnErrors ) goto cleanupAndExit;
           }
         } else {
-          fprintf(stderr, "ERROR:  missing argument to -N/--select-by-name\n");
-          rc = EINVAL;
+          fprintf(stderr, "ERROR:  unable to read descriptors from %s\n", optarg);
+          rc = ENOENT;
           if ( exitOnErrors ) goto cleanupAndExit;
         }
         break;
       }
       
-      case 'V': {
-        if ( optarg && *optarg ) {
-          unsigned short  vendorId, productId;
-          int             nChar;
-          
-          if ( sscanf(optarg, "%hi:%n", &vendorId, &nChar) == 1 ) {
-            if ( sscanf(optarg + nChar, "%hi", &productId) == 1 ) {
-              if ( ! uvcDevices ) uvcDevices = [[UVCController uvcControllers] retain];
-              if ( uvcDevices && [uvcDevices count] ) {
-                targetDevice = UVCUtilGetControllerWithVendorAndProductId(uvcDevices, vendorId, productId);
-                if ( ! targetDevice ) {
-                  fprintf(stderr, "ERROR:  no UVC-capable device with vendor:product = 0x%04hx:0x%04hx\n", vendorId, productId);
-                  rc = ENODEV;
-                  if ( exitOnErrors ) goto cleanupAndExit;
-                }
-              } else {
-                fprintf(stderr, "ERROR:  no UVC-capable devices available\n");
-                rc = ENODEV;
-                if ( exitOnErrors ) goto cleanupAndExit;
-              }
-            } else {
-              fprintf(stderr, "ERROR:  invalid product id: %s\n", optarg + nChar);
-              rc = EINVAL;
-              if ( exitOnErrors) goto cleanupAndExit;
-            }
-          } else {
-            fprintf(stderr, "ERROR:  invalid vendor id: %s\n", optarg);
-            rc = EINVAL;
-            if ( exitOnErrors) goto cleanupAndExit;
-          }
+      case kUVCUtilOptionPollInterval: {
+        char              *endPtr = NULL;
+        double            interval = strtod(optarg, &endPtr);
+        
+        if ( (endPtr > optarg) && ! *endPtr && (interval >= 0) ) {
+          pollInterval = interval;
         } else {
-          fprintf(stderr, "ERROR:  missing argument to -V/--select-by-vendor-and-product-id\n");
+          fprintf(stderr, "ERROR:  invalid poll interval: %s\n", optarg);
           rc = EINVAL;
           if ( exitOnErrors ) goto cleanupAndExit;
         }
         break;
       }
       
-      case 'L': {
-        if ( optarg && *optarg ) {
-          unsigned    locationId;
+      case kUVCUtilOptionWatch: {
+        if ( daemonClient ) {
+          fprintf(stderr, "ERROR:  --watch is not available with --connect\n");
+          rc = ENOTSUP;
+          if ( exitOnErrors ) goto cleanupAndExit;
+        } else if ( targetDevice ) {
+          NSMutableArray    *controls = [NSMutableArray array];
+          NSArray           *controlNames;
+          NSEnumerator      *eNames;
+          NSString          *name;
+          BOOL              isAll = ( (*optarg == '*') && (*(optarg + 1) == '\0') );
           
-          if ( sscanf(optarg, "%i", &locationId) == 1 ) {
-            if ( ! uvcDevices ) uvcDevices = [[UVCController uvcControllers] retain];
-            if ( uvcDevices && [uvcDevices count] ) {
-              targetDevice = UVCUtilGetControllerWithLocationId(uvcDevices, locationId);
-              if ( ! targetDevice ) {
-                fprintf(stderr, "ERROR:  no UVC-capable device with location = 0x%08x\n", locationId);
-                rc = ENODEV;
-                if ( exitOnErrors ) goto cleanupAndExit;
-              }
-            } else {
-              fprintf(stderr, "ERROR:  no UVC-capable devices available\n");
-              rc = ENODEV;
+          controlNames = isAll ? [UVCController controlStrings] : [[NSString stringWithUTF8String:optarg] componentsSeparatedByString:@","];
+          eNames = [controlNames objectEnumerator];
+          while ( (name = [eNames nextObject]) ) {
+            UVCControl      *control = [targetDevice controlWithName:[[name stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]] lowercaseString]];
+            
+            if ( control ) {
+              if ( [control supportsGetValue] ) [controls addObject:control];
+            } else if ( ! isAll ) {
+              fprintf(stderr, "ERROR:  invalid control name: %s\n", [name UTF8String]);
+              rc = ENOENT;
+              if ( exitOnErrors ) goto cleanupAndExit;
+            }
+          }
+          if ( [controls count] && [targetDevice readControls:controls] ) {
+            UVCControlChangeEvent event = { .attribute = kUVCControlChangeValue };
+            NSUInteger            i, iMax = [controls count];
+            
+            for ( i = 0; i < iMax; i++ ) {
+              event.control = [controls objectAtIndex:i];
+              printControlChange(NULL, &event);
+            }
+            if ( ! [targetDevice watchControls:controls pollInterval:pollInterval duration:0 callback:printControlChange context:NULL] ) {
+              fprintf(stderr, "ERROR:  unable to watch controls%s\n", ( [targetDevice hasStatusInterruptEndpoint] || (pollInterval > 0) ) ? "" : " (device has no status interrupt endpoint and polling is disabled)");
+              rc = EACCES;
               if ( exitOnErrors ) goto cleanupAndExit;
             }
           } else {
-            fprintf(stderr, "ERROR:  invalid location id: %s\n", optarg);
-            rc = EINVAL;
-            if ( exitOnErrors) goto cleanupAndExit;
+            fprintf(stderr, "ERROR:  no readable controls to watch\n");
+            rc = ENOENT;
+            if ( exitOnErrors ) goto cleanupAndExit;
           }
         } else {
-          fprintf(stderr, "ERROR:  missing argument to -L/--select-by-location-id\n");
-          rc = EINVAL;
+          fprintf(stderr, "ERROR:  no target device selected\n");
+          rc = ENODEV;
           if ( exitOnErrors ) goto cleanupAndExit;
         }
         break;
       }
       
-      case 'S': {
-        if ( targetDevice ) {
-          if ( optarg && *optarg ) {
-            if ( (*optarg == '*') && (*(optarg + 1) == '\0') ) {
-              NSArray     *controlNames = [UVCController controlStrings];
-          
-              if ( controlNames && [controlNames count] ) {
-                NSEnumerator  *eNames = [controlNames objectEnumerator];
-                NSString      *name;
-                
-                while ( (name = [eNames nextObject]) ) {
-                  UVCControl  *control = [targetDevice controlWithName:name];
-                  
-                  if ( control ) printf("%s\n", [[control summaryString] cStringUsingEncoding:NSASCIIStringEncoding]);
-                }
-              } else {
-                fprintf(stderr, "WARNING:  no controls implemented by this device\n");
-              }
-            } else {
-              long              controlNameLen = strlen(optarg);
-              
-              if ( controlNameLen ) {
-                char            controlName[controlNameLen + 1];
-                long            i = 0;
-                  
-                while ( i < controlNameLen ) {
-                  controlName[i] = tolower(optarg[i]);
-                  i++;
-                }
-                controlName[i] = '\0';
-                  
-                UVCControl      *control = [targetDevice controlWithName:[NSString stringWithCString:controlName encoding:NSASCIIStringEncoding]];
-                    
-                if ( control ) {
-                  printf("%s\n", [[control summaryString] cStringUsingEncoding:NSASCIIStringEncoding]);
-                } else {
-                  fprintf(stderr, "ERROR:  invalid control name: %s\n", controlName);
-                  rc = ENOENT;
-                  if ( exitOnErrors ) goto cleanupAndExit;
-                }
-              }
-            }
-          } else {
-            fprintf(stderr, "ERROR:  missing argument to -S/--show option\n");
-            rc = EINVAL;
-            if ( exitOnErrors ) goto cleanupAndExit;
+      case kUVCUtilOptionMoveDuration:
+      case kUVCUtilOptionMoveVelocity:
+      case kUVCUtilOptionMoveRate: {
+        char              *endPtr = NULL;
+        double            number = strtod(optarg, &endPtr);
+        
+        if ( (endPtr > optarg) && ! *endPtr && ((optCh == kUVCUtilOptionMoveDuration) ? (number >= 0) : (number > 0)) ) {
+          switch ( optCh ) {
+            case kUVCUtilOptionMoveDuration:
+              moveDuration = number;
+              moveVelocity = 0.0;
+              break;
+            case kUVCUtilOptionMoveVelocity:
+              moveVelocity = number;
+              break;
+            case kUVCUtilOptionMoveRate:
+              moveRate = number;
+              break;
           }
         } else {
-          fprintf(stderr, "ERROR:  no target device selected\n");
-          rc = ENODEV;
+          fprintf(stderr, "ERROR:  invalid %s: %s\n", ((optCh == kUVCUtilOptionMoveDuration) ? "move duration" : ((optCh == kUVCUtilOptionMoveVelocity) ? "move velocity" : "move rate")), optarg);
+          rc = EINVAL;
           if ( exitOnErrors ) goto cleanupAndExit;
         }
         break;
       }
       
-      case 'o':
-      case 'g': {
-        if ( targetDevice ) {
-          if ( optarg && *optarg ) {
-            UVCControl      *control = [targetDevice controlWithName:[NSString stringWithCString:optarg encoding:NSASCIIStringEncoding]];
-                
-            if ( control ) {
-              UVCValue      *currentValue = [control currentValue];
+      case kUVCUtilOptionMove: {
+        const char        *valuePtr = strchr(optarg, '=');
+        
+        if ( daemonClient ) {
+          fprintf(stderr, "ERROR:  --move is not available with --connect\n");
+          rc = ENOTSUP;
+          if ( exitOnErrors ) goto cleanupAndExit;
+        } else if ( ! targetDevice ) {
+          fprintf(stderr, "ERROR:  no target device selected\n");
+          rc = ENODEV;
+          if ( exitOnErrors ) goto cleanupAndExit;
+        } else if ( ! valuePtr || (valuePtr == optarg) ) {
+          fprintf(stderr, "ERROR:  --move requires <control-name>=<value>: %s\n", optarg);
+          rc = EINVAL;
+          if ( exitOnErrors ) goto cleanupAndExit;
+        } else {
+          NSString          *controlName = [[[[NSString alloc] initWithBytes:optarg length:(valuePtr - optarg) encoding:NSASCIIStringEncoding] autorelease] lowercaseString];
+          UVCControl        *control = [targetDevice controlWithName:controlName];
+          
+          valuePtr++;
+          if ( ! control ) {
+            fprintf(stderr, "ERROR:  invalid control name: %s\n", [controlName UTF8String]);
+            rc = ENOENT;
+            if ( exitOnErrors ) goto cleanupAndExit;
+          } else if ( ! [control supportsGetValue] || ! [control supportsSetValue] ) {
+            fprintf(stderr, "ERROR:  control %s cannot be both read and written\n", [controlName UTF8String]);
+            rc = EACCES;
+            if ( exitOnErrors ) goto cleanupAndExit;
+          } else {
+            UVCValue          *target = [UVCValue uvcValueWithType:[[control valueBuffer] valueType]];
+            NSUInteger        errorOffset = 0;
+            UVCTypeScanStatus scanStatus = [target scanCString:valuePtr flags:[session scanFlags] minimum:[control minimum] maximum:[control maximum] stepSize:[control stepSize] defaultValue:[control defaultValue] errorOffset:&errorOffset];
+            
+            if ( scanStatus != kUVCTypeScanOk ) {
+              fprintf(stderr, "ERROR:  invalid value for control %s: %s (at offset %lu: %s)\n", [controlName UTF8String], valuePtr, (unsigned long)errorOffset, UVCTypeScanStatusString(scanStatus));
+              rc = EINVAL;
+              if ( exitOnErrors ) goto cleanupAndExit;
+            } else {
+              UVCTrajectory           *trajectory = ( (moveVelocity > 0) ? [UVCTrajectory trajectoryWithControl:control target:target velocity:moveVelocity] : [UVCTrajectory trajectoryWithControl:control target:target duration:moveDuration] );
+              UVCTrajectoryStatistics stats;
+              BOOL                    didMove;
               
-              if ( currentValue ) {
-                if ( optCh == 'o' ) {
-                  printf("%s\n", [[currentValue stringValue] cStringUsingEncoding:NSASCIIStringEncoding]);
-                } else {
-                  printf("%s = %s\n", [[control controlName] cStringUsingEncoding:NSASCIIStringEncoding], [[currentValue stringValue] cStringUsingEncoding:NSASCIIStringEncoding]);
-                }
-              } else {
-                fprintf(stderr, "ERROR:  unable to read value of control: %s\n", optarg);
+              [trajectory setUpdateRate:moveRate];
+              didMove = [trajectory runWithStatistics:&stats];
+              printf("%s: %lu points in %.3f s (%.1f/s achieved of %.1f/s); %lu written, %lu unchanged, %lu dropped, %lu deadline miss(es); maximum lateness %.3f ms\n",
+                  [controlName UTF8String],
+                  (unsigned long)stats.pointCount,
+                  stats.elapsedTime,
+                  stats.achievedRate,
+                  moveRate,
+                  (unsigned long)stats.writeCount,
+                  (unsigned long)stats.unchangedCount,
+                  (unsigned long)stats.droppedCount,
+                  (unsigned long)stats.deadlineMissCount,
+                  stats.maximumLateness * 1000.0
+                );
+              if ( ! didMove ) {
+                fprintf(stderr, "ERROR:  unable to move control %s\n", [controlName UTF8String]);
                 rc = EACCES;
                 if ( exitOnErrors ) goto cleanupAndExit;
               }
-            } else {
-              fprintf(stderr, "ERROR:  invalid control name: %s\n", optarg);
-              rc = ENOENT;
-              if ( exitOnErrors ) goto cleanupAndExit;
             }
-          } else {
-            fprintf(stderr, "ERROR:  missing argument to -g/--get/-o/--get-value option\n");
-            rc = EINVAL;
-            if ( exitOnErrors ) goto cleanupAndExit;
           }
-        } else {
-          fprintf(stderr, "ERROR:  no target device selected\n");
-          rc = ENODEV;
+        }
+        break;
+      }
+      
+      case kUVCUtilOptionDaemon: {
+        if ( daemonClient ) {
+          fprintf(stderr, "ERROR:  --daemon is not available with --connect\n");
+          rc = ENOTSUP;
           if ( exitOnErrors ) goto cleanupAndExit;
+        } else {
+          UVCDaemon       *daemon = [UVCDaemon daemonWithSocketPath:[NSString stringWithUTF8String:optarg] session:session];
+          int             daemonRc = [daemon listen];
+          
+          if ( daemonRc == 0 ) {
+            daemonRc = [daemon serve];
+            if ( [session scanFlags] & kUVCTypeScanFlagShowInfo ) fprintf(stderr, "INFO:  daemon served %lu request(s) on %lu connection(s)\n", (unsigned long)[daemon requestCount], (unsigned long)[daemon connectionCount]);
+          }
+          if ( daemonRc ) {
+            fprintf(stderr, "ERROR:  unable to serve requests at %s: %s\n", optarg, strerror(daemonRc));
+            rc = daemonRc;
+          }
+          // Anything that follows was meant for a client:
+          goto cleanupAndExit;
         }
         break;
       }
       
-      case 'r': {
-        if ( targetDevice ) {
-          NSArray     *controlNames = [UVCController controlStrings];
+      case kUVCUtilOptionConnect: {
+        int               connectRc = 0;
+        
+        if ( daemonClient ) [daemonClient release];
+        daemonClient = [[UVCDaemonClient daemonClientWithSocketPath:[NSString stringWithUTF8String:optarg] error:&connectRc] retain];
+        if ( ! daemonClient ) {
+          fprintf(stderr, "ERROR:  unable to connect to daemon at %s: %s\n", optarg, strerror(connectRc));
+          rc = connectRc;
+          goto cleanupAndExit;
+        }
+        break;
+      }
+      
+      case kUVCUtilOptionBatch: {
+        if ( daemonClient ) {
+          fprintf(stderr, "ERROR:  --batch is not available with --connect\n");
+          rc = ENOTSUP;
+          if ( exitOnErrors ) goto cleanupAndExit;
+        } else {
+          int                         fd = ( strcmp(optarg, "-") == 0 ) ? STDIN_FILENO : open(optarg, O_RDONLY);
           
-          if ( controlNames && [controlNames count] ) {
-            NSEnumerator  *eNames = [controlNames objectEnumerator];
-            NSString      *name;
+          if ( fd >= 0 ) {
+            UVCCommandBatchStatistics stats;
+            int                       batchRc = [session performCommandsFromFileDescriptor:fd exitOnErrors:exitOnErrors statistics:&stats];
             
-            while ( (name = [eNames nextObject]) ) {
-              UVCControl  *control = [targetDevice controlWithName:name];
-              
-              if ( control && [control hasDefaultValue] ) {
-                if ( ! [control resetToDefaultValue] ) {
-                  fprintf(stderr, "ERROR:  unable to write default value to control %s\n", [name cStringUsingEncoding:NSASCIIStringEncoding]);
-                  rc = EACCES;
-                  if ( exitOnErrors ) goto cleanupAndExit;
-                }
-              }
+            if ( fd != STDIN_FILENO ) close(fd);
+            if ( [session scanFlags] & kUVCTypeScanFlagShowInfo ) fprintf(stderr, "INFO:  batch executed %lu command(s), %lu failed; %lu get(s) shared %lu pipelined read(s)\n", (unsigned long)stats.commandCount, (unsigned long)stats.failedCount, (unsigned long)stats.sharedReadCount, (unsigned long)stats.sharedReadGroupCount);
+            if ( batchRc ) {
+              rc = batchRc;
+              if ( exitOnErrors ) goto cleanupAndExit;
             }
           } else {
-            fprintf(stderr, "WARNING:  no controls implemented by this device\n");
+            fprintf(stderr, "ERROR:  unable to read commands from %s\n", optarg);
+            rc = ENOENT;
+            if ( exitOnErrors ) goto cleanupAndExit;
           }
-        } else {
+        }
+        break;
+      }
+      
+      case kUVCUtilOptionSaveProfile:
+        command = kUVCCommandSaveProfile;
+        break;
+        
+      case kUVCUtilOptionApplyProfile:
+        command = kUVCCommandApplyProfile;
+        break;
+        
+      case kUVCUtilOptionSelectSimulated:
+        command = kUVCCommandSelectSimulated;
+        break;
+        
+      case kUVCUtilOptionSelectAll:
+        command = kUVCCommandSelectAll;
+        break;
+        
+      case kUVCUtilOptionSelectAllByVendorAndProductId:
+        command = kUVCCommandSelectAllByVendorAndProductId;
+        break;
+        
+      case kUVCUtilOptionSelectAllByLocationId:
+        command = kUVCCommandSelectAllByLocationId;
+        break;
+        
+      case kUVCUtilOptionSelectSimulatedGroup:
+        command = kUVCCommandSelectSimulatedGroup;
+        break;
+        
+      case kUVCUtilOptionStats:
+        command = kUVCCommandStats;
+        break;
+        
+      case kUVCUtilOptionDump:
+        command = kUVCCommandDump;
+        break;
+      
+      case kUVCUtilOptionRecordTrace: {
+        if ( daemonClient ) {
+          fprintf(stderr, "ERROR:  --record-trace is not available with --connect\n");
+          rc = ENOTSUP;
+          if ( exitOnErrors ) goto cleanupAndExit;
+        } else if ( ! targetDevice ) {
           fprintf(stderr, "ERROR:  no target device selected\n");
           rc = ENODEV;
           if ( exitOnErrors ) goto cleanupAndExit;
+        } else {
+          UVCTraceRecorder      *recorder = [UVCTraceRecorder traceRecorderForController:targetDevice path:[NSString stringWithUTF8String:optarg]];
+          
+          if ( recorder ) {
+            [targetDevice setTransport:recorder];
+          } else {
+            fprintf(stderr, "ERROR:  unable to create trace file %s\n", optarg);
+            rc = EPERM;
+            if ( exitOnErrors ) goto cleanupAndExit;
+          }
         }
         break;
       }
       
-      case 's': {
-        if ( targetDevice ) {
-          if ( optarg && *optarg ) {
-            const char                  *valuePtr = strchr(optarg, '=');
-            
-            if ( valuePtr ) {
-              long                        controlNameLen = valuePtr - optarg;
-              
-              valuePtr++;
-              if ( controlNameLen ) {
-                char                        controlName[controlNameLen + 1];
-                long                        i = 0;
-                
-                while ( i < controlNameLen ) {
-                  controlName[i] = tolower(optarg[i]);
-                  i++;
-                }
-                controlName[i] = '\0';
-                
-                UVCControl      *control = [targetDevice controlWithName:[NSString stringWithCString:controlName encoding:NSASCIIStringEncoding]];
-                  
-                if ( control ) {
-                  if ( [control setCurrentValueFromCString:valuePtr flags:uvcScanFlags] ) {
-                    if ( ! [control writeFromCurrentValue] ) {
-                      fprintf(stderr, "ERROR:  unable to write new value to control %s\n", controlName);
-                      rc = EACCES;
-                      if ( exitOnErrors ) goto cleanupAndExit;
-                    }
-                  } else {
-                    fprintf(stderr, "ERROR:  invalid value for control %s: %s\n", controlName, valuePtr);
-                    rc = EINVAL;
-                    if ( exitOnErrors ) goto cleanupAndExit;
-                  }
-                } else {
-                  fprintf(stderr, "ERROR:  invalid control name: %s\n", controlName);
-                  rc = ENOENT;
-                  if ( exitOnErrors ) goto cleanupAndExit;
-                }
-              } else {
-                fprintf(stderr, "ERROR:  missing control name: %s\n", optarg);
-                rc = EINVAL;
-                if ( exitOnErrors ) goto cleanupAndExit;
-              }
-            } else {
-              fprintf(stderr, "ERROR:  no value provided with control name: %s\n", optarg);
-              rc = EINVAL;
-              if ( exitOnErrors ) goto cleanupAndExit;
-            }
+      case kUVCUtilOptionReplayTiming: {
+        if ( ! UVCTraceReplayTimingWithName(optarg, &replayTiming) ) {
+          fprintf(stderr, "ERROR:  invalid replay timing: %s\n", optarg);
+          rc = EINVAL;
+          if ( exitOnErrors ) goto cleanupAndExit;
+        }
+        break;
+      }
+      
+      case kUVCUtilOptionReplayTrace: {
+        if ( daemonClient ) {
+          fprintf(stderr, "ERROR:  --replay-trace is not available with --connect\n");
+          rc = ENOTSUP;
+          if ( exitOnErrors ) goto cleanupAndExit;
+        } else {
+          UVCTraceReplayTransport *replay = [UVCTraceReplayTransport traceReplayTransportWithPath:[NSString stringWithUTF8String:optarg] timing:replayTiming];
+          
+          if ( replay ) {
+            if ( [session scanFlags] & kUVCTypeScanFlagShowInfo ) fprintf(stderr, "INFO:  replaying %lu recorded transfer(s) from %s\n", (unsigned long)[replay recordCount], optarg);
+            [session setTargetDevice:[replay controller]];
           } else {
-            fprintf(stderr, "ERROR:  missing argument to -s/--set option\n");
-            rc = EINVAL;
+            fprintf(stderr, "ERROR:  unable to read trace from %s\n", optarg);
+            rc = ENOENT;
             if ( exitOnErrors ) goto cleanupAndExit;
           }
-        } else {
-          fprintf(stderr, "ERROR:  no target device selected\n");
-          rc = ENODEV;
+        }
+        break;
+      }
+      
+      case kUVCUtilOptionBenchmarkBaseline:
+        benchmarkBaseline = optarg;
+        break;
+      
+      case kUVCUtilOptionBenchmark: {
+        UVCBenchmark            *benchmark = [UVCBenchmark benchmarkWithStream:stdout];
+        NSArray                 *suiteNames = nil;
+        int                     benchmarkRc;
+        
+        if ( benchmarkBaseline && ! [benchmark loadBaselineFromFile:[NSString stringWithUTF8String:benchmarkBaseline]] ) {
+          fprintf(stderr, "ERROR:  unable to read benchmark baseline from %s\n", benchmarkBaseline);
+          rc = ENOENT;
+          if ( exitOnErrors ) goto cleanupAndExit;
+          break;
+        }
+        if ( optarg && *optarg ) suiteNames = [[NSString stringWithUTF8String:optarg] componentsSeparatedByString:@","];
+        if ( (benchmarkRc = [benchmark runSuitesWithNames:suiteNames]) ) {
+          fprintf(stderr, "ERROR:  unknown benchmark suite in %s (available: %s)\n", optarg, [[[UVCBenchmark suiteNames] componentsJoinedByString:@","] UTF8String]);
+          rc = benchmarkRc;
+          if ( exitOnErrors ) goto cleanupAndExit;
+        } else if ( [benchmark regressionCount] ) {
+          if ( [session scanFlags] & kUVCTypeScanFlagShowInfo ) fprintf(stderr, "INFO:  %lu benchmark result(s) regressed against the baseline or exceeded their limit\n", (unsigned long)[benchmark regressionCount]);
+          rc = ERANGE;
           if ( exitOnErrors ) goto cleanupAndExit;
         }
         break;
       }
+      
+      case 'd':
+      case 'c':
+      case '0':
+      case 'I':
+      case 'N':
+      case 'V':
+      case 'L':
+      case 'S':
+      case 'o':
+      case 'g':
+      case 'r':
+      case 's':
+        command = optCh;
+        break;
   
     }
+    if ( command != kUVCCommandNone ) {
+      int                 commandRc;
+      
+      if ( daemonClient ) {
+        commandRc = [daemonClient performCommand:command argument:optarg];
+      } else {
+        commandRc = [session performCommand:command argument:optarg];
+      }
+      if ( commandRc ) {
+        rc = commandRc;
+        if ( exitOnErrors ) goto cleanupAndExit;
+      }
+    }
+    [optionPool drain];
   }
-}
 
 cleanupAndExit:
-  if ( uvcDevices ) [uvcDevices release];
+  if ( daemonClient ) [daemonClient release];
+}
   return rc;
 }